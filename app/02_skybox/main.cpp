@@ -68,24 +68,32 @@ class Sphere : public GameObject {
   Sphere() : GameObject("Sphere") {}
   void OnStart() override {
     ImmutableModel sphereModel = ImmutableModel::CreateSphere("sphere", 1, 32);
-    CreateVboIbo(sphereModel, Vbo, Ibo);
+    CreateVboIbo(sphereModel, Vbo, Ibo, IndexType);
     IndexCount = int(sphereModel.GetIndexCount());
   }
   std::shared_ptr<BufferOpenGL> Vbo;
   std::shared_ptr<BufferOpenGL> Ibo;
+  IndexDataType IndexType{};
   int IndexCount{};
 };
 
 class SkyboxPass : public RenderPass {
  public:
-  SkyboxPass() : RenderPass("Skybox", 1) {}
+  SkyboxPass() : RenderPass("Skybox", 1) {
+    //六个面在工作线程上同时解码
+    for (size_t i = 0; i < 6; i++) {
+      _faceHandles[i] = GetApp().GetAssets().RequestBitmap(faces[i], GetApp().GetAssetPath() / "skybox1" / faces[i], false);
+    }
+  }
   void OnStart() override {
-    ImmutableBitmap bitmap[6];
+    std::shared_ptr<ImmutableBitmap> bitmap[6];
     for (size_t i = 0; i < 6; i++) {
-      bitmap[i] = ImmutableBitmap(faces[i], GetApp().GetAssetPath() / "skybox1" / faces[i], false);
-      if (!bitmap[i].IsValid()) {
+      try {
+        bitmap[i] = _faceHandles[i].Get();
+      } catch (const AssetLoadException&) {
         throw AppRuntimeException(std::string("Can't load bitmap ") + faces[i]);
       }
+      _faceHandles[i] = {};
     }
     TextureCubeMapDescriptorOpenGL cubeDesc{};
     cubeDesc.Wrap = WrapMode::Clamp;
@@ -95,9 +103,9 @@ class SkyboxPass : public RenderPass {
     cubeDesc.Width = 2048;
     cubeDesc.Height = 2048;
     for (size_t i = 0; i < 6; i++) {
-      cubeDesc.DataFormat[i] = bitmap[i].GetChannel() == 3 ? ImageDataFormat::RGB : ImageDataFormat::RGBA;
+      cubeDesc.DataFormat[i] = bitmap[i]->GetChannel() == 3 ? ImageDataFormat::RGB : ImageDataFormat::RGBA;
       cubeDesc.DataType[i] = ImageDataType::Byte;
-      cubeDesc.DataPtr[i] = (void*)bitmap[i].GetData();
+      cubeDesc.DataPtr[i] = (void*)bitmap[i]->GetData();
     }
     _skybox = GetContext().CreateCubeMap(cubeDesc);
     _cube = GetApp().GetGameObject<Cube>("Cube");
@@ -128,6 +136,7 @@ class SkyboxPass : public RenderPass {
       "bottom.jpg",
       "front.jpg",
       "back.jpg"};
+  AssetHandle<ImmutableBitmap> _faceHandles[6];
 };
 
 class NormalPass : public RenderPass {
@@ -152,7 +161,7 @@ class NormalPass : public RenderPass {
     SetVertexBuffer(*(_sphere->Vbo), GetVertexPosPNT());
     SetVertexBuffer(*(_sphere->Vbo), GetVertexNormalPNT());
     SetIndexBuffer(*(_sphere->Ibo));
-    DrawIndexed(_sphere->IndexCount, 0);
+    DrawIndexed(_sphere->IndexCount, 0, _sphere->IndexType);
   }
 
  private:
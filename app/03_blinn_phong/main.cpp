@@ -55,11 +55,12 @@ class Sphere : public GameObject {
   Sphere() : GameObject("Sphere") {}
   void OnStart() override {
     ImmutableModel sphereModel = ImmutableModel::CreateSphere("sphere", 1, 32);
-    CreateVboIbo(sphereModel, Vbo, Ibo);
+    CreateVboIbo(sphereModel, Vbo, Ibo, IndexType);
     IndexCount = int(sphereModel.GetIndexCount());
   }
   std::shared_ptr<BufferOpenGL> Vbo;
   std::shared_ptr<BufferOpenGL> Ibo;
+  IndexDataType IndexType{};
   int IndexCount{};
 };
 
@@ -92,7 +93,7 @@ class BlinnPhongPass : public RenderPass {
     SetVertexBuffer(*(_sphere->Vbo), GetVertexPosPNT());
     SetVertexBuffer(*(_sphere->Vbo), GetVertexNormalPNT());
     SetIndexBuffer(*(_sphere->Ibo));
-    DrawIndexed(_sphere->IndexCount, 0);
+    DrawIndexed(_sphere->IndexCount, 0, _sphere->IndexType);
   }
 
  private:
@@ -96,25 +96,33 @@ Vector3f lightDir = -Normalize(lightTarget - lightPos);
 
 class Wall : public GameObject {
  public:
-  Wall() : GameObject("Wall") {}
+  Wall() : GameObject("Wall") {
+    Model = GetApp().GetAssets().RequestModel("wall", GetApp().GetAssetPath() / "04_wall.obj");
+  }
   void OnStart() override {
-    ImmutableModel wall("wall", GetApp().GetAssetPath() / "04_wall.obj");
-    CreateVboIbo(wall, Vbo, Ibo);
-    IndexCount = int(wall.GetIndexCount());
+    auto wall = Model.Get();
+    Model = {};
+    CreateVboIbo(*wall, Vbo, Ibo, IndexType);
+    IndexCount = int(wall->GetIndexCount());
   }
 
+  AssetHandle<ImmutableModel> Model;
   std::shared_ptr<BufferOpenGL> Vbo;
   std::shared_ptr<BufferOpenGL> Ibo;
+  IndexDataType IndexType{};
   int IndexCount{};
 };
 
 class Ring : public GameObject {
  public:
-  Ring() : GameObject("Ring") {}
+  Ring() : GameObject("Ring") {
+    Model = GetApp().GetAssets().RequestModel("ring", GetApp().GetAssetPath() / "04_ring.obj");
+  }
   void OnStart() override {
-    ImmutableModel wall("ring", GetApp().GetAssetPath() / "04_ring.obj");
-    CreateVboIbo(wall, Vbo, Ibo);
-    IndexCount = int(wall.GetIndexCount());
+    auto ring = Model.Get();
+    Model = {};
+    CreateVboIbo(*ring, Vbo, Ibo, IndexType);
+    IndexCount = int(ring->GetIndexCount());
   }
   void OnUpdate() override {
     Matrix4f old = GetTransform().Rotation;
@@ -122,8 +130,10 @@ class Ring : public GameObject {
     Matrix4f rotateY = Rotate<float>({0, 1, 0}, Radian(45 * deltaTime));
     GetTransform().Rotation = rotateY * old;
   }
+  AssetHandle<ImmutableModel> Model;
   std::shared_ptr<BufferOpenGL> Vbo;
   std::shared_ptr<BufferOpenGL> Ibo;
+  IndexDataType IndexType{};
   int IndexCount{};
 };
 
@@ -159,11 +169,11 @@ class DepthPass : public RenderPass {
     prog->UniformMat4("lightMVP", (_wall->GetTransform().ObjectToWorldMatrix() * lightLookAt * lightPersp).GetAddress());
     SetVertexBuffer(*(_wall->Vbo), GetVertexPosPNT());
     SetIndexBuffer(*(_wall->Ibo));
-    DrawIndexed(_wall->IndexCount, 0);
+    DrawIndexed(_wall->IndexCount, 0, _wall->IndexType);
     prog->UniformMat4("lightMVP", (_ring->GetTransform().ObjectToWorldMatrix() * lightLookAt * lightPersp).GetAddress());
     SetVertexBuffer(*(_ring->Vbo), GetVertexPosPNT());
     SetIndexBuffer(*(_ring->Ibo));
-    DrawIndexed(_ring->IndexCount, 0);
+    DrawIndexed(_ring->IndexCount, 0, _ring->IndexType);
     _depthFrame->Unbind();
   }
 
@@ -217,7 +227,7 @@ class BlinnPhongPass : public RenderPass {
     SetVertexBuffer(*(_wall->Vbo), GetVertexPosPNT());
     SetVertexBuffer(*(_wall->Vbo), GetVertexNormalPNT());
     SetIndexBuffer(*(_wall->Ibo));
-    DrawIndexed(_wall->IndexCount, 0);
+    DrawIndexed(_wall->IndexCount, 0, _wall->IndexType);
 
     auto ringModel = _ring->GetTransform().ObjectToWorldMatrix();
     blinnProg->UniformMat4("model", ringModel.GetAddress());
@@ -230,7 +240,7 @@ class BlinnPhongPass : public RenderPass {
     SetVertexBuffer(*(_ring->Vbo), GetVertexPosPNT());
     SetVertexBuffer(*(_ring->Vbo), GetVertexNormalPNT());
     SetIndexBuffer(*(_ring->Ibo));
-    DrawIndexed(_ring->IndexCount, 0);
+    DrawIndexed(_ring->IndexCount, 0, _ring->IndexType);
   }
 
  private:
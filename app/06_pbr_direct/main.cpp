@@ -13,18 +13,20 @@ class Sphere : public GameObject {
   void OnStart() override {
     if (VertexCount == 0) {
       ImmutableModel cubeModel = ImmutableModel::CreateSphere("sphere", 0.25f, 32);
-      CreateVboIbo(cubeModel, Vbo, Ibo);
+      CreateVboIbo(cubeModel, Vbo, Ibo, IndexType);
       VertexCount = int(cubeModel.GetIndexCount());
     }
   }
 
   static std::shared_ptr<BufferOpenGL> Vbo;
   static std::shared_ptr<BufferOpenGL> Ibo;
+  static IndexDataType IndexType;
   static int VertexCount;
 };
 
 std::shared_ptr<BufferOpenGL> Sphere::Vbo;
 std::shared_ptr<BufferOpenGL> Sphere::Ibo;
+IndexDataType Sphere::IndexType{};
 int Sphere::VertexCount = 0;
 
 class ClearPass : public RenderPass {
@@ -62,7 +64,7 @@ class BlinnPass : public RenderPass {
     SetVertexBuffer(_sphere->Vbo, GetVertexPosPNT());
     SetVertexBuffer(_sphere->Vbo, GetVertexNormalPNT());
     SetIndexBuffer(_sphere->Ibo);
-    DrawIndexed(_sphere->VertexCount, 0);
+    DrawIndexed(_sphere->VertexCount, 0, _sphere->IndexType);
   }
 
  private:
@@ -110,7 +112,7 @@ class MicrofacetCookTorrance : public RenderPass {
         SetVertexBuffer(sphere->Vbo, GetVertexPosPNT());
         SetVertexBuffer(sphere->Vbo, GetVertexNormalPNT());
         SetIndexBuffer(sphere->Ibo);
-        DrawIndexed(sphere->VertexCount, 0);
+        DrawIndexed(sphere->VertexCount, 0, sphere->IndexType);
       }
     }
   }
@@ -21,11 +21,12 @@ class Sphere : public GameObject {
   Sphere() : GameObject("sphere") {}
   void OnStart() override {
     ImmutableModel sphereModel = ImmutableModel::CreateSphere("sphere", 1, 32);
-    CreateVboIbo(sphereModel, Vbo, Ibo);
+    CreateVboIbo(sphereModel, Vbo, Ibo, IndexType);
     IndexCount = int(sphereModel.GetIndexCount());
   }
   std::shared_ptr<BufferOpenGL> Vbo;
   std::shared_ptr<BufferOpenGL> Ibo;
+  IndexDataType IndexType{};
   int IndexCount{};
 };
 
@@ -58,7 +59,7 @@ class ColorPass : public RenderPass {
     GetProgram()->UniformCubeMap("u_cube", BindTexture(*convSky));
     SetVertexBuffer(_sphere->Vbo, GetVertexPosPNT());
     SetIndexBuffer(_sphere->Ibo);
-    DrawIndexed(_sphere->IndexCount, 0);
+    DrawIndexed(_sphere->IndexCount, 0, _sphere->IndexType);
   }
 
   std::shared_ptr<Sphere> _sphere;
@@ -67,23 +68,22 @@ class ColorPass : public RenderPass {
 
 class SkyboxPass : public RenderPass {
  public:
-  SkyboxPass() : RenderPass("Skybox", 2) {}
+  SkyboxPass() : RenderPass("Skybox", 2) {
+    _hdr = GetApp().GetAssets().RequestHdrTexture("hdr", GetApp().GetAssetPath() / "skybox_pillars_4k" / "pillars_4k.hdr", true, HdrStorage::RGB9E5);
+  }
 
   void OnStart() override {
     _cube = GetApp().GetGameObject<Cube>("cube");
 
-    ImmutableHdrTexture tex("hdr", GetApp().GetAssetPath() / "skybox_pillars_4k" / "pillars_4k.hdr", true);
+    auto hdr = _hdr.Get();
+    _hdr = {};
+    const auto& tex = *hdr;
     Texture2dDescriptorOpenGL hdrDesc;
     hdrDesc.Wrap = WrapMode::Clamp;
     hdrDesc.MinFilter = FilterMode::Bilinear;
     hdrDesc.MagFilter = FilterMode::Bilinear;
     hdrDesc.MipMapLevel = 0;
-    hdrDesc.TextureFormat = PixelFormat::RGB32F;
-    hdrDesc.Width = tex.GetWidth();
-    hdrDesc.Height = tex.GetHeight();
-    hdrDesc.DataFormat = tex.GetChannel() == 3 ? ImageDataFormat::RGB : ImageDataFormat::RGBA;
-    hdrDesc.DataType = ImageDataType::Float32;
-    hdrDesc.DataPtr = tex.GetData();
+    SetHdrTextureData(tex, hdrDesc);
     TextureCubeMapDescriptorOpenGL dyMapDesc;
     dyMapDesc.Wrap = WrapMode::Clamp;
     dyMapDesc.MinFilter = FilterMode::Bilinear;
@@ -143,6 +143,7 @@ class SkyboxPass : public RenderPass {
   std::shared_ptr<TextureOpenGL> _skybox;
   std::shared_ptr<TextureOpenGL> _conv;
   std::shared_ptr<Cube> _cube;
+  AssetHandle<ImmutableHdrTexture> _hdr;
 };
 
 int main(int argc, char** argv) {
@@ -25,17 +25,19 @@ class Sphere : public GameObject {
   void OnStart() override {
     if (IndexCount == 0) {
       ImmutableModel sphereModel = ImmutableModel::CreateSphere("sphere", 0.4f, 32);
-      CreateVboIbo(sphereModel, Vbo, Ibo);
+      CreateVboIbo(sphereModel, Vbo, Ibo, IndexType);
       IndexCount = int(sphereModel.GetIndexCount());
     }
   }
   static std::shared_ptr<BufferOpenGL> Vbo;
   static std::shared_ptr<BufferOpenGL> Ibo;
+  static IndexDataType IndexType;
   static int IndexCount;
 };
 
 std::shared_ptr<BufferOpenGL> Sphere::Vbo;
 std::shared_ptr<BufferOpenGL> Sphere::Ibo;
+IndexDataType Sphere::IndexType{};
 int Sphere::IndexCount = 0;
 
 class ClearPass : public RenderPass {
@@ -72,7 +74,7 @@ class ColorPass : public RenderPass {
       SetVertexBuffer(sphere[i]->Vbo, GetVertexPosPNT());
       SetVertexBuffer(sphere[i]->Vbo, GetVertexNormalPNT());
       SetIndexBuffer(sphere[i]->Ibo);
-      DrawIndexed(sphere[i]->IndexCount, 0);
+      DrawIndexed(sphere[i]->IndexCount, 0, sphere[i]->IndexType);
     }
   }
 
@@ -82,23 +84,22 @@ class ColorPass : public RenderPass {
 
 class SkyboxPass : public RenderPass {
  public:
-  SkyboxPass() : RenderPass("Skybox", 2) {}
+  SkyboxPass() : RenderPass("Skybox", 2) {
+    _hdr = GetApp().GetAssets().RequestHdrTexture("hdr", GetApp().GetAssetPath() / "skybox_pillars_4k" / "pillars_4k.hdr", true, HdrStorage::RGB9E5);
+  }
 
   void OnStart() override {
     _cube = GetApp().GetGameObject<Cube>("cube");
 
-    ImmutableHdrTexture tex("hdr", GetApp().GetAssetPath() / "skybox_pillars_4k" / "pillars_4k.hdr", true);
+    auto hdr = _hdr.Get();
+    _hdr = {};
+    const auto& tex = *hdr;
     Texture2dDescriptorOpenGL hdrDesc;
     hdrDesc.Wrap = WrapMode::Clamp;
     hdrDesc.MinFilter = FilterMode::Bilinear;
     hdrDesc.MagFilter = FilterMode::Bilinear;
     hdrDesc.MipMapLevel = 0;
-    hdrDesc.TextureFormat = PixelFormat::RGB32F;
-    hdrDesc.Width = tex.GetWidth();
-    hdrDesc.Height = tex.GetHeight();
-    hdrDesc.DataFormat = tex.GetChannel() == 3 ? ImageDataFormat::RGB : ImageDataFormat::RGBA;
-    hdrDesc.DataType = ImageDataType::Float32;
-    hdrDesc.DataPtr = tex.GetData();
+    SetHdrTextureData(tex, hdrDesc);
     TextureCubeMapDescriptorOpenGL dyMapDesc;
     dyMapDesc.Wrap = WrapMode::Clamp;
     dyMapDesc.MinFilter = FilterMode::Bilinear;
@@ -155,6 +156,7 @@ class SkyboxPass : public RenderPass {
   std::shared_ptr<TextureOpenGL> _skybox;
   std::shared_ptr<TextureOpenGL> _conv;
   std::shared_ptr<Cube> _cube;
+  AssetHandle<ImmutableHdrTexture> _hdr;
 };
 
 int main(int argc, char** argv) {
@@ -2,6 +2,7 @@
 
 #include <HikariLight.glsl>
 #include <HikariCamera.glsl>
+#include <HikariEnvironment.glsl>
 #include <BRDF.glsl>
 
 in vec3 v_Pos;
@@ -10,7 +11,6 @@ in vec3 v_Normal;
 out vec4 f_Color;
 
 uniform MetallicWorkflowMaterial u_metal;
-uniform samplerCube u_IrradianceMap;
 uniform samplerCube u_PrefilterMap;
 uniform sampler2D u_BrdfLut;
 uniform int u_MaxLod;
@@ -42,7 +42,7 @@ void main() {
   vec3 f = FresnelSchlickRoughness(f0, v, n, roughness);
   vec3 ks = f;
   vec3 kd = (vec3(1.0) - ks) * (1.0 - metallic);
-  vec3 irradiance = texture(u_IrradianceMap, n).rgb;
+  vec3 irradiance = GetIrradianceSH(n);
   vec3 LeDiffuse = kd * irradiance * albedo;
   vec3 prefilter = textureLod(u_PrefilterMap, r, roughness * u_MaxLod).rgb;
   vec2 brdf = texture(u_BrdfLut, vec2(NdotV, roughness)).rg;
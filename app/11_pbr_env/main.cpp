@@ -28,69 +28,27 @@ class PbrPass : public RenderPass {
  public:
   PbrPass() : RenderPass("PBR Pass", 1) {
     albedo = {1.0f, 1.0f, 0.0f};
+    envHandle = GetApp().GetAssets().RequestHdrTexture("hdr", GetApp().GetAssetPath() / "skybox_pillars_4k" / "pillars_4k.hdr", true, HdrStorage::RGB9E5);
   }
 
   void OnStart() override {
     LoadProgram("cook_torrance.vert", "cook_torrance.frag", {POSITION(), NORMAL()});
 
-    ImmutableHdrTexture env("hdr", GetApp().GetAssetPath() / "skybox_pillars_4k" / "pillars_4k.hdr", true);
-    Texture2dDescriptorOpenGL hdrDesc;
-    hdrDesc.Wrap = WrapMode::Clamp;
-    hdrDesc.MinFilter = FilterMode::Bilinear;
-    hdrDesc.MagFilter = FilterMode::Bilinear;
-    hdrDesc.MipMapLevel = 0;
-    hdrDesc.TextureFormat = PixelFormat::RGB32F;
-    hdrDesc.Width = env.GetWidth();
-    hdrDesc.Height = env.GetHeight();
-    hdrDesc.DataFormat = env.GetChannel() == 3 ? ImageDataFormat::RGB : ImageDataFormat::RGBA;
-    hdrDesc.DataType = ImageDataType::Float32;
-    hdrDesc.DataPtr = env.GetData();
-    TextureCubeMapDescriptorOpenGL skyDesc;
-    skyDesc.Wrap = WrapMode::Clamp;
-    skyDesc.MinFilter = FilterMode::Bilinear;
-    skyDesc.MagFilter = FilterMode::Bilinear;
-    skyDesc.MipMapLevel = 0;
-    skyDesc.TextureFormat = PixelFormat::RGB32F;
-    skyDesc.Width = 1024;
-    skyDesc.Height = 1024;
-    for (int i = 0; i < 6; i++) {
-      skyDesc.DataFormat[i] = ImageDataFormat::RGB;
-      skyDesc.DataType[i] = ImageDataType::Float32;
-      skyDesc.DataPtr[i] = nullptr;
-    }
-    std::cout << "converting pillars_4k.hdr to cube map...";
-    skybox = GetContext().ConvertSphericalToCubemap(hdrDesc, skyDesc, GetApp().GetShaderLibPath());
+    auto hdr = envHandle.Get();
+    envHandle = {};
+    const auto& env = *hdr;
+    EnvironmentBakeOptions bakeOptions;
+    bakeOptions.SkyboxSize = 1024;
+    bakeOptions.PrefilterSize = 1024;
+    std::cout << "baking pillars_4k.hdr environment maps...";
+    auto maps = GetContext().BakeEnvironmentMaps(env, bakeOptions, GetApp().GetShaderLibPath());
+    skybox = maps.Skybox;
+    skyFilter = maps.Prefiltered;
     std::cout << "Done." << std::endl;
 
-    TextureCubeMapDescriptorOpenGL skyConvDesc;
-    skyConvDesc.Wrap = WrapMode::Clamp;
-    skyConvDesc.MinFilter = FilterMode::Bilinear;
-    skyConvDesc.MagFilter = FilterMode::Bilinear;
-    skyConvDesc.MipMapLevel = 0;
-    skyConvDesc.TextureFormat = PixelFormat::RGB32F;
-    skyConvDesc.Width = 64;
-    skyConvDesc.Height = 64;
-    for (int i = 0; i < 6; i++) {
-      skyConvDesc.DataFormat[i] = ImageDataFormat::RGB;
-      skyConvDesc.DataType[i] = ImageDataType::Float32;
-      skyConvDesc.DataPtr[i] = nullptr;
-    }
-    std::cout << "generating irradiance convolution for pillars_4k.hdr...";
-    skyConv = GetContext().GenIrradianceConvolutionCubemap(skybox, skyConvDesc, GetApp().GetShaderLibPath());
-    std::cout << "Done." << std::endl;
-
-    TextureCubeMapDescriptorOpenGL filterDesc;
-    filterDesc.Wrap = WrapMode::Clamp;
-    filterDesc.TextureFormat = PixelFormat::RGB32F;
-    filterDesc.Width = 1024;
-    filterDesc.Height = 1024;
-    for (int i = 0; i < 6; i++) {
-      filterDesc.DataFormat[i] = ImageDataFormat::RGB;
-      filterDesc.DataType[i] = ImageDataType::Float32;
-      filterDesc.DataPtr[i] = nullptr;
-    }
-    std::cout << "prefilter pillars_4k.hdr...";
-    skyFilter = GetContext().PrefilterEnvMap(skybox, filterDesc, GetApp().GetShaderLibPath());
+    //漫反射环境光用球谐代替卷积cubemap，低分辨率的cubemap已经足够
+    std::cout << "projecting pillars_4k.hdr to spherical harmonics...";
+    GetContext().SetGlobalIrradianceSH9(ProjectIrradianceSH9(ConvertEquirectToCubeMap(env, 64)));
     std::cout << "Done." << std::endl;
     maxLod = TextureOpenGL::CalcMipmapLevels(0, 512, true);
 
@@ -100,15 +58,13 @@ class PbrPass : public RenderPass {
     lutDesc.MagFilter = FilterMode::Bilinear;
     lutDesc.MipMapLevel = 0;
     lutDesc.TextureFormat = PixelFormat::RG32F;
-    lutDesc.Width = 1024;
-    lutDesc.Height = 1024;
-    lutDesc.DataFormat = ImageDataFormat::RG;
-    lutDesc.DataType = ImageDataType::Float32;
-    std::cout << "precompute brdf lut...";
-    brdfLut = GetContext().PrecomputeBrdfLut(lutDesc, GetApp().GetShaderLibPath());
+    std::cout << "bake brdf lut...";
+    auto lutData = BakeBrdfLut(BrdfLutType::SplitSum, 256, 256);
+    SetBrdfLutData(lutData, lutDesc);
+    brdfLut = GetContext().CreateTexture2D(lutDesc);
     std::cout << "Done." << std::endl;
 
-    GetApp().SetSharedObject("skybox", skyConv);
+    GetApp().SetSharedObject("skybox", skybox);
   }
 
   void OnPostStart() override {
@@ -121,7 +77,6 @@ class PbrPass : public RenderPass {
     SetViewportFullFrameBuffer();
     ActivePipelineConfig();
     ActiveProgram();
-    GetProgram()->UniformCubeMap("u_IrradianceMap", BindTexture(*skyConv));
     GetProgram()->UniformCubeMap("u_PrefilterMap", BindTexture(*skyFilter));
     GetProgram()->UniformTexture2D("u_BrdfLut", BindTexture(*brdfLut));
     GetProgram()->UniformInt("u_MaxLod", maxLod);
@@ -141,12 +96,12 @@ class PbrPass : public RenderPass {
   }
 
   std::shared_ptr<TextureOpenGL> skybox;
-  std::shared_ptr<TextureOpenGL> skyConv;
   std::shared_ptr<TextureOpenGL> skyFilter;
   std::shared_ptr<TextureOpenGL> brdfLut;
   std::shared_ptr<Sphere> spheres[25];
   Vector3f albedo{};
   int maxLod{};
+  AssetHandle<ImmutableHdrTexture> envHandle;
 };
 
 class SkyboxPass : public RenderPass {
@@ -19,15 +19,24 @@ class Sphere : public GameObject {
 
 class ColorPass : public RenderPass {
  public:
-  ColorPass() : RenderPass("Color Pass", 0) {}
+  ColorPass() : RenderPass("Color Pass", 0) {
+    auto& assets = GetApp().GetAssets();
+    auto file = GetApp().GetAssetPath() / "copper-rock1-bl";
+    bitmaps[0] = assets.RequestBitmap("albedo", file / "copper-rock1-alb.png", true);
+    bitmaps[1] = assets.RequestBitmap("normal", file / "copper-rock1-normal.png", true);
+    bitmaps[2] = assets.RequestBitmap("rough", file / "copper-rock1-rough.png", true);
+  }
 
   void OnStart() override {
     LoadProgram("pbr.vert", "pbr.frag", {POSITION(), TANGENT(), NORMAL(), TEXCOORD0()});
     auto& ctx = GetContext();
-    auto file = GetApp().GetAssetPath() / "copper-rock1-bl";
-    albedo = ctx.LoadBitmap2D(file / "copper-rock1-alb.png", WrapMode::Clamp, FilterMode::Bilinear, PixelFormat::RGB8);
-    normal = ctx.LoadBitmap2D(file / "copper-rock1-normal.png", WrapMode::Clamp, FilterMode::Bilinear, PixelFormat::RGB8);
-    rough = ctx.LoadBitmap2D(file / "copper-rock1-rough.png", WrapMode::Clamp, FilterMode::Bilinear, PixelFormat::RGB8);
+    std::shared_ptr<TextureOpenGL>* textures[] = {&albedo, &normal, &rough};
+    //法线对块压缩的误差比较敏感，保持未压缩
+    PixelFormat formats[] = {PixelFormat::BC1, PixelFormat::RGB8, PixelFormat::BC4};
+    for (size_t i = 0; i < 3; i++) {
+      *textures[i] = ctx.LoadBitmap2D(*bitmaps[i].Get(), WrapMode::Clamp, FilterMode::Bilinear, formats[i]);
+      bitmaps[i] = {};
+    }
     metallic = 0.5f;
   }
 
@@ -59,6 +68,7 @@ class ColorPass : public RenderPass {
   std::shared_ptr<TextureOpenGL> albedo;
   std::shared_ptr<TextureOpenGL> normal;
   std::shared_ptr<TextureOpenGL> rough;
+  AssetHandle<ImmutableBitmap> bitmaps[3];
   float metallic{};
 };
 
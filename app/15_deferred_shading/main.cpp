@@ -52,6 +52,7 @@ class Sphere : public GameObject {
   }
 
   std::shared_ptr<Renderable> sphere;
+  int lod{};
 };
 
 class Quad : public GameObject {
@@ -108,7 +109,8 @@ class GPass : public RenderPass {
       SetVertexBuffer(o->sphere->GetVbo(), GetVertexPosPNT());
       SetVertexBuffer(o->sphere->GetVbo(), GetVertexNormalPNT());
       SetIndexBuffer(o->sphere->GetIbo());
-      DrawIndexed(o->sphere->GetDrawCount(), 0);
+      o->lod = o->sphere->SelectLod(*GetCamera(), o->GetTransform(), 1080, o->lod);
+      o->sphere->DrawLod(*this, o->lod);
     }
     gbuffer->Frame->Unbind();
   }
@@ -161,6 +163,8 @@ int main(int argc, char** argv) {
   app.CreatePass<ShadePass>();
   app.CreateRenderable<RenderableSphere>("sphere", 0.5f, 32);
   app.CreateRenderable<RenderableQuad>("quad", 1.0f);
+  app.GetRenderable("sphere")->SetOptimizeMesh(true);
+  app.GetRenderable("sphere")->SetGenerateLod(true);
   for (int i = 0; i <= 1024; i++) {
     app.Instantiate<Sphere>(i, Vector3f{-10 + d(gen) * 20, -10 + d(gen) * 20, -10 + d(gen) * 20});
   }
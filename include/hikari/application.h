@@ -8,11 +8,15 @@
 #include <filesystem>
 #include <any>
 #include <chrono>
+#include <optional>
 
 #include <hikari/mathematics.h>
 #include <hikari/window.h>
 #include <hikari/render_context.h>
+#include <hikari/shader_variant.h>
 #include <hikari/asset.h>
+#include <hikari/asset_manager.h>
+#include <hikari/mesh.h>
 #include <hikari/camera.h>
 #include <hikari/input.h>
 
@@ -56,10 +60,14 @@ class GameObject {
   RenderContextOpenGL& GetContext();
 
   static void CreateVbo(const ImmutableModel& model, std::shared_ptr<BufferOpenGL>& vbo);
+  /**
+   * @param indexType 输出索引类型，与模型索引的宽度一致，绘制时传给 DrawIndexed
+   */
   static void CreateVboIbo(
       const ImmutableModel& model,
       std::shared_ptr<BufferOpenGL>& vbo,
-      std::shared_ptr<BufferOpenGL>& ibo);
+      std::shared_ptr<BufferOpenGL>& ibo,
+      IndexDataType& indexType);
 
  private:
   std::string _name;
@@ -112,6 +120,11 @@ class LightCollection {
   void SubmitData(RenderContextOpenGL& ctx) const;
   void Clear();
   std::vector<std::string> GetMacro() const;
+  /**
+   * @brief 灯光数量对应的着色器关键字。数量向上取到2的幂，灯光增减时需要编译的变体更少
+   */
+  std::vector<std::pair<std::string, std::string>> GetKeywords() const;
+  static std::vector<ShaderKeywordAxis> GetKeywordAxes();
 
  private:
   int _maxLight = 4096;
@@ -134,8 +147,33 @@ class Renderable {
   const std::shared_ptr<BufferOpenGL>& GetVbo() const { return _vbo; }
   const std::shared_ptr<BufferOpenGL>& GetIbo() const { return _ibo; }
   int GetDrawCount() const { return _drawCount; }
+  IndexDataType GetIndexType() const { return _indexType; }
   bool HasIbo() const;
   void Draw(RenderPass& pass) const;
+  /**
+   * @brief 创建缓冲前是否对模型做顶点缓存、过度绘制和顶点读取优化，需要在OnCreate之前设置
+   */
+  void SetOptimizeMesh(bool isOptimize) { _isOptimizeMesh = isOptimize; }
+  bool IsOptimizeMesh() const { return _isOptimizeMesh; }
+  const MeshOptimizeStats& GetOptimizeStats() const { return _optimizeStats; }
+  /**
+   * @brief 创建缓冲前是否生成LOD链，需要在OnCreate之前设置，只对带索引的缓冲有效
+   */
+  void SetGenerateLod(bool isGenerate) { _isGenerateLod = isGenerate; }
+  bool IsGenerateLod() const { return _isGenerateLod; }
+  /**
+   * @brief 设置屏幕空间误差阈值（像素），误差在阈值的 [1-hysteresis, 1+hysteresis] 内时保持当前级别，避免来回跳变
+   */
+  void SetLodThreshold(float pixelError, float hysteresis = 0.25f);
+  int GetLodCount() const { return int(_lods.size()); }
+  const MeshLod& GetLod(int lod) const { return _lods[lod]; }
+  /**
+   * @brief 按投影到屏幕上的误差选择LOD
+   * @param viewportHeight 视口高度（像素）
+   * @param currentLod 上一帧使用的级别
+   */
+  int SelectLod(const Camera& camera, const Transform& transform, int viewportHeight, int currentLod) const;
+  void DrawLod(RenderPass& pass, int lod) const;
 
  protected:
   void CreateVbo(const ImmutableModel& model);
@@ -144,9 +182,22 @@ class Renderable {
   void CreateVboIboWithTangent(const ImmutableModel& model);
 
  private:
+  const ImmutableModel& PrepareModel(const ImmutableModel& model, std::optional<ImmutableModel>& optimized);
+  void InitLod(const ImmutableModel& model);
+  void CreateLodIbo(const ImmutableModel& model);
+
   std::shared_ptr<BufferOpenGL> _vbo;
   std::shared_ptr<BufferOpenGL> _ibo;
+  IndexDataType _indexType{IndexDataType::UnsignedInt};
   int _drawCount{};
+  bool _isOptimizeMesh{};
+  MeshOptimizeStats _optimizeStats{};
+  bool _isGenerateLod{};
+  std::vector<MeshLod> _lods;
+  float _lodThreshold{1.0f};
+  float _lodHysteresis{0.25f};
+  Vector3f _boundsCenter{};
+  float _boundsRadius{};
 };
 
 class RenderableWithTangent : public Renderable {
@@ -242,9 +293,17 @@ class RenderPass : public IRenderPass {
   std::unique_ptr<Camera>& GetCamera();
   void SetProgram(const std::shared_ptr<ProgramOpenGL>& prog);
   void SetProgram(const std::string& vs, const std::string& fs, const ShaderAttributeLayouts& layouts);
+  /**
+   * @brief 加载着色器程序，灯光数量作为关键字维度，灯光数量变化时自动切换变体
+   */
   void LoadProgram(const std::filesystem::path& vsPath,
                    const std::filesystem::path& fsPath,
                    const ShaderAttributeLayouts& layouts);
+  void LoadProgram(const std::filesystem::path& vsPath,
+                   const std::filesystem::path& fsPath,
+                   const ShaderAttributeLayouts& layouts,
+                   const std::vector<ShaderKeywordAxis>& axes);
+  const std::shared_ptr<ShaderPermutation>& GetProgramPermutation() const;
   PipelineState& GetPipelineState();
   void SetPipelineState(const PipelineState& state);
 
@@ -256,14 +315,22 @@ class RenderPass : public IRenderPass {
   void SetIndexBuffer(const std::shared_ptr<BufferOpenGL>& ibo);
   uint32_t BindTexture(const TextureOpenGL& texture);
   void SetModelMatrix(const GameObject& go);
+  /**
+   * @brief 位置量化为UNORM16时，设置shader中还原位置用的 u_PositionOffset/u_PositionScale
+   */
+  void SetPositionDequantization(const PositionQuantization& quant);
   void Draw(int vertexCount, int vertexStart);
-  void DrawIndexed(int indexCount, int indexStart);
+  /**
+   * @param indexStart 起始索引的序号，按 type 换算成字节偏移
+   */
+  void DrawIndexed(int indexCount, int indexStart, IndexDataType type = IndexDataType::UnsignedInt);
 
  private:
   std::string _name;
   int _priority{};
   PipelineState _pipeState;
   std::shared_ptr<ProgramOpenGL> _prog;
+  std::shared_ptr<ShaderPermutation> _permutation;
   uint32_t _textureSlot{};
 };
 
@@ -291,6 +358,10 @@ class Application {
   MainCamera& GetCamera();
   const std::filesystem::path& GetAssetPath() const;
   const std::filesystem::path& GetShaderLibPath() const;
+  /**
+   * @brief 资源异步加载，在 Awake 之前发出请求可以让解码与窗口、GL初始化重叠
+   */
+  AssetManager& GetAssets();
   std::shared_ptr<GameObject> GetGameObject(const std::string& name);
   std::shared_ptr<IRenderPass> GetRenderPass(const std::string& name);
   std::any& GetSharedObject(const std::string& name);
@@ -312,6 +383,21 @@ class Application {
   void ParseArgs(int argc, char** argv);
   void AddRenderable(const std::string& name, const std::shared_ptr<Renderable>& renderable);
   void EnableImgui();
+  /**
+   * @brief 退出时输出每个着色器变体的预处理和编译耗时，默认关闭。也可以随时用 ShaderPermutation::GetStats 查询
+   */
+  void EnableShaderVariantStats();
+  /**
+   * @brief 注册着色器程序的变体，每帧按当前关键字把选中的变体写入 target。
+   * Awake 期间所有 OnStart 结束后才一起并行预处理再编译链接，所以 OnStart 里拿不到结果；其他时候立即加载
+   */
+  std::shared_ptr<ShaderPermutation> LoadProgram(const ShaderProgramRequest& base,
+                                                 const std::vector<ShaderKeywordAxis>& axes,
+                                                 std::shared_ptr<ProgramOpenGL>& target);
+  /**
+   * @brief 设置选择着色器变体用的关键字，灯光数量的关键字每帧自动更新
+   */
+  void SetShaderKeyword(const std::string& name, const std::string& value);
 
   template <class PassType, class... Args>
   void CreatePass(Args&&... args) {
@@ -359,6 +445,8 @@ class Application {
  private:
   Application();
   void UpdateTime();
+  void LoadPendingPrograms();
+  void UpdateProgramVariants();
 
   WindowCreateInfo _wdInfo;
   ContextOpenGLDescription _ctxDesc;
@@ -382,6 +470,11 @@ class Application {
   int64_t _frameTimer{};
   float _fps{};
   bool _canUseImgui{};
+  AssetManager _assets;
+  bool _isCollectingPrograms{};
+  bool _isPrintVariantStats{};
+  std::unordered_map<std::string, std::string> _shaderKeywords;
+  std::vector<std::pair<std::shared_ptr<ShaderPermutation>, std::shared_ptr<ProgramOpenGL>*>> _programVariants;
 };
 
 }  // namespace Hikari
\ No newline at end of file
@@ -3,9 +3,11 @@
 #include <string>
 #include <filesystem>
 #include <vector>
+#include <array>
 #include <memory>
 #include <stdexcept>
 
+#include <hikari/common.h>
 #include <hikari/mathematics.h>
 
 namespace Hikari {
@@ -35,8 +37,18 @@ class Asset : public std::enable_shared_from_this<Asset> {
      * @brief 释放资源
     */
   virtual void Release() = 0;
+  /**
+   * @brief CPU端数据占用的字节数，用于资源缓存的内存预算
+   */
+  virtual size_t GetByteSize() const = 0;
 };
 
+/**
+ * @brief 原地上下翻转图像的行，按固定大小的块交换，编译器会生成向量化的读写
+ * @param rowBytes 每行的字节数
+ */
+void FlipImageRows(void* data, size_t rowBytes, size_t rowCount);
+
 /**
   * @brief 8bit 位图
   */
@@ -57,6 +69,7 @@ class ImmutableBitmap : public Asset {
   const std::string& GetName() const override;
   bool IsValid() const override;
   void Release() override;
+  size_t GetByteSize() const override;
 
   int GetWidth() const;
   int GetHeight() const;
@@ -66,7 +79,25 @@ class ImmutableBitmap : public Asset {
   int GetChannel() const;
   const uint8_t* const GetData() const;
 
+  /**
+   * @brief 线程安全，翻转在解码后单独进行，不依赖stbi的全局翻转开关
+   */
   static bool LoadFromDisk(const std::string&, const std::filesystem::path&, bool filpY, ImmutableBitmap&);
+  /**
+   * @brief 在共享线程池上并行解码多张图片，names 与 paths 一一对应
+   * @return 任意一张失败时为false，失败的那张无效
+   */
+  static bool LoadFromDiskParallel(const std::vector<std::string>& names,
+                                   const std::vector<std::filesystem::path>& paths,
+                                   bool filpY,
+                                   std::vector<ImmutableBitmap>& result);
+  /**
+   * @brief 并行解码立方体贴图的六个面，顺序与 faces 相同，一般为 +X -X +Y -Y +Z -Z
+   */
+  static bool LoadCubeFaces(const std::filesystem::path& directory,
+                            const std::array<std::string, 6>& faces,
+                            bool filpY,
+                            std::array<ImmutableBitmap, 6>& result);
 
  private:
   std::string _name;
@@ -77,12 +108,34 @@ class ImmutableBitmap : public Asset {
 };
 
 /**
- * @brief 32bit HDR图片
+ * @brief HDR图片在内存中的存储格式
+ */
+enum class HdrStorage {
+  Float32,
+  /**
+   * @brief 每通道16位浮点，大于65504的值截断
+   */
+  Half,
+  /**
+   * @brief 共享指数，每像素一个uint32，只能表示非负的颜色
+   */
+  RGB9E5
+};
+
+/**
+ * @brief HDR图片
 */
 class ImmutableHdrTexture : public Asset {
  public:
   ImmutableHdrTexture() noexcept;
-  ImmutableHdrTexture(const std::string& name, const std::filesystem::path& path, bool isFilpY);
+  /**
+   * @param storage 紧凑格式时Radiance文件逐行解码并转换，不会产生完整的float图像；
+   * 其他格式先按float解码再转换
+   */
+  ImmutableHdrTexture(const std::string& name,
+                      const std::filesystem::path& path,
+                      bool isFilpY,
+                      HdrStorage storage = HdrStorage::Float32);
   ImmutableHdrTexture(const ImmutableHdrTexture&) = delete;
   ImmutableHdrTexture(ImmutableHdrTexture&&) noexcept;
   ImmutableHdrTexture& operator=(ImmutableHdrTexture&&) noexcept;
@@ -90,20 +143,153 @@ class ImmutableHdrTexture : public Asset {
   const std::string& GetName() const override;
   bool IsValid() const override;
   void Release() override;
+  size_t GetByteSize() const override;
 
   int GetWidth() const;
   int GetHeight() const;
   int GetChannel() const;
+  /**
+   * @brief 只在 HdrStorage::Float32 时有效，否则为空
+   */
   const float* const GetData() const;
+  HdrStorage GetStorage() const;
+  /**
+   * @brief 按 GetStorage 解释的像素数据
+   */
+  const void* GetRawData() const;
 
  private:
+  bool LoadRadianceCompact(const std::filesystem::path& path, bool isFilpY, HdrStorage storage);
+  void ConvertToCompact(HdrStorage storage);
+
   std::string _name;
   int _width{};
   int _height{};
   int _channelCount{};
   float* _data{nullptr};
+  HdrStorage _storage{HdrStorage::Float32};
+  std::vector<uint8_t> _compact;
+};
+
+/**
+ * @brief OBJ顶点(位置,法线,纹理坐标)索引三元组的去重表，开放寻址+线性探测
+ */
+class VertexDedupTable {
+ public:
+  /**
+   * @param indexCount 面索引总数，用于预分配容量
+   */
+  explicit VertexDedupTable(size_t indexCount);
+  /**
+   * @brief 查找三元组，不存在时以 next 插入
+   * @return 三元组对应的顶点序号，以及是否是新插入的
+   */
+  std::pair<uint32_t, bool> Insert(int p, int n, int t, uint32_t next);
+  size_t GetSize() const;
+  size_t GetMemoryBytes() const;
+  /**
+   * @brief 下一次插入是否会扩容。扩容时新旧两份槽同时存在，占用是当前的三倍
+   */
+  bool IsFull() const;
+  /**
+   * @brief 遍历所有三元组，func(p, n, t, value)，顺序不确定
+   */
+  template <typename Func>
+  void ForEach(Func&& func) const {
+    for (const auto& slot : _slots) {
+      if (slot.P >= 0) {
+        func(slot.P, slot.N, slot.T, slot.Value);
+      }
+    }
+  }
+
+ private:
+  struct Slot {
+    int P;
+    int N;
+    int T;
+    uint32_t Value;
+  };
+  void Grow();
+
+  std::vector<Slot> _slots;
+  size_t _mask{};
+  size_t _size{};
+};
+
+/**
+ * @brief OBJ面的一个角，分别索引位置、法线、纹理坐标，缺失为-1
+ */
+struct ObjCorner {
+  int P;
+  int N;
+  int T;
 };
 
+/**
+ * @brief OBJ解析结果，面已三角化
+ */
+struct ObjData {
+  std::vector<float> Positions;  //xyz
+  std::vector<float> Normals;    //xyz
+  std::vector<float> TexCoords;  //uv
+  std::vector<ObjCorner> Corners;
+};
+
+/**
+ * @brief 多线程解析OBJ。文件按行边界切分成块，每块独立解析 v/vn/vt/f 后合并，
+ * 多边形按扇形三角化，其余语句忽略
+ */
+bool ParseObjParallel(const std::filesystem::path& path, ObjData& data);
+
+/**
+ * @brief OBJ解析器
+ */
+enum class ModelImporter {
+  TinyObj,
+  Parallel,
+  /**
+   * @brief 按固定大小的窗口流式读取，顶点和索引直接写入最终的数组，内存占用有上限。
+   * 要求面引用的顶点在面之前定义
+   */
+  Streaming
+};
+
+/**
+ * @brief 模型导入统计
+ */
+struct ModelImportStats {
+  /**
+   * @brief 流式导入过程中追踪到的峰值内存（字节）
+   */
+  size_t PeakMemoryBytes = 0;
+};
+
+/**
+ * @brief 模型导入选项
+ */
+struct ModelImportOptions {
+  /**
+   * @brief 是否使用二进制网格缓存，缓存以源文件内容的哈希为键
+   */
+  bool UseCache = true;
+  ModelImporter Importer = ModelImporter::Parallel;
+  /**
+   * @brief 流式导入的读取窗口大小（字节）
+   */
+  size_t StreamWindowSize = 4 << 20;
+  /**
+   * @brief 流式导入的峰值内存上限（字节），0表示不限制。预计或实际超出时导入失败
+   */
+  size_t MemoryLimit = 0;
+  /**
+   * @brief 非空时写入导入统计
+   */
+  ModelImportStats* Stats = nullptr;
+};
+
+struct TangentSplit;
+
 /**
   * @brief 模型
   */
@@ -120,13 +306,13 @@ class ImmutableModel : public Asset {
                  std::vector<Vector3f>&& pos,
                  std::vector<Vector3f>&& nor,
                  std::vector<Vector2f>&& tex,
-                 std::vector<size_t>&& ind) noexcept;
+                 std::vector<uint32_t>&& ind) noexcept;
   ImmutableModel(const std::string& name,
                  std::vector<Vector3f>&& pos,
                  std::vector<Vector3f>&& nor,
                  std::vector<Vector2f>&& tex,
                  std::vector<Vector4f>&& tan,
-                 std::vector<size_t>&& ind) noexcept;
+                 std::vector<uint32_t>&& ind) noexcept;
   ImmutableModel(const ImmutableModel&) = delete;
   ImmutableModel(ImmutableModel&&) noexcept;
   ImmutableModel& operator=(ImmutableModel&&) noexcept;
@@ -134,12 +320,22 @@ class ImmutableModel : public Asset {
   const std::string& GetName() const override;
   bool IsValid() const override;
   void Release() override;
+  size_t GetByteSize() const override;
 
-  const std::vector<Vector3f>& GetPosition() const;
-  const std::vector<Vector3f>& GetNormals() const;
-  const std::vector<Vector2f>& GetTexCoords() const;
-  const std::vector<Vector4f>& GetTangents() const;
-  const std::vector<size_t>& GetIndices() const;
+  ArrayView<Vector3f> GetPosition() const;
+  ArrayView<Vector3f> GetNormals() const;
+  ArrayView<Vector2f> GetTexCoords() const;
+  ArrayView<Vector4f> GetTangents() const;
+  /**
+   * @brief 顶点数量不超过65536时索引以16位存储，否则为32位
+   */
+  IndexArrayView GetIndices() const;
+  IndexFormat GetIndexFormat() const;
+  /**
+   * @brief 包围盒
+   */
+  const Vector3f& GetBoundsMin() const;
+  const Vector3f& GetBoundsMax() const;
   /**
     * @brief 是否存在法线
     */
@@ -156,18 +352,58 @@ class ImmutableModel : public Asset {
   size_t GetIndexCount() const;
   size_t GetTriangleCount() const;
 
-  static bool LoadFromFile(const std::string&, const std::filesystem::path&, ImmutableModel&);
+  /**
+   * @brief 写入二进制网格缓存
+   * @param sourceHash 源文件内容的哈希
+   */
+  bool SaveToCache(const std::filesystem::path& cachePath, uint64_t sourceHash) const;
+
+  static bool LoadFromFile(const std::string&, const std::filesystem::path&, ImmutableModel&, const ModelImportOptions& options = ModelImportOptions());
+  /**
+   * @brief 内存映射二进制网格缓存，数据直接指向映射的文件，不做解析和复制
+   * @param sourceHash 与缓存中记录的源文件哈希不一致时加载失败
+   */
+  static bool LoadFromCache(const std::string&, const std::filesystem::path& cachePath, uint64_t sourceHash, ImmutableModel&);
+  /**
+   * @brief 源文件哈希对应的缓存路径
+   */
+  static std::filesystem::path GetCachePath(uint64_t sourceHash);
   static ImmutableModel CreateSphere(const std::string& name, float radius, int numberSlices);
   static ImmutableModel CreateCube(const std::string& name, float halfExtend);
   static ImmutableModel CreateQuad(const std::string& name, float halfExtend, float offset = 0);
 
  private:
+  static bool LoadFromObj(const std::string&, const std::filesystem::path&, ModelImporter, ImmutableModel&);
+  static bool LoadFromObjStreaming(const std::string&, const std::filesystem::path&, const ModelImportOptions&, ImmutableModel&);
+  template <typename ForEachCorner>
+  static bool BuildFromObj(const std::string&,
+                           ArrayView<float> pos,
+                           ArrayView<float> nor,
+                           ArrayView<float> tex,
+                           size_t indexCount,
+                           ForEachCorner&& forEach,
+                           ImmutableModel&);
+  void CalcTangents();
+  void SplitVertices(const TangentSplit& split);
+  void NarrowIndices();
+  void BindViews();
+  void CalcBounds();
+
   std::vector<Vector3f> _positions;
   std::vector<Vector3f> _normals;
   std::vector<Vector2f> _texcoords;
   std::vector<Vector4f> _tangent;
-  std::vector<size_t> _indices;
+  std::vector<uint32_t> _indices;
+  std::vector<uint16_t> _indices16;
   std::string _name;
+  MappedFile _mapped;
+  ArrayView<Vector3f> _positionView;
+  ArrayView<Vector3f> _normalView;
+  ArrayView<Vector2f> _texcoordView;
+  ArrayView<Vector4f> _tangentView;
+  IndexArrayView _indexView;
+  Vector3f _boundsMin;
+  Vector3f _boundsMax;
 };
 
 class ImmutableText : public Asset {
@@ -178,6 +414,7 @@ class ImmutableText : public Asset {
   const std::string& GetName() const override;
   bool IsValid() const override;
   void Release() override;
+  size_t GetByteSize() const override;
 
   const std::string& GetText() const;
 
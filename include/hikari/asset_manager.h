@@ -0,0 +1,193 @@
+#pragma once
+
+#include <string>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+#include <hikari/asset.h>
+#include <hikari/parallel.h>
+
+namespace Hikari {
+class AssetManager;
+
+/**
+ * @brief 异步加载的资源句柄，只记录资源在管理器中的键，同一个资源的多次请求共享一次加载。
+ * 资源被淘汰后再次 Get 会透明地重新加载，句柄不能比管理器活得更久
+ */
+template <typename T>
+class AssetHandle {
+ public:
+  AssetHandle() noexcept = default;
+  AssetHandle(AssetManager* manager, const std::string& key) : _manager(manager), _key(key) {}
+
+  /**
+   * @brief 是否关联了一个资源
+   */
+  bool IsValid() const { return _manager != nullptr; }
+  /**
+   * @brief 资源是否已经常驻内存或者加载已经结束（成功或失败），不阻塞
+   */
+  bool IsReady() const;
+  void Wait() const;
+  /**
+   * @brief 阻塞到解码结束，并标记为最近使用。加载失败时重新抛出加载时的异常
+   */
+  std::shared_ptr<T> Get() const;
+  /**
+   * @brief 固定的资源不会被淘汰，可以嵌套调用
+   */
+  void Pin() const;
+  void Unpin() const;
+
+ private:
+  AssetManager* _manager{nullptr};
+  std::string _key;
+};
+
+/**
+ * @brief 资源缓存的内存统计
+ */
+struct AssetMemoryStats {
+  /**
+   * @brief 内存预算（字节），0表示不限制
+   */
+  size_t Budget = 0;
+  /**
+   * @brief 当前常驻资源的字节数
+   */
+  size_t Usage = 0;
+  /**
+   * @brief 常驻资源字节数的峰值
+   */
+  size_t Peak = 0;
+  size_t ResidentCount = 0;
+  size_t EvictCount = 0;
+  /**
+   * @brief 被淘汰后又重新加载的次数
+   */
+  size_t ReloadCount = 0;
+};
+
+/**
+ * @brief 在工作线程上解码资源，按类型和路径去重。只做CPU端的解码，
+ * 上传GPU由调用者在拿到结果后在GL线程上完成。
+ * 常驻资源按 Asset::GetByteSize 计入内存预算，超出时按最近最少使用的顺序淘汰没有固定、
+ * 也没有在外部被持有的资源（外部持有时释放不了内存）。加载完还没有被 Get 取走的资源不会被淘汰
+ */
+class AssetManager {
+ public:
+  /**
+   * @param threadCount 工作线程数量，0表示使用硬件线程数
+   */
+  explicit AssetManager(size_t threadCount = 0);
+  AssetManager(const AssetManager&) = delete;
+  /**
+   * @brief 等待已提交的加载全部结束
+   */
+  ~AssetManager() noexcept;
+
+  /**
+   * @brief 同一路径、影响导入结果的选项也相同时直接返回之前的句柄，名字以第一次请求为准。
+   * 选项不同的请求各自加载；Stats 只由实际执行的那次加载写入
+   */
+  AssetHandle<ImmutableModel> RequestModel(const std::string& name,
+                                           const std::filesystem::path& path,
+                                           const ModelImportOptions& options = ModelImportOptions());
+  AssetHandle<ImmutableBitmap> RequestBitmap(const std::string& name, const std::filesystem::path& path, bool isFlipY);
+  /**
+   * @brief 不同存储格式的请求各自缓存
+   */
+  AssetHandle<ImmutableHdrTexture> RequestHdrTexture(const std::string& name,
+                                                     const std::filesystem::path& path,
+                                                     bool isFlipY,
+                                                     HdrStorage storage = HdrStorage::Float32);
+  /**
+   * @brief 等待所有已提交的加载结束，不抛出加载失败的异常
+   */
+  void WaitAll();
+  /**
+   * @brief 已请求的不同资源数量
+   */
+  size_t GetRequestCount();
+  /**
+   * @brief 设置内存预算（字节），0表示不限制。立即淘汰超出的部分
+   */
+  void SetMemoryBudget(size_t bytes);
+  AssetMemoryStats GetMemoryStats();
+  /**
+   * @brief 释放所有没有固定的常驻资源，不考虑预算。句柄仍然有效，下次访问时重新加载
+   */
+  void Clear();
+
+ private:
+  template <typename>
+  friend class AssetHandle;
+
+  struct Entry {
+    std::function<std::shared_ptr<Asset>()> Load;
+    std::shared_future<void> Future;
+    std::shared_ptr<Asset> Resident;
+    size_t ByteSize = 0;
+    size_t LoadCount = 0;
+    int PinCount = 0;
+    /**
+     * @brief 加载完成后是否被 Get 取走过。还没取走的资源不参与淘汰，否则会被反复解码
+     */
+    bool IsAcquiredSinceLoad = false;
+    /**
+     * @brief 在 _lru 中的位置，只在常驻时有效
+     */
+    std::list<std::string>::iterator LruIter;
+  };
+
+  template <typename T>
+  AssetHandle<T> Request(const std::string& key, std::function<std::shared_ptr<Asset>()>&& load);
+  std::shared_ptr<Asset> Acquire(const std::string& key);
+  bool IsReady(const std::string& key);
+  void Wait(const std::string& key);
+  void Pin(const std::string& key, int delta);
+  /**
+   * @brief 提交加载任务，调用时必须持有 _mutex
+   */
+  void SubmitLoad(const std::string& key, Entry& entry);
+  void OnLoaded(const std::string& key, std::shared_ptr<Asset>&& asset);
+  /**
+   * @brief 淘汰到预算以内。调用时必须持有 _mutex
+   */
+  void EvictToBudget();
+  void Evict(Entry& entry);
+  void ReleaseEntry(Entry& entry);
+  static std::string MakeKey(const char* type, const std::filesystem::path& path);
+
+  std::mutex _mutex;
+  std::unordered_map<std::string, Entry> _entries;
+  /**
+   * @brief 常驻资源的键，头部是最近使用的
+   */
+  std::list<std::string> _lru;
+  AssetMemoryStats _stats;
+  //最后声明，析构时先等待工作线程结束
+  ThreadPool _pool;
+};
+
+template <typename T>
+bool AssetHandle<T>::IsReady() const { return _manager->IsReady(_key); }
+
+template <typename T>
+void AssetHandle<T>::Wait() const { _manager->Wait(_key); }
+
+template <typename T>
+std::shared_ptr<T> AssetHandle<T>::Get() const { return std::static_pointer_cast<T>(_manager->Acquire(_key)); }
+
+template <typename T>
+void AssetHandle<T>::Pin() const { _manager->Pin(_key, 1); }
+
+template <typename T>
+void AssetHandle<T>::Unpin() const { _manager->Pin(_key, -1); }
+
+}  // namespace Hikari
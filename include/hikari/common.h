@@ -1,5 +1,13 @@
 #pragma once
 
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <filesystem>
+
 //HIKARI_EXPORT宏，用于导出符号
 #if defined(HIKARI_EXPORT)
 #error "multiple define HIKARI_EXPORT!"
@@ -18,4 +26,168 @@
 #endif  // defined(HIKARI_EXPORT)
 
 namespace Hikari {
-}  // namespace Hikari
\ No newline at end of file
+/**
+ * @brief 只读的连续内存视图，不持有数据
+ */
+template <typename T>
+class ArrayView {
+ public:
+  constexpr ArrayView() noexcept = default;
+  constexpr ArrayView(const T* data, size_t size) noexcept : _data(data), _size(size) {}
+  ArrayView(const std::vector<T>& vec) noexcept : _data(vec.data()), _size(vec.size()) {}
+
+  constexpr const T& operator[](size_t i) const {
+    assert(i < _size);
+    return _data[i];
+  }
+  constexpr const T* data() const noexcept { return _data; }
+  constexpr size_t size() const noexcept { return _size; }
+  constexpr bool empty() const noexcept { return _size == 0; }
+  constexpr const T* begin() const noexcept { return _data; }
+  constexpr const T* end() const noexcept { return _data + _size; }
+
+ private:
+  const T* _data{nullptr};
+  size_t _size{};
+};
+
+/**
+ * @brief 索引的存储宽度
+ */
+enum class IndexFormat {
+  UInt16,
+  UInt32
+};
+/**
+ * @brief 顶点数量允许时选择16位索引
+ */
+constexpr IndexFormat ChooseIndexFormat(size_t vertexCount) {
+  return vertexCount <= 0x10000 ? IndexFormat::UInt16 : IndexFormat::UInt32;
+}
+constexpr size_t SizeOfIndexFormat(IndexFormat format) {
+  return format == IndexFormat::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+/**
+ * @brief 16位或32位索引的只读视图，读出的值统一为uint32_t
+ */
+class IndexArrayView {
+ public:
+  class Iterator {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = uint32_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = uint32_t;
+
+    constexpr Iterator(const void* data, IndexFormat format, size_t i) noexcept : _data(data), _format(format), _i(i) {}
+    uint32_t operator*() const { return Read(_data, _format, _i); }
+    uint32_t operator[](difference_type n) const { return Read(_data, _format, _i + n); }
+    constexpr Iterator& operator++() noexcept { _i++; return *this; }
+    constexpr Iterator operator++(int) noexcept { return Iterator(_data, _format, _i++); }
+    constexpr Iterator& operator--() noexcept { _i--; return *this; }
+    constexpr Iterator operator--(int) noexcept { return Iterator(_data, _format, _i--); }
+    constexpr Iterator& operator+=(difference_type n) noexcept { _i += n; return *this; }
+    constexpr Iterator& operator-=(difference_type n) noexcept { _i -= n; return *this; }
+    constexpr Iterator operator+(difference_type n) const noexcept { return Iterator(_data, _format, _i + n); }
+    constexpr Iterator operator-(difference_type n) const noexcept { return Iterator(_data, _format, _i - n); }
+    constexpr difference_type operator-(const Iterator& o) const noexcept { return difference_type(_i) - difference_type(o._i); }
+    constexpr bool operator==(const Iterator& o) const noexcept { return _i == o._i; }
+    constexpr bool operator!=(const Iterator& o) const noexcept { return _i != o._i; }
+    constexpr bool operator<(const Iterator& o) const noexcept { return _i < o._i; }
+    constexpr bool operator>(const Iterator& o) const noexcept { return _i > o._i; }
+    constexpr bool operator<=(const Iterator& o) const noexcept { return _i <= o._i; }
+    constexpr bool operator>=(const Iterator& o) const noexcept { return _i >= o._i; }
+
+   private:
+    //迭代器不引用视图本身，视图是临时对象时也可以使用
+    const void* _data;
+    IndexFormat _format;
+    size_t _i;
+  };
+
+  constexpr IndexArrayView() noexcept = default;
+  constexpr IndexArrayView(ArrayView<uint16_t> view) noexcept : _data(view.data()), _size(view.size()), _format(IndexFormat::UInt16) {}
+  constexpr IndexArrayView(ArrayView<uint32_t> view) noexcept : _data(view.data()), _size(view.size()), _format(IndexFormat::UInt32) {}
+  IndexArrayView(const std::vector<uint16_t>& vec) noexcept : IndexArrayView(ArrayView<uint16_t>(vec)) {}
+  IndexArrayView(const std::vector<uint32_t>& vec) noexcept : IndexArrayView(ArrayView<uint32_t>(vec)) {}
+
+  uint32_t operator[](size_t i) const {
+    assert(i < _size);
+    return Read(_data, _format, i);
+  }
+  constexpr const void* data() const noexcept { return _data; }
+  constexpr size_t size() const noexcept { return _size; }
+  constexpr bool empty() const noexcept { return _size == 0; }
+  constexpr Iterator begin() const noexcept { return Iterator(_data, _format, 0); }
+  constexpr Iterator end() const noexcept { return Iterator(_data, _format, _size); }
+  constexpr IndexFormat GetFormat() const noexcept { return _format; }
+  constexpr size_t GetByteSize() const noexcept { return _size * SizeOfIndexFormat(_format); }
+  /**
+   * @brief 格式不对时返回空视图
+   */
+  ArrayView<uint16_t> AsUInt16() const noexcept {
+    return _format == IndexFormat::UInt16 ? ArrayView<uint16_t>(static_cast<const uint16_t*>(_data), _size) : ArrayView<uint16_t>();
+  }
+  ArrayView<uint32_t> AsUInt32() const noexcept {
+    return _format == IndexFormat::UInt32 ? ArrayView<uint32_t>(static_cast<const uint32_t*>(_data), _size) : ArrayView<uint32_t>();
+  }
+
+ private:
+  static uint32_t Read(const void* data, IndexFormat format, size_t i) {
+    return format == IndexFormat::UInt16 ? static_cast<const uint16_t*>(data)[i] : static_cast<const uint32_t*>(data)[i];
+  }
+
+  const void* _data{nullptr};
+  size_t _size{};
+  IndexFormat _format{IndexFormat::UInt32};
+};
+
+/**
+ * @brief 只读内存映射文件
+ */
+class MappedFile {
+ public:
+  MappedFile() noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&&) noexcept;
+  MappedFile& operator=(MappedFile&&) noexcept;
+  ~MappedFile() noexcept;
+
+  bool Open(const std::filesystem::path& path);
+  void Close();
+  bool IsOpen() const;
+  const uint8_t* GetData() const;
+  size_t GetSize() const;
+
+ private:
+  const uint8_t* _data{nullptr};
+  size_t _size{};
+#if defined(_WIN32)
+  void* _file{nullptr};
+  void* _mapping{nullptr};
+#else
+  int _fd{-1};
+#endif
+};
+
+/**
+ * @brief 64位非加密哈希（xxHash64）
+ */
+uint64_t Hash64(const void* data, size_t size, uint64_t seed = 0);
+/**
+ * @brief 计算文件内容的哈希
+ */
+bool HashFileContent(const std::filesystem::path& path, uint64_t& hash);
+/**
+ * @brief 64位整数转16进制字符串，用作缓存文件名
+ */
+std::string ToHexString(uint64_t value);
+/**
+ * @brief 磁盘缓存根目录，默认为工作目录下的HikariCache
+ */
+const std::filesystem::path& GetCacheDirectory();
+void SetCacheDirectory(const std::filesystem::path& path);
+
+}  // namespace Hikari
@@ -0,0 +1,369 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <array>
+
+#include <hikari/common.h>
+#include <hikari/asset.h>
+
+namespace Hikari {
+enum class MipFilter {
+  /**
+   * @brief 按源像素覆盖面积加权平均，尺寸为奇数时也不会偏移
+   */
+  Box,
+  /**
+   * @brief Kaiser窗口的sinc，更锐利，负瓣可能让结果超出源数据的范围
+   */
+  Kaiser
+};
+
+enum class MipDataType {
+  UInt8,
+  Float32
+};
+
+/**
+ * @brief CPU生成mipmap的参数
+ */
+struct MipGenerateOptions {
+  MipFilter Filter = MipFilter::Box;
+  /**
+   * @brief 8位数据按sRGB解码到线性空间后再平均，alpha通道保持线性。对浮点数据无效
+   */
+  bool IsSrgb = false;
+  /**
+   * @brief 采样超出边界时环绕，否则取边缘像素
+   */
+  bool IsWrap = false;
+  /**
+   * @brief 包括第0级在内的级数上限，0表示生成到1x1
+   */
+  int MaxLevelCount = 0;
+  /**
+   * @brief Kaiser窗口的半宽（以目标像素为单位）和形状参数
+   */
+  float KaiserWidth = 3.0f;
+  float KaiserAlpha = 4.0f;
+  /**
+   * @brief 按源数据和参数的哈希缓存到磁盘
+   */
+  bool UseCache = true;
+};
+
+/**
+ * @brief 第1级开始的mip链，第0级是源图像，不保存。每级的格式与源图像相同，行之间没有填充
+ */
+class MipChain {
+ public:
+  MipChain() noexcept = default;
+
+  bool IsValid() const;
+  /**
+   * @brief 包括第0级在内的级数
+   */
+  int GetLevelCount() const;
+  int GetWidth(int level) const;
+  int GetHeight(int level) const;
+  int GetChannel() const;
+  MipDataType GetDataType() const;
+  /**
+   * @param level 范围 [1, GetLevelCount())
+   */
+  const void* GetLevelData(int level) const;
+  size_t GetLevelByteSize(int level) const;
+  /**
+   * @brief 第1级开始每一级的数据指针，可以直接作为纹理描述的预计算mipmap
+   */
+  std::vector<const void*> GetLevelPointers() const;
+  size_t GetByteSize() const;
+
+ private:
+  friend MipChain GenerateMipChain(const void*, int, int, int, MipDataType, const MipGenerateOptions&);
+  void Allocate(int width, int height, int channel, MipDataType type, int levelCount);
+  bool SaveToCache(const std::filesystem::path& cachePath, uint64_t key) const;
+  bool LoadFromCache(const std::filesystem::path& cachePath, uint64_t key);
+
+  int _width{};
+  int _height{};
+  int _channel{};
+  MipDataType _type{MipDataType::UInt8};
+  int _levelCount{};
+  /**
+   * @brief 第 i 级在 _data 中的偏移，_offsets[0]无意义
+   */
+  std::vector<size_t> _offsets;
+  std::vector<uint8_t> _data;
+};
+
+/**
+ * @brief 在CPU上生成mip链，每一级由上一级的线性浮点结果按行并行滤波，避免多次量化的误差累积。
+ * 级数和每级尺寸与OpenGL一致（每级长宽减半向下取整，最小为1）
+ * @param data 紧密排列的源图像
+ */
+MipChain GenerateMipChain(const void* data,
+                          int width,
+                          int height,
+                          int channel,
+                          MipDataType type,
+                          const MipGenerateOptions& options = MipGenerateOptions());
+
+/**
+ * @brief 块压缩格式，每块4x4像素
+ */
+enum class BlockFormat {
+  /**
+   * @brief RGB，每块8字节，不使用1位alpha模式
+   */
+  BC1,
+  /**
+   * @brief BC1的颜色加BC4的alpha，每块16字节
+   */
+  BC3,
+  /**
+   * @brief 单通道，每块8字节
+   */
+  BC4,
+  /**
+   * @brief 两个BC4，常用于法线的XY，每块16字节
+   */
+  BC5,
+  /**
+   * @brief 无符号半精度HDR，每块16字节。编码器只使用模式11（单区域，10位端点，4位索引）
+   */
+  BC6H
+};
+
+size_t GetBlockByteSize(BlockFormat format);
+/**
+ * @brief 一级的字节数，长宽向上取整到4的倍数
+ */
+size_t CalcBlockCompressedSize(BlockFormat format, int width, int height);
+
+struct BlockCompressOptions {
+  /**
+   * @brief 颜色是sRGB数据，mipmap按线性空间平均，上传时使用sRGB纹理格式。只对BC1和BC3有效
+   */
+  bool IsSrgb = false;
+  bool GenerateMips = true;
+  /**
+   * @brief 生成mipmap的参数，IsSrgb 和 UseCache 以外层为准
+   */
+  MipGenerateOptions Mip;
+  /**
+   * @brief 按源数据和参数的哈希把压缩结果缓存为DDS
+   */
+  bool UseCache = true;
+};
+
+/**
+ * @brief CPU端的块压缩纹理，包括所有mip级别
+ */
+class CompressedTexture {
+ public:
+  CompressedTexture() noexcept = default;
+
+  bool IsValid() const;
+  BlockFormat GetFormat() const;
+  bool IsSrgb() const;
+  int GetLevelCount() const;
+  int GetWidth(int level) const;
+  int GetHeight(int level) const;
+  const void* GetLevelData(int level) const;
+  size_t GetLevelByteSize(int level) const;
+  size_t GetByteSize() const;
+  /**
+   * @brief 写为带DX10扩展头的DDS
+   */
+  bool SaveToDds(const std::filesystem::path& path) const;
+
+  /**
+   * @brief 只支持2D纹理，BC1/BC3/BC4/BC5/BC6H_UF16，FourCC和DX10两种头
+   */
+  static bool LoadFromDds(const std::filesystem::path& path, CompressedTexture& texture);
+  /**
+   * @brief 只支持2D纹理、没有超压缩的KTX2
+   */
+  static bool LoadFromKtx2(const std::filesystem::path& path, CompressedTexture& texture);
+  /**
+   * @brief 按文件头判断是DDS还是KTX2
+   */
+  static bool LoadFromFile(const std::filesystem::path& path, CompressedTexture& texture);
+
+ private:
+  friend CompressedTexture CompressTexture(const void*, int, int, int, MipDataType, BlockFormat, const BlockCompressOptions&);
+  void Allocate(BlockFormat format, bool isSrgb, int width, int height, int levelCount);
+  bool SaveToDds(const std::filesystem::path& path, uint64_t key) const;
+  bool LoadDds(const std::filesystem::path& path, uint64_t* key);
+
+  BlockFormat _format{BlockFormat::BC1};
+  bool _isSrgb{};
+  int _width{};
+  int _height{};
+  int _levelCount{};
+  std::vector<size_t> _offsets;
+  std::vector<uint8_t> _data;
+};
+
+/**
+ * @brief 多线程块压缩，按块行切分任务
+ * @param data BC1/BC3/BC4/BC5 需要8位数据，BC6H 需要浮点数据，缺少的通道按灰度或不透明补齐
+ * @return 输入不支持时返回无效的纹理
+ */
+CompressedTexture CompressTexture(const void* data,
+                                  int width,
+                                  int height,
+                                  int channel,
+                                  MipDataType type,
+                                  BlockFormat format,
+                                  const BlockCompressOptions& options = BlockCompressOptions());
+/**
+ * @brief 解压一级数据。BC1/BC3输出RGBA8，BC4输出R8，BC5输出RG8，BC6H输出RGB浮点。
+ * 可用于不支持对应压缩格式时的回退
+ * @return BC6H遇到模式11以外的块时返回false
+ */
+bool DecompressBlocks(const void* blocks, BlockFormat format, int width, int height, void* output);
+
+/**
+ * @brief 六个面的RGB浮点图像，面的顺序与 GL_TEXTURE_CUBE_MAP_POSITIVE_X + i 一致，每个面紧密排列
+ */
+class CubeMapImage {
+ public:
+  CubeMapImage() noexcept = default;
+
+  bool IsValid() const;
+  int GetSize() const;
+  int GetChannel() const;
+  const float* GetFaceData(int face) const;
+  size_t GetFaceByteSize() const;
+  size_t GetByteSize() const;
+
+ private:
+  friend CubeMapImage ConvertEquirectToCubeMap(const void*, int, int, int, HdrStorage, int);
+  void Allocate(int size);
+
+  int _size{};
+  std::vector<float> _data;
+};
+
+/**
+ * @brief 带mip的RGB半精度cubemap，用于把GPU烘焙的环境贴图保存到磁盘。
+ * 第 level 级的边长是 max(1, size >> level)，每级六个面依次紧密排列
+ */
+class BakedCubeMap {
+ public:
+  BakedCubeMap() noexcept = default;
+
+  void Allocate(int size, int levelCount);
+  bool IsValid() const;
+  int GetSize(int level) const;
+  int GetLevelCount() const;
+  void* GetFaceData(int level, int face);
+  const void* GetFaceData(int level, int face) const;
+  size_t GetFaceByteSize(int level) const;
+  size_t GetByteSize() const;
+  /**
+   * @param key 写入文件头，读取时必须一致
+   */
+  bool SaveToFile(const std::filesystem::path& path, uint64_t key) const;
+  bool LoadFromFile(const std::filesystem::path& path, uint64_t key);
+
+ private:
+  int _size{};
+  int _levelCount{};
+  std::vector<size_t> _offsets;
+  std::vector<uint16_t> _data;
+};
+
+/**
+ * @brief 在CPU上把等距柱状投影的全景图转换为cubemap，不需要GPU。
+ * 映射与 SphericalToCubeMap.frag 相同，对全景图双线性采样，水平方向环绕，竖直方向取边缘。
+ * 六个面的行一起切分给多个线程
+ * @param data 按 storage 解释的像素，Float32 时通道数为3或4，其他格式只能是3
+ * @param faceSize 每个面的边长
+ */
+CubeMapImage ConvertEquirectToCubeMap(const void* data, int width, int height, int channel, HdrStorage storage, int faceSize);
+CubeMapImage ConvertEquirectToCubeMap(const ImmutableHdrTexture& hdr, int faceSize);
+
+/**
+ * @brief 环境光辐照度的三阶球谐（9个系数）。系数已经乘上基函数的常数和余弦卷积，再除以PI，
+ * 与卷积cubemap的结果一致，计算方式见 EvaluateIrradianceSH9
+ */
+struct IrradianceSH9 {
+  std::array<Vector3f, 9> Coefficients{};
+};
+
+/**
+ * @brief 把cubemap按纹素立体角投影到球谐，六个面的行并行累加
+ */
+IrradianceSH9 ProjectIrradianceSH9(const CubeMapImage& cube);
+/**
+ * @param faces 六个面的RGB浮点数据，面的顺序与 GL_TEXTURE_CUBE_MAP_POSITIVE_X + i 一致
+ */
+IrradianceSH9 ProjectIrradianceSH9(const float* const faces[6], int size, int channel);
+/**
+ * @brief 与 HikariEnvironment.glsl 的 GetIrradianceSH 相同，n 是单位向量
+ */
+Vector3f EvaluateIrradianceSH9(const IrradianceSH9& sh, const Vector3f& n);
+
+enum class BrdfLutType {
+  /**
+   * @brief 与 BrdfLut.frag 相同，两个通道，分别是F0的系数和偏移
+   */
+  SplitSum,
+  /**
+   * @brief 与 BrdfLutMultiScattering.frag 相同，三个通道，前两个是镜面反射的积分，第三个是漫反射的积分
+   */
+  MultiScattering
+};
+
+struct BrdfLutOptions {
+  /**
+   * @brief 镜面反射部分每个纹素的GGX重要性采样数
+   */
+  int SampleCount = 2048;
+  /**
+   * @brief 漫反射部分每个纹素的余弦采样数，只对 MultiScattering 有效
+   */
+  int DiffuseSampleCount = 128;
+  /**
+   * @brief 按尺寸和参数的哈希缓存到磁盘
+   */
+  bool UseCache = true;
+};
+
+/**
+ * @brief CPU端的BRDF查询表，浮点数据紧密排列。横轴是 NdotV，纵轴是粗糙度，第0行对应纹理坐标 v 最小的一行
+ */
+class BrdfLut {
+ public:
+  BrdfLut() noexcept = default;
+
+  bool IsValid() const;
+  BrdfLutType GetType() const;
+  int GetWidth() const;
+  int GetHeight() const;
+  int GetChannel() const;
+  const float* GetData() const;
+  size_t GetByteSize() const;
+
+ private:
+  friend BrdfLut BakeBrdfLut(BrdfLutType, int, int, const BrdfLutOptions&);
+  void Allocate(BrdfLutType type, int width, int height);
+  bool SaveToCache(const std::filesystem::path& cachePath, uint64_t key) const;
+  bool LoadFromCache(const std::filesystem::path& cachePath, uint64_t key);
+
+  BrdfLutType _type{BrdfLutType::SplitSum};
+  int _width{};
+  int _height{};
+  std::vector<float> _data;
+};
+
+/**
+ * @brief 在CPU上积分split sum查询表，与GPU版本使用相同的Hammersley序列和GGX重要性采样，
+ * 在纹素中心取值。按行并行，每一行的半程向量只计算一次
+ */
+BrdfLut BakeBrdfLut(BrdfLutType type, int width, int height, const BrdfLutOptions& options = BrdfLutOptions());
+
+}  // namespace Hikari
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+#include <hikari/common.h>
+#include <hikari/mathematics.h>
+#include <hikari/asset.h>
+
+namespace Hikari {
+/**
+ * @brief 顶点后变换缓存的模拟结果
+ */
+struct VertexCacheStats {
+  /**
+   * @brief 平均每个三角形的缓存未命中次数，范围 [0.5, 3]
+   */
+  float Acmr;
+  /**
+   * @brief 平均每个顶点的缓存未命中次数，最优为1
+   */
+  float Atvr;
+};
+
+/**
+ * @brief 网格优化前后的缓存统计
+ */
+struct MeshOptimizeStats {
+  VertexCacheStats Before;
+  VertexCacheStats After;
+};
+
+/**
+ * @brief LOD链中的一级，索引范围指向合并后的索引
+ */
+struct MeshLod {
+  size_t IndexStart;
+  size_t IndexCount;
+  /**
+   * @brief 相对原模型的几何误差，模型空间的距离
+   */
+  float Error;
+};
+
+/**
+ * @brief 簇的顶点和三角形数量上限，与常见 mesh shader 的输出上限一致
+ */
+constexpr size_t MESHLET_MAX_VERTICES = 64;
+constexpr size_t MESHLET_MAX_TRIANGLES = 124;
+
+/**
+ * @brief 一个簇在 MeshletData 顶点表和三角形表中的范围
+ */
+struct Meshlet {
+  uint32_t VertexOffset;
+  uint32_t TriangleOffset;
+  uint16_t VertexCount;
+  uint16_t TriangleCount;
+};
+
+/**
+ * @brief 簇的包围球和法线锥。锥用包围球中心表示，相机满足
+ * dot(Center - camera, ConeAxis) >= ConeCutoff * |Center - camera| + Radius 时整个簇背向相机
+ */
+struct MeshletBounds {
+  Vector3f Center;
+  float Radius;
+  Vector3f ConeAxis;
+  /**
+   * @brief 锥半角的正弦，法线分布太散时为1，此时永远不会被剔除
+   */
+  float ConeCutoff;
+};
+
+/**
+ * @brief 紧凑的簇格式：Vertices 存原模型的顶点编号，Triangles 每3个字节是簇内的局部顶点编号
+ */
+struct MeshletData {
+  std::vector<Meshlet> Meshlets;
+  std::vector<MeshletBounds> Bounds;
+  std::vector<uint32_t> Vertices;
+  std::vector<uint8_t> Triangles;
+};
+
+/**
+ * @brief 视锥的六个平面，xyz是朝内的法线，w是偏移
+ */
+struct Frustum {
+  Vector4f Planes[6];
+
+  /**
+   * @param viewProj 与 UNIFORM_VP_MATRIX 相同，即 view * proj
+   */
+  static Frustum FromMatrix(const Matrix4f& viewProj);
+};
+
+/**
+ * @brief 用FIFO缓存模拟计算ACMR/ATVR
+ */
+VertexCacheStats AnalyzeVertexCache(ArrayView<uint32_t> indices, size_t vertexCount, size_t cacheSize = 16);
+/**
+ * @brief Tipsify三角形重排（Sander 2007），提高后变换缓存命中率
+ * @return 重排后的索引
+ */
+std::vector<uint32_t> OptimizeVertexCache(ArrayView<uint32_t> indices, size_t vertexCount, size_t cacheSize = 16);
+/**
+ * @brief 按缓存边界把三角形分簇，朝外的簇先画，减少过度绘制且不破坏簇内的缓存局部性
+ * @param indices 应当是 OptimizeVertexCache 的结果
+ */
+std::vector<uint32_t> OptimizeOverdraw(ArrayView<uint32_t> indices, ArrayView<Vector3f> positions, size_t cacheSize = 16);
+/**
+ * @brief 按首次引用的顺序重排顶点，提高顶点读取的局部性
+ * @return 旧顶点到新顶点的映射，未被引用的顶点为UINT32_MAX
+ */
+std::vector<uint32_t> OptimizeVertexFetchRemap(ArrayView<uint32_t> indices, size_t vertexCount);
+/**
+ * @brief 依次进行缓存、过度绘制、顶点读取优化，返回新模型
+ */
+ImmutableModel OptimizeModel(const ImmutableModel& model, MeshOptimizeStats* stats = nullptr);
+/**
+ * @brief 基于二次误差度量（Garland 1997）的半边折叠简化。顶点只折叠到已有顶点上，法线、纹理坐标等属性不做插值；
+ * 位置相同但属性不同的接缝顶点和开放边界上的顶点不会被移除
+ * @param targetIndexCount 目标索引数量
+ * @param targetError 允许的最大误差，模型空间的距离
+ * @param resultError 输出实际误差，可以为空
+ * @return 简化后的索引，仍然引用原来的顶点
+ */
+std::vector<uint32_t> SimplifyMesh(ArrayView<uint32_t> indices,
+                                   ArrayView<Vector3f> positions,
+                                   size_t targetIndexCount,
+                                   float targetError,
+                                   float* resultError = nullptr);
+/**
+ * @brief 逐级简化生成LOD链，所有级别共享原模型的顶点，各级索引首尾相接写入 indices
+ * @param maxLevel 最多生成的级别数量，包括原模型
+ * @param ratio 每一级相对上一级的目标三角形比例
+ */
+std::vector<MeshLod> BuildLodChain(const ImmutableModel& model,
+                                   std::vector<uint32_t>& indices,
+                                   size_t maxLevel = 6,
+                                   float ratio = 0.5f);
+/**
+ * @brief 把网格切分成簇，从上一个三角形的邻接三角形中优先挑引入新顶点最少的，保持簇在空间上紧凑
+ * @param indices 最好先经过 OptimizeVertexCache
+ */
+MeshletData BuildMeshlets(ArrayView<uint32_t> indices,
+                          ArrayView<Vector3f> positions,
+                          size_t maxVertices = MESHLET_MAX_VERTICES,
+                          size_t maxTriangles = MESHLET_MAX_TRIANGLES);
+MeshletData BuildMeshlets(const ImmutableModel& model);
+/**
+ * @brief 计算一组三角形的包围球和法线锥
+ */
+MeshletBounds ComputeMeshletBounds(ArrayView<uint32_t> vertices, ArrayView<uint8_t> triangles, ArrayView<Vector3f> positions);
+/**
+ * @brief 用法线锥和视锥剔除整个簇，结果保守，不会剔除可见的三角形
+ * @param visible 输出可见簇的编号
+ * @return 可见簇的数量
+ */
+size_t CullMeshlets(const MeshletData& data, const Frustum& frustum, const Vector3f& cameraPos, std::vector<uint32_t>& visible);
+/**
+ * @brief 手性相反的三角形共享顶点时的拆分结果。新顶点接在原顶点之后编号
+ */
+struct TangentSplit {
+  /**
+   * @brief 每个新顶点复制自哪个原顶点
+   */
+  std::vector<uint32_t> Sources;
+  /**
+   * @brief 需要改指向新顶点的角：(在索引数组中的位置, 新顶点)
+   */
+  std::vector<std::pair<uint32_t, uint32_t>> Remap;
+};
+
+/**
+ * @brief 按MikkTSpace的规则生成切线：每个角的切线先投影到顶点法线的切平面上，再按角度加权累加，
+ * w为纹理坐标的手性。两种手性的三角形分开累加，共享顶点时权重大的一侧留在原顶点。
+ * 只有一个线程时逐三角形累加，否则按顶点的邻接表并行收集，两种方式的累加顺序相同
+ * @param split 非空时拆出手性少的一侧，返回值包含新顶点的切线；为空时不拆分，只返回原顶点保留一侧的切线
+ * @return 缺少法线或纹理坐标时为空
+ */
+std::vector<Vector4f> GenerateTangents(IndexArrayView indices,
+                                       ArrayView<Vector3f> positions,
+                                       ArrayView<Vector3f> normals,
+                                       ArrayView<Vector2f> texcoords,
+                                       TangentSplit* split = nullptr);
+/**
+ * @brief GenerateTangents 除结果以外临时占用的字节数，用于流式导入估计峰值内存
+ */
+size_t GetTangentScratchBytes(size_t vertexCount, size_t indexCount);
+
+}  // namespace Hikari
@@ -9,6 +9,8 @@
 #include <memory>
 #include <stdexcept>
 #include <functional>
+#include <tuple>
+#include <array>
 
 #include <hikari/opengl_header.h>
 
@@ -25,6 +27,20 @@
 #endif  // defined(NDEBUG)
 #endif  // defined(CHECK_GL)
 
+//glad没有生成S3TC扩展，这几个枚举值来自 GL_EXT_texture_compression_s3tc 和 GL_EXT_texture_sRGB
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+//来自 GL_KHR_parallel_shader_compile，与 ARB 版本的值相同
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
 namespace Hikari {
 class ObjectOpenGL;
 class BufferOpenGL;
@@ -66,6 +82,23 @@ class FeatureOpenGL {
   bool CanUseBufferStorage() const;
   bool CanUseVertexAttribBinding() const;
   bool CanUseTextureStorage() const;
+  /**
+   * @brief BC1/BC3，不是核心功能，只能查扩展
+   */
+  bool CanUseS3tc() const;
+  /**
+   * @brief BC6H/BC7
+   */
+  bool CanUseBptc() const;
+  /**
+   * @brief glGetProgramBinary/glProgramBinary，驱动至少要支持一种二进制格式
+   */
+  bool CanUseProgramBinary() const;
+  /**
+   * @brief 驱动可以在后台并行编译，提交后用 GL_COMPLETION_STATUS_KHR 查询是否完成
+   */
+  bool CanUseParallelShaderCompile() const;
+  bool IsProgramBinaryFormatSupported(GLenum format) const;
 
   static FeatureOpenGL& Get() noexcept;
 
@@ -82,6 +115,7 @@ class FeatureOpenGL {
   std::string _driverInfo;
   std::string _deviceInfo;
   std::unordered_set<std::string> _extensions;
+  std::vector<GLenum> _programBinaryFormats;
 };
 
 class ObjectOpenGL : public std::enable_shared_from_this<ObjectOpenGL> {
@@ -118,6 +152,7 @@ enum class DepthComparison {
 
 GLenum MapPrimitiveMode(PrimitiveMode);
 GLenum MapIndexDataType(IndexDataType);
+size_t SizeOfIndexDataType(IndexDataType);
 GLenum MapComparison(DepthComparison);
 
 enum class BufferType {
@@ -191,6 +226,14 @@ class ShaderOpenGL : public ObjectOpenGL {
 
   static GLenum MapType(ShaderType type);
   static bool CompileFromSource(GLenum type, const std::string& source, GLuint& result);
+  /**
+   * @brief 只提交编译，不查询状态，编译结果在链接后由 ProgramOpenGL::FinishLink 一起检查
+   */
+  static ShaderOpenGL SubmitCompile(ShaderType type, const std::string& source);
+  /**
+   * @brief 查询编译状态，失败时输出日志。会等待驱动编译完成
+   */
+  static bool CheckCompileStatus(GLuint shader);
 
  private:
   void Delete();
@@ -300,6 +343,15 @@ struct ShaderUniformBlock {
   bool operator!=(const ShaderUniformBlock& o) const;
 };
 
+/**
+ * @brief 程序链接后反射得到的信息，可以和程序二进制一起缓存
+ */
+struct ProgramReflection {
+  std::vector<ShaderAttribute> Attributes;
+  std::vector<ShaderUniform> Uniforms;
+  std::vector<ShaderUniformBlock> Blocks;
+};
+
 class ProgramOpenGL : public ObjectOpenGL {
  public:
   ProgramOpenGL() noexcept;
@@ -343,12 +395,42 @@ class ProgramOpenGL : public ObjectOpenGL {
                    const ShaderOpenGL& fs,
                    const ShaderAttributeLayouts& desc,
                    ProgramOpenGL& result);
+  /**
+   * @brief 只提交链接，不查询状态。驱动支持并行编译时，多个程序可以同时在后台编译
+   */
+  static GLuint SubmitLink(const ShaderOpenGL& vs, const ShaderOpenGL& fs);
+  /**
+   * @brief 驱动是否已经完成编译链接，不会阻塞。不支持并行编译时总是返回true
+   */
+  static bool IsLinkCompleted(GLuint prog);
+  /**
+   * @brief 检查链接结果并反射，成功后程序归 result 所有，失败时删除程序。驱动没完成时会等待
+   */
+  static bool FinishLink(GLuint prog,
+                         const ShaderOpenGL& vs,
+                         const ShaderOpenGL& fs,
+                         const ShaderAttributeLayouts& desc,
+                         ProgramOpenGL& result);
+  /**
+   * @brief 用 glProgramBinary 创建程序，反射信息直接使用传入的数据，不再查询驱动
+   * @return 驱动不接受这份二进制时返回false，例如驱动更新过
+   */
+  static bool LoadBinary(GLenum format,
+                         const void* binary,
+                         size_t size,
+                         ProgramReflection&& reflection,
+                         ProgramOpenGL& result);
+  /**
+   * @brief 读取链接好的程序的二进制，驱动不支持时返回false
+   */
+  bool GetBinary(GLenum& format, std::vector<uint8_t>& binary) const;
   static std::vector<ShaderAttribute> ReflectActiveAttrib(GLuint prog);
   static std::vector<ShaderUniform> ReflectActiveUniform(GLuint prog);
   static std::vector<ShaderUniformBlock> ReflectActiveBlock(GLuint prog);
 
  private:
   void Delete();
+  void SetReflection(ProgramReflection&& reflection);
   template <class T>
   using IfPresentAction = std::function<void(GLuint, GLint, T)>;
   template <class T>
@@ -380,11 +462,24 @@ struct VertexBufferBinding {
   VertexBufferBinding(GLuint handle, GLintptr offset = 0, GLsizei stride = 0) noexcept;
 };
 
+/**
+ * @brief 顶点属性在buffer中的存储格式，Default表示与shader中声明的类型一致
+ */
+enum class VertexFormat {
+  Default,
+  Half2,      //2个半精度浮点
+  UNorm16x2,  //2个归一化的uint16，[0, 1]
+  UNorm16x4,
+  SNorm16x2,  //2个归一化的int16，[-1, 1]
+  SNorm16x4
+};
+
 struct VertexAttributeFormat {
   GLuint AttribIndex;
   ParamType Type;
   GLboolean IsNormalised;
   GLuint RelativeOffset;  //以字节为单位
+  VertexFormat Format = VertexFormat::Default;
 };
 
 struct VertexAssociate {
@@ -415,13 +510,23 @@ class VertexArrayOpenGL : public ObjectOpenGL {
   void SetVertexBuffer(const VertexBufferBinding& binding) const;
   //如果opengl版本小于4.5，应该确保调用该函数前，绑定的VAO是正确的
   void SetIndexBuffer(GLuint iboHandle) const;
+  /**
+   * @brief 修改属性在buffer中的存储格式，格式不变时不调用GL。需要在SetVertexBuffer之前调用
+   * 如果opengl版本小于4.5，应该确保调用该函数前，绑定的VAO是正确的
+   * @param type shader中声明的类型，format为Default时使用
+   */
+  void SetAttribFormat(GLuint attribIndex, ParamType type, VertexFormat format) const;
 
   static std::pair<GLint, GLenum> MapType(ParamType type);
+  /**
+   * @return 分量数量、分量类型、是否归一化
+   */
+  static std::tuple<GLint, GLenum, GLboolean> MapFormat(ParamType type, VertexFormat format);
 
  private:
   void Delete();
   GLuint _handle{};
-  std::unordered_map<GLuint, VertexAttributeFormat> _attribFormat;
+  mutable std::unordered_map<GLuint, VertexAttributeFormat> _attribFormat;
 };
 
 enum class TextureType {
@@ -446,20 +551,32 @@ enum class ImageDataFormat {
   RGB,
   RGBA,
   Depth,
-  RG
+  RG,
+  R
 };
 
 enum class PixelFormat : GLenum {
+  R8 = GL_R8,
   RG8 = GL_RG8,
   RG16 = GL_RG16,
   RG16F = GL_RG16F,
   RG32F = GL_RG32F,
   RGB8 = GL_RGB8,
   RGBA8 = GL_RGBA8,
+  SRGB8A8 = GL_SRGB8_ALPHA8,
   RGB16F = GL_RGB16F,
   RGBA16F = GL_RGBA16F,
   RGB32F = GL_RGB32F,
   RGBA32F = GL_RGBA32F,
+  RGB9E5 = GL_RGB9_E5,
+  //块压缩格式，上传时忽略 ImageDataFormat 和 ImageDataType
+  BC1 = GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+  BC1Srgb = GL_COMPRESSED_SRGB_S3TC_DXT1_EXT,
+  BC3 = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+  BC3Srgb = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT,
+  BC4 = GL_COMPRESSED_RED_RGTC1,
+  BC5 = GL_COMPRESSED_RG_RGTC2,
+  BC6H = GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT,
   Depth16 = GL_DEPTH_COMPONENT16,
   Depth24 = GL_DEPTH_COMPONENT24,
   Depth32 = GL_DEPTH_COMPONENT32,
@@ -467,7 +584,12 @@ enum class PixelFormat : GLenum {
 
 enum class ImageDataType {
   Byte,
-  Float32
+  Float32,
+  Float16,
+  /**
+   * @brief 共享指数的RGB9E5打包格式，配合 PixelFormat::RGB9E5 使用
+   */
+  UInt5999Rev
 };
 
 struct Texture2dDescriptorOpenGL {
@@ -481,6 +603,12 @@ struct Texture2dDescriptorOpenGL {
   ImageDataFormat DataFormat;
   ImageDataType DataType;
   const void* DataPtr;
+  /**
+   * @brief 预先生成的mipmap，MipDataPtr[i] 是第 i+1 级，格式与 DataPtr 相同。
+   * 覆盖了所有级别时不再调用 glGenerateMipmap，否则仍由驱动生成全部级别。
+   * 压缩格式不能由驱动生成，只分配提供了数据的级别
+   */
+  std::vector<const void*> MipDataPtr{};
 };
 
 struct TextureCubeMapDescriptorOpenGL {
@@ -495,6 +623,11 @@ struct TextureCubeMapDescriptorOpenGL {
   ImageDataFormat DataFormat[6];
   ImageDataType DataType[6];
   const void* DataPtr[6];
+  /**
+   * @brief 预先生成的mipmap，MipDataPtr[i][face] 是第 i+1 级，格式与 DataPtr 相同。
+   * 覆盖了所有级别时不再调用 glGenerateMipmap
+   */
+  std::vector<std::array<const void*, 6>> MipDataPtr{};
 };
 
 struct DepthTextureDescriptorOpenGL {
@@ -524,12 +657,22 @@ class TextureOpenGL : public ObjectOpenGL {
   int GetWidth() const;
   int GetHeight() const;
   constexpr PixelFormat GetPixelFormat() const { return _pixelFormat; }
+  /**
+   * @brief 把一级纹理读回CPU，会阻塞到GPU完成之前的绘制。行之间没有填充
+   * @param face cubemap的面，与 GL_TEXTURE_CUBE_MAP_POSITIVE_X + face 对应，2D纹理忽略
+   */
+  void ReadImage(int level, int face, ImageDataFormat format, ImageDataType type, void* output) const;
 
   static GLuint MapFilterMode(FilterMode mode);
   static GLuint MapWrapMode(WrapMode mode);
   static GLint MapPixelFormat(ImageDataFormat format);
   static GLenum MapTextureDataType(ImageDataType format);
   static GLsizei CalcMipmapLevels(int mipmapLevel, int maxSize, bool isUseTrilinear);
+  static bool IsCompressedFormat(PixelFormat format);
+  /**
+   * @brief 压缩格式一级的字节数，按4x4块计算。不是压缩格式时返回0
+   */
+  static GLsizei CalcCompressedImageSize(PixelFormat format, int width, int height);
   static void CreateTexture2d(const Texture2dDescriptorOpenGL& desc, TextureOpenGL& texture);
   static void CreateCubeMap(const TextureCubeMapDescriptorOpenGL& desc, TextureOpenGL& texture);
   static GLenum MapTextureType(TextureType type);
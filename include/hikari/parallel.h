@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+namespace Hikari {
+/**
+ * @brief 固定数量工作线程的线程池
+ */
+class ThreadPool {
+ public:
+  /**
+   * @param threadCount 工作线程数量，0表示使用硬件线程数
+   */
+  explicit ThreadPool(size_t threadCount = 0);
+  ThreadPool(const ThreadPool&) = delete;
+  ~ThreadPool() noexcept;
+
+  /**
+   * @brief 提交任务，返回任务结果的future
+   */
+  template <typename Func>
+  auto Submit(Func&& func) -> std::future<std::invoke_result_t<std::decay_t<Func>>> {
+    using Result = std::invoke_result_t<std::decay_t<Func>>;
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+    auto future = task->get_future();
+    Enqueue([task]() { (*task)(); });
+    return future;
+  }
+  size_t GetThreadCount() const;
+  /**
+   * @brief 进程内共享的线程池
+   */
+  static ThreadPool& GetGlobal();
+
+ private:
+  void Enqueue(std::function<void()> task);
+  void WorkerLoop();
+
+  std::vector<std::thread> _workers;
+  std::queue<std::function<void()>> _tasks;
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  bool _isStop{false};
+};
+
+/**
+ * @brief 把 [begin, end) 按 grain 切块后在共享线程池上并行执行，调用线程也参与执行
+ * @param func 参数为一块的 [begin, end)
+ */
+void ParallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& func);
+
+}  // namespace Hikari
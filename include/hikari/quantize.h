@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+#include <hikari/mathematics.h>
+
+namespace Hikari {
+/**
+ * @brief float转IEEE 754半精度，舍入到最近偶数，超出范围的值变为无穷
+ */
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+/**
+ * @brief [-1, 1] 量化为 GL_SHORT 归一化格式，与GL的解码 max(c / 32767, -1) 对应
+ */
+int16_t FloatToSnorm16(float value);
+/**
+ * @brief [0, 1] 量化为 GL_UNSIGNED_SHORT 归一化格式
+ */
+uint16_t FloatToUnorm16(float value);
+/**
+ * @brief 共享指数格式 GL_RGB9_E5（EXT_texture_shared_exponent），负数和NaN变为0，超出范围的截为最大值65408
+ */
+uint32_t FloatToRgb9e5(const Vector3f& rgb);
+Vector3f Rgb9e5ToFloat(uint32_t value);
+/**
+ * @brief Radiance的RGBE直接转为RGB9E5。8位尾数左移一位后只需要平移指数，范围内没有精度损失
+ */
+uint32_t RgbeToRgb9e5(const uint8_t* rgbe);
+/**
+ * @brief 单位向量的八面体编码（Cigolle 2014），结果在 [-1, 1]^2
+ */
+Vector2f EncodeOctahedral(const Vector3f& n);
+Vector3f DecodeOctahedral(const Vector2f& e);
+
+/**
+ * @brief 位置相对包围盒量化为UNORM16，解码为 Offset + Scale * p
+ */
+struct PositionQuantization {
+  Vector3f Offset{};
+  Vector3f Scale{1};
+
+  static PositionQuantization FromBounds(const Vector3f& min, const Vector3f& max);
+};
+
+}  // namespace Hikari
@@ -4,20 +4,30 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <vector>
+#include <mutex>
 #include <stdexcept>
 #include <optional>
 #include <filesystem>
 
 #include <glslang/Public/ShaderLang.h>
 
+#include <hikari/common.h>
 #include <hikari/mathematics.h>
+#include <hikari/quantize.h>
+#include <hikari/image.h>
 #include <hikari/opengl.h>
 
 namespace Hikari {
 class RenderPass;
+class ImmutableBitmap;
+class ImmutableHdrTexture;
 class RenderContextOpenGL;
 struct VertexPNT;
 struct VertexPTNT;
+struct VertexPNTC;
+struct VertexPNTQ;
+struct VertexPTNTC;
+struct VertexPTNTQ;
 
 class RenderContextException : public std::runtime_error {
  public:
@@ -41,23 +51,70 @@ struct PipelineState {
   PrimitiveMode Primitive = PrimitiveMode::Triangles;
 };
 
+/**
+ * @brief 从HDR全景图烘焙环境贴图的参数。cubemap都是RGBA16F（RGB16F不保证可以作为渲染目标），缓存只保存RGB
+ */
+struct EnvironmentBakeOptions {
+  int SkyboxSize = 1024;
+  /**
+   * @brief 辐照度卷积cubemap的边长，0表示不生成
+   */
+  int IrradianceSize = 0;
+  /**
+   * @brief 预滤波cubemap的边长，包括所有mip级别，0表示不生成
+   */
+  int PrefilterSize = 0;
+  /**
+   * @brief 按全景图数据、参数和烘焙shader的哈希缓存到磁盘，命中时直接上传，不再执行烘焙pass
+   */
+  bool UseCache = true;
+};
+
+struct EnvironmentMaps {
+  std::shared_ptr<TextureOpenGL> Skybox;
+  std::shared_ptr<TextureOpenGL> Irradiance;
+  std::shared_ptr<TextureOpenGL> Prefiltered;
+};
+
+constexpr IndexDataType MapIndexFormat(IndexFormat format) {
+  return format == IndexFormat::UInt16 ? IndexDataType::UnsignedShort : IndexDataType::UnsignedInt;
+}
+
 struct VertexBufferLayout {
   int Stride = 0;
   int Offset = 0;
   AttributeSemantic Semantic;
+  VertexFormat Format = VertexFormat::Default;
   VertexBufferLayout() noexcept = default;
-  constexpr VertexBufferLayout(AttributeSemantic semantic, int stride, int offset) noexcept {
+  constexpr VertexBufferLayout(AttributeSemantic semantic, int stride, int offset,
+                               VertexFormat format = VertexFormat::Default) noexcept {
     Semantic = semantic;
     Stride = stride;
     Offset = offset;
+    Format = format;
   }
 };
 
+/**
+ * @brief 按HDR贴图的存储格式填写纹理格式、尺寸和数据，过滤和环绕方式由调用者决定
+ */
+void SetHdrTextureData(const ImmutableHdrTexture& hdr, Texture2dDescriptorOpenGL& desc);
+/**
+ * @brief 填写CPU转换得到的cubemap的尺寸和六个面的数据，纹理格式、过滤和环绕方式由调用者决定
+ */
+void SetCubeMapData(const CubeMapImage& cube, TextureCubeMapDescriptorOpenGL& desc);
+/**
+ * @brief 填写CPU烘焙的BRDF查询表的尺寸和数据，纹理格式、过滤和环绕方式由调用者决定
+ */
+void SetBrdfLutData(const BrdfLut& lut, Texture2dDescriptorOpenGL& desc);
+
 struct GlobalUniformBlock {
   ShaderUniformBlock Block{};
   size_t BindingPoint = std::numeric_limits<size_t>::max();
   std::shared_ptr<BufferOpenGL> Ubo;
   std::vector<uint8_t> Data;  //用来debug（
+  int RefCount = 0;      //引用这个布局的程序数，为0的块不上传
+  bool IsDirty = true;  //上次上传后数据是否改变过
 };
 
 struct GlobalUniform {
@@ -65,9 +122,47 @@ struct GlobalUniform {
   size_t BlockHandle;
 };
 
+/**
+ * @brief 最近一次写入全局uniform的数据。还没有程序用到这个uniform时也会保留，
+ * 之后注册的uniform block布局会用它初始化
+ */
+struct GlobalUniformValue {
+  size_t DataSize;
+  int Length;
+  int Align;
+  std::vector<uint8_t> Data;
+};
+
+/**
+ * @brief 内存中缓存的include文件
+ */
+struct ShaderIncludeFile {
+  std::string Text;
+  uint64_t Hash;
+  std::filesystem::file_time_type WriteTime;
+};
+
+/**
+ * @brief 预处理时实际用到的include文件，用于判断预处理缓存是否过期
+ */
+struct ShaderDependency {
+  std::string Path;
+  uint64_t Hash;
+  std::string Name;  //#include 里写的名字，重新查找时用
+  bool IsSystem;
+};
+
+/**
+ * @brief 多个 ShaderIncluder 共享的include文件缓存
+ */
+struct ShaderIncludeCache {
+  std::mutex Mutex;
+  std::unordered_map<std::string, std::shared_ptr<const ShaderIncludeFile>> Files;
+};
+
 class ShaderIncluder : public glslang::TShader::Includer {
  public:
-  ShaderIncluder() noexcept;
+  ShaderIncluder();
   ~ShaderIncluder() override;
 
   IncludeResult* includeSystem(const char* headerName, const char* includerName, size_t inclusionDepth) override;
@@ -75,12 +170,82 @@ class ShaderIncluder : public glslang::TShader::Includer {
   void releaseInclude(IncludeResult*) override;
 
   void AddSystemPath(const std::filesystem::path& sysPath);
+  /**
+   * @brief 复制查找路径并共享文件缓存，记录是独立的。每个预处理任务用一个，可以在不同线程同时使用
+   */
+  ShaderIncluder Fork() const;
+  /**
+   * @brief 按顺序哈希查找路径，查找路径变化时同名include可能解析到别的文件
+   */
+  uint64_t HashSearchPaths(uint64_t seed) const;
+  /**
+   * @brief 按 #include <> 或 #include "" 的规则查找文件
+   * @return 找不到时返回空路径
+   */
+  std::filesystem::path Resolve(const std::string& headerName, bool isSystem);
+  /**
+   * @brief 按路径缓存文件内容，修改时间变化后重新读取，同一个库文件只读一次。线程安全
+   * @return 文件不存在时返回空
+   */
+  std::shared_ptr<const ShaderIncludeFile> GetFile(const std::filesystem::path& p);
+  /**
+   * @brief 清空并开始记录之后include的文件
+   */
+  void BeginRecord();
+  const std::vector<ShaderDependency>& GetRecord() const;
 
   static std::string ReadText(const std::filesystem::path& p);
 
  private:
+  IncludeResult* MakeResult(const char* headerName, const std::filesystem::path& p, bool isSystem);
+
   std::vector<std::filesystem::path> _systemPaths;
   std::filesystem::path _workPath;
+  std::shared_ptr<ShaderIncludeCache> _cache;
+  std::vector<ShaderDependency> _record;
+};
+
+/**
+ * @brief 加载一个着色器程序需要的参数，路径的查找规则与 LoadShaderProgram 相同
+ */
+struct ShaderProgramRequest {
+  std::filesystem::path VsPath;
+  std::filesystem::path FsPath;
+  std::filesystem::path LibPath;
+  ShaderAttributeLayouts Layouts;
+  std::vector<std::string> Macros;
+};
+
+/**
+ * @brief 已经提交给驱动、可能还在后台编译的着色器程序，由 RenderContextOpenGL::PollShaderProgram 推进
+ */
+class ShaderProgramTask {
+ public:
+  ShaderProgramTask() noexcept;
+  /**
+   * @brief 已经完成的任务，比如从程序缓存读到的程序。program 为空表示失败
+   */
+  explicit ShaderProgramTask(std::shared_ptr<ProgramOpenGL> program) noexcept;
+  ShaderProgramTask(const ShaderProgramTask&) = delete;
+  ~ShaderProgramTask() noexcept;
+
+  bool IsDone() const;
+  bool IsFailed() const;
+  /**
+   * @brief 完成前和失败时为空
+   */
+  const std::shared_ptr<ProgramOpenGL>& GetProgram() const;
+
+ private:
+  friend class RenderContextOpenGL;
+  ShaderOpenGL _vs;
+  ShaderOpenGL _fs;
+  GLuint _handle{};
+  ShaderAttributeLayouts _layouts;
+  uint64_t _cacheKey{};
+  std::filesystem::path _cachePath;
+  std::shared_ptr<ProgramOpenGL> _program;
+  bool _isDone{};
 };
 
 struct GBufferLayout {
@@ -124,16 +289,70 @@ class RenderContextOpenGL {
   std::shared_ptr<BufferOpenGL> CreateUniformBuffer(const void* data, size_t size,
                                                     BufferUsage usage = BufferUsage::Static,
                                                     BufferAccess access = BufferAccess::NoMap);
+  /**
+   * @brief 编译链接着色器程序。驱动支持程序二进制时，按源码、驱动、硬件和顶点属性语义的哈希把二进制和反射信息缓存到磁盘，
+   * 之后直接用 glProgramBinary 加载，缓存损坏或者驱动不再接受时重新编译
+   */
   std::shared_ptr<ProgramOpenGL> CreateShaderProgram(const std::string& vs,
                                                      const std::string& fs,
                                                      const ShaderAttributeLayouts& desc);
+  /**
+   * @brief 提交编译链接后立即返回，不查询状态，驱动支持 GL_KHR_parallel_shader_compile 时在后台并行编译。
+   * 命中程序二进制缓存时任务直接完成
+   */
+  std::shared_ptr<ShaderProgramTask> SubmitShaderProgram(const std::string& vs,
+                                                         const std::string& fs,
+                                                         const ShaderAttributeLayouts& desc);
+  /**
+   * @brief 驱动完成后检查链接结果、反射并加入上下文，不会等待驱动
+   * @return 任务是否已经结束（成功或失败）
+   */
+  bool PollShaderProgram(ShaderProgramTask& task);
+  /**
+   * @brief 等待任务结束，失败时抛出异常
+   */
+  std::shared_ptr<ProgramOpenGL> WaitShaderProgram(ShaderProgramTask& task);
   std::shared_ptr<ProgramOpenGL> LoadShaderProgram(const std::filesystem::path& vsPath,
                                                    const std::filesystem::path& fsPath,
                                                    const std::filesystem::path& libPath,
                                                    const ShaderAttributeLayouts& desc,
                                                    const std::vector<std::string>& macros = {});
+  /**
+   * @brief 批量加载着色器程序。读取和预处理在线程池上并行，相同的阶段只处理一次；
+   * 之后在调用线程（GL线程）上一起提交编译链接再等待，结果与 requests 一一对应
+   */
+  std::vector<std::shared_ptr<ProgramOpenGL>> LoadShaderPrograms(const std::vector<ShaderProgramRequest>& requests);
+  /**
+   * @brief 读取并预处理一个程序的两个阶段，不需要GL上下文，可以在其他线程调用。失败时抛出异常
+   */
+  void PreprocessShaderProgram(const ShaderProgramRequest& request, std::string& vs, std::string& fs);
   std::shared_ptr<TextureOpenGL> CreateTexture2D(const Texture2dDescriptorOpenGL& desc);
-  std::shared_ptr<TextureOpenGL> LoadBitmap2D(std::filesystem::path, WrapMode, FilterMode, PixelFormat);
+  std::shared_ptr<TextureOpenGL> LoadBitmap2D(std::filesystem::path,
+                                              WrapMode,
+                                              FilterMode,
+                                              PixelFormat,
+                                              const MipGenerateOptions& mipOptions = MipGenerateOptions());
+  /**
+   * @brief 上传已经解码好的位图，配合 AssetManager 使用。三线性过滤时在CPU上生成mipmap。
+   * 纹理格式是BC1/BC3/BC4/BC5时先在CPU上压缩，压缩结果缓存在磁盘
+   */
+  std::shared_ptr<TextureOpenGL> LoadBitmap2D(const ImmutableBitmap&,
+                                              WrapMode,
+                                              FilterMode,
+                                              PixelFormat,
+                                              const MipGenerateOptions& mipOptions = MipGenerateOptions());
+  /**
+   * @brief 未压缩位图生成mipmap时实际使用的参数：SRGB8A8 纹理在线性空间下采样
+   */
+  static MipGenerateOptions GetBitmapMipOptions(PixelFormat, const MipGenerateOptions& mipOptions);
+  /**
+   * @brief 上传块压缩纹理和它的所有mip级别。驱动不支持对应格式时在CPU上解压后按未压缩格式上传
+   */
+  std::shared_ptr<TextureOpenGL> LoadCompressedTexture2D(const CompressedTexture&, WrapMode, FilterMode);
+  /**
+   * @brief 读取DDS或KTX2文件
+   */
+  std::shared_ptr<TextureOpenGL> LoadCompressedTexture2D(const std::filesystem::path&, WrapMode, FilterMode);
   std::shared_ptr<TextureOpenGL> CreateCubeMap(const TextureCubeMapDescriptorOpenGL& desc);
   std::shared_ptr<TextureOpenGL> CreateDepthTexture(const DepthTextureDescriptorOpenGL& desc);
   std::shared_ptr<FrameBufferOpenGL> CreateFrameBuffer(const FrameBufferDepthDescriptor& desc);
@@ -145,8 +364,16 @@ class RenderContextOpenGL {
   std::shared_ptr<BufferOpenGL> CreateQuadVbo(float halfExtend, int& vertexCnt);
   std::shared_ptr<BufferOpenGL> CreateVbo(const std::vector<VertexPNT>& pnt);
   std::shared_ptr<BufferOpenGL> CreateVbo(const std::vector<VertexPTNT>& ptnt);
+  std::shared_ptr<BufferOpenGL> CreateVbo(const std::vector<VertexPNTC>& pnt);
+  std::shared_ptr<BufferOpenGL> CreateVbo(const std::vector<VertexPNTQ>& pnt);
+  std::shared_ptr<BufferOpenGL> CreateVbo(const std::vector<VertexPTNTC>& ptnt);
+  std::shared_ptr<BufferOpenGL> CreateVbo(const std::vector<VertexPTNTQ>& ptnt);
+  /**
+   * @brief 按索引原本的宽度上传，绘制时使用 MapIndexFormat(indices.GetFormat())
+   */
+  std::shared_ptr<BufferOpenGL> CreateIbo(IndexArrayView indices);
   /**
-   * @brief 将等距柱状投影图转换为立方体图
+   * @brief 将等距柱状投影图转换为立方体图。没有GPU时可以用 ConvertEquirectToCubeMap 在CPU上转换，结果相同
   */
   std::shared_ptr<TextureOpenGL> ConvertSphericalToCubemap(
       const Texture2dDescriptorOpenGL& tex2d,
@@ -167,7 +394,13 @@ class RenderContextOpenGL {
       const TextureCubeMapDescriptorOpenGL& config,
       const std::filesystem::path& shaderLib);
   /**
-   * @brief 预计算BRDF查询表
+   * @brief 依次转换cubemap、生成辐照度卷积和预滤波贴图，每张贴图读回后单独缓存
+   */
+  EnvironmentMaps BakeEnvironmentMaps(const ImmutableHdrTexture& hdr,
+                                      const EnvironmentBakeOptions& options,
+                                      const std::filesystem::path& shaderLib);
+  /**
+   * @brief 预计算BRDF查询表。每次都在GPU上重新计算，也可以用 BakeBrdfLut 在CPU上烘焙并缓存到磁盘
   */
   std::shared_ptr<TextureOpenGL> PrecomputeBrdfLut(const Texture2dDescriptorOpenGL& desc,
                                                    const std::filesystem::path& shaderLib);
@@ -178,6 +411,20 @@ class RenderContextOpenGL {
       const Texture2dDescriptorOpenGL& desc,
       const std::filesystem::path& shaderLib);
   void AddUniformBlocks(const ProgramOpenGL& prog);
+  /**
+   * @brief 登记uniform block的一种布局并增加一次引用，只处理CPU端的数据，buffer由 AddUniformBlocks 创建。
+   * 新布局优先复用已经释放的编号，用之前写入过的全局数据初始化
+   * @param maxCount 最多同时存在的布局数，超出时抛出异常。AddUniformBlocks 传入驱动的 GL_MAX_UNIFORM_BUFFER_BINDINGS
+   * @return 布局的编号（也是binding point）和是否是新登记的
+   */
+  std::pair<size_t, bool> RegisterGlobalBlock(const ShaderUniformBlock& block,
+                                              size_t maxCount = std::numeric_limits<size_t>::max());
+  /**
+   * @brief 减少一次引用。没有程序引用时注销这个布局，编号留给之后登记的布局
+   * @return 布局是否被注销
+   */
+  bool ReleaseGlobalBlock(size_t handle);
+  const GlobalUniformBlock& GetGlobalBlock(size_t handle) const;
   void DestroyObject(const std::shared_ptr<ObjectOpenGL>& ptr);
   void DestroyObject(const std::shared_ptr<ProgramOpenGL>& ptr);
 
@@ -185,7 +432,9 @@ class RenderContextOpenGL {
   const VertexArrayOpenGL& GetVertexArray(const std::shared_ptr<ProgramOpenGL>&) const;
 
   /**
-   * @brief 预处理shader。应用宏替换，处理include指令，初步验证语法正确性
+   * @brief 预处理shader。应用宏替换，处理include指令，初步验证语法正确性。
+   * 结果按源码、宏和阶段的哈希缓存到磁盘，同时记录用到的include文件的哈希，这些文件都没变时不再调用glslang。
+   * 不需要GL上下文，可以在多个线程同时调用
    * @param type 阶段（shader stage）
    * @param source glsl源码
    * @param res 预处理后glsl源码，如果处理失败则不返回任何数据
@@ -217,7 +466,10 @@ class RenderContextOpenGL {
   void DrawArrays(PrimitiveMode, int first, int count) const;
   void DrawElements(PrimitiveMode, int count, IndexDataType = IndexDataType::UnsignedInt, size_t first = 0) const;
 
-  void SubmitGlobalUnifroms() const;
+  /**
+   * @brief 上传有程序引用、并且上次上传后改变过的uniform block
+   */
+  void SubmitGlobalUnifroms();
   void SetGlobalUniformData(const std::string& name, size_t dataSize, int length, int align, const void* data);
   /**
    * @brief 将uniform block需要的数据传入buffer
@@ -229,6 +481,11 @@ class RenderContextOpenGL {
    * @return 
   */
   void SetGlobalUniformData(const GlobalUniform& uniform, size_t dataSize, int length, int align, const void* data);
+  /**
+   * @brief 着色器变体的数组长度不同时，同名的uniform block有多种布局，每种布局都会写入，数组截断到该布局的长度。
+   * 更长的变体还在编译时只有旧布局，多出的元素先保留，新布局登记时再写入。
+   * 数据会保留下来，还没有加载用到它的程序时写入也不会丢失
+   */
   void SetGlobalUniform(const std::string& name, size_t dataSize, int length, int align, const void* data);
   void SetGlobalFloat(const std::string& name, float value);
   void SetGlobalInt(const std::string& name, int value);
@@ -242,17 +499,25 @@ class RenderContextOpenGL {
   void SetGlobalVec3Array(const std::string& name, const void* value, int length);
   void SetGlobalTex2dArray(const std::string& name, const void* tex2d, int length);
   void SetGlobalCubeMapArray(const std::string& name, const void* cubemap, int length);
+  /**
+   * @brief 设置 HikariEnvironment.glsl 中的球谐辐照度，数据保留到下次设置
+   */
+  void SetGlobalIrradianceSH9(const IrradianceSH9& sh);
 
  private:
   void CheckInit() const;
   void AddObjectToSet(const std::shared_ptr<ObjectOpenGL>& obj);
+  void FinishShaderProgram(ShaderProgramTask& task);
+  void AddProgram(const std::shared_ptr<ProgramOpenGL>& program);
 
   ShaderIncluder _includer;
   std::unordered_set<std::shared_ptr<ObjectOpenGL>> _objects;
   std::unordered_map<std::shared_ptr<ProgramOpenGL>, VertexArrayOpenGL> _vaos;
   std::vector<GlobalUniformBlock> _globalBlocks;
-  std::unordered_map<std::string, size_t> _blockQueryMap;
-  std::unordered_map<std::string, GlobalUniform> _globalUniforms;
+  std::vector<size_t> _freeBlocks;
+  std::unordered_multimap<std::string, size_t> _blockQueryMap;
+  std::unordered_multimap<std::string, GlobalUniform> _globalUniforms;
+  std::unordered_map<std::string, GlobalUniformValue> _globalValues;
   bool _isValid{};
 };
 
@@ -270,6 +535,9 @@ constexpr const char* UNIFORM_LIGHT_DIR_CNT = "u_LightDirCount";
 constexpr const char* UNIFORM_LIGHT_POINT_RAD = "u_LightRadiancePoint";
 constexpr const char* UNIFORM_LIGHT_POINT_DIR = "u_LightPositionPoint";
 constexpr const char* UNIFORM_LIGHT_POINT_CNT = "u_LightPointCount";
+constexpr const char* UNIFORM_IRRADIANCE_SH = "u_IrradianceSH";
+constexpr const char* UNIFORM_POSITION_OFFSET = "u_PositionOffset";
+constexpr const char* UNIFORM_POSITION_SCALE = "u_PositionScale";
 
 //在buffer中排列：PNTPNTPNT
 struct VertexPNT {
@@ -278,13 +546,13 @@ struct VertexPNT {
   Vector2f TexCoord;
 };
 constexpr int SizePNT() { return static_cast<int>(sizeof(VertexPNT)); }
-std::vector<VertexPNT> GenVboDataPNT(const std::vector<Vector3f>& pos,
-                                     const std::vector<Vector3f>& normal,
-                                     const std::vector<Vector2f>& tex);
-std::vector<VertexPNT> GenVboDataPNT(const std::vector<Vector3f>& pos,
-                                     const std::vector<Vector3f>& normal,
-                                     const std::vector<Vector2f>& tex,
-                                     const std::vector<size_t>& idx);
+std::vector<VertexPNT> GenVboDataPNT(ArrayView<Vector3f> pos,
+                                     ArrayView<Vector3f> normal,
+                                     ArrayView<Vector2f> tex);
+std::vector<VertexPNT> GenVboDataPNT(ArrayView<Vector3f> pos,
+                                     ArrayView<Vector3f> normal,
+                                     ArrayView<Vector2f> tex,
+                                     IndexArrayView idx);
 constexpr VertexBufferLayout GetVertexPosPNT() {
   return VertexBufferLayout({SemanticType::Vertex, 0}, SizePNT(), offsetof(VertexPNT, Position));
 }
@@ -302,15 +570,15 @@ struct VertexPTNT {
   Vector2f TexCoord;
 };
 constexpr int SizePTNT() { return static_cast<int>(sizeof(VertexPTNT)); }
-std::vector<VertexPTNT> GenVboDataPTNT(const std::vector<Vector3f>& pos,
-                                       const std::vector<Vector4f>& tan,
-                                       const std::vector<Vector3f>& normal,
-                                       const std::vector<Vector2f>& tex);
-std::vector<VertexPTNT> GenVboDataPTNT(const std::vector<Vector3f>& pos,
-                                       const std::vector<Vector4f>& tan,
-                                       const std::vector<Vector3f>& normal,
-                                       const std::vector<Vector2f>& tex,
-                                       const std::vector<size_t>& idx);
+std::vector<VertexPTNT> GenVboDataPTNT(ArrayView<Vector3f> pos,
+                                       ArrayView<Vector4f> tan,
+                                       ArrayView<Vector3f> normal,
+                                       ArrayView<Vector2f> tex);
+std::vector<VertexPTNT> GenVboDataPTNT(ArrayView<Vector3f> pos,
+                                       ArrayView<Vector4f> tan,
+                                       ArrayView<Vector3f> normal,
+                                       ArrayView<Vector2f> tex,
+                                       IndexArrayView idx);
 constexpr VertexBufferLayout GetVertexPosPTNT() {
   return VertexBufferLayout({SemanticType::Vertex, 0}, SizePTNT(), offsetof(VertexPTNT, Position));
 }
@@ -324,6 +592,112 @@ constexpr VertexBufferLayout GetVertexTexPTNT(int index) {
   return VertexBufferLayout({SemanticType::TexCoord, index}, SizePTNT(), offsetof(VertexPTNT, TexCoord));
 }
 
+/**
+ * @brief 16位纹理坐标的编码，UNorm16精度更高但只能表示 [0, 1]，超出范围时用Half
+ */
+enum class TexCoordEncoding {
+  UNorm16,
+  Half
+};
+TexCoordEncoding ChooseTexCoordEncoding(ArrayView<Vector2f> tex);
+constexpr VertexFormat MapTexCoordFormat(TexCoordEncoding encoding) {
+  return encoding == TexCoordEncoding::Half ? VertexFormat::Half2 : VertexFormat::UNorm16x2;
+}
+
+//压缩格式，在buffer中排列：PNT PNT，法线八面体编码为SNORM16，纹理坐标16位，共20字节
+//shader中用 HikariVertex.glsl 解码
+struct VertexPNTC {
+  Vector3f Position;
+  int16_t Normal[2];
+  uint16_t TexCoord[2];
+};
+constexpr int SizePNTC() { return static_cast<int>(sizeof(VertexPNTC)); }
+std::vector<VertexPNTC> GenVboDataPNTC(ArrayView<Vector3f> pos,
+                                       ArrayView<Vector3f> normal,
+                                       ArrayView<Vector2f> tex,
+                                       TexCoordEncoding encoding);
+constexpr VertexBufferLayout GetVertexPosPNTC() {
+  return VertexBufferLayout({SemanticType::Vertex, 0}, SizePNTC(), offsetof(VertexPNTC, Position));
+}
+constexpr VertexBufferLayout GetVertexNormalPNTC() {
+  return VertexBufferLayout({SemanticType::Normal, 0}, SizePNTC(), offsetof(VertexPNTC, Normal), VertexFormat::SNorm16x2);
+}
+constexpr VertexBufferLayout GetVertexTexPNTC(int index, TexCoordEncoding encoding) {
+  return VertexBufferLayout({SemanticType::TexCoord, index}, SizePNTC(), offsetof(VertexPNTC, TexCoord), MapTexCoordFormat(encoding));
+}
+//位置也相对包围盒量化为UNORM16（第四个分量补齐），共16字节，shader中需要 u_PositionOffset/u_PositionScale
+struct VertexPNTQ {
+  uint16_t Position[4];
+  int16_t Normal[2];
+  uint16_t TexCoord[2];
+};
+constexpr int SizePNTQ() { return static_cast<int>(sizeof(VertexPNTQ)); }
+std::vector<VertexPNTQ> GenVboDataPNTQ(ArrayView<Vector3f> pos,
+                                       ArrayView<Vector3f> normal,
+                                       ArrayView<Vector2f> tex,
+                                       const PositionQuantization& quant,
+                                       TexCoordEncoding encoding);
+constexpr VertexBufferLayout GetVertexPosPNTQ() {
+  return VertexBufferLayout({SemanticType::Vertex, 0}, SizePNTQ(), offsetof(VertexPNTQ, Position), VertexFormat::UNorm16x4);
+}
+constexpr VertexBufferLayout GetVertexNormalPNTQ() {
+  return VertexBufferLayout({SemanticType::Normal, 0}, SizePNTQ(), offsetof(VertexPNTQ, Normal), VertexFormat::SNorm16x2);
+}
+constexpr VertexBufferLayout GetVertexTexPNTQ(int index, TexCoordEncoding encoding) {
+  return VertexBufferLayout({SemanticType::TexCoord, index}, SizePNTQ(), offsetof(VertexPNTQ, TexCoord), MapTexCoordFormat(encoding));
+}
+//压缩格式，在buffer中排列：PTNT PTNT，切线为八面体编码+副切线符号，共28字节
+struct VertexPTNTC {
+  Vector3f Position;
+  int16_t Tangent[4];
+  int16_t Normal[2];
+  uint16_t TexCoord[2];
+};
+constexpr int SizePTNTC() { return static_cast<int>(sizeof(VertexPTNTC)); }
+std::vector<VertexPTNTC> GenVboDataPTNTC(ArrayView<Vector3f> pos,
+                                         ArrayView<Vector4f> tan,
+                                         ArrayView<Vector3f> normal,
+                                         ArrayView<Vector2f> tex,
+                                         TexCoordEncoding encoding);
+constexpr VertexBufferLayout GetVertexPosPTNTC() {
+  return VertexBufferLayout({SemanticType::Vertex, 0}, SizePTNTC(), offsetof(VertexPTNTC, Position));
+}
+constexpr VertexBufferLayout GetVertexTanPTNTC() {
+  return VertexBufferLayout({SemanticType::Tangent, 0}, SizePTNTC(), offsetof(VertexPTNTC, Tangent), VertexFormat::SNorm16x4);
+}
+constexpr VertexBufferLayout GetVertexNormalPTNTC() {
+  return VertexBufferLayout({SemanticType::Normal, 0}, SizePTNTC(), offsetof(VertexPTNTC, Normal), VertexFormat::SNorm16x2);
+}
+constexpr VertexBufferLayout GetVertexTexPTNTC(int index, TexCoordEncoding encoding) {
+  return VertexBufferLayout({SemanticType::TexCoord, index}, SizePTNTC(), offsetof(VertexPTNTC, TexCoord), MapTexCoordFormat(encoding));
+}
+//位置量化为UNORM16，共24字节
+struct VertexPTNTQ {
+  uint16_t Position[4];
+  int16_t Tangent[4];
+  int16_t Normal[2];
+  uint16_t TexCoord[2];
+};
+constexpr int SizePTNTQ() { return static_cast<int>(sizeof(VertexPTNTQ)); }
+std::vector<VertexPTNTQ> GenVboDataPTNTQ(ArrayView<Vector3f> pos,
+                                         ArrayView<Vector4f> tan,
+                                         ArrayView<Vector3f> normal,
+                                         ArrayView<Vector2f> tex,
+                                         const PositionQuantization& quant,
+                                         TexCoordEncoding encoding);
+constexpr VertexBufferLayout GetVertexPosPTNTQ() {
+  return VertexBufferLayout({SemanticType::Vertex, 0}, SizePTNTQ(), offsetof(VertexPTNTQ, Position), VertexFormat::UNorm16x4);
+}
+constexpr VertexBufferLayout GetVertexTanPTNTQ() {
+  return VertexBufferLayout({SemanticType::Tangent, 0}, SizePTNTQ(), offsetof(VertexPTNTQ, Tangent), VertexFormat::SNorm16x4);
+}
+constexpr VertexBufferLayout GetVertexNormalPTNTQ() {
+  return VertexBufferLayout({SemanticType::Normal, 0}, SizePTNTQ(), offsetof(VertexPTNTQ, Normal), VertexFormat::SNorm16x2);
+}
+constexpr VertexBufferLayout GetVertexTexPTNTQ(int index, TexCoordEncoding encoding) {
+  return VertexBufferLayout({SemanticType::TexCoord, index}, SizePTNTQ(), offsetof(VertexPTNTQ, TexCoord), MapTexCoordFormat(encoding));
+}
+
 ShaderAttributeLayout POSITION();
 ShaderAttributeLayout TANGENT();
 ShaderAttributeLayout NORMAL();
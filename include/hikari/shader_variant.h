@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <future>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+
+#include <hikari/render_context.h>
+
+namespace Hikari {
+/**
+ * @brief 着色器变体的一个关键字维度，变体通过 #define Name Value 区分
+ */
+struct ShaderKeywordAxis {
+  std::string Name;
+  std::string DefaultValue;
+};
+
+/**
+ * @brief 一个变体的编译状态和耗时，单位毫秒。PreprocessTime 是线程池上的预处理耗时，
+ * CompileTime 是从提交给驱动到发现完成的时间
+ */
+struct ShaderVariantStats {
+  std::vector<std::string> Values;
+  double PreprocessTime{};
+  double CompileTime{};
+  bool IsReady{};
+  bool IsFailed{};
+};
+
+/**
+ * @brief 变体编译的各个步骤，默认调用 RenderContextOpenGL 的对应函数。
+ * Preprocess 在线程池上执行，其余都在GL线程上。替换后不需要GL上下文也能检查变体的选择和回退
+ */
+struct ShaderVariantBackend {
+  std::function<void(RenderContextOpenGL&, const ShaderProgramRequest&, std::string& vs, std::string& fs)> Preprocess;
+  std::function<std::shared_ptr<ShaderProgramTask>(RenderContextOpenGL&, const std::string& vs, const std::string& fs, const ShaderAttributeLayouts&)> Submit;
+  std::function<bool(RenderContextOpenGL&, ShaderProgramTask&)> Poll;
+  std::function<void(RenderContextOpenGL&, ShaderProgramTask&)> Wait;
+
+  static ShaderVariantBackend Default();
+};
+
+/**
+ * @brief 一个着色器程序按关键字展开的所有变体。变体第一次被请求时才编译，从来没用到的组合不会编译。
+ * 没编译好时 Get 返回最近一次可用的变体作为回退
+ */
+class ShaderPermutation {
+ public:
+  ShaderPermutation(const ShaderProgramRequest& base,
+                    const std::vector<ShaderKeywordAxis>& axes,
+                    ShaderVariantBackend backend = ShaderVariantBackend::Default());
+  ShaderPermutation(const ShaderPermutation&) = delete;
+  ~ShaderPermutation() noexcept;
+
+  const ShaderProgramRequest& GetRequest() const;
+  const std::vector<ShaderKeywordAxis>& GetAxes() const;
+  /**
+   * @brief 从关键字表里取出每个维度的值，表里没有的维度用默认值
+   */
+  std::vector<std::string> SelectValues(const std::unordered_map<std::string, std::string>& keywords) const;
+  /**
+   * @brief 开始在线程池上预处理变体，已经开始或者已经完成时什么也不做
+   */
+  void Prepare(RenderContextOpenGL& ctx, const std::vector<std::string>& values);
+  /**
+   * @brief 等待预处理完成并提交给驱动，不等待驱动编译。启动时先提交所有程序，驱动可以并行编译
+   */
+  void Submit(RenderContextOpenGL& ctx, const std::vector<std::string>& values);
+  /**
+   * @brief 变体已经可用时直接返回；否则开始后台预处理并返回回退变体。还没有任何可用变体时等待这个变体编译完成
+   */
+  std::shared_ptr<ProgramOpenGL> Get(RenderContextOpenGL& ctx, const std::vector<std::string>& values);
+  /**
+   * @brief 在GL线程上提交预处理完成的变体，每次最多提交 maxCount 个，避免一帧卡太久；
+   * 再检查已经提交的变体，驱动完成的才做反射
+   */
+  void Update(RenderContextOpenGL& ctx, int maxCount = 1);
+  bool IsCompiling() const;
+  std::vector<ShaderVariantStats> GetStats() const;
+
+ private:
+  struct Preprocessed {
+    std::string Vs;
+    std::string Fs;
+    double Time;
+  };
+  struct Variant {
+    ShaderVariantStats Stats;
+    std::shared_ptr<ProgramOpenGL> Program;
+    std::future<Preprocessed> Pending;
+    std::shared_ptr<ShaderProgramTask> Task;
+    std::chrono::time_point<std::chrono::high_resolution_clock> SubmitTime;
+  };
+
+  std::string MakeKey(const std::vector<std::string>& values) const;
+  Variant& GetVariant(RenderContextOpenGL& ctx, const std::vector<std::string>& values);
+  void SubmitVariant(RenderContextOpenGL& ctx, Variant& variant);
+  void CompleteVariant(Variant& variant);
+  void WaitVariant(RenderContextOpenGL& ctx, Variant& variant);
+
+  ShaderProgramRequest _base;
+  std::vector<ShaderKeywordAxis> _axes;
+  ShaderVariantBackend _backend;
+  std::unordered_map<std::string, Variant> _variants;
+  std::shared_ptr<ProgramOpenGL> _fallback;
+};
+
+}  // namespace Hikari
@@ -0,0 +1,22 @@
+#ifndef HIKARI_ENVIRONMENT_INCLUDED
+#define HIKARI_ENVIRONMENT_INCLUDED
+
+//三阶球谐表示的环境光辐照度，系数已经乘上基函数常数和余弦卷积，结果与卷积cubemap相同
+layout(std140) uniform HikariEnvironment {
+  vec3 u_IrradianceSH[9];
+};
+
+vec3 GetIrradianceSH(vec3 n) {
+  vec3 e = u_IrradianceSH[0];
+  e += u_IrradianceSH[1] * n.y;
+  e += u_IrradianceSH[2] * n.z;
+  e += u_IrradianceSH[3] * n.x;
+  e += u_IrradianceSH[4] * (n.x * n.y);
+  e += u_IrradianceSH[5] * (n.y * n.z);
+  e += u_IrradianceSH[6] * (3.0 * n.z * n.z - 1.0);
+  e += u_IrradianceSH[7] * (n.x * n.z);
+  e += u_IrradianceSH[8] * (n.x * n.x - n.y * n.y);
+  return max(e, vec3(0.0));
+}
+
+#endif
@@ -26,12 +26,13 @@ vec3 GetDirLightDirection(int idx) {
   return normalize(u_LightDirectionDir[idx]);
 }
 
+//新变体编译好之前，回退变体的数组可能比灯光数量短
 int GetDirLightCount() {
-  return u_LightDirCount;
+  return min(u_LightDirCount, MAX_DIR_LIGHT);
 }
 
 int GetPointLightCount() {
-  return u_LightPointCount;
+  return min(u_LightPointCount, MAX_POI_LIGHT);
 }
 
 vec3 GetPointLightDirection(int idx, vec3 point) {
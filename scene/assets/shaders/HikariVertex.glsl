@@ -0,0 +1,25 @@
+#ifndef HIKARI_VERTEX_INCLUDED
+#define HIKARI_VERTEX_INCLUDED
+
+//压缩顶点格式（VertexPNTC/VertexPNTQ/VertexPTNTC/VertexPTNTQ）的解码
+
+uniform vec3 u_PositionOffset;
+uniform vec3 u_PositionScale;
+
+vec3 HikariDecodePosition(vec4 pos) {
+  return u_PositionOffset + u_PositionScale * pos.xyz;
+}
+
+vec3 HikariDecodeOctahedral(vec2 e) {
+  vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+
+vec4 HikariDecodeTangent(vec4 tangent) {
+  return vec4(HikariDecodeOctahedral(tangent.xy), tangent.z < 0.0 ? -1.0 : 1.0);
+}
+
+#endif
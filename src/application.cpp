@@ -4,6 +4,8 @@
 #include <algorithm>
 #include <thread>
 #include <cstring>
+#include <limits>
+#include <stdexcept>
 
 #include <hikari/opengl.h>
 
@@ -130,19 +132,12 @@ void GameObject::CreateVbo(const ImmutableModel& model, std::shared_ptr<BufferOp
 }
 
 void GameObject::CreateVboIbo(const ImmutableModel& model,
-                              std::shared_ptr<BufferOpenGL>& vbo, std::shared_ptr<BufferOpenGL>& ibo) {
+                              std::shared_ptr<BufferOpenGL>& vbo, std::shared_ptr<BufferOpenGL>& ibo,
+                              IndexDataType& indexType) {
   auto vertex = GenVboDataPNT(model.GetPosition(), model.GetNormals(), model.GetTexCoords());
   vbo = Application::GetInstance().GetContext().CreateVbo(vertex);
-  std::vector<uint32_t> indices(model.GetIndexCount());
-  for (size_t i = 0; i < model.GetIndexCount(); i++) {
-    if (model.GetIndices()[i] >= std::numeric_limits<uint32_t>::max()) {
-      throw AppRuntimeException("model vertex index out of range");
-    }
-    indices[i] = static_cast<decltype(indices)::value_type>(model.GetIndices()[i]);
-  }
-  auto indexData = indices.data();
-  auto indexSize = indices.size() * sizeof(decltype(indices)::value_type);
-  ibo = Application::GetInstance().GetContext().CreateIndexBuffer(indexData, indexSize);
+  ibo = Application::GetInstance().GetContext().CreateIbo(model.GetIndices());
+  indexType = MapIndexFormat(model.GetIndexFormat());
 }
 
 MainCamera::MainCamera() : GameObject("Main Camera") {}
@@ -266,8 +261,28 @@ void LightCollection::Clear() {
 }
 
 std::vector<std::string> LightCollection::GetMacro() const {
-  return {std::string("#define MAX_DIR_LIGHT ") + std::to_string(_dir.size() == 0 ? 1 : _dir.size()),
-          std::string("#define MAX_POI_LIGHT ") + std::to_string(_point.size() == 0 ? 1 : _point.size())};
+  std::vector<std::string> macros;
+  for (const auto& [name, value] : GetKeywords()) {
+    macros.emplace_back("#define " + name + " " + value);
+  }
+  return macros;
+}
+
+static size_t CeilPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+std::vector<std::pair<std::string, std::string>> LightCollection::GetKeywords() const {
+  return {{"MAX_DIR_LIGHT", std::to_string(CeilPowerOfTwo(_dir.size()))},
+          {"MAX_POI_LIGHT", std::to_string(CeilPowerOfTwo(_point.size()))}};
+}
+
+std::vector<ShaderKeywordAxis> LightCollection::GetKeywordAxes() {
+  return {{"MAX_DIR_LIGHT", "1"}, {"MAX_POI_LIGHT", "1"}};
 }
 
 Renderable::Renderable() noexcept = default;
@@ -276,51 +291,157 @@ Renderable::~Renderable() = default;
 
 bool Renderable::HasIbo() const { return _ibo != nullptr; }
 
+void Renderable::SetLodThreshold(float pixelError, float hysteresis) {
+  _lodThreshold = pixelError;
+  _lodHysteresis = hysteresis;
+}
+
+int Renderable::SelectLod(const Camera& camera, const Transform& transform, int viewportHeight, int currentLod) const {
+  const int count = GetLodCount();
+  if (count <= 1) {
+    return 0;
+  }
+  currentLod = std::clamp(currentLod, 0, count - 1);
+  const auto proj = camera.GetProjectionMatrix();
+  const auto& s = transform.LocalScale;
+  const float scale = std::max(std::abs(s.X()), std::max(std::abs(s.Y()), std::abs(s.Z())));
+  //投影矩阵第四列为0是透视投影，误差随距离缩小；正交投影与距离无关
+  const bool isPerspective = proj.At(3, 3) == 0;
+  float pixelPerUnit = proj.At(1, 1) * float(viewportHeight) * 0.5f * scale;
+  if (isPerspective) {
+    //与着色器里的 u_ObjectToWorld * pos 一致
+    auto center = Transpose(transform.ObjectToWorldMatrix()) * Vector4f{_boundsCenter.X(), _boundsCenter.Y(), _boundsCenter.Z(), 1.0f};
+    float distance = Length(Vector3f(center.X(), center.Y(), center.Z()) - camera.GetPosition()) - _boundsRadius * scale;
+    pixelPerUnit /= std::max(distance, 1e-4f);
+  }
+  auto screenError = [&](int lod) { return _lods[lod].Error * pixelPerUnit; };
+  int target = 0;
+  for (int i = count - 1; i > 0; i--) {
+    if (screenError(i) <= _lodThreshold) {
+      target = i;
+      break;
+    }
+  }
+  if (target > currentLod) {
+    //变粗时误差要明显低于阈值
+    while (target > currentLod && screenError(target) > _lodThreshold * (1 - _lodHysteresis)) {
+      target--;
+    }
+  } else if (target < currentLod && screenError(currentLod) <= _lodThreshold * (1 + _lodHysteresis)) {
+    //变细时当前级别的误差要明显超过阈值
+    target = currentLod;
+  }
+  return target;
+}
+
+void Renderable::DrawLod(RenderPass& pass, int lod) const {
+  if (!HasIbo() || _lods.empty()) {
+    Draw(pass);
+    return;
+  }
+  const auto& level = _lods[std::clamp(lod, 0, GetLodCount() - 1)];
+  pass.DrawIndexed(int(level.IndexCount), int(level.IndexStart), _indexType);
+}
+
 void Renderable::Draw(RenderPass& pass) const {
   if (HasIbo()) {
-    pass.DrawIndexed(GetDrawCount(), 0);
+    pass.DrawIndexed(GetDrawCount(), 0, _indexType);
   } else {
     pass.Draw(GetDrawCount(), 0);
   }
 }
 
-void Renderable::CreateVbo(const ImmutableModel& model) {
+const ImmutableModel& Renderable::PrepareModel(const ImmutableModel& model, std::optional<ImmutableModel>& optimized) {
+  if (!_isOptimizeMesh || model.GetIndexCount() == 0) {
+    return model;
+  }
+  optimized.emplace(OptimizeModel(model, &_optimizeStats));
+  std::cout << "optimize mesh " << model.GetName()
+            << ": ACMR " << _optimizeStats.Before.Acmr << " -> " << _optimizeStats.After.Acmr
+            << ", ATVR " << _optimizeStats.Before.Atvr << " -> " << _optimizeStats.After.Atvr << "\n";
+  return *optimized;
+}
+
+void Renderable::InitLod(const ImmutableModel& model) {
+  const auto& min = model.GetBoundsMin();
+  const auto& max = model.GetBoundsMax();
+  _boundsCenter = (min + max) * Vector3f(0.5f);
+  _boundsRadius = Length(max - min) * 0.5f;
+  _lods.clear();
+  _lods.emplace_back(MeshLod{0, model.GetIndexCount(), 0.0f});
+}
+
+void Renderable::CreateLodIbo(const ImmutableModel& model) {
+  std::vector<uint32_t> indices;
+  _lods = BuildLodChain(model, indices);
+  std::cout << "lod chain " << model.GetName() << ":";
+  for (const auto& lod : _lods) {
+    std::cout << " " << lod.IndexCount / 3;
+  }
+  std::cout << " triangles\n";
+  _drawCount = int(_lods[0].IndexCount);
+  auto& ctx = Application::GetInstance().GetContext();
+  if (model.GetIndexFormat() == IndexFormat::UInt16) {
+    //各级都引用原模型的顶点，宽度与原模型一致
+    std::vector<uint16_t> narrow(indices.begin(), indices.end());
+    _ibo = ctx.CreateIbo(narrow);
+  } else {
+    _ibo = ctx.CreateIbo(indices);
+  }
+  _indexType = MapIndexFormat(model.GetIndexFormat());
+}
+
+void Renderable::CreateVbo(const ImmutableModel& input) {
+  std::optional<ImmutableModel> optimized;
+  const auto& model = PrepareModel(input, optimized);
+  InitLod(model);
   _drawCount = int(model.GetIndexCount());
   GameObject::CreateVbo(model, _vbo);
 }
 
-void Renderable::CreateVboIbo(const ImmutableModel& model) {
+void Renderable::CreateVboIbo(const ImmutableModel& input) {
+  std::optional<ImmutableModel> optimized;
+  const auto& model = PrepareModel(input, optimized);
+  InitLod(model);
   _drawCount = int(model.GetIndexCount());
-  GameObject::CreateVboIbo(model, _vbo, _ibo);
+  if (_isGenerateLod) {
+    auto vertex = GenVboDataPNT(model.GetPosition(), model.GetNormals(), model.GetTexCoords());
+    _vbo = Application::GetInstance().GetContext().CreateVbo(vertex);
+    CreateLodIbo(model);
+  } else {
+    GameObject::CreateVboIbo(model, _vbo, _ibo, _indexType);
+  }
 }
 
-void Renderable::CreateVboWithTangent(const ImmutableModel& model) {
+void Renderable::CreateVboWithTangent(const ImmutableModel& input) {
+  std::optional<ImmutableModel> optimized;
+  const auto& model = PrepareModel(input, optimized);
   auto ptnt = GenVboDataPTNT(model.GetPosition(),
                              model.GetTangents(),
                              model.GetNormals(),
                              model.GetTexCoords(),
                              model.GetIndices());
+  InitLod(model);
   _drawCount = int(model.GetIndexCount());
   _vbo = Application::GetInstance().GetContext().CreateVbo(ptnt);
 }
 
-void Renderable::CreateVboIboWithTangent(const ImmutableModel& model) {
+void Renderable::CreateVboIboWithTangent(const ImmutableModel& input) {
+  std::optional<ImmutableModel> optimized;
+  const auto& model = PrepareModel(input, optimized);
+  InitLod(model);
   _drawCount = int(model.GetIndexCount());
   auto vertex = GenVboDataPTNT(model.GetPosition(),
                                model.GetTangents(),
                                model.GetNormals(),
                                model.GetTexCoords());
   _vbo = Application::GetInstance().GetContext().CreateVbo(vertex);
-  std::vector<uint32_t> indices(model.GetIndexCount());
-  for (size_t i = 0; i < model.GetIndexCount(); i++) {
-    if (model.GetIndices()[i] >= std::numeric_limits<uint32_t>::max()) {
-      throw AppRuntimeException("model vertex index out of range");
-    }
-    indices[i] = static_cast<decltype(indices)::value_type>(model.GetIndices()[i]);
+  if (_isGenerateLod) {
+    CreateLodIbo(model);
+    return;
   }
-  auto indexData = indices.data();
-  auto indexSize = indices.size() * sizeof(decltype(indices)::value_type);
-  _ibo = Application::GetInstance().GetContext().CreateIndexBuffer(indexData, indexSize);
+  _ibo = Application::GetInstance().GetContext().CreateIbo(model.GetIndices());
+  _indexType = MapIndexFormat(model.GetIndexFormat());
 }
 
 RenderableWithTangent::RenderableWithTangent(float hasTan) noexcept : Renderable(), _hasTangent(hasTan) {}
@@ -437,10 +558,17 @@ void RenderPass::SetProgram(const std::string& vs, const std::string& fs, const
 
 void RenderPass::LoadProgram(const std::filesystem::path& vsPath, const std::filesystem::path& fsPath,
                              const ShaderAttributeLayouts& layouts) {
-  auto macros = GetApp().GetLights().GetMacro();
-  _prog = GetContext().LoadShaderProgram(vsPath, fsPath, GetApp().GetShaderLibPath(), layouts, macros);
+  LoadProgram(vsPath, fsPath, layouts, LightCollection::GetKeywordAxes());
+}
+
+void RenderPass::LoadProgram(const std::filesystem::path& vsPath, const std::filesystem::path& fsPath,
+                             const ShaderAttributeLayouts& layouts, const std::vector<ShaderKeywordAxis>& axes) {
+  auto& app = GetApp();
+  _permutation = app.LoadProgram({vsPath, fsPath, app.GetShaderLibPath(), layouts, {}}, axes, _prog);
 }
 
+const std::shared_ptr<ShaderPermutation>& RenderPass::GetProgramPermutation() const { return _permutation; }
+
 PipelineState& RenderPass::GetPipelineState() { return _pipeState; }
 
 void RenderPass::SetPipelineState(const PipelineState& state) { _pipeState = state; }
@@ -470,6 +598,10 @@ void RenderPass::SetVertexBuffer(const BufferOpenGL& vbo, const VertexBufferLayo
     return;
   }
   const auto& vao = GetApp().GetContext().GetVertexArray(_prog);
+  auto attrib = _prog->GetAttribute(layout.Semantic);
+  if (attrib.has_value()) {
+    vao.SetAttribFormat((GLuint)bp, (*attrib)->Type, layout.Format);
+  }
   vao.SetVertexBuffer({(GLuint)bp, vbo.GetHandle(), layout.Offset, layout.Stride});
 }
 
@@ -495,6 +627,11 @@ uint32_t RenderPass::BindTexture(const TextureOpenGL& texture) {
   return slot;
 }
 
+void RenderPass::SetPositionDequantization(const PositionQuantization& quant) {
+  _prog->UniformVec3(UNIFORM_POSITION_OFFSET, quant.Offset.GetAddress());
+  _prog->UniformVec3(UNIFORM_POSITION_SCALE, quant.Scale.GetAddress());
+}
+
 void RenderPass::SetModelMatrix(const GameObject& go) {
   auto m = go.GetTransform().ObjectToWorldMatrix();
   Matrix4f invM;
@@ -511,8 +648,9 @@ void RenderPass::Draw(int vertexCount, int vertexStart) {
   GetApp().GetContext().DrawArrays(_pipeState.Primitive, vertexStart, vertexCount);
 }
 
-void RenderPass::DrawIndexed(int indexCount, int indexStart) {
-  GetApp().GetContext().DrawElements(_pipeState.Primitive, indexCount, IndexDataType::UnsignedInt, indexStart);
+void RenderPass::DrawIndexed(int indexCount, int indexStart, IndexDataType type) {
+  //glDrawElements的偏移以字节为单位
+  GetApp().GetContext().DrawElements(_pipeState.Primitive, indexCount, type, indexStart * SizeOfIndexDataType(type));
 }
 
 Application::Application() {
@@ -596,23 +734,80 @@ void Application::Awake() {
   for (auto& mesh : _renderables) {
     mesh.second->OnCreate();
   }
+  _isCollectingPrograms = true;
   for (auto& gameObject : _gameObjects) {
     gameObject->OnStart();
   }
   for (auto& renderPass : _renderPasses) {
     renderPass->OnStart();
   }
+  _isCollectingPrograms = false;
+  LoadPendingPrograms();
   for (auto& gameObject : _gameObjects) {
     gameObject->OnPostStart();
   }
   for (auto& renderPass : _renderPasses) {
     renderPass->OnPostStart();
   }
+  //启动阶段请求的资源都已经上传，释放管理器持有的CPU端副本
+  auto assetStats = _assets.GetMemoryStats();
+  std::cout << "asset memory peak:" << assetStats.Peak / (1024.0 * 1024.0) << "MB"
+            << " evicted:" << assetStats.EvictCount
+            << " reloaded:" << assetStats.ReloadCount << std::endl;
+  _assets.Clear();
   if (feature.GetMajorVersion() >= 4 && feature.GetMinorVersion() >= 1) {
     HIKARI_CHECK_GL(glReleaseShaderCompiler());
   }
 }
 
+std::shared_ptr<ShaderPermutation> Application::LoadProgram(const ShaderProgramRequest& base,
+                                                            const std::vector<ShaderKeywordAxis>& axes,
+                                                            std::shared_ptr<ProgramOpenGL>& target) {
+  auto permutation = std::make_shared<ShaderPermutation>(base, axes);
+  auto iter = std::find_if(_programVariants.begin(), _programVariants.end(), [&](const auto& p) { return p.second == &target; });
+  if (iter == _programVariants.end()) {
+    _programVariants.emplace_back(permutation, &target);
+  } else {
+    iter->first = permutation;
+  }
+  if (!_isCollectingPrograms) {
+    target = permutation->Get(_context, permutation->SelectValues(_shaderKeywords));
+  }
+  return permutation;
+}
+
+void Application::SetShaderKeyword(const std::string& name, const std::string& value) { _shaderKeywords[name] = value; }
+
+void Application::LoadPendingPrograms() {
+  if (_programVariants.empty()) {
+    return;
+  }
+  auto start = std::chrono::high_resolution_clock::now();
+  for (const auto& [name, value] : _lights.GetKeywords()) {
+    _shaderKeywords[name] = value;
+  }
+  //先把所有程序的预处理都交给线程池，再全部提交给驱动，最后等待驱动完成
+  for (auto& [permutation, _] : _programVariants) {
+    permutation->Prepare(_context, permutation->SelectValues(_shaderKeywords));
+  }
+  for (auto& [permutation, _] : _programVariants) {
+    permutation->Submit(_context, permutation->SelectValues(_shaderKeywords));
+  }
+  UpdateProgramVariants();
+  auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start);
+  std::cout << "load " << _programVariants.size() << " shader programs in " << elapsed.count() << "ms" << std::endl;
+}
+
+void Application::UpdateProgramVariants() {
+  for (const auto& [name, value] : _lights.GetKeywords()) {
+    _shaderKeywords[name] = value;
+  }
+  for (auto& [permutation, target] : _programVariants) {
+    permutation->Update(_context);
+    *target = permutation->Get(_context, permutation->SelectValues(_shaderKeywords));
+  }
+}
+
 void Application::Run() {
   const auto& feature = FeatureOpenGL::Get();
   while (!_window.ShouldClose()) {
@@ -625,6 +820,7 @@ void Application::Run() {
     for (auto& gameObject : _gameObjects) {  //更新GameObject
       gameObject->OnUpdate();
     }
+    UpdateProgramVariants();  //灯光数量等关键字变化时切换变体，新变体编译好之前继续用旧的
     _lights.CollectData();
     _lights.SubmitData(_context);             //上传灯光
     _context.SubmitGlobalUnifroms();          //上传所有uniform block块数据
@@ -669,6 +865,19 @@ void Application::Destroy() {
   _shared.clear();
   _renderables.clear();
   _camera = nullptr;
+  if (_isPrintVariantStats) {
+    for (const auto& [permutation, _] : _programVariants) {
+      for (const auto& stats : permutation->GetStats()) {
+        std::cout << "shader variant " << permutation->GetRequest().FsPath.filename().string();
+        for (const auto& value : stats.Values) {
+          std::cout << " " << value;
+        }
+        std::cout << " preprocess:" << stats.PreprocessTime << "ms compile:" << stats.CompileTime << "ms"
+                  << (stats.IsFailed ? " failed" : "") << std::endl;
+      }
+    }
+  }
+  _programVariants.clear();
   _lights.Clear();
   _gameObjects.clear();
   _renderPasses.clear();
@@ -750,10 +959,27 @@ void Application::ParseArgs(int argc, char** argv) {
     std::cout << "Command-line arguments options:\n"
               << "  -A | --asset    Set asset root path\n"
               << "  --shader-lib    Set shader library root path.Default location is \"shaders\" folder in the asset path\n"
+              << "  --asset-budget  Set CPU memory budget of decoded assets in MB.Default is unlimited\n"
               << std::endl;
   }
   for (int i = 1; i < argc;) {
-    if (strncmp(argv[i], "--asset", 7) == 0 || strncmp(argv[i], "-A", 2) == 0) {
+    if (strncmp(argv[i], "--asset-budget", 14) == 0) {  //必须在--asset之前判断
+      if (i == argc - 1) {
+        throw AppRuntimeException("invalid argument.--asset-budget must follow size in MB");
+      }
+      size_t budget;
+      try {
+        size_t pos;
+        budget = size_t(std::stoull(argv[i + 1], &pos));
+        if (pos != strlen(argv[i + 1]) || argv[i + 1][0] == '-' || budget > (std::numeric_limits<size_t>::max() >> 20)) {
+          throw std::out_of_range("asset budget");
+        }
+      } catch (std::logic_error&) {
+        throw AppRuntimeException(std::string("invalid argument.--asset-budget size is not a valid MB count: ") + argv[i + 1]);
+      }
+      _assets.SetMemoryBudget(budget << 20);
+      i += 2;
+    } else if (strncmp(argv[i], "--asset", 7) == 0 || strncmp(argv[i], "-A", 2) == 0) {
       if (i == argc - 1) {
         throw AppRuntimeException("invalid argument.--asset/-A must follow asset path");
       }
@@ -787,10 +1013,16 @@ void Application::EnableImgui() {
   _canUseImgui = true;
 }
 
+void Application::EnableShaderVariantStats() {
+  _isPrintVariantStats = true;
+}
+
 const std::filesystem::path& Application::GetAssetPath() const { return _assetRoot; }
 
 const std::filesystem::path& Application::GetShaderLibPath() const { return _shaderLibRoot; }
 
+AssetManager& Application::GetAssets() { return _assets; }
+
 std::any& Application::GetSharedObject(const std::string& name) {
   auto iter = _shared.find(name);
   if (iter == _shared.end()) {
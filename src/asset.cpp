@@ -1,13 +1,41 @@
 #include <hikari/asset.h>
 
 #include <iostream>
-#include <map>
 #include <fstream>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <cstdlib>
+#include <atomic>
 
 #include <stb_image.h>
 #include <tiny_obj_loader.h>
 
+#include <hikari/parallel.h>
+#include <hikari/mesh.h>
+#include <hikari/quantize.h>
+
 namespace Hikari {
+void FlipImageRows(void* data, size_t rowBytes, size_t rowCount) {
+  constexpr size_t block = 64;
+  auto bytes = static_cast<uint8_t*>(data);
+  for (size_t y = 0; y < rowCount / 2; y++) {
+    uint8_t* a = bytes + y * rowBytes;
+    uint8_t* b = bytes + (rowCount - 1 - y) * rowBytes;
+    size_t i = 0;
+    for (; i + block <= rowBytes; i += block) {
+      uint8_t temp[block];
+      std::memcpy(temp, a + i, block);
+      std::memcpy(a + i, b + i, block);
+      std::memcpy(b + i, temp, block);
+    }
+    for (; i < rowBytes; i++) {
+      std::swap(a[i], b[i]);
+    }
+  }
+}
+
 Asset::Asset() noexcept = default;
 
 Asset::~Asset() noexcept = default;
@@ -37,6 +65,10 @@ ImmutableBitmap::ImmutableBitmap(ImmutableBitmap&& other) noexcept {
 }
 
 ImmutableBitmap& ImmutableBitmap::operator=(ImmutableBitmap&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  Release();  //覆盖之前释放已有的数据
   _width = other._width;
   _height = other._height;
   _channelCount = other._channelCount;
@@ -61,6 +93,10 @@ void ImmutableBitmap::Release() {
   }
 }
 
+size_t ImmutableBitmap::GetByteSize() const {
+  return _data == nullptr ? 0 : size_t(_width) * _height * _channelCount;
+}
+
 int ImmutableBitmap::GetWidth() const {
   return _width;
 }
@@ -81,9 +117,13 @@ bool ImmutableBitmap::LoadFromDisk(const std::string& name,
                                    const std::filesystem::path& p,
                                    bool filpY,
                                    ImmutableBitmap& texture) {
-  stbi_set_flip_vertically_on_load(filpY);
+  //不使用stbi的全局翻转开关，多个线程可以同时解码
   int width, height, channels;
   auto data = stbi_load((const char*)p.generic_u8string().c_str(), &width, &height, &channels, 0);
+  if (data != nullptr && filpY) {
+    FlipImageRows(data, size_t(width) * channels, height);
+  }
+  texture.Release();
   texture._width = width;
   texture._height = height;
   texture._channelCount = channels;
@@ -92,20 +132,219 @@ bool ImmutableBitmap::LoadFromDisk(const std::string& name,
   return data != nullptr;
 }
 
+bool ImmutableBitmap::LoadFromDiskParallel(const std::vector<std::string>& names,
+                                           const std::vector<std::filesystem::path>& paths,
+                                           bool filpY,
+                                           std::vector<ImmutableBitmap>& result) {
+  if (names.size() != paths.size()) {
+    return false;
+  }
+  result.clear();
+  result.resize(paths.size());
+  std::atomic<bool> isSuccess{true};
+  ParallelFor(0, paths.size(), 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      if (!LoadFromDisk(names[i], paths[i], filpY, result[i])) {
+        std::cout << "can't load image " << paths[i] << ": " << stbi_failure_reason() << std::endl;
+        isSuccess = false;
+      }
+    }
+  });
+  return isSuccess;
+}
+
+bool ImmutableBitmap::LoadCubeFaces(const std::filesystem::path& directory,
+                                    const std::array<std::string, 6>& faces,
+                                    bool filpY,
+                                    std::array<ImmutableBitmap, 6>& result) {
+  std::vector<std::string> names(faces.begin(), faces.end());
+  std::vector<std::filesystem::path> paths;
+  paths.reserve(faces.size());
+  for (const auto& face : faces) {
+    paths.emplace_back(directory / face);
+  }
+  std::vector<ImmutableBitmap> bitmaps;
+  bool isSuccess = LoadFromDiskParallel(names, paths, filpY, bitmaps);
+  for (size_t i = 0; i < faces.size(); i++) {
+    result[i] = std::move(bitmaps[i]);
+  }
+  return isSuccess;
+}
+
 ImmutableHdrTexture::ImmutableHdrTexture() noexcept = default;
 
-ImmutableHdrTexture::ImmutableHdrTexture(const std::string& name, const std::filesystem::path& path, bool isFilpY) {
-  stbi_set_flip_vertically_on_load(isFilpY);
+//Radiance HDR逐行解码，每解出一行以RGBE调用 onRow(y, rgbe)。只支持标准的 -Y h +X w 方向，与stb_image一致
+template <typename OnRow>
+static bool DecodeRadianceScanlines(const uint8_t* data, size_t size, int& width, int& height, OnRow&& onRow) {
+  const uint8_t* cursor = data;
+  const uint8_t* end = data + size;
+  auto readLine = [&](std::string& line) {
+    line.clear();
+    while (cursor < end && *cursor != '\n') {
+      line.push_back(char(*cursor++));
+    }
+    if (cursor == end) {
+      return false;
+    }
+    cursor++;
+    return true;
+  };
+  std::string line;
+  if (!readLine(line) || (line != "#?RADIANCE" && line != "#?RGBE")) {
+    return false;
+  }
+  while (true) {
+    if (!readLine(line)) {
+      return false;
+    }
+    if (line.empty()) {
+      break;
+    }
+    if (line.rfind("FORMAT=", 0) == 0 && line != "FORMAT=32-bit_rle_rgbe") {
+      return false;
+    }
+  }
+  if (!readLine(line) || std::sscanf(line.c_str(), "-Y %d +X %d", &height, &width) != 2 || width <= 0 || height <= 0) {
+    return false;
+  }
+  std::vector<uint8_t> rgbe(size_t(width) * 4);
+  for (int y = 0; y < height; y++) {
+    bool isRle = width >= 8 && width < 32768 && end - cursor >= 4 &&
+                 cursor[0] == 2 && cursor[1] == 2 && (cursor[2] & 0x80) == 0;
+    if (!isRle) {
+      if (size_t(end - cursor) < rgbe.size()) {
+        return false;
+      }
+      std::memcpy(rgbe.data(), cursor, rgbe.size());
+      cursor += rgbe.size();
+    } else {
+      if (((int(cursor[2]) << 8) | cursor[3]) != width) {
+        return false;
+      }
+      cursor += 4;
+      //新式游程编码，四个分量分别存储
+      for (int k = 0; k < 4; k++) {
+        int x = 0;
+        while (x < width) {
+          if (cursor == end) {
+            return false;
+          }
+          int count = *cursor++;
+          if (count > 128) {
+            count -= 128;
+            if (count > width - x || cursor == end) {
+              return false;
+            }
+            uint8_t value = *cursor++;
+            for (int i = 0; i < count; i++) {
+              rgbe[size_t(x++) * 4 + k] = value;
+            }
+          } else {
+            if (count == 0 || count > width - x || end - cursor < count) {
+              return false;
+            }
+            for (int i = 0; i < count; i++) {
+              rgbe[size_t(x++) * 4 + k] = *cursor++;
+            }
+          }
+        }
+      }
+    }
+    onRow(y, rgbe.data());
+  }
+  return true;
+}
+
+ImmutableHdrTexture::ImmutableHdrTexture(const std::string& name,
+                                         const std::filesystem::path& path,
+                                         bool isFilpY,
+                                         HdrStorage storage) {
+  _name = name;
+  if (storage != HdrStorage::Float32 && LoadRadianceCompact(path, isFilpY, storage)) {
+    return;
+  }
   int width, height, channels;
   auto data = stbi_loadf((const char*)path.generic_u8string().c_str(), &width, &height, &channels, 0);
   if (data == nullptr) {
     throw AssetLoadException("can't load from disk");
   }
+  if (isFilpY) {
+    FlipImageRows(data, size_t(width) * channels * sizeof(float), height);
+  }
   _width = width;
   _height = height;
   _channelCount = channels;
   _data = data;
-  _name = name;
+  if (storage != HdrStorage::Float32) {
+    ConvertToCompact(storage);
+  }
+}
+
+bool ImmutableHdrTexture::LoadRadianceCompact(const std::filesystem::path& path, bool isFilpY, HdrStorage storage) {
+  MappedFile file;
+  if (!file.Open(path)) {
+    return false;
+  }
+  int width = 0, height = 0;
+  const size_t pixelBytes = storage == HdrStorage::Half ? 3 * sizeof(uint16_t) : sizeof(uint32_t);
+  std::vector<uint8_t> compact;
+  bool isSuccess = DecodeRadianceScanlines(file.GetData(), file.GetSize(), width, height, [&](int y, const uint8_t* rgbe) {
+    if (compact.empty()) {
+      compact.resize(size_t(width) * height * pixelBytes);
+    }
+    //翻转直接体现在写入的行号上，不需要额外的交换
+    size_t row = isFilpY ? size_t(height - 1 - y) : size_t(y);
+    uint8_t* dst = compact.data() + row * width * pixelBytes;
+    if (storage == HdrStorage::Half) {
+      auto half = reinterpret_cast<uint16_t*>(dst);
+      for (int x = 0; x < width; x++) {
+        const uint8_t* p = rgbe + size_t(x) * 4;
+        float scale = p[3] == 0 ? 0.0f : std::ldexp(1.0f, int(p[3]) - 136);
+        for (int c = 0; c < 3; c++) {
+          half[x * 3 + c] = FloatToHalf(std::min(float(p[c]) * scale, 65504.0f));
+        }
+      }
+    } else {
+      auto packed = reinterpret_cast<uint32_t*>(dst);
+      for (int x = 0; x < width; x++) {
+        packed[x] = RgbeToRgb9e5(rgbe + size_t(x) * 4);
+      }
+    }
+  });
+  if (!isSuccess) {
+    return false;
+  }
+  _width = width;
+  _height = height;
+  _channelCount = 3;
+  _storage = storage;
+  _compact = std::move(compact);
+  return true;
+}
+
+void ImmutableHdrTexture::ConvertToCompact(HdrStorage storage) {
+  if (_channelCount < 3) {
+    return;  //紧凑格式只有RGB，少于三个通道时保持float
+  }
+  const size_t pixelCount = size_t(_width) * _height;
+  const size_t pixelBytes = storage == HdrStorage::Half ? 3 * sizeof(uint16_t) : sizeof(uint32_t);
+  std::vector<uint8_t> compact(pixelCount * pixelBytes);
+  for (size_t i = 0; i < pixelCount; i++) {
+    const float* p = _data + i * _channelCount;
+    if (storage == HdrStorage::Half) {
+      auto half = reinterpret_cast<uint16_t*>(compact.data()) + i * 3;
+      for (int c = 0; c < 3; c++) {
+        half[c] = FloatToHalf(std::clamp(p[c], -65504.0f, 65504.0f));
+      }
+    } else {
+      reinterpret_cast<uint32_t*>(compact.data())[i] = FloatToRgb9e5(Vector3f{p[0], p[1], p[2]});
+    }
+  }
+  stbi_image_free(_data);
+  _data = nullptr;
+  _channelCount = 3;
+  _storage = storage;
+  _compact = std::move(compact);
 }
 
 ImmutableHdrTexture::ImmutableHdrTexture(ImmutableHdrTexture&& other) noexcept {
@@ -115,15 +354,23 @@ ImmutableHdrTexture::ImmutableHdrTexture(ImmutableHdrTexture&& other) noexcept {
   _data = other._data;
   other._data = nullptr;
   _name = std::move(other._name);
+  _storage = other._storage;
+  _compact = std::move(other._compact);
 }
 
 ImmutableHdrTexture& ImmutableHdrTexture::operator=(ImmutableHdrTexture&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  Release();  //覆盖之前释放已有的数据
   _width = other._width;
   _height = other._height;
   _channelCount = other._channelCount;
   _data = other._data;
   other._data = nullptr;
   _name = std::move(other._name);
+  _storage = other._storage;
+  _compact = std::move(other._compact);
   return *this;
 }
 
@@ -136,13 +383,19 @@ ImmutableHdrTexture::~ImmutableHdrTexture() noexcept {
 
 const std::string& ImmutableHdrTexture::GetName() const { return _name; }
 
-bool ImmutableHdrTexture::IsValid() const { return _data != nullptr; }
+bool ImmutableHdrTexture::IsValid() const { return _data != nullptr || !_compact.empty(); }
 
 void ImmutableHdrTexture::Release() {
   if (_data != nullptr) {
     stbi_image_free(_data);
     _data = nullptr;
   }
+  _compact.clear();
+  _compact.shrink_to_fit();
+}
+
+size_t ImmutableHdrTexture::GetByteSize() const {
+  return _data == nullptr ? _compact.size() : size_t(_width) * _height * _channelCount * sizeof(float);
 }
 
 int ImmutableHdrTexture::GetWidth() const { return _width; }
@@ -153,6 +406,12 @@ int ImmutableHdrTexture::GetChannel() const { return _channelCount; }
 
 const float* const ImmutableHdrTexture::GetData() const { return _data; }
 
+HdrStorage ImmutableHdrTexture::GetStorage() const { return _storage; }
+
+const void* ImmutableHdrTexture::GetRawData() const {
+  return _storage == HdrStorage::Float32 ? static_cast<const void*>(_data) : _compact.data();
+}
+
 ImmutableModel::ImmutableModel() noexcept = default;
 
 ImmutableModel::ImmutableModel(const std::string& name, const std::filesystem::path& path) {
@@ -165,12 +424,19 @@ ImmutableModel::ImmutableModel(const std::string& name,
                                std::vector<Vector3f>&& pos,
                                std::vector<Vector3f>&& nor,
                                std::vector<Vector2f>&& tex,
-                               std::vector<size_t>&& ind) noexcept {
+                               std::vector<uint32_t>&& ind) noexcept {
   _name = name;
   _positions = std::move(pos);
   _normals = std::move(nor);
   _texcoords = std::move(tex);
   _indices = std::move(ind);
+  NarrowIndices();
+  BindViews();
+  if (_tangent.empty() && HasNormal() && HasTexCoord()) {
+    CalcTangents();
+    BindViews();
+  }
+  CalcBounds();
 }
 
 ImmutableModel::ImmutableModel(const std::string& name,
@@ -178,22 +444,24 @@ ImmutableModel::ImmutableModel(const std::string& name,
                                std::vector<Vector3f>&& nor,
                                std::vector<Vector2f>&& tex,
                                std::vector<Vector4f>&& tan,
-                               std::vector<size_t>&& ind) noexcept {
+                               std::vector<uint32_t>&& ind) noexcept {
   _name = name;
   _positions = std::move(pos);
   _normals = std::move(nor);
   _texcoords = std::move(tex);
   _tangent = std::move(tan);
   _indices = std::move(ind);
+  NarrowIndices();
+  BindViews();
+  if (_tangent.empty() && HasNormal() && HasTexCoord()) {
+    CalcTangents();
+    BindViews();
+  }
+  CalcBounds();
 }
 
 ImmutableModel::ImmutableModel(ImmutableModel&& other) noexcept {
-  _positions = std::move(other._positions);
-  _normals = std::move(other._normals);
-  _texcoords = std::move(other._texcoords);
-  _tangent = std::move(other._tangent);
-  _indices = std::move(other._indices);
-  _name = std::move(other._name);
+  *this = std::move(other);
 }
 
 ImmutableModel& ImmutableModel::operator=(ImmutableModel&& other) noexcept {
@@ -202,21 +470,23 @@ ImmutableModel& ImmutableModel::operator=(ImmutableModel&& other) noexcept {
   _texcoords = std::move(other._texcoords);
   _tangent = std::move(other._tangent);
   _indices = std::move(other._indices);
+  _indices16 = std::move(other._indices16);
   _name = std::move(other._name);
+  _mapped = std::move(other._mapped);
+  //vector移动后缓冲区不变，映射的地址也不变，视图可以直接复用
+  _positionView = other._positionView;
+  _normalView = other._normalView;
+  _texcoordView = other._texcoordView;
+  _tangentView = other._tangentView;
+  _indexView = other._indexView;
+  _boundsMin = other._boundsMin;
+  _boundsMax = other._boundsMax;
+  other.BindViews();
   return *this;
 }
 
 ImmutableModel::~ImmutableModel() noexcept {
-  _positions.clear();
-  _normals.clear();
-  _texcoords.clear();
-  _tangent.clear();
-  _indices.clear();
-  _positions.shrink_to_fit();
-  _normals.shrink_to_fit();
-  _texcoords.shrink_to_fit();
-  _tangent.shrink_to_fit();
-  _indices.shrink_to_fit();
+  Release();
 }
 
 const std::string& ImmutableModel::GetName() const {
@@ -224,7 +494,7 @@ const std::string& ImmutableModel::GetName() const {
 }
 
 bool ImmutableModel::IsValid() const {
-  return _positions.size() > 0;
+  return _positionView.size() > 0;
 }
 
 void ImmutableModel::Release() {
@@ -233,74 +503,442 @@ void ImmutableModel::Release() {
   _texcoords.clear();
   _tangent.clear();
   _indices.clear();
+  _indices16.clear();
   _positions.shrink_to_fit();
   _normals.shrink_to_fit();
   _texcoords.shrink_to_fit();
   _tangent.shrink_to_fit();
   _indices.shrink_to_fit();
+  _indices16.shrink_to_fit();
+  _mapped.Close();
+  BindViews();
 }
 
-const std::vector<Vector3f>& ImmutableModel::GetPosition() const {
-  return _positions;
+size_t ImmutableModel::GetByteSize() const {
+  //从缓存映射的模型也按视图计算，访问过的页同样占用物理内存
+  return _positionView.size() * sizeof(Vector3f) +
+         _normalView.size() * sizeof(Vector3f) +
+         _texcoordView.size() * sizeof(Vector2f) +
+         _tangentView.size() * sizeof(Vector4f) +
+         _indexView.GetByteSize();
 }
 
-const std::vector<Vector3f>& ImmutableModel::GetNormals() const {
-  return _normals;
-}
+ArrayView<Vector3f> ImmutableModel::GetPosition() const { return _positionView; }
 
-const std::vector<Vector2f>& ImmutableModel::GetTexCoords() const {
-  return _texcoords;
-}
+ArrayView<Vector3f> ImmutableModel::GetNormals() const { return _normalView; }
 
-const std::vector<Vector4f>& ImmutableModel::GetTangents() const {
-  return _tangent;
-}
+ArrayView<Vector2f> ImmutableModel::GetTexCoords() const { return _texcoordView; }
 
-const std::vector<size_t>& ImmutableModel::GetIndices() const {
-  return _indices;
-}
+ArrayView<Vector4f> ImmutableModel::GetTangents() const { return _tangentView; }
+
+IndexArrayView ImmutableModel::GetIndices() const { return _indexView; }
+
+IndexFormat ImmutableModel::GetIndexFormat() const { return _indexView.GetFormat(); }
+
+const Vector3f& ImmutableModel::GetBoundsMin() const { return _boundsMin; }
+
+const Vector3f& ImmutableModel::GetBoundsMax() const { return _boundsMax; }
 
 bool ImmutableModel::HasNormal() const {
-  return _normals.size() > 0;
+  return _normalView.size() > 0;
 }
 
 bool ImmutableModel::HasTexCoord() const {
-  return _texcoords.size() > 0;
+  return _texcoordView.size() > 0;
 }
 
 bool ImmutableModel::HasTangent() const {
-  return _tangent.size() > 0;
+  return _tangentView.size() > 0;
 }
 
 size_t ImmutableModel::GetVertexCount() const {
-  return _positions.size();
+  return _positionView.size();
 }
 
 size_t ImmutableModel::GetIndexCount() const {
-  return _indices.size();
+  return _indexView.size();
 }
 
 size_t ImmutableModel::GetTriangleCount() const {
-  assert(_indices.size() % 3 == 0);
-  return _indices.size() / 3;
-}
-
-struct __VertexIdx {
-  int p;
-  int n;
-  int t;
-  bool operator<(const __VertexIdx& v) const {
-    if (p < v.p) return true;
-    if (p > v.p) return false;
-    if (n < v.n) return true;
-    if (n > v.n) return false;
-    if (t < v.t) return true;
-    if (t > v.t) return false;
-    return false;
+  assert(_indexView.size() % 3 == 0);
+  return _indexView.size() / 3;
+}
+
+void ImmutableModel::BindViews() {
+  _positionView = _positions;
+  _normalView = _normals;
+  _texcoordView = _texcoords;
+  _tangentView = _tangent;
+  _indexView = _indices16.empty() ? IndexArrayView(_indices) : IndexArrayView(_indices16);
+}
+
+void ImmutableModel::NarrowIndices() {
+  if (_indices.empty() || ChooseIndexFormat(_positions.size()) != IndexFormat::UInt16) {
+    return;
+  }
+  _indices16.assign(_indices.begin(), _indices.end());
+  _indices.clear();
+  _indices.shrink_to_fit();
+}
+
+void ImmutableModel::CalcBounds() {
+  if (_positionView.empty()) {
+    _boundsMin = Vector3f{};
+    _boundsMax = Vector3f{};
+    return;
+  }
+  Vector3f min(std::numeric_limits<float>::max());
+  Vector3f max(std::numeric_limits<float>::lowest());
+  for (const auto& p : _positionView) {
+    for (size_t i = 0; i < 3; i++) {
+      min[i] = std::min(min[i], p[i]);
+      max[i] = std::max(max[i], p[i]);
+    }
   }
+  _boundsMin = min;
+  _boundsMax = max;
+}
+
+/**
+ * @brief 二进制网格缓存格式
+ * 文件头之后依次是位置、法线、纹理坐标、切线、索引，每段按16字节对齐，
+ * 数据与内存布局一致，加载时直接映射
+ */
+constexpr uint32_t MESH_CACHE_MAGIC = 0x434D4B48;  //"HKMC"
+constexpr uint32_t MESH_CACHE_VERSION = 4;  //3: 切线改由 GenerateTangents 生成 4: 手性相反的共享顶点被拆分
+constexpr uint32_t MESH_CACHE_HAS_NORMAL = 1 << 0;
+constexpr uint32_t MESH_CACHE_HAS_TEXCOORD = 1 << 1;
+constexpr uint32_t MESH_CACHE_HAS_TANGENT = 1 << 2;
+
+struct MeshCacheHeader {
+  uint32_t Magic;
+  uint32_t Version;
+  uint64_t SourceHash;
+  uint64_t FileSize;
+  uint64_t VertexCount;
+  uint64_t IndexCount;
+  uint32_t Flags;
+  uint32_t IndexSize;
+  float BoundsMin[3];
+  float BoundsMax[3];
+  uint64_t PositionOffset;
+  uint64_t NormalOffset;
+  uint64_t TexCoordOffset;
+  uint64_t TangentOffset;
+  uint64_t IndexOffset;
 };
+static_assert(std::is_trivially_copyable_v<Vector3f> && sizeof(Vector3f) == 12, "cache layout");
+static_assert(sizeof(Vector2f) == 8 && sizeof(Vector4f) == 16, "cache layout");
+
+static uint64_t AlignCacheOffset(uint64_t offset) { return (offset + 15) & ~uint64_t(15); }
+
+std::filesystem::path ImmutableModel::GetCachePath(uint64_t sourceHash) {
+  return GetCacheDirectory() / "mesh" / (ToHexString(sourceHash) + ".hkm");
+}
+
+bool ImmutableModel::SaveToCache(const std::filesystem::path& cachePath, uint64_t sourceHash) const {
+  MeshCacheHeader header{};
+  header.Magic = MESH_CACHE_MAGIC;
+  header.Version = MESH_CACHE_VERSION;
+  header.SourceHash = sourceHash;
+  header.VertexCount = GetVertexCount();
+  header.IndexCount = GetIndexCount();
+  header.Flags = (HasNormal() ? MESH_CACHE_HAS_NORMAL : 0) |
+                 (HasTexCoord() ? MESH_CACHE_HAS_TEXCOORD : 0) |
+                 (HasTangent() ? MESH_CACHE_HAS_TANGENT : 0);
+  header.IndexSize = uint32_t(SizeOfIndexFormat(_indexView.GetFormat()));
+  for (size_t i = 0; i < 3; i++) {
+    header.BoundsMin[i] = _boundsMin[i];
+    header.BoundsMax[i] = _boundsMax[i];
+  }
+  struct Section {
+    const void* Data;
+    uint64_t Size;
+    uint64_t* Offset;
+  } sections[] = {
+      {_positionView.data(), _positionView.size() * sizeof(Vector3f), &header.PositionOffset},
+      {_normalView.data(), _normalView.size() * sizeof(Vector3f), &header.NormalOffset},
+      {_texcoordView.data(), _texcoordView.size() * sizeof(Vector2f), &header.TexCoordOffset},
+      {_tangentView.data(), _tangentView.size() * sizeof(Vector4f), &header.TangentOffset},
+      {_indexView.data(), _indexView.GetByteSize(), &header.IndexOffset}};
+  uint64_t offset = AlignCacheOffset(sizeof(MeshCacheHeader));
+  for (auto& sec : sections) {
+    *sec.Offset = offset;
+    offset = AlignCacheOffset(offset + sec.Size);
+  }
+  header.FileSize = offset;
+
+  std::error_code ec;
+  std::filesystem::create_directories(cachePath.parent_path(), ec);
+  //先写临时文件再重命名，避免其他进程映射到写了一半的缓存
+  auto tempPath = cachePath;
+  tempPath += ".tmp";
+  {
+    std::ofstream stream(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+      return false;
+    }
+    const char zero[16]{};
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t written = sizeof(header);
+    for (const auto& sec : sections) {
+      stream.write(zero, *sec.Offset - written);
+      if (sec.Size > 0) {
+        stream.write(static_cast<const char*>(sec.Data), sec.Size);
+      }
+      written = *sec.Offset + sec.Size;
+    }
+    stream.write(zero, header.FileSize - written);
+    if (!stream.good()) {
+      return false;
+    }
+  }
+  std::filesystem::rename(tempPath, cachePath, ec);
+  if (ec) {
+    std::filesystem::remove(tempPath, ec);
+    return false;
+  }
+  return true;
+}
+
+bool ImmutableModel::LoadFromCache(const std::string& name, const std::filesystem::path& cachePath, uint64_t sourceHash, ImmutableModel& mesh) {
+  MappedFile file;
+  if (!file.Open(cachePath) || file.GetSize() < sizeof(MeshCacheHeader)) {
+    return false;
+  }
+  MeshCacheHeader header;
+  std::memcpy(&header, file.GetData(), sizeof(header));
+  if (header.Magic != MESH_CACHE_MAGIC ||
+      header.Version != MESH_CACHE_VERSION ||
+      header.SourceHash != sourceHash ||
+      header.FileSize != file.GetSize() ||
+      (header.IndexSize != sizeof(uint16_t) && header.IndexSize != sizeof(uint32_t))) {
+    return false;
+  }
+  auto vCount = header.VertexCount;
+  auto section = [&](uint64_t offset, uint64_t count, size_t stride) {
+    return offset % 16 == 0 && offset <= header.FileSize && count <= (header.FileSize - offset) / stride;
+  };
+  if (!section(header.PositionOffset, vCount, sizeof(Vector3f)) ||
+      !section(header.NormalOffset, vCount, sizeof(Vector3f)) ||
+      !section(header.TexCoordOffset, vCount, sizeof(Vector2f)) ||
+      !section(header.TangentOffset, vCount, sizeof(Vector4f)) ||
+      !section(header.IndexOffset, header.IndexCount, header.IndexSize)) {
+    return false;
+  }
+  const uint8_t* base = file.GetData();
+  mesh.Release();
+  mesh._positionView = {reinterpret_cast<const Vector3f*>(base + header.PositionOffset), vCount};
+  if (header.Flags & MESH_CACHE_HAS_NORMAL) {
+    mesh._normalView = {reinterpret_cast<const Vector3f*>(base + header.NormalOffset), vCount};
+  }
+  if (header.Flags & MESH_CACHE_HAS_TEXCOORD) {
+    mesh._texcoordView = {reinterpret_cast<const Vector2f*>(base + header.TexCoordOffset), vCount};
+  }
+  if (header.Flags & MESH_CACHE_HAS_TANGENT) {
+    mesh._tangentView = {reinterpret_cast<const Vector4f*>(base + header.TangentOffset), vCount};
+  }
+  if (header.IndexSize == sizeof(uint16_t)) {
+    mesh._indexView = ArrayView<uint16_t>(reinterpret_cast<const uint16_t*>(base + header.IndexOffset), header.IndexCount);
+  } else {
+    mesh._indexView = ArrayView<uint32_t>(reinterpret_cast<const uint32_t*>(base + header.IndexOffset), header.IndexCount);
+  }
+  mesh._boundsMin = {header.BoundsMin[0], header.BoundsMin[1], header.BoundsMin[2]};
+  mesh._boundsMax = {header.BoundsMax[0], header.BoundsMax[1], header.BoundsMax[2]};
+  mesh._mapped = std::move(file);
+  mesh._name = name;
+  return true;
+}
+
+bool ImmutableModel::LoadFromFile(const std::string& name, const std::filesystem::path& path, ImmutableModel& mesh, const ModelImportOptions& options) {
+  uint64_t hash = 0;
+  std::filesystem::path cachePath;
+  if (options.UseCache && HashFileContent(path, hash)) {
+    cachePath = GetCachePath(hash);
+    std::error_code ec;
+    if (std::filesystem::exists(cachePath, ec) && LoadFromCache(name, cachePath, hash, mesh)) {
+      return true;
+    }
+  }
+  bool isLoaded = options.Importer == ModelImporter::Streaming
+                      ? LoadFromObjStreaming(name, path, options, mesh)
+                      : LoadFromObj(name, path, options.Importer, mesh);
+  if (!isLoaded) {
+    return false;
+  }
+  if (!cachePath.empty() && !mesh.SaveToCache(cachePath, hash)) {
+    std::cout << "can't write mesh cache: " << cachePath << "\n";
+  }
+  return true;
+}
+
+static inline size_t HashVertexIdx(int p, int n, int t) {
+  uint64_t k = (static_cast<uint64_t>(static_cast<uint32_t>(p)) << 32) | static_cast<uint32_t>(n);
+  k ^= static_cast<uint64_t>(static_cast<uint32_t>(t)) * 0x9E3779B97F4A7C15ULL;
+  k ^= k >> 33;
+  k *= 0xFF51AFD7ED558CCDULL;
+  k ^= k >> 33;
+  return static_cast<size_t>(k);
+}
+
+VertexDedupTable::VertexDedupTable(size_t indexCount) {
+  //封闭网格唯一顶点数通常远少于索引数，按一半预留，负载超过0.75时扩容
+  size_t capacity = 16;
+  while (capacity * 3 < (indexCount / 2) * 4) {
+    capacity <<= 1;
+  }
+  _slots.assign(capacity, Slot{-1, -1, -1, 0});
+  _mask = capacity - 1;
+}
+
+std::pair<uint32_t, bool> VertexDedupTable::Insert(int p, int n, int t, uint32_t next) {
+  assert(p >= 0);
+  if (IsFull()) {
+    Grow();
+  }
+  size_t i = HashVertexIdx(p, n, t) & _mask;
+  while (true) {
+    Slot& slot = _slots[i];
+    if (slot.P < 0) {
+      slot = {p, n, t, next};
+      _size++;
+      return {next, true};
+    }
+    if (slot.P == p && slot.N == n && slot.T == t) {
+      return {slot.Value, false};
+    }
+    i = (i + 1) & _mask;
+  }
+}
+
+size_t VertexDedupTable::GetSize() const { return _size; }
 
-bool ImmutableModel::LoadFromFile(const std::string& name, const std::filesystem::path& path, ImmutableModel& mesh) {
+size_t VertexDedupTable::GetMemoryBytes() const { return _slots.capacity() * sizeof(Slot); }
+
+bool VertexDedupTable::IsFull() const { return (_size + 1) * 4 > _slots.size() * 3; }
+
+void VertexDedupTable::Grow() {
+  std::vector<Slot> old(_slots.size() * 2, Slot{-1, -1, -1, 0});
+  old.swap(_slots);
+  _mask = _slots.size() - 1;
+  for (const auto& slot : old) {
+    if (slot.P < 0) {
+      continue;
+    }
+    size_t i = HashVertexIdx(slot.P, slot.N, slot.T) & _mask;
+    while (_slots[i].P >= 0) {
+      i = (i + 1) & _mask;
+    }
+    _slots[i] = slot;
+  }
+}
+
+template <typename ForEachCorner>
+bool ImmutableModel::BuildFromObj(const std::string& name,
+                                  ArrayView<float> pos,
+                                  ArrayView<float> nor,
+                                  ArrayView<float> tex,
+                                  size_t indexCount,
+                                  ForEachCorner&& forEach,
+                                  ImmutableModel& mesh) {
+  if (indexCount >= std::numeric_limits<uint32_t>::max()) {
+    std::cout << ".obj too many indices: " << indexCount << "\n";
+    return false;
+  }
+  mesh.Release();
+  const size_t posCount = pos.size() / 3;
+  const size_t norCount = nor.size() / 3;
+  const size_t texCount = tex.size() / 2;
+  VertexDedupTable uni(indexCount);
+  mesh._indices.reserve(indexCount);
+  uint32_t count = 0;
+  bool isValid = true;
+  forEach([&](int p, int n, int t) {
+    if (p < 0 || (size_t)p >= posCount || n >= (int64_t)norCount || t >= (int64_t)texCount) {
+      isValid = false;
+      return;
+    }
+    auto [index, isIn] = uni.Insert(p, n, t, count);
+    if (isIn) {
+      mesh._positions.emplace_back(pos[3 * (size_t)p + 0], pos[3 * (size_t)p + 1], pos[3 * (size_t)p + 2]);
+      if (n >= 0) {
+        mesh._normals.emplace_back(nor[3 * (size_t)n + 0], nor[3 * (size_t)n + 1], nor[3 * (size_t)n + 2]);
+      }
+      if (t >= 0) {
+        mesh._texcoords.emplace_back(tex[2 * (size_t)t + 0], tex[2 * (size_t)t + 1]);
+      }
+      count++;
+    }
+    mesh._indices.emplace_back(index);
+  });
+  if (!isValid) {
+    std::cout << ".obj index out of range\n";
+    mesh.Release();
+    return false;
+  }
+  mesh._positions.shrink_to_fit();
+  mesh._normals.shrink_to_fit();
+  mesh._texcoords.shrink_to_fit();
+  mesh.NarrowIndices();
+  mesh.BindViews();
+  if (mesh.HasNormal() && mesh.HasTexCoord()) {
+    mesh.CalcTangents();
+  }
+  mesh._name = name;
+  mesh.BindViews();
+  mesh.CalcBounds();
+  return true;
+}
+
+void ImmutableModel::CalcTangents() {
+  TangentSplit split;
+  _tangent = GenerateTangents(_indexView, _positionView, _normalView, _texcoordView, &split);
+  SplitVertices(split);
+}
+
+void ImmutableModel::SplitVertices(const TangentSplit& split) {
+  if (split.Sources.empty()) {
+    return;
+  }
+  //新顶点只有切线的手性不同，其余属性复制原顶点
+  auto append = [&](auto& attribute) {
+    attribute.reserve(attribute.size() + split.Sources.size());
+    for (uint32_t source : split.Sources) {
+      attribute.push_back(attribute[source]);
+    }
+  };
+  append(_positions);
+  append(_normals);
+  append(_texcoords);
+  if (!_indices16.empty() && ChooseIndexFormat(_positions.size()) != IndexFormat::UInt16) {
+    //拆分后16位索引放不下
+    _indices.assign(_indices16.begin(), _indices16.end());
+    _indices16.clear();
+    _indices16.shrink_to_fit();
+  }
+  for (const auto& [corner, vertex] : split.Remap) {
+    if (_indices16.empty()) {
+      _indices[corner] = vertex;
+    } else {
+      _indices16[corner] = static_cast<uint16_t>(vertex);
+    }
+  }
+}
+
+bool ImmutableModel::LoadFromObj(const std::string& name, const std::filesystem::path& path, ModelImporter importer, ImmutableModel& mesh) {
+  if (importer == ModelImporter::Parallel) {
+    ObjData data;
+    if (!ParseObjParallel(path, data)) {
+      std::cout << ".obj parse error: " << path << "\n";
+      return false;
+    }
+    auto forEach = [&](auto&& visit) {
+      for (const auto& c : data.Corners) {
+        visit(c.P, c.N, c.T);
+      }
+    };
+    return BuildFromObj(name, data.Positions, data.Normals, data.TexCoords, data.Corners.size(), forEach, mesh);
+  }
   using namespace tinyobj;
   ObjReader reader;
   bool isLoaded = reader.ParseFromFile((const char*)path.generic_u8string().c_str());
@@ -311,96 +949,623 @@ bool ImmutableModel::LoadFromFile(const std::string& name, const std::filesystem
   }
   const auto& attribs = reader.GetAttrib();
   const auto& shapes = reader.GetShapes();
-  size_t count = 0;
-  std::map<__VertexIdx, size_t> uni;
+  size_t indexCount = 0;
   for (const auto& shape : shapes) {
-    const auto& m = shape.mesh;
-    for (size_t j = 0; j < m.indices.size(); j++) {
-      const auto& idx = m.indices[j];
-      __VertexIdx vid{idx.vertex_index, idx.normal_index, idx.texcoord_index};
-      auto [iter, isIn] = uni.try_emplace(vid, count);
-      if (isIn) {
-        const auto& i = iter->first;
-        Vector3f pos = {attribs.vertices[3 * (size_t)i.p + 0],
-                        attribs.vertices[3 * (size_t)i.p + 1],
-                        attribs.vertices[3 * (size_t)i.p + 2]};
-        mesh._positions.emplace_back(pos);
-        if (i.n >= 0) {
-          Vector3f nor = {attribs.normals[3 * (size_t)i.n + 0],
-                          attribs.normals[3 * (size_t)i.n + 1],
-                          attribs.normals[3 * (size_t)i.n + 2]};
-          mesh._normals.emplace_back(nor);
+    indexCount += shape.mesh.indices.size();
+  }
+  auto forEach = [&](auto&& visit) {
+    for (const auto& shape : shapes) {
+      for (const auto& i : shape.mesh.indices) {
+        visit(i.vertex_index, i.normal_index, i.texcoord_index);
+      }
+    }
+  };
+  return BuildFromObj(name, attribs.vertices, attribs.normals, attribs.texcoords, indexCount, forEach, mesh);
+}
+
+//10的非负整数次幂，22以内可以用double精确表示
+static constexpr double OBJ_POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+static inline bool IsObjSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static inline bool IsObjDigit(char c) { return c >= '0' && c <= '9'; }
+
+static inline const char* SkipObjSpace(const char* p, const char* end) {
+  while (p < end && IsObjSpace(*p)) {
+    p++;
+  }
+  return p;
+}
+
+/**
+ * @brief 解析浮点数，有效数字不超过19位且指数较小时只需一次double乘除
+ * @return 解析结束的位置，失败返回nullptr
+ */
+static const char* ParseObjFloat(const char* p, const char* end, float& out) {
+  const char* start = p;
+  bool isNeg = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    isNeg = *p == '-';
+    p++;
+  }
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exp10 = 0;
+  bool hasDigit = false;
+  while (p < end && IsObjDigit(*p)) {
+    int d = *p - '0';
+    if (digits < 19) {
+      mantissa = mantissa * 10 + d;
+      digits += mantissa != 0;
+    } else {
+      exp10++;
+    }
+    hasDigit = true;
+    p++;
+  }
+  if (p < end && *p == '.') {
+    p++;
+    while (p < end && IsObjDigit(*p)) {
+      int d = *p - '0';
+      if (digits < 19) {
+        mantissa = mantissa * 10 + d;
+        digits += mantissa != 0;
+        exp10--;
+      }
+      hasDigit = true;
+      p++;
+    }
+  }
+  if (!hasDigit) {
+    //nan、inf等少见写法交给strtof
+    char buffer[64];
+    size_t len = 0;
+    while (start + len < end && len < sizeof(buffer) - 1 && !IsObjSpace(start[len]) && start[len] != '\n') {
+      buffer[len] = start[len];
+      len++;
+    }
+    buffer[len] = '\0';
+    char* parseEnd = nullptr;
+    out = std::strtof(buffer, &parseEnd);
+    return parseEnd == buffer ? nullptr : start + (parseEnd - buffer);
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    const char* e = p + 1;
+    bool isExpNeg = false;
+    if (e < end && (*e == '-' || *e == '+')) {
+      isExpNeg = *e == '-';
+      e++;
+    }
+    if (e < end && IsObjDigit(*e)) {
+      int exp = 0;
+      while (e < end && IsObjDigit(*e)) {
+        exp = std::min(exp * 10 + (*e - '0'), 10000);
+        e++;
+      }
+      exp10 += isExpNeg ? -exp : exp;
+      p = e;
+    }
+  }
+  double value = static_cast<double>(mantissa);
+  if (mantissa == 0) {
+    value = 0.0;
+  } else if (exp10 >= 0 && exp10 <= 22 && mantissa < (1ULL << 53)) {
+    value *= OBJ_POW10[exp10];
+  } else if (exp10 < 0 && exp10 >= -22 && mantissa < (1ULL << 53)) {
+    value /= OBJ_POW10[-exp10];
+  } else {
+    value *= std::pow(10.0, exp10);
+  }
+  out = static_cast<float>(isNeg ? -value : value);
+  return p;
+}
+
+static const char* ParseObjInt(const char* p, const char* end, int& out) {
+  bool isNeg = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    isNeg = *p == '-';
+    p++;
+  }
+  if (p >= end || !IsObjDigit(*p)) {
+    return nullptr;
+  }
+  int64_t value = 0;
+  while (p < end && IsObjDigit(*p)) {
+    value = std::min<int64_t>(value * 10 + (*p - '0'), std::numeric_limits<int>::max());
+    p++;
+  }
+  out = static_cast<int>(isNeg ? -value : value);
+  return p;
+}
+
+/**
+ * @brief 一个块的解析结果。负数索引相对于块内已有数量解析，合并时再加上前面块的数量
+ */
+struct ObjChunk {
+  const char* Begin;
+  const char* End;
+  std::vector<float> Positions;
+  std::vector<float> Normals;
+  std::vector<float> TexCoords;
+  std::vector<ObjCorner> Corners;
+  std::vector<size_t> RelativeFix;  //需要修正的分量，值为 角序号*3+分量
+  bool IsError = false;
+};
+
+static const char* ParseObjFloats(const char* p, const char* end, int required, int maxCount, std::vector<float>& out) {
+  for (int i = 0; i < maxCount; i++) {
+    p = SkipObjSpace(p, end);
+    if (p >= end || *p == '\n' || *p == '#') {
+      if (i < required) {
+        return nullptr;
+      }
+      out.emplace_back(0.0f);
+      continue;
+    }
+    float value;
+    p = ParseObjFloat(p, end, value);
+    if (p == nullptr) {
+      return nullptr;
+    }
+    out.emplace_back(value);
+  }
+  return p;
+}
+
+enum class ObjLine {
+  Other,
+  Position,
+  Normal,
+  TexCoord,
+  Face
+};
+
+/**
+ * @brief 判断行类型，返回关键字之后的位置
+ */
+static ObjLine ClassifyObjLine(const char* p, const char* lineEnd, const char*& rest) {
+  if (lineEnd - p >= 2 && p[0] == 'v' && IsObjSpace(p[1])) {
+    rest = p + 2;
+    return ObjLine::Position;
+  } else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && IsObjSpace(p[2])) {
+    rest = p + 3;
+    return ObjLine::Normal;
+  } else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && IsObjSpace(p[2])) {
+    rest = p + 3;
+    return ObjLine::TexCoord;
+  } else if (lineEnd - p >= 2 && p[0] == 'f' && IsObjSpace(p[1])) {
+    rest = p + 2;
+    return ObjLine::Face;
+  }
+  return ObjLine::Other;
+}
+
+struct ObjPolyCorner {
+  ObjCorner Corner;
+  int RelativeMask;  //负数索引的分量，1位置，2法线，4纹理坐标
+};
+
+/**
+ * @brief 解析一个面的所有角，负数索引相对于传入的已有数量解析
+ */
+static bool ParseObjFace(const char* p, const char* lineEnd, size_t posCount, size_t norCount, size_t texCount, std::vector<ObjPolyCorner>& poly) {
+  auto resolve = [](int value, size_t count, int& out, int bit, int& mask) {
+    if (value > 0) {
+      out = value - 1;
+      return true;
+    }
+    if (value < 0) {
+      out = static_cast<int>(count) + value;
+      mask |= bit;
+      return true;
+    }
+    return false;
+  };
+  poly.clear();
+  while (true) {
+    p = SkipObjSpace(p, lineEnd);
+    if (p >= lineEnd || *p == '#') {
+      return true;
+    }
+    int v = 0, t = 0, n = 0;
+    ObjPolyCorner c{{-1, -1, -1}, 0};
+    p = ParseObjInt(p, lineEnd, v);
+    if (p == nullptr || !resolve(v, posCount, c.Corner.P, 1, c.RelativeMask)) {
+      return false;
+    }
+    if (p < lineEnd && *p == '/') {
+      p++;
+      if (p < lineEnd && *p != '/') {
+        p = ParseObjInt(p, lineEnd, t);
+        if (p == nullptr || !resolve(t, texCount, c.Corner.T, 4, c.RelativeMask)) {
+          return false;
         }
-        if (i.t >= 0) {
-          Vector2f tex = {attribs.texcoords[2 * (size_t)i.t + 0],
-                          attribs.texcoords[2 * (size_t)i.t + 1]};
-          mesh._texcoords.emplace_back(tex);
+      }
+      if (p < lineEnd && *p == '/') {
+        p++;
+        p = ParseObjInt(p, lineEnd, n);
+        if (p == nullptr || !resolve(n, norCount, c.Corner.N, 2, c.RelativeMask)) {
+          return false;
         }
-        count++;
       }
-      mesh._indices.emplace_back(iter->second);
     }
+    poly.emplace_back(c);
   }
-  mesh._positions.shrink_to_fit();
-  mesh._normals.shrink_to_fit();
-  mesh._texcoords.shrink_to_fit();
+}
+
+static void ParseObjChunk(ObjChunk& chunk) {
+  std::vector<ObjPolyCorner> poly;
+  const char* p = chunk.Begin;
+  const char* end = chunk.End;
+  while (p < end) {
+    p = SkipObjSpace(p, end);
+    const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (lineEnd == nullptr) {
+      lineEnd = end;
+    }
+    const char* rest = nullptr;
+    bool isOk = true;
+    switch (ClassifyObjLine(p, lineEnd, rest)) {
+      case ObjLine::Position:
+        isOk = ParseObjFloats(rest, lineEnd, 3, 3, chunk.Positions) != nullptr;
+        break;
+      case ObjLine::Normal:
+        isOk = ParseObjFloats(rest, lineEnd, 3, 3, chunk.Normals) != nullptr;
+        break;
+      case ObjLine::TexCoord:
+        isOk = ParseObjFloats(rest, lineEnd, 1, 2, chunk.TexCoords) != nullptr;
+        break;
+      case ObjLine::Face: {
+        isOk = ParseObjFace(rest, lineEnd, chunk.Positions.size() / 3, chunk.Normals.size() / 3, chunk.TexCoords.size() / 2, poly);
+        //扇形三角化
+        for (size_t k = 2; isOk && k < poly.size(); k++) {
+          for (const auto* c : {&poly[0], &poly[k - 1], &poly[k]}) {
+            size_t corner = chunk.Corners.size();
+            for (int comp = 0; comp < 3; comp++) {
+              if (c->RelativeMask & (1 << comp)) {
+                chunk.RelativeFix.emplace_back(corner * 3 + comp);
+              }
+            }
+            chunk.Corners.emplace_back(c->Corner);
+          }
+        }
+        break;
+      }
+      default:
+        break;
+    }
+    if (!isOk) {
+      chunk.IsError = true;
+      return;
+    }
+    p = lineEnd + 1;
+  }
+}
+
+bool ParseObjParallel(const std::filesystem::path& path, ObjData& data) {
+  MappedFile file;
+  if (!file.Open(path)) {
+    return false;
+  }
+  const char* begin = reinterpret_cast<const char*>(file.GetData());
+  const char* end = begin + file.GetSize();
+  //每个线程分到若干块以平衡负载，块太小时合并开销不划算
+  size_t threadCount = ThreadPool::GetGlobal().GetThreadCount() + 1;
+  size_t chunkSize = std::max<size_t>(file.GetSize() / (threadCount * 4), 1 << 20);
+  std::vector<ObjChunk> chunks;
+  for (const char* p = begin; p < end;) {
+    const char* chunkEnd = p + std::min<size_t>(chunkSize, end - p);
+    if (chunkEnd < end) {
+      const char* lineEnd = static_cast<const char*>(std::memchr(chunkEnd, '\n', end - chunkEnd));
+      chunkEnd = lineEnd == nullptr ? end : lineEnd + 1;
+    }
+    ObjChunk chunk;
+    chunk.Begin = p;
+    chunk.End = chunkEnd;
+    chunks.emplace_back(std::move(chunk));
+    p = chunkEnd;
+  }
+  ParallelFor(0, chunks.size(), 1, [&](size_t b, size_t e) {
+    for (size_t i = b; i < e; i++) {
+      ParseObjChunk(chunks[i]);
+    }
+  });
+  struct ChunkBase {
+    size_t P;
+    size_t N;
+    size_t T;
+    size_t Corner;
+  };
+  std::vector<ChunkBase> bases(chunks.size());
+  ChunkBase total{};
+  for (size_t i = 0; i < chunks.size(); i++) {
+    if (chunks[i].IsError) {
+      return false;
+    }
+    bases[i] = total;
+    total.P += chunks[i].Positions.size();
+    total.N += chunks[i].Normals.size();
+    total.T += chunks[i].TexCoords.size();
+    total.Corner += chunks[i].Corners.size();
+  }
+  data.Positions.resize(total.P);
+  data.Normals.resize(total.N);
+  data.TexCoords.resize(total.T);
+  data.Corners.resize(total.Corner);
+  std::atomic<bool> isValid{true};
+  ParallelFor(0, chunks.size(), 1, [&](size_t b, size_t e) {
+    for (size_t i = b; i < e; i++) {
+      auto& chunk = chunks[i];
+      const auto& base = bases[i];
+      std::copy(chunk.Positions.begin(), chunk.Positions.end(), data.Positions.begin() + base.P);
+      std::copy(chunk.Normals.begin(), chunk.Normals.end(), data.Normals.begin() + base.N);
+      std::copy(chunk.TexCoords.begin(), chunk.TexCoords.end(), data.TexCoords.begin() + base.T);
+      const size_t offset[] = {base.P / 3, base.N / 3, base.T / 2};
+      for (size_t fix : chunk.RelativeFix) {
+        auto& c = chunk.Corners[fix / 3];
+        int* value = fix % 3 == 0 ? &c.P : (fix % 3 == 1 ? &c.N : &c.T);
+        *value += static_cast<int>(offset[fix % 3]);
+        if (*value < 0) {
+          isValid = false;
+        }
+      }
+      std::copy(chunk.Corners.begin(), chunk.Corners.end(), data.Corners.begin() + base.Corner);
+      chunk = ObjChunk{};
+    }
+  });
+  return isValid;
+}
 
+/**
+ * @brief 按固定大小的窗口读取文件，对每一行调用 func(lineBegin, lineEnd)，每个窗口处理完调用 afterWindow()。
+ * 窗口末尾不完整的行移动到下一个窗口，单行超过窗口大小时扩大窗口
+ */
+template <typename LineFunc, typename WindowFunc>
+static bool ForEachObjLine(std::ifstream& stream, std::vector<char>& window, LineFunc&& func, WindowFunc&& afterWindow) {
+  stream.clear();
+  stream.seekg(0);
+  size_t carry = 0;
+  while (true) {
+    if (carry == window.size()) {
+      window.resize(window.size() * 2);
+    }
+    stream.read(window.data() + carry, window.size() - carry);
+    size_t total = carry + static_cast<size_t>(stream.gcount());
+    bool isEnd = total < window.size();
+    const char* begin = window.data();
+    const char* end = begin + total;
+    const char* last = end;
+    if (!isEnd) {
+      last = begin;
+      for (const char* q = end; q > begin; q--) {
+        if (q[-1] == '\n') {
+          last = q;
+          break;
+        }
+      }
+    }
+    for (const char* p = begin; p < last;) {
+      const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', last - p));
+      if (lineEnd == nullptr) {
+        lineEnd = last;
+      }
+      if (!func(SkipObjSpace(p, lineEnd), lineEnd)) {
+        return false;
+      }
+      p = lineEnd + 1;
+    }
+    if (!afterWindow()) {
+      return false;
+    }
+    if (isEnd) {
+      return true;
+    }
+    carry = end - last;
+    std::memmove(window.data(), last, carry);
+  }
+}
+
+template <typename T>
+static size_t CapacityBytes(const std::vector<T>& v) { return v.capacity() * sizeof(T); }
+
+bool ImmutableModel::LoadFromObjStreaming(const std::string& name, const std::filesystem::path& path, const ModelImportOptions& options, ImmutableModel& mesh) {
+  std::ifstream stream(path, std::ios::in | std::ios::binary);
+  if (!stream.is_open()) {
+    std::cout << ".obj can't open: " << path << "\n";
+    return false;
+  }
+  mesh.Release();
+  std::vector<char> window(std::max<size_t>(options.StreamWindowSize, 4096));
+  //第一遍：只统计数量，用于精确预留属性和索引数组
+  size_t posCount = 0, norCount = 0, texCount = 0, cornerCount = 0;
+  auto countLine = [&](const char* p, const char* lineEnd) {
+    const char* rest = nullptr;
+    switch (ClassifyObjLine(p, lineEnd, rest)) {
+      case ObjLine::Position: posCount++; break;
+      case ObjLine::Normal: norCount++; break;
+      case ObjLine::TexCoord: texCount++; break;
+      case ObjLine::Face: {
+        size_t tokens = 0;
+        while (true) {
+          rest = SkipObjSpace(rest, lineEnd);
+          if (rest >= lineEnd || *rest == '#') {
+            break;
+          }
+          tokens++;
+          while (rest < lineEnd && !IsObjSpace(*rest)) {
+            rest++;
+          }
+        }
+        cornerCount += tokens >= 3 ? (tokens - 2) * 3 : 0;
+        break;
+      }
+      default:
+        break;
+    }
+    return true;
+  };
+  if (!ForEachObjLine(stream, window, countLine, []() { return true; })) {
+    return false;
+  }
+  if (cornerCount >= std::numeric_limits<uint32_t>::max()) {
+    std::cout << ".obj too many indices: " << cornerCount << "\n";
+    return false;
+  }
+
+  //唯一顶点数要等第二遍去重后才知道，去重表按属性的最大数量预留，最终的顶点数组在知道数量后一次分配
+  size_t vertexEstimate = std::max({posCount, norCount, texCount});
+  size_t vertexBytes = sizeof(Vector3f) + (norCount > 0 ? sizeof(Vector3f) : 0) + (texCount > 0 ? sizeof(Vector2f) : 0);
+  std::vector<float> positions, normals, texcoords;
+  positions.reserve(posCount * 3);
+  normals.reserve(norCount * 3);
+  texcoords.reserve(texCount * 2);
+  VertexDedupTable uni(vertexEstimate * 2);
+  mesh._indices.reserve(cornerCount);
+
+  size_t peak = 0;
+  auto track = [&](size_t transient = 0) {
+    size_t current = CapacityBytes(window) + CapacityBytes(positions) + CapacityBytes(normals) + CapacityBytes(texcoords) +
+                     uni.GetMemoryBytes() + CapacityBytes(mesh._positions) + CapacityBytes(mesh._normals) +
+                     CapacityBytes(mesh._texcoords) + CapacityBytes(mesh._tangent) + CapacityBytes(mesh._indices) + CapacityBytes(mesh._indices16);
+    peak = std::max(peak, current + transient);
+    return current + transient;
+  };
+  //每次分配之前检查，超出上限时在分配之前失败，峰值不会超过上限
+  auto isOverLimit = [&](size_t bytes) { return options.MemoryLimit != 0 && bytes > options.MemoryLimit; };
+  auto reportOverLimit = [&](size_t bytes) {
+    std::cout << ".obj streaming import exceeds memory limit: " << bytes << " > " << options.MemoryLimit << "\n";
+    mesh.Release();
+    return false;
+  };
+  //唯一顶点至少有 vertexEstimate 个，最终数组和计算切线的临时数组至少这么大
+  size_t minFinal = vertexEstimate * (vertexBytes + sizeof(Vector4f)) + GetTangentScratchBytes(vertexEstimate, cornerCount);
+  if (isOverLimit(track()) || isOverLimit(track() + minFinal)) {
+    return reportOverLimit(track() + minFinal);
+  }
+
+  //第二遍：读取属性，遇到面时去重并写入索引，顶点属性在去重结束后填入
+  std::vector<ObjPolyCorner> poly;
+  uint32_t count = 0;
+  size_t overBytes = 0;
+  auto emit = [&](const ObjCorner& c) {
+    if (c.P < 0 || (size_t)c.P * 3 >= positions.size() ||
+        c.N < -1 || (c.N >= 0 && (size_t)c.N * 3 >= normals.size()) ||
+        c.T < -1 || (c.T >= 0 && (size_t)c.T * 2 >= texcoords.size())) {
+      return false;
+    }
+    if (uni.IsFull() && isOverLimit(track(2 * uni.GetMemoryBytes()))) {
+      overBytes = track(2 * uni.GetMemoryBytes());
+      return false;
+    }
+    auto [index, isIn] = uni.Insert(c.P, c.N, c.T, count);
+    if (isIn) {
+      count++;
+    }
+    mesh._indices.emplace_back(index);
+    return true;
+  };
+  auto parseLine = [&](const char* p, const char* lineEnd) {
+    const char* rest = nullptr;
+    switch (ClassifyObjLine(p, lineEnd, rest)) {
+      case ObjLine::Position: return ParseObjFloats(rest, lineEnd, 3, 3, positions) != nullptr;
+      case ObjLine::Normal: return ParseObjFloats(rest, lineEnd, 3, 3, normals) != nullptr;
+      case ObjLine::TexCoord: return ParseObjFloats(rest, lineEnd, 1, 2, texcoords) != nullptr;
+      case ObjLine::Face: {
+        if (!ParseObjFace(rest, lineEnd, positions.size() / 3, normals.size() / 3, texcoords.size() / 2, poly)) {
+          return false;
+        }
+        for (size_t k = 2; k < poly.size(); k++) {
+          if (!emit(poly[0].Corner) || !emit(poly[k - 1].Corner) || !emit(poly[k].Corner)) {
+            return false;
+          }
+        }
+        return true;
+      }
+      default:
+        return true;
+    }
+  };
+  auto afterWindow = [&]() {
+    if (isOverLimit(track())) {
+      overBytes = track();
+      return false;
+    }
+    return true;
+  };
+  if (!ForEachObjLine(stream, window, parseLine, afterWindow)) {
+    if (overBytes != 0) {
+      return reportOverLimit(overBytes);
+    }
+    std::cout << ".obj streaming parse error: " << path << "\n";
+    mesh.Release();
+    return false;
+  }
+  window = std::vector<char>();
+  //唯一顶点数已知，最终数组按准确数量一次分配，不会在导入中途扩容
+  bool hasNormal = norCount > 0, hasTexCoord = texCount > 0;
+  if (isOverLimit(track(size_t(count) * vertexBytes))) {
+    return reportOverLimit(track(size_t(count) * vertexBytes));
+  }
+  mesh._positions.resize(count);
+  mesh._normals.resize(hasNormal ? count : 0);
+  mesh._texcoords.resize(hasTexCoord ? count : 0);
+  uni.ForEach([&](int p, int n, int t, uint32_t index) {
+    mesh._positions[index] = Vector3f(positions[3 * (size_t)p + 0], positions[3 * (size_t)p + 1], positions[3 * (size_t)p + 2]);
+    if (hasNormal && n >= 0) {
+      mesh._normals[index] = Vector3f(normals[3 * (size_t)n + 0], normals[3 * (size_t)n + 1], normals[3 * (size_t)n + 2]);
+    }
+    if (hasTexCoord && t >= 0) {
+      mesh._texcoords[index] = Vector2f(texcoords[2 * (size_t)t + 0], texcoords[2 * (size_t)t + 1]);
+    }
+  });
+  track();
+  //属性和去重表已不再需要，先释放再计算切线
+  positions = std::vector<float>();
+  normals = std::vector<float>();
+  texcoords = std::vector<float>();
+  uni = VertexDedupTable(0);
+  //收窄时两份索引同时存在
+  size_t narrow = ChooseIndexFormat(mesh._positions.size()) == IndexFormat::UInt16 ? mesh._indices.size() * sizeof(uint16_t) : 0;
+  if (isOverLimit(track(narrow))) {
+    return reportOverLimit(track(narrow));
+  }
+  mesh.NarrowIndices();
+  mesh.BindViews();
   if (mesh.HasNormal() && mesh.HasTexCoord()) {
-    //http://foundationsofgameenginedev.com/FGED2-sample.pdf
-    //第9页
-    std::vector<Vector3f> tangent(mesh.GetVertexCount(), Vector3f{});
-    std::vector<Vector3f> biTan(mesh.GetVertexCount(), Vector3f{});
-    mesh._tangent.resize(mesh.GetVertexCount());
-    //计算每个三角形的切线和副切线，叠加到三个顶点上
-    for (size_t i = 0; i < mesh.GetIndexCount(); i += 3) {
-      auto i0 = i + 0;
-      auto i1 = i + 1;
-      auto i2 = i + 2;
-      auto p0 = mesh.GetPosition()[mesh._indices[i0]];
-      auto p1 = mesh.GetPosition()[mesh._indices[i1]];
-      auto p2 = mesh.GetPosition()[mesh._indices[i2]];
-      auto w0 = mesh.GetTexCoords()[mesh._indices[i0]];
-      auto w1 = mesh.GetTexCoords()[mesh._indices[i1]];
-      auto w2 = mesh.GetTexCoords()[mesh._indices[i2]];
-
-      auto e1 = p1 - p0;
-      auto e2 = p2 - p0;
-      auto x1 = w1.X() - w0.X();
-      auto x2 = w2.X() - w0.X();
-      auto y1 = w1.Y() - w0.Y();
-      auto y2 = w2.Y() - w0.Y();
-
-      float r = 1.0f / (x1 * y2 - x2 * y1);
-      auto t = (e1 * Vector3f(y2) - e2 * Vector3f(y1)) * Vector3f(r);
-      auto b = (e2 * Vector3f(x1) - e1 * Vector3f(x2)) * Vector3f(r);
-
-      tangent[i0] += t;
-      tangent[i1] += t;
-      tangent[i2] += t;
-      biTan[i0] += b;
-      biTan[i1] += b;
-      biTan[i2] += b;
-    }
-    //正交化所有切线并计算手性
-    for (size_t i = 0; i < mesh.GetVertexCount(); i++) {
-      const auto& t = tangent[i];
-      const auto& b = biTan[i];
-      const auto& n = mesh.GetNormals()[i];
-      //应该是叫Gram-Schmidt process？
-      auto xyz = Normalize(Reject(t, n));
-      auto w = (Dot(Cross(t, b), n) > 0.0f) ? 1.0f : -1.0f;
-      mesh._tangent[i] = {xyz.X(), xyz.Y(), xyz.Z(), w};
+    size_t temp = mesh.GetVertexCount() * sizeof(Vector4f) + GetTangentScratchBytes(mesh.GetVertexCount(), mesh.GetIndexCount());
+    if (isOverLimit(track(temp))) {
+      return reportOverLimit(track(temp));
+    }
+    TangentSplit split;
+    mesh._tangent = GenerateTangents(mesh._indexView, mesh._positionView, mesh._normalView, mesh._texcoordView, &split);
+    //拆分顶点时属性数组按新的数量重新分配，16位索引放不下时还要放宽
+    size_t splitCount = split.Sources.size();
+    size_t splitBytes = 0;
+    if (splitCount > 0) {
+      size_t vertexCount = mesh._positions.size() + splitCount;
+      bool isWiden = !mesh._indices16.empty() && ChooseIndexFormat(vertexCount) != IndexFormat::UInt16;
+      splitBytes = vertexCount * vertexBytes + (isWiden ? mesh._indices16.size() * sizeof(uint32_t) : 0) +
+                   CapacityBytes(split.Sources) + CapacityBytes(split.Remap);
     }
+    if (isOverLimit(track(splitBytes))) {
+      return reportOverLimit(track(splitBytes));
+    }
+    mesh.SplitVertices(split);
   }
   mesh._name = name;
+  mesh.BindViews();
+  mesh.CalcBounds();
+  track();
+  if (options.Stats != nullptr) {
+    options.Stats->PeakMemoryBytes = peak;
+  }
   return true;
 }
 
 ImmutableModel ImmutableModel::CreateSphere(const std::string& name, float radius, int numberSlices) {
   assert(numberSlices >= 3);
 
-  const Vector3f axisX = {1.0f, 0.0f, 0.0f};
-
   uint32_t numberParallels = numberSlices / 2;
   uint32_t numberVertices = (numberParallels + 1) * (numberSlices + 1);
   uint32_t numberIndices = numberParallels * numberSlices * 6;
@@ -433,24 +1598,22 @@ ImmutableModel ImmutableModel::CreateSphere(const std::string& name, float radiu
       float ty = 1.0f - (float)i / (float)numberParallels;
       texCoords[texCoordsIndex] = {tx, ty};
 
-      Quaternionf quat({0, 1, 0}, 360.0f * texCoords[texCoordsIndex].X());
-      auto mat = Rotate(quat);
-      auto t = Matrix3f(mat) * axisX;
-      tangents[tangentIndex] = {t.X(), t.Y(), t.Z(), 1.0f};
+      //位置对u的偏导方向
+      tangents[tangentIndex] = {std::cos(angleStep * (float)j), 0.0f, -std::sin(angleStep * (float)j), 1.0f};
     }
   }
 
   uint32_t indexIndices = 0;
-  std::vector<size_t> indices(numberIndices, size_t{});
+  std::vector<uint32_t> indices(numberIndices, uint32_t{});
   for (uint32_t i = 0; i < numberParallels; i++) {
     for (uint32_t j = 0; j < (uint32_t)(numberSlices); j++) {
-      indices[indexIndices++] = i * ((size_t)numberSlices + 1) + j;
-      indices[indexIndices++] = ((size_t)i + 1) * ((size_t)numberSlices + 1) + j;
-      indices[indexIndices++] = ((size_t)i + 1) * ((size_t)numberSlices + 1) + ((size_t)j + 1);
+      indices[indexIndices++] = i * ((uint32_t)numberSlices + 1) + j;
+      indices[indexIndices++] = ((uint32_t)i + 1) * ((uint32_t)numberSlices + 1) + j;
+      indices[indexIndices++] = ((uint32_t)i + 1) * ((uint32_t)numberSlices + 1) + ((uint32_t)j + 1);
 
-      indices[indexIndices++] = i * ((size_t)numberSlices + 1) + j;
-      indices[indexIndices++] = ((size_t)i + 1) * ((size_t)numberSlices + 1) + ((size_t)j + 1);
-      indices[indexIndices++] = (size_t)i * ((size_t)numberSlices + 1) + ((size_t)j + 1);
+      indices[indexIndices++] = i * ((uint32_t)numberSlices + 1) + j;
+      indices[indexIndices++] = ((uint32_t)i + 1) * ((uint32_t)numberSlices + 1) + ((uint32_t)j + 1);
+      indices[indexIndices++] = (uint32_t)i * ((uint32_t)numberSlices + 1) + ((uint32_t)j + 1);
     }
   }
 
@@ -491,7 +1654,7 @@ ImmutableModel ImmutableModel::CreateCube(const std::string& name, float halfExt
        +1.0f, 0.0f, 0.0f, +1.0f, 0.0f, 0.0f, +1.0f, 0.0f, 0.0f, +1.0f, 0.0f, 0.0f,
        0.0f, 0.0f, +1.0f, 0.0f, 0.0f, +1.0f, 0.0f, 0.0f, +1.0f, 0.0f, 0.0f, +1.0f,
        0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f};
-  constexpr const size_t cubeIndices[] =
+  constexpr const uint32_t cubeIndices[] =
       {0, 2, 1, 0, 3, 2,
        4, 5, 6, 4, 6, 7,
        8, 9, 10, 8, 10, 11,
@@ -515,12 +1678,12 @@ ImmutableModel ImmutableModel::CreateCube(const std::string& name, float halfExt
                   cubeNormals[i * 3 + 2]};
     texCoords[i] = {cubeTexCoords[i * 2 + 0],
                     cubeTexCoords[i * 2 + 1]};
-    tangents[i] = {cubeTangents[i * 2 + 0],
-                   cubeTangents[i * 2 + 1],
-                   cubeTangents[i * 2 + 2],
+    tangents[i] = {cubeTangents[i * 3 + 0],
+                   cubeTangents[i * 3 + 1],
+                   cubeTangents[i * 3 + 2],
                    1.0f};
   }
-  std::vector<size_t> indices(cubeIndices, cubeIndices + numberIndices);
+  std::vector<uint32_t> indices(cubeIndices, cubeIndices + numberIndices);
   return ImmutableModel(name,
                         std::move(vertices),
                         std::move(normals),
@@ -550,7 +1713,7 @@ ImmutableModel ImmutableModel::CreateQuad(const std::string& name, float halfExt
        1.0f, 0.0f, 0.0f,
        1.0f, 0.0f, 0.0f,
        1.0f, 0.0f, 0.0f};
-  constexpr const size_t quadIndices[] =
+  constexpr const uint32_t quadIndices[] =
       {0, 1, 2,
        1, 3, 2};
   constexpr const uint32_t numberVertices = 4;
@@ -573,7 +1736,7 @@ ImmutableModel ImmutableModel::CreateQuad(const std::string& name, float halfExt
                    quadTan[i * 3 + 2],
                    1.0f};
   }
-  std::vector<size_t> indices(quadIndices, quadIndices + numberIndices);
+  std::vector<uint32_t> indices(quadIndices, quadIndices + numberIndices);
   return ImmutableModel(name,
                         std::move(vertices),
                         std::move(normals),
@@ -602,6 +1765,8 @@ void ImmutableText::Release() {
   _text.shrink_to_fit();
 }
 
+size_t ImmutableText::GetByteSize() const { return _text.size(); }
+
 const std::string& ImmutableText::GetText() const { return _text; }
 
 }  // namespace Hikari
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include <hikari/asset_manager.h>
+
+#include <vector>
+#include <algorithm>
+
+namespace Hikari {
+AssetManager::AssetManager(size_t threadCount) : _pool(threadCount) {}
+
+AssetManager::~AssetManager() noexcept = default;
+
+std::string AssetManager::MakeKey(const char* type, const std::filesystem::path& path) {
+  //同一个文件的不同写法（相对路径、..）映射到同一个键
+  std::error_code ec;
+  auto full = std::filesystem::weakly_canonical(path, ec);
+  return std::string(type) + ":" + (ec ? path.lexically_normal() : full).generic_u8string();
+}
+
+template <typename T>
+AssetHandle<T> AssetManager::Request(const std::string& key, std::function<std::shared_ptr<Asset>()>&& load) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto [iter, isInserted] = _entries.try_emplace(key);
+  if (isInserted) {
+    iter->second.Load = std::move(load);
+    SubmitLoad(key, iter->second);
+  }
+  return AssetHandle<T>(this, key);
+}
+
+AssetHandle<ImmutableModel> AssetManager::RequestModel(const std::string& name,
+                                                       const std::filesystem::path& path,
+                                                       const ModelImportOptions& options) {
+  //影响导入结果的选项计入键：导入器和是否使用缓存；流式导入时窗口大小和内存上限决定能否导入成功，也计入
+  const char* importers[] = {"model_tinyobj", "model_parallel", "model_streaming"};
+  std::string type = importers[int(options.Importer)];
+  if (!options.UseCache) {
+    type += "_nocache";
+  }
+  if (options.Importer == ModelImporter::Streaming) {
+    type += "_" + std::to_string(options.StreamWindowSize) + "_" + std::to_string(options.MemoryLimit);
+  }
+  return Request<ImmutableModel>(MakeKey(type.c_str(), path), [name, path, options]() -> std::shared_ptr<Asset> {
+    auto model = std::make_shared<ImmutableModel>();
+    if (!ImmutableModel::LoadFromFile(name, path, *model, options)) {
+      throw AssetLoadException("can't load model " + path.generic_u8string());
+    }
+    return model;
+  });
+}
+
+AssetHandle<ImmutableBitmap> AssetManager::RequestBitmap(const std::string& name, const std::filesystem::path& path, bool isFlipY) {
+  auto key = MakeKey(isFlipY ? "bitmap_flip" : "bitmap", path);
+  return Request<ImmutableBitmap>(key, [name, path, isFlipY]() -> std::shared_ptr<Asset> {
+    return std::make_shared<ImmutableBitmap>(name, path, isFlipY);
+  });
+}
+
+AssetHandle<ImmutableHdrTexture> AssetManager::RequestHdrTexture(const std::string& name,
+                                                                 const std::filesystem::path& path,
+                                                                 bool isFlipY,
+                                                                 HdrStorage storage) {
+  const char* types[] = {"hdr", "hdr_half", "hdr_rgb9e5", "hdr_flip", "hdr_half_flip", "hdr_rgb9e5_flip"};
+  auto key = MakeKey(types[int(storage) + (isFlipY ? 3 : 0)], path);
+  return Request<ImmutableHdrTexture>(key, [name, path, isFlipY, storage]() -> std::shared_ptr<Asset> {
+    return std::make_shared<ImmutableHdrTexture>(name, path, isFlipY, storage);
+  });
+}
+
+void AssetManager::SubmitLoad(const std::string& key, Entry& entry) {
+  if (entry.LoadCount++ > 0) {
+    _stats.ReloadCount++;
+  }
+  auto load = entry.Load;
+  entry.Future = _pool.Submit([this, key, load]() { OnLoaded(key, load()); }).share();
+}
+
+void AssetManager::OnLoaded(const std::string& key, std::shared_ptr<Asset>&& asset) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto& entry = _entries.at(key);
+  if (entry.Resident != nullptr) {
+    return;
+  }
+  entry.Resident = std::move(asset);
+  entry.IsAcquiredSinceLoad = false;
+  entry.ByteSize = entry.Resident->GetByteSize();
+  _lru.push_front(key);
+  entry.LruIter = _lru.begin();
+  _stats.Usage += entry.ByteSize;
+  _stats.Peak = std::max(_stats.Peak, _stats.Usage);
+  _stats.ResidentCount++;
+  EvictToBudget();
+}
+
+std::shared_ptr<Asset> AssetManager::Acquire(const std::string& key) {
+  while (true) {
+    std::shared_future<void> future;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto& entry = _entries.at(key);
+      if (entry.Resident != nullptr) {
+        _lru.splice(_lru.begin(), _lru, entry.LruIter);
+        entry.IsAcquiredSinceLoad = true;
+        return entry.Resident;
+      }
+      if (!entry.Future.valid()) {
+        SubmitLoad(key, entry);
+      }
+      future = entry.Future;
+    }
+    //加载失败时在这里抛出。成功但取走之前又被淘汰时重新加载
+    future.get();
+  }
+}
+
+bool AssetManager::IsReady(const std::string& key) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto& entry = _entries.at(key);
+  return entry.Resident != nullptr ||
+         (entry.Future.valid() && entry.Future.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+}
+
+void AssetManager::Wait(const std::string& key) {
+  std::shared_future<void> future;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& entry = _entries.at(key);
+    if (entry.Resident != nullptr) {
+      return;
+    }
+    if (!entry.Future.valid()) {
+      SubmitLoad(key, entry);
+    }
+    future = entry.Future;
+  }
+  future.wait();
+}
+
+void AssetManager::Pin(const std::string& key, int delta) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto& entry = _entries.at(key);
+  entry.PinCount = std::max(entry.PinCount + delta, 0);
+  if (delta < 0) {
+    EvictToBudget();
+  }
+}
+
+void AssetManager::Evict(Entry& entry) {
+  _stats.EvictCount++;
+  ReleaseEntry(entry);
+}
+
+void AssetManager::ReleaseEntry(Entry& entry) {
+  _stats.Usage -= entry.ByteSize;
+  _stats.ResidentCount--;
+  _lru.erase(entry.LruIter);
+  if (entry.Resident.use_count() == 1) {
+    entry.Resident->Release();
+  }
+  entry.Resident = nullptr;
+  entry.Future = std::shared_future<void>();
+  entry.ByteSize = 0;
+}
+
+void AssetManager::EvictToBudget() {
+  if (_stats.Budget == 0 || _stats.Usage <= _stats.Budget) {
+    return;
+  }
+  //从最久未使用的一端开始挑，先收集再淘汰，避免边遍历边删除链表
+  std::vector<Entry*> candidates;
+  for (auto iter = _lru.rbegin(); iter != _lru.rend(); ++iter) {
+    auto& entry = _entries.at(*iter);
+    //加载完还没有被取走的资源淘汰后，Get 时又要重新解码，多个这样的资源会互相挤掉
+    if (entry.PinCount > 0 || entry.Resident.use_count() > 1 || !entry.IsAcquiredSinceLoad) {
+      continue;
+    }
+    candidates.emplace_back(&entry);
+  }
+  for (auto entry : candidates) {
+    if (_stats.Usage <= _stats.Budget) {
+      break;
+    }
+    Evict(*entry);
+  }
+}
+
+void AssetManager::WaitAll() {
+  std::vector<std::shared_future<void>> pending;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    pending.reserve(_entries.size());
+    for (const auto& entry : _entries) {
+      if (entry.second.Future.valid()) {
+        pending.emplace_back(entry.second.Future);
+      }
+    }
+  }
+  for (const auto& future : pending) {
+    future.wait();
+  }
+}
+
+size_t AssetManager::GetRequestCount() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _entries.size();
+}
+
+void AssetManager::SetMemoryBudget(size_t bytes) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _stats.Budget = bytes;
+  EvictToBudget();
+}
+
+AssetMemoryStats AssetManager::GetMemoryStats() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _stats;
+}
+
+void AssetManager::Clear() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  //主动清空不算预算淘汰，不计入 EvictCount
+  for (auto& entry : _entries) {
+    if (entry.second.Resident != nullptr && entry.second.PinCount == 0) {
+      ReleaseEntry(entry.second);
+    }
+  }
+}
+
+}  // namespace Hikari
@@ -1,5 +1,261 @@
 #include <hikari/common.h>
 
 #include <iostream>
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 namespace Hikari {
-}  // namespace Hikari
\ No newline at end of file
+MappedFile::MappedFile() noexcept = default;
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+  _data = other._data;
+  _size = other._size;
+  other._data = nullptr;
+  other._size = 0;
+#if defined(_WIN32)
+  _file = other._file;
+  _mapping = other._mapping;
+  other._file = nullptr;
+  other._mapping = nullptr;
+#else
+  _fd = other._fd;
+  other._fd = -1;
+#endif
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  Close();
+  _data = other._data;
+  _size = other._size;
+  other._data = nullptr;
+  other._size = 0;
+#if defined(_WIN32)
+  _file = other._file;
+  _mapping = other._mapping;
+  other._file = nullptr;
+  other._mapping = nullptr;
+#else
+  _fd = other._fd;
+  other._fd = -1;
+#endif
+  return *this;
+}
+
+MappedFile::~MappedFile() noexcept {
+  Close();
+}
+
+bool MappedFile::Open(const std::filesystem::path& path) {
+  Close();
+#if defined(_WIN32)
+  HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return false;
+  }
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (view == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+  _file = file;
+  _mapping = mapping;
+  _data = static_cast<const uint8_t*>(view);
+  _size = static_cast<size_t>(size.QuadPart);
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return false;
+  }
+  void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  if (view == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+  _fd = fd;
+  _data = static_cast<const uint8_t*>(view);
+  _size = static_cast<size_t>(st.st_size);
+#endif
+  return true;
+}
+
+void MappedFile::Close() {
+#if defined(_WIN32)
+  if (_data != nullptr) {
+    UnmapViewOfFile(_data);
+  }
+  if (_mapping != nullptr) {
+    CloseHandle(_mapping);
+    _mapping = nullptr;
+  }
+  if (_file != nullptr) {
+    CloseHandle(_file);
+    _file = nullptr;
+  }
+#else
+  if (_data != nullptr) {
+    munmap(const_cast<uint8_t*>(_data), _size);
+  }
+  if (_fd >= 0) {
+    close(_fd);
+    _fd = -1;
+  }
+#endif
+  _data = nullptr;
+  _size = 0;
+}
+
+bool MappedFile::IsOpen() const { return _data != nullptr; }
+
+const uint8_t* MappedFile::GetData() const { return _data; }
+
+size_t MappedFile::GetSize() const { return _size; }
+
+//https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+static constexpr uint64_t XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static constexpr uint64_t XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static constexpr uint64_t XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+static constexpr uint64_t XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static constexpr uint64_t XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t XxhRotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+static inline uint64_t XxhRead64(const uint8_t* p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint32_t XxhRead32(const uint8_t* p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint64_t XxhRound(uint64_t acc, uint64_t input) {
+  acc += input * XXH_PRIME64_2;
+  acc = XxhRotl(acc, 31);
+  return acc * XXH_PRIME64_1;
+}
+
+static inline uint64_t XxhMerge(uint64_t acc, uint64_t val) {
+  acc ^= XxhRound(0, val);
+  return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+uint64_t Hash64(const void* data, size_t size, uint64_t seed) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  const uint8_t* end = p + size;
+  uint64_t h;
+  if (size >= 32) {
+    uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+    uint64_t v2 = seed + XXH_PRIME64_2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - XXH_PRIME64_1;
+    const uint8_t* limit = end - 32;
+    do {
+      v1 = XxhRound(v1, XxhRead64(p + 0));
+      v2 = XxhRound(v2, XxhRead64(p + 8));
+      v3 = XxhRound(v3, XxhRead64(p + 16));
+      v4 = XxhRound(v4, XxhRead64(p + 24));
+      p += 32;
+    } while (p <= limit);
+    h = XxhRotl(v1, 1) + XxhRotl(v2, 7) + XxhRotl(v3, 12) + XxhRotl(v4, 18);
+    h = XxhMerge(h, v1);
+    h = XxhMerge(h, v2);
+    h = XxhMerge(h, v3);
+    h = XxhMerge(h, v4);
+  } else {
+    h = seed + XXH_PRIME64_5;
+  }
+  h += static_cast<uint64_t>(size);
+  while (p + 8 <= end) {
+    h ^= XxhRound(0, XxhRead64(p));
+    h = XxhRotl(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    p += 8;
+  }
+  if (p + 4 <= end) {
+    h ^= static_cast<uint64_t>(XxhRead32(p)) * XXH_PRIME64_1;
+    h = XxhRotl(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+    p += 4;
+  }
+  while (p < end) {
+    h ^= static_cast<uint64_t>(*p) * XXH_PRIME64_5;
+    h = XxhRotl(h, 11) * XXH_PRIME64_1;
+    p++;
+  }
+  h ^= h >> 33;
+  h *= XXH_PRIME64_2;
+  h ^= h >> 29;
+  h *= XXH_PRIME64_3;
+  h ^= h >> 32;
+  return h;
+}
+
+bool HashFileContent(const std::filesystem::path& path, uint64_t& hash) {
+  std::error_code ec;
+  auto size = std::filesystem::file_size(path, ec);
+  if (ec) {
+    return false;
+  }
+  if (size == 0) {
+    hash = Hash64(nullptr, 0);
+    return true;
+  }
+  MappedFile file;
+  if (!file.Open(path)) {
+    return false;
+  }
+  hash = Hash64(file.GetData(), file.GetSize());
+  return true;
+}
+
+std::string ToHexString(uint64_t value) {
+  constexpr const char digits[] = "0123456789abcdef";
+  std::string result(16, '0');
+  for (int i = 15; i >= 0; i--) {
+    result[i] = digits[value & 0xF];
+    value >>= 4;
+  }
+  return result;
+}
+
+static std::filesystem::path& CacheDirectory() {
+  static std::filesystem::path dir = std::filesystem::current_path() / "HikariCache";
+  return dir;
+}
+
+const std::filesystem::path& GetCacheDirectory() { return CacheDirectory(); }
+
+void SetCacheDirectory(const std::filesystem::path& path) { CacheDirectory() = path; }
+
+}  // namespace Hikari
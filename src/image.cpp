@@ -0,0 +1,2007 @@
+#include <hikari/image.h>
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include <hikari/mathematics.h>
+#include <hikari/parallel.h>
+#include <hikari/quantize.h>
+
+namespace Hikari {
+constexpr uint32_t MIP_CACHE_MAGIC = 0x504D4B48;  //"HKMP"
+constexpr uint32_t MIP_CACHE_VERSION = 1;
+
+struct MipCacheHeader {
+  uint32_t Magic;
+  uint32_t Version;
+  uint64_t Key;
+  uint32_t Width;
+  uint32_t Height;
+  uint32_t Channel;
+  uint32_t DataType;
+  uint32_t LevelCount;
+  uint32_t Reserved;
+  uint64_t FileSize;
+};
+
+/**
+ * @brief 参与缓存哈希的参数，全部是4字节的字段，没有填充
+ */
+struct MipCacheKey {
+  uint32_t Width;
+  uint32_t Height;
+  uint32_t Channel;
+  uint32_t DataType;
+  uint32_t LevelCount;
+  uint32_t Filter;
+  uint32_t IsSrgb;
+  uint32_t IsWrap;
+  float KaiserWidth;
+  float KaiserAlpha;
+};
+
+/**
+ * @brief 一个方向上每个目标像素的采样位置和归一化的权重
+ */
+struct MipFilterTaps {
+  std::vector<size_t> Begin;
+  std::vector<int> Index;
+  std::vector<float> Weight;
+};
+
+struct SrgbTable {
+  float Decode[256];
+  /**
+   * @brief 相邻两个8位值在sRGB空间中点对应的线性值，线性值超过第 i 个时编码结果大于 i，即sRGB空间的四舍五入
+   */
+  float Threshold[256];
+  /**
+   * @brief 线性值按 1/4095 分桶，每个桶起点的编码结果。桶内最多再往后找一两步
+   */
+  uint8_t Bucket[4096];
+
+  uint8_t Encode(float linear) const {
+    linear = std::clamp(linear, 0.0f, 1.0f);
+    int i = Bucket[int(linear * 4095.0f)];
+    while (linear > Threshold[i]) {
+      i++;
+    }
+    return uint8_t(i);
+  }
+};
+
+static float SrgbToLinear(float s) { return s <= 0.04045f ? s / 12.92f : std::pow((s + 0.055f) / 1.055f, 2.4f); }
+
+static const SrgbTable& GetSrgbTable() {
+  static const SrgbTable table = []() {
+    SrgbTable t;
+    for (int i = 0; i < 256; i++) {
+      t.Decode[i] = SrgbToLinear(i / 255.0f);
+    }
+    for (int i = 0; i < 255; i++) {
+      t.Threshold[i] = SrgbToLinear((i + 0.5f) / 255.0f);
+    }
+    t.Threshold[255] = 2.0f;  //哨兵，输入已经截断到 [0, 1]
+    int code = 0;
+    for (int i = 0; i < 4096; i++) {
+      while (i / 4095.0f > t.Threshold[code]) {
+        code++;
+      }
+      t.Bucket[i] = uint8_t(code);
+    }
+    return t;
+  }();
+  return table;
+}
+
+static double BesselI0(double x) {
+  //级数展开，Kaiser窗口常用的参数范围内很快收敛
+  double sum = 1, term = 1, halfX = x * 0.5;
+  for (int k = 1; k < 64; k++) {
+    term *= (halfX / k) * (halfX / k);
+    sum += term;
+    if (term < sum * 1e-12) {
+      break;
+    }
+  }
+  return sum;
+}
+
+static double Sinc(double x) {
+  if (std::abs(x) < 1e-6) {
+    return 1;
+  }
+  x *= PI_VALUE;
+  return std::sin(x) / x;
+}
+
+static MipFilterTaps BuildMipFilterTaps(int srcSize, int dstSize, const MipGenerateOptions& options) {
+  MipFilterTaps taps;
+  taps.Begin.reserve(size_t(dstSize) + 1);
+  const double scale = double(srcSize) / dstSize;
+  const bool isBox = options.Filter == MipFilter::Box;
+  const double radius = isBox ? scale * 0.5 : options.KaiserWidth * scale;
+  const double invI0 = 1.0 / BesselI0(options.KaiserAlpha);
+  for (int o = 0; o < dstSize; o++) {
+    size_t begin = taps.Index.size();
+    taps.Begin.emplace_back(begin);
+    double center = (o + 0.5) * scale;
+    int first = int(std::floor(center - radius));
+    int last = int(std::ceil(center + radius));
+    double sum = 0;
+    for (int i = first; i < last; i++) {
+      double w;
+      if (isBox) {
+        w = std::min(i + 1.0, center + radius) - std::max(double(i), center - radius);
+      } else {
+        double x = (i + 0.5 - center) / scale;
+        double t = x / options.KaiserWidth;
+        w = std::abs(t) < 1 ? Sinc(x) * BesselI0(options.KaiserAlpha * std::sqrt(1 - t * t)) * invI0 : 0;
+      }
+      if (w == 0 || (isBox && w < 0)) {
+        continue;
+      }
+      int index = options.IsWrap ? ((i % srcSize) + srcSize) % srcSize : std::clamp(i, 0, srcSize - 1);
+      taps.Index.emplace_back(index);
+      taps.Weight.emplace_back(float(w));
+      sum += w;
+    }
+    for (size_t i = begin; i < taps.Weight.size(); i++) {
+      taps.Weight[i] = float(taps.Weight[i] / sum);
+    }
+  }
+  taps.Begin.emplace_back(taps.Index.size());
+  return taps;
+}
+
+static size_t SizeOfMipDataType(MipDataType type) { return type == MipDataType::UInt8 ? 1 : sizeof(float); }
+
+/**
+ * @brief sRGB时不参与转换的alpha通道，没有时返回-1
+ */
+static int GetAlphaChannel(int channel) { return channel == 4 ? 3 : (channel == 2 ? 1 : -1); }
+
+/**
+ * @brief 一行的水平滤波，通道数是编译期常量时内层循环可以展开
+ */
+template <int Channel>
+static void FilterMipRow(const float* src, float* dst, const MipFilterTaps& taps, int dstWidth, int channel) {
+  const int c = Channel > 0 ? Channel : channel;
+  for (int x = 0; x < dstWidth; x++) {
+    float acc[4] = {};
+    float* out = dst + size_t(x) * c;
+    for (size_t t = taps.Begin[x]; t < taps.Begin[x + 1]; t++) {
+      const float* in = src + size_t(taps.Index[t]) * c;
+      const float w = taps.Weight[t];
+      if constexpr (Channel > 0) {
+        for (int k = 0; k < Channel; k++) {
+          acc[k] += w * in[k];
+        }
+      } else {
+        for (int k = 0; k < c; k++) {
+          out[k] = (t == taps.Begin[x] ? 0.0f : out[k]) + w * in[k];
+        }
+      }
+    }
+    if constexpr (Channel > 0) {
+      for (int k = 0; k < Channel; k++) {
+        out[k] = acc[k];
+      }
+    }
+  }
+}
+
+static void FilterMipRow(const float* src, float* dst, const MipFilterTaps& taps, int dstWidth, int channel) {
+  switch (channel) {
+    case 1:
+      FilterMipRow<1>(src, dst, taps, dstWidth, channel);
+      break;
+    case 2:
+      FilterMipRow<2>(src, dst, taps, dstWidth, channel);
+      break;
+    case 3:
+      FilterMipRow<3>(src, dst, taps, dstWidth, channel);
+      break;
+    case 4:
+      FilterMipRow<4>(src, dst, taps, dstWidth, channel);
+      break;
+    default:
+      FilterMipRow<0>(src, dst, taps, dstWidth, channel);
+      break;
+  }
+}
+
+bool MipChain::IsValid() const { return _levelCount > 0; }
+
+int MipChain::GetLevelCount() const { return _levelCount; }
+
+int MipChain::GetWidth(int level) const { return std::max(1, _width >> level); }
+
+int MipChain::GetHeight(int level) const { return std::max(1, _height >> level); }
+
+int MipChain::GetChannel() const { return _channel; }
+
+MipDataType MipChain::GetDataType() const { return _type; }
+
+const void* MipChain::GetLevelData(int level) const {
+  if (level < 1 || level >= _levelCount) {
+    return nullptr;
+  }
+  return _data.data() + _offsets[level];
+}
+
+size_t MipChain::GetLevelByteSize(int level) const {
+  if (level < 1 || level >= _levelCount) {
+    return 0;
+  }
+  return size_t(GetWidth(level)) * GetHeight(level) * _channel * SizeOfMipDataType(_type);
+}
+
+std::vector<const void*> MipChain::GetLevelPointers() const {
+  std::vector<const void*> result;
+  for (int i = 1; i < _levelCount; i++) {
+    result.emplace_back(GetLevelData(i));
+  }
+  return result;
+}
+
+size_t MipChain::GetByteSize() const { return _data.size(); }
+
+void MipChain::Allocate(int width, int height, int channel, MipDataType type, int levelCount) {
+  _width = width;
+  _height = height;
+  _channel = channel;
+  _type = type;
+  _levelCount = levelCount;
+  _offsets.assign(size_t(levelCount), 0);
+  size_t offset = 0;
+  for (int i = 1; i < levelCount; i++) {
+    _offsets[i] = offset;
+    offset += GetLevelByteSize(i);
+  }
+  _data.assign(offset, 0);
+}
+
+bool MipChain::SaveToCache(const std::filesystem::path& cachePath, uint64_t key) const {
+  MipCacheHeader header{};
+  header.Magic = MIP_CACHE_MAGIC;
+  header.Version = MIP_CACHE_VERSION;
+  header.Key = key;
+  header.Width = uint32_t(_width);
+  header.Height = uint32_t(_height);
+  header.Channel = uint32_t(_channel);
+  header.DataType = uint32_t(_type);
+  header.LevelCount = uint32_t(_levelCount);
+  header.FileSize = sizeof(header) + _data.size();
+  std::error_code ec;
+  std::filesystem::create_directories(cachePath.parent_path(), ec);
+  //先写临时文件再重命名，避免其他进程读到写了一半的缓存
+  auto tempPath = cachePath;
+  tempPath += ".tmp";
+  {
+    std::ofstream stream(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+      return false;
+    }
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(_data.data()), _data.size());
+    if (!stream.good()) {
+      return false;
+    }
+  }
+  std::filesystem::rename(tempPath, cachePath, ec);
+  if (ec) {
+    std::filesystem::remove(tempPath, ec);
+    return false;
+  }
+  return true;
+}
+
+bool MipChain::LoadFromCache(const std::filesystem::path& cachePath, uint64_t key) {
+  MappedFile file;
+  if (!file.Open(cachePath) || file.GetSize() < sizeof(MipCacheHeader)) {
+    return false;
+  }
+  MipCacheHeader header;
+  std::memcpy(&header, file.GetData(), sizeof(header));
+  if (header.Magic != MIP_CACHE_MAGIC ||
+      header.Version != MIP_CACHE_VERSION ||
+      header.Key != key ||
+      header.FileSize != file.GetSize() ||
+      header.DataType > uint32_t(MipDataType::Float32)) {
+    return false;
+  }
+  Allocate(int(header.Width), int(header.Height), int(header.Channel), MipDataType(header.DataType), int(header.LevelCount));
+  if (sizeof(header) + _data.size() != header.FileSize) {
+    *this = MipChain();
+    return false;
+  }
+  std::memcpy(_data.data(), file.GetData() + sizeof(header), _data.size());
+  return true;
+}
+
+MipChain GenerateMipChain(const void* data,
+                          int width,
+                          int height,
+                          int channel,
+                          MipDataType type,
+                          const MipGenerateOptions& options) {
+  MipChain chain;
+  if (data == nullptr || width <= 0 || height <= 0 || channel <= 0) {
+    return chain;
+  }
+  int levelCount = 1;
+  while ((std::max(width, height) >> levelCount) > 0) {
+    levelCount++;
+  }
+  if (options.MaxLevelCount > 0) {
+    levelCount = std::min(levelCount, options.MaxLevelCount);
+  }
+  const size_t srcCount = size_t(width) * height * channel;
+  std::filesystem::path cachePath;
+  uint64_t key = 0;
+  if (options.UseCache) {
+    MipCacheKey k{uint32_t(width), uint32_t(height), uint32_t(channel), uint32_t(type), uint32_t(levelCount),
+                  uint32_t(options.Filter), options.IsSrgb, options.IsWrap, options.KaiserWidth, options.KaiserAlpha};
+    key = Hash64(&k, sizeof(k), Hash64(data, srcCount * SizeOfMipDataType(type)));
+    cachePath = GetCacheDirectory() / "mip" / (ToHexString(key) + ".hkmip");
+    if (chain.LoadFromCache(cachePath, key)) {
+      return chain;
+    }
+  }
+  chain.Allocate(width, height, channel, type, levelCount);
+
+  const bool isSrgb = options.IsSrgb && type == MipDataType::UInt8;
+  const int alpha = GetAlphaChannel(channel);
+  const auto& srgb = GetSrgbTable();
+  //每个任务大约处理这么多个float，小的级别一次做完
+  constexpr size_t taskFloatCount = 16384;
+  //8位的第0级不整体转换为浮点，第一趟水平滤波时逐行解码，省下一份完整的浮点拷贝
+  auto bytes = static_cast<const uint8_t*>(data);
+  auto decodeRow = [&](size_t y, float* row) {
+    const size_t rowSize = size_t(width) * channel;
+    const uint8_t* in = bytes + y * rowSize;
+    for (size_t i = 0; i < rowSize; i++) {
+      row[i] = isSrgb ? srgb.Decode[in[i]] : in[i] * (1.0f / 255.0f);
+    }
+    if (isSrgb && alpha >= 0) {
+      for (size_t i = alpha; i < rowSize; i += channel) {
+        row[i] = in[i] * (1.0f / 255.0f);
+      }
+    }
+  };
+  //当前级的线性浮点数据。浮点图像的每一级直接作为下一级的输入
+  const float* current = type == MipDataType::Float32 ? static_cast<const float*>(data) : nullptr;
+  std::vector<float> horizontal;
+  std::vector<float> linear;
+  int srcW = width, srcH = height;
+  for (int level = 1; level < levelCount; level++) {
+    const int dstW = chain.GetWidth(level);
+    const int dstH = chain.GetHeight(level);
+    const auto tapsX = BuildMipFilterTaps(srcW, dstW, options);
+    const auto tapsY = BuildMipFilterTaps(srcH, dstH, options);
+    const size_t srcRow = size_t(srcW) * channel;
+    const size_t dstRow = size_t(dstW) * channel;
+    //先水平再垂直的可分离滤波，两趟都按行切分任务
+    horizontal.resize(dstRow * srcH);
+    ParallelFor(0, srcH, std::max<size_t>(1, taskFloatCount / srcRow), [&](size_t begin, size_t end) {
+      std::vector<float> row(current == nullptr ? srcRow : 0);
+      for (size_t y = begin; y < end; y++) {
+        const float* src = current;
+        if (src == nullptr) {
+          decodeRow(y, row.data());
+          src = row.data();
+        } else {
+          src += y * srcRow;
+        }
+        FilterMipRow(src, horizontal.data() + y * dstRow, tapsX, dstW, channel);
+      }
+    });
+    auto levelData = const_cast<void*>(chain.GetLevelData(level));
+    float* dst;
+    if (type == MipDataType::Float32) {
+      dst = static_cast<float*>(levelData);
+    } else {
+      linear.resize(dstRow * dstH);  //上一级已经在水平滤波中用完，可以原地覆盖
+      dst = linear.data();
+    }
+    ParallelFor(0, dstH, std::max<size_t>(1, taskFloatCount / dstRow), [&](size_t begin, size_t end) {
+      for (size_t y = begin; y < end; y++) {
+        float* out = dst + y * dstRow;
+        //整行连续的乘加，编译器可以直接向量化
+        for (size_t t = tapsY.Begin[y]; t < tapsY.Begin[y + 1]; t++) {
+          const float* in = horizontal.data() + size_t(tapsY.Index[t]) * dstRow;
+          const float w = tapsY.Weight[t];
+          if (t == tapsY.Begin[y]) {
+            for (size_t i = 0; i < dstRow; i++) {
+              out[i] = w * in[i];
+            }
+          } else {
+            for (size_t i = 0; i < dstRow; i++) {
+              out[i] += w * in[i];
+            }
+          }
+        }
+        if (type == MipDataType::Float32) {
+          continue;
+        }
+        uint8_t* encoded = static_cast<uint8_t*>(levelData) + y * dstRow;
+        for (size_t i = 0; i < dstRow; i++) {
+          encoded[i] = isSrgb ? srgb.Encode(out[i]) : uint8_t(std::clamp(out[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+        if (isSrgb && alpha >= 0) {
+          for (size_t i = alpha; i < dstRow; i += channel) {
+            encoded[i] = uint8_t(std::clamp(out[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+          }
+        }
+      }
+    });
+    current = dst;
+    srcW = dstW;
+    srcH = dstH;
+  }
+  if (options.UseCache && !chain.SaveToCache(cachePath, key)) {
+    std::cout << "can't write mip cache: " << cachePath << "\n";
+  }
+  return chain;
+}
+
+//-------------------------------------------------------------------------------------------------
+// 块压缩
+//-------------------------------------------------------------------------------------------------
+constexpr uint32_t DDS_MAGIC = 0x20534444;  //"DDS "
+constexpr uint32_t DDS_HIKARI_TAG = 0x43424B48;  //"HKBC"，写在保留字段里，后面跟缓存的键
+constexpr uint32_t BC_CACHE_VERSION = 1;
+constexpr uint8_t KTX2_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+constexpr uint32_t MakeFourCC(char a, char b, char c, char d) {
+  return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+}
+
+struct DdsPixelFormat {
+  uint32_t Size;
+  uint32_t Flags;
+  uint32_t FourCC;
+  uint32_t RgbBitCount;
+  uint32_t Mask[4];
+};
+
+struct DdsHeader {
+  uint32_t Size;
+  uint32_t Flags;
+  uint32_t Height;
+  uint32_t Width;
+  uint32_t PitchOrLinearSize;
+  uint32_t Depth;
+  uint32_t MipMapCount;
+  uint32_t Reserved1[11];
+  DdsPixelFormat PixelFormat;
+  uint32_t Caps[4];
+  uint32_t Reserved2;
+};
+
+struct DdsHeaderDx10 {
+  uint32_t DxgiFormat;
+  uint32_t ResourceDimension;
+  uint32_t MiscFlag;
+  uint32_t ArraySize;
+  uint32_t MiscFlags2;
+};
+
+static_assert(sizeof(DdsHeader) == 124 && sizeof(DdsHeaderDx10) == 20, "dds layout");
+
+struct Ktx2Header {
+  uint8_t Identifier[12];
+  uint32_t VkFormat;
+  uint32_t TypeSize;
+  uint32_t PixelWidth;
+  uint32_t PixelHeight;
+  uint32_t PixelDepth;
+  uint32_t LayerCount;
+  uint32_t FaceCount;
+  uint32_t LevelCount;
+  uint32_t SupercompressionScheme;
+  uint32_t DfdByteOffset;
+  uint32_t DfdByteLength;
+  uint32_t KvdByteOffset;
+  uint32_t KvdByteLength;
+  uint64_t SgdByteOffset;
+  uint64_t SgdByteLength;
+};
+
+struct Ktx2LevelIndex {
+  uint64_t ByteOffset;
+  uint64_t ByteLength;
+  uint64_t UncompressedByteLength;
+};
+
+static_assert(sizeof(Ktx2Header) == 80 && sizeof(Ktx2LevelIndex) == 24, "ktx2 layout");
+
+struct BlockCacheKey {
+  uint32_t Version;
+  uint32_t Width;
+  uint32_t Height;
+  uint32_t Channel;
+  uint32_t DataType;
+  uint32_t Format;
+  uint32_t IsSrgb;
+  uint32_t GenerateMips;
+  uint32_t Filter;
+  uint32_t IsWrap;
+  int32_t MaxLevelCount;
+  float KaiserWidth;
+  float KaiserAlpha;
+};
+
+/**
+ * @brief DXGI_FORMAT 和 VkFormat 与块格式的对应关系
+ */
+struct BlockFormatInfo {
+  BlockFormat Format;
+  bool IsSrgb;
+  uint32_t Dxgi;
+  uint32_t Vk;
+};
+
+static const BlockFormatInfo BLOCK_FORMAT_INFOS[] = {
+    {BlockFormat::BC1, false, 71, 131},
+    {BlockFormat::BC1, true, 72, 132},
+    {BlockFormat::BC1, false, 71, 133},  //VK_FORMAT_BC1_RGBA_UNORM_BLOCK，忽略1位alpha
+    {BlockFormat::BC1, true, 72, 134},
+    {BlockFormat::BC3, false, 77, 137},
+    {BlockFormat::BC3, true, 78, 138},
+    {BlockFormat::BC4, false, 80, 139},
+    {BlockFormat::BC5, false, 83, 141},
+    {BlockFormat::BC6H, false, 95, 143},
+};
+
+size_t GetBlockByteSize(BlockFormat format) {
+  return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+size_t CalcBlockCompressedSize(BlockFormat format, int width, int height) {
+  return size_t((width + 3) / 4) * size_t((height + 3) / 4) * GetBlockByteSize(format);
+}
+
+/**
+ * @brief 沿主成分方向取投影的两端作为端点
+ */
+static void FitPrincipalEndpoints(const float (*points)[3], int count, float lo[3], float hi[3]) {
+  float mean[3] = {};
+  for (int i = 0; i < count; i++) {
+    for (int k = 0; k < 3; k++) {
+      mean[k] += points[i][k];
+    }
+  }
+  for (int k = 0; k < 3; k++) {
+    mean[k] /= count;
+  }
+  float cov[3][3] = {};
+  for (int i = 0; i < count; i++) {
+    float d[3] = {points[i][0] - mean[0], points[i][1] - mean[1], points[i][2] - mean[2]};
+    for (int a = 0; a < 3; a++) {
+      for (int b = 0; b < 3; b++) {
+        cov[a][b] += d[a] * d[b];
+      }
+    }
+  }
+  //幂迭代求最大特征向量
+  float axis[3] = {1, 1, 1};
+  for (int iter = 0; iter < 8; iter++) {
+    float v[3];
+    for (int a = 0; a < 3; a++) {
+      v[a] = cov[a][0] * axis[0] + cov[a][1] * axis[1] + cov[a][2] * axis[2];
+    }
+    float m = std::max({std::abs(v[0]), std::abs(v[1]), std::abs(v[2])});
+    if (m < 1e-12f) {
+      break;
+    }
+    for (int a = 0; a < 3; a++) {
+      axis[a] = v[a] / m;
+    }
+  }
+  float len = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+  for (int k = 0; k < 3; k++) {
+    axis[k] /= len;
+  }
+  float minT = 0, maxT = 0;
+  for (int i = 0; i < count; i++) {
+    float t = (points[i][0] - mean[0]) * axis[0] + (points[i][1] - mean[1]) * axis[1] + (points[i][2] - mean[2]) * axis[2];
+    minT = std::min(minT, t);
+    maxT = std::max(maxT, t);
+  }
+  for (int k = 0; k < 3; k++) {
+    lo[k] = mean[k] + axis[k] * minT;
+    hi[k] = mean[k] + axis[k] * maxT;
+  }
+}
+
+/**
+ * @brief 已知每个点在两个端点之间的插值系数 t（0为lo，1为hi），最小二乘求端点
+ */
+static bool SolveEndpoints(const float (*points)[3], const float* t, int count, float lo[3], float hi[3]) {
+  float aa = 0, bb = 0, ab = 0, ax[3] = {}, bx[3] = {};
+  for (int i = 0; i < count; i++) {
+    float a = 1 - t[i], b = t[i];
+    aa += a * a;
+    bb += b * b;
+    ab += a * b;
+    for (int k = 0; k < 3; k++) {
+      ax[k] += a * points[i][k];
+      bx[k] += b * points[i][k];
+    }
+  }
+  float det = aa * bb - ab * ab;
+  if (std::abs(det) < 1e-6f) {
+    return false;
+  }
+  for (int k = 0; k < 3; k++) {
+    lo[k] = (ax[k] * bb - bx[k] * ab) / det;
+    hi[k] = (bx[k] * aa - ax[k] * ab) / det;
+  }
+  return true;
+}
+
+static uint16_t PackRgb565(const float c[3]) {
+  auto q = [](float v, int maxValue) { return uint16_t(std::clamp(int(std::lround(v * maxValue / 255.0f)), 0, maxValue)); };
+  return uint16_t((q(c[0], 31) << 11) | (q(c[1], 63) << 5) | q(c[2], 31));
+}
+
+static void UnpackRgb565(uint16_t v, int out[3]) {
+  int r = v >> 11, g = (v >> 5) & 63, b = v & 31;
+  out[0] = (r << 3) | (r >> 2);
+  out[1] = (g << 2) | (g >> 4);
+  out[2] = (b << 3) | (b >> 2);
+}
+
+static void MakeBc1Palette(uint16_t c0, uint16_t c1, bool isFourColor, int palette[4][4]) {
+  UnpackRgb565(c0, palette[0]);
+  UnpackRgb565(c1, palette[1]);
+  palette[0][3] = palette[1][3] = 255;
+  for (int k = 0; k < 3; k++) {
+    if (isFourColor) {
+      palette[2][k] = (2 * palette[0][k] + palette[1][k]) / 3;
+      palette[3][k] = (palette[0][k] + 2 * palette[1][k]) / 3;
+    } else {
+      palette[2][k] = (palette[0][k] + palette[1][k]) / 2;
+      palette[3][k] = 0;
+    }
+  }
+  palette[2][3] = 255;
+  palette[3][3] = isFourColor ? 255 : 0;
+}
+
+/**
+ * @brief 选出每个像素最近的颜色，返回总的平方误差
+ */
+static int SelectBc1Indices(const uint8_t (*rgba)[4], uint16_t c0, uint16_t c1, uint8_t indices[16]) {
+  int palette[4][4];
+  MakeBc1Palette(c0, c1, true, palette);
+  int total = 0;
+  for (int i = 0; i < 16; i++) {
+    int best = 0, bestError = INT32_MAX;
+    for (int j = 0; j < 4; j++) {
+      int dr = rgba[i][0] - palette[j][0], dg = rgba[i][1] - palette[j][1], db = rgba[i][2] - palette[j][2];
+      int error = dr * dr + dg * dg + db * db;
+      if (error < bestError) {
+        best = j;
+        bestError = error;
+      }
+    }
+    indices[i] = uint8_t(best);
+    total += bestError;
+  }
+  return total;
+}
+
+/**
+ * @brief 总是使用四色模式，BC3的颜色部分也可以直接用
+ */
+static void EncodeBc1(const uint8_t (*rgba)[4], uint8_t* block) {
+  float points[16][3];
+  for (int i = 0; i < 16; i++) {
+    for (int k = 0; k < 3; k++) {
+      points[i][k] = rgba[i][k];
+    }
+  }
+  float lo[3], hi[3];
+  FitPrincipalEndpoints(points, 16, lo, hi);
+  uint16_t c0 = PackRgb565(hi), c1 = PackRgb565(lo);
+  uint8_t indices[16];
+  int error = SelectBc1Indices(rgba, c0, c1, indices);
+  //按当前的索引用最小二乘修正端点，误差变小才采用
+  constexpr float weights[4] = {0, 1, 1.0f / 3, 2.0f / 3};  //向c1插值的系数
+  for (int iter = 0; iter < 2 && error > 0; iter++) {
+    float t[16];
+    for (int i = 0; i < 16; i++) {
+      t[i] = weights[indices[i]];
+    }
+    if (!SolveEndpoints(points, t, 16, hi, lo)) {
+      break;
+    }
+    uint16_t n0 = PackRgb565(hi), n1 = PackRgb565(lo);
+    uint8_t newIndices[16];
+    int newError = SelectBc1Indices(rgba, n0, n1, newIndices);
+    if (newError >= error) {
+      break;
+    }
+    c0 = n0;
+    c1 = n1;
+    error = newError;
+    std::memcpy(indices, newIndices, sizeof(indices));
+  }
+  if (c0 < c1) {
+    std::swap(c0, c1);
+    for (auto& index : indices) {
+      index ^= 1;  //0和1、2和3互换
+    }
+  } else if (c0 == c1) {
+    std::memset(indices, 0, sizeof(indices));  //c0 == c1 会被解码为三色模式，只能用第0个颜色
+  }
+  uint32_t bits = 0;
+  for (int i = 0; i < 16; i++) {
+    bits |= uint32_t(indices[i]) << (i * 2);
+  }
+  block[0] = uint8_t(c0);
+  block[1] = uint8_t(c0 >> 8);
+  block[2] = uint8_t(c1);
+  block[3] = uint8_t(c1 >> 8);
+  std::memcpy(block + 4, &bits, 4);
+}
+
+static void DecodeBc1(const uint8_t* block, bool isForceFourColor, uint8_t (*rgba)[4]) {
+  uint16_t c0 = uint16_t(block[0] | (block[1] << 8));
+  uint16_t c1 = uint16_t(block[2] | (block[3] << 8));
+  int palette[4][4];
+  MakeBc1Palette(c0, c1, isForceFourColor || c0 > c1, palette);
+  uint32_t bits;
+  std::memcpy(&bits, block + 4, 4);
+  for (int i = 0; i < 16; i++) {
+    const int* c = palette[(bits >> (i * 2)) & 3];
+    for (int k = 0; k < 4; k++) {
+      rgba[i][k] = uint8_t(c[k]);
+    }
+  }
+}
+
+static void MakeBc4Palette(int e0, int e1, int palette[8]) {
+  palette[0] = e0;
+  palette[1] = e1;
+  if (e0 > e1) {
+    for (int i = 2; i < 8; i++) {
+      palette[i] = ((8 - i) * e0 + (i - 1) * e1 + 3) / 7;
+    }
+  } else {
+    for (int i = 2; i < 6; i++) {
+      palette[i] = ((6 - i) * e0 + (i - 1) * e1 + 2) / 5;
+    }
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+}
+
+/**
+ * @brief 使用八值模式，端点取最大最小值
+ */
+static void EncodeBc4(const uint8_t* values, size_t stride, uint8_t* block) {
+  int e0 = 0, e1 = 255;
+  for (int i = 0; i < 16; i++) {
+    e0 = std::max(e0, int(values[i * stride]));
+    e1 = std::min(e1, int(values[i * stride]));
+  }
+  int palette[8];
+  MakeBc4Palette(e0, e1, palette);
+  uint64_t bits = 0;
+  for (int i = 0; i < 16; i++) {
+    int v = values[i * stride];
+    int best = 0, bestError = INT32_MAX;
+    for (int j = 0; j < 8; j++) {
+      int error = std::abs(v - palette[j]);
+      if (error < bestError) {
+        best = j;
+        bestError = error;
+      }
+    }
+    bits |= uint64_t(best) << (i * 3);
+  }
+  block[0] = uint8_t(e0);
+  block[1] = uint8_t(e1);
+  for (int i = 0; i < 6; i++) {
+    block[2 + i] = uint8_t(bits >> (i * 8));
+  }
+}
+
+static void DecodeBc4(const uint8_t* block, uint8_t* values, size_t stride) {
+  int palette[8];
+  MakeBc4Palette(block[0], block[1], palette);
+  uint64_t bits = 0;
+  for (int i = 0; i < 6; i++) {
+    bits |= uint64_t(block[2 + i]) << (i * 8);
+  }
+  for (int i = 0; i < 16; i++) {
+    values[i * stride] = uint8_t(palette[(bits >> (i * 3)) & 7]);
+  }
+}
+
+constexpr int BC6H_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+static int Bc6hUnquantize(int q) {
+  if (q == 0) {
+    return 0;
+  }
+  if (q == 1023) {
+    return 0xFFFF;
+  }
+  return ((q << 16) + 0x8000) >> 10;
+}
+
+/**
+ * @brief 半精度的位模式反推10位端点（未取整），是 Bc6hUnquantize 和 Bc6hInterpolate 最后一步的逆
+ */
+static float Bc6hQuantize(float halfBits) {
+  float unq = std::clamp(halfBits, 0.0f, 31743.0f) * (64.0f / 31.0f);
+  return std::clamp((unq - 32.0f) / 64.0f, 0.0f, 1023.0f);
+}
+
+static int Bc6hInterpolate(int a, int b, int index) {
+  int w = BC6H_WEIGHTS[index];
+  //无符号格式最后乘31/64，得到半精度的位模式
+  return ((((64 - w) * a + w * b + 32) >> 6) * 31) >> 6;
+}
+
+static float SelectBc6hIndices(const float (*halfBits)[3], const int q0[3], const int q1[3], uint8_t indices[16]) {
+  int a[3], b[3];
+  for (int k = 0; k < 3; k++) {
+    a[k] = Bc6hUnquantize(q0[k]);
+    b[k] = Bc6hUnquantize(q1[k]);
+  }
+  int palette[16][3];
+  for (int j = 0; j < 16; j++) {
+    for (int k = 0; k < 3; k++) {
+      palette[j][k] = Bc6hInterpolate(a[k], b[k], j);
+    }
+  }
+  float total = 0;
+  for (int i = 0; i < 16; i++) {
+    int best = 0;
+    float bestError = 1e30f;
+    for (int j = 0; j < 16; j++) {
+      float error = 0;
+      for (int k = 0; k < 3; k++) {
+        float d = halfBits[i][k] - palette[j][k];
+        error += d * d;
+      }
+      if (error < bestError) {
+        best = j;
+        bestError = error;
+      }
+    }
+    indices[i] = uint8_t(best);
+    total += bestError;
+  }
+  return total;
+}
+
+/**
+ * @brief 按位模式的大小拟合端点，半精度的位模式近似对数分布，相对误差比较均匀
+ */
+static void EncodeBc6h(const float (*rgb)[3], uint8_t* block) {
+  float points[16][3];
+  for (int i = 0; i < 16; i++) {
+    for (int k = 0; k < 3; k++) {
+      float v = rgb[i][k] > 0 ? std::min(rgb[i][k], 65504.0f) : 0.0f;  //NaN也变为0
+      points[i][k] = float(FloatToHalf(v));
+    }
+  }
+  //10位端点的步长约为3%，除了四舍五入，再试一次把端点向外取整，让插值覆盖端点之间的值
+  int q0[3] = {}, q1[3] = {};
+  uint8_t indices[16] = {};
+  float error = 1e30f;
+  auto tryEndpoints = [&](const float lo[3], const float hi[3]) {
+    bool isBetter = false;
+    for (int isOutward = 0; isOutward < 2; isOutward++) {
+      int n0[3], n1[3];
+      for (int k = 0; k < 3; k++) {
+        float a = Bc6hQuantize(lo[k]), b = Bc6hQuantize(hi[k]);
+        if (isOutward) {
+          n0[k] = int(a <= b ? std::floor(a) : std::ceil(a));
+          n1[k] = int(a <= b ? std::ceil(b) : std::floor(b));
+        } else {
+          n0[k] = int(std::lround(a));
+          n1[k] = int(std::lround(b));
+        }
+      }
+      uint8_t newIndices[16];
+      float newError = SelectBc6hIndices(points, n0, n1, newIndices);
+      if (newError < error) {
+        std::memcpy(q0, n0, sizeof(q0));
+        std::memcpy(q1, n1, sizeof(q1));
+        std::memcpy(indices, newIndices, sizeof(indices));
+        error = newError;
+        isBetter = true;
+      }
+    }
+    return isBetter;
+  };
+  float lo[3], hi[3];
+  FitPrincipalEndpoints(points, 16, lo, hi);
+  tryEndpoints(lo, hi);
+  for (int iter = 0; iter < 2 && error > 0; iter++) {
+    float t[16];
+    for (int i = 0; i < 16; i++) {
+      t[i] = BC6H_WEIGHTS[indices[i]] / 64.0f;
+    }
+    if (!SolveEndpoints(points, t, 16, lo, hi) || !tryEndpoints(lo, hi)) {
+      break;
+    }
+  }
+  //第0个像素的索引只存3位，最高位必须为0，否则交换端点。权重表是对称的
+  if (indices[0] >= 8) {
+    std::swap(q0, q1);
+    for (auto& index : indices) {
+      index = uint8_t(15 - index);
+    }
+  }
+  uint64_t bits[2] = {};
+  int pos = 0;
+  auto write = [&](uint64_t value, int count) {
+    for (int i = 0; i < count; i++, pos++) {
+      bits[pos >> 6] |= ((value >> i) & 1) << (pos & 63);
+    }
+  };
+  write(0x03, 5);  //模式11
+  for (int k = 0; k < 3; k++) {
+    write(uint64_t(q0[k]), 10);
+  }
+  for (int k = 0; k < 3; k++) {
+    write(uint64_t(q1[k]), 10);
+  }
+  write(indices[0], 3);
+  for (int i = 1; i < 16; i++) {
+    write(indices[i], 4);
+  }
+  for (int i = 0; i < 16; i++) {
+    block[i] = uint8_t(bits[i >> 3] >> ((i & 7) * 8));
+  }
+}
+
+static bool DecodeBc6h(const uint8_t* block, float (*rgb)[3]) {
+  int pos = 0;
+  auto read = [&](int count) {
+    int value = 0;
+    for (int i = 0; i < count; i++, pos++) {
+      value |= ((block[pos >> 3] >> (pos & 7)) & 1) << i;
+    }
+    return value;
+  };
+  if (read(5) != 0x03) {
+    return false;
+  }
+  int a[3], b[3];
+  for (int k = 0; k < 3; k++) {
+    a[k] = Bc6hUnquantize(read(10));
+  }
+  for (int k = 0; k < 3; k++) {
+    b[k] = Bc6hUnquantize(read(10));
+  }
+  for (int i = 0; i < 16; i++) {
+    int index = read(i == 0 ? 3 : 4);
+    for (int k = 0; k < 3; k++) {
+      rgb[i][k] = HalfToFloat(uint16_t(Bc6hInterpolate(a[k], b[k], index)));
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief 压缩一级，超出边界的像素取边缘像素
+ */
+static void CompressLevel(const void* data, int width, int height, int channel, BlockFormat format, uint8_t* output) {
+  const int blocksX = (width + 3) / 4;
+  const int blocksY = (height + 3) / 4;
+  const size_t blockSize = GetBlockByteSize(format);
+  ParallelFor(0, blocksY, 1, [&](size_t begin, size_t end) {
+    for (size_t by = begin; by < end; by++) {
+      for (int bx = 0; bx < blocksX; bx++) {
+        uint8_t* block = output + (by * blocksX + bx) * blockSize;
+        if (format == BlockFormat::BC6H) {
+          float rgb[16][3];
+          for (int i = 0; i < 16; i++) {
+            int x = std::min(bx * 4 + (i & 3), width - 1);
+            int y = std::min(int(by) * 4 + (i >> 2), height - 1);
+            const float* p = static_cast<const float*>(data) + (size_t(y) * width + x) * channel;
+            for (int k = 0; k < 3; k++) {
+              rgb[i][k] = channel >= 3 ? p[k] : (channel == 1 ? p[0] : (k < 2 ? p[k] : 0.0f));
+            }
+          }
+          EncodeBc6h(rgb, block);
+          continue;
+        }
+        uint8_t rgba[16][4];
+        for (int i = 0; i < 16; i++) {
+          int x = std::min(bx * 4 + (i & 3), width - 1);
+          int y = std::min(int(by) * 4 + (i >> 2), height - 1);
+          const uint8_t* p = static_cast<const uint8_t*>(data) + (size_t(y) * width + x) * channel;
+          for (int k = 0; k < 3; k++) {
+            rgba[i][k] = channel >= 3 ? p[k] : (channel == 1 ? p[0] : (k < 2 ? p[k] : 0));
+          }
+          rgba[i][3] = channel == 4 ? p[3] : 255;
+        }
+        switch (format) {
+          case BlockFormat::BC1:
+            EncodeBc1(rgba, block);
+            break;
+          case BlockFormat::BC3:
+            EncodeBc4(&rgba[0][3], 4, block);
+            EncodeBc1(rgba, block + 8);
+            break;
+          case BlockFormat::BC4:
+            EncodeBc4(&rgba[0][0], 4, block);
+            break;
+          case BlockFormat::BC5:
+            EncodeBc4(&rgba[0][0], 4, block);
+            EncodeBc4(&rgba[0][1], 4, block + 8);
+            break;
+          default:
+            break;
+        }
+      }
+    }
+  });
+}
+
+bool DecompressBlocks(const void* blocks, BlockFormat format, int width, int height, void* output) {
+  const int blocksX = (width + 3) / 4;
+  const int blocksY = (height + 3) / 4;
+  const size_t blockSize = GetBlockByteSize(format);
+  const int channel = format == BlockFormat::BC4 ? 1 : (format == BlockFormat::BC5 ? 2 : (format == BlockFormat::BC6H ? 3 : 4));
+  for (int by = 0; by < blocksY; by++) {
+    for (int bx = 0; bx < blocksX; bx++) {
+      const uint8_t* block = static_cast<const uint8_t*>(blocks) + (size_t(by) * blocksX + bx) * blockSize;
+      uint8_t rgba[16][4];
+      float rgb[16][3];
+      switch (format) {
+        case BlockFormat::BC1:
+          DecodeBc1(block, false, rgba);
+          break;
+        case BlockFormat::BC3:
+          DecodeBc1(block + 8, true, rgba);
+          DecodeBc4(block, &rgba[0][3], 4);
+          break;
+        case BlockFormat::BC4:
+          DecodeBc4(block, &rgba[0][0], 4);
+          break;
+        case BlockFormat::BC5:
+          DecodeBc4(block, &rgba[0][0], 4);
+          DecodeBc4(block + 8, &rgba[0][1], 4);
+          break;
+        case BlockFormat::BC6H:
+          if (!DecodeBc6h(block, rgb)) {
+            return false;
+          }
+          break;
+      }
+      for (int i = 0; i < 16; i++) {
+        int x = bx * 4 + (i & 3), y = by * 4 + (i >> 2);
+        if (x >= width || y >= height) {
+          continue;
+        }
+        size_t offset = (size_t(y) * width + x) * channel;
+        if (format == BlockFormat::BC6H) {
+          std::memcpy(static_cast<float*>(output) + offset, rgb[i], sizeof(rgb[i]));
+        } else {
+          std::memcpy(static_cast<uint8_t*>(output) + offset, rgba[i], channel);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool CompressedTexture::IsValid() const { return _levelCount > 0; }
+
+BlockFormat CompressedTexture::GetFormat() const { return _format; }
+
+bool CompressedTexture::IsSrgb() const { return _isSrgb; }
+
+int CompressedTexture::GetLevelCount() const { return _levelCount; }
+
+int CompressedTexture::GetWidth(int level) const { return std::max(1, _width >> level); }
+
+int CompressedTexture::GetHeight(int level) const { return std::max(1, _height >> level); }
+
+const void* CompressedTexture::GetLevelData(int level) const {
+  if (level < 0 || level >= _levelCount) {
+    return nullptr;
+  }
+  return _data.data() + _offsets[level];
+}
+
+size_t CompressedTexture::GetLevelByteSize(int level) const {
+  if (level < 0 || level >= _levelCount) {
+    return 0;
+  }
+  return CalcBlockCompressedSize(_format, GetWidth(level), GetHeight(level));
+}
+
+size_t CompressedTexture::GetByteSize() const { return _data.size(); }
+
+void CompressedTexture::Allocate(BlockFormat format, bool isSrgb, int width, int height, int levelCount) {
+  _format = format;
+  _isSrgb = isSrgb;
+  _width = width;
+  _height = height;
+  _levelCount = levelCount;
+  _offsets.assign(size_t(levelCount), 0);
+  size_t offset = 0;
+  for (int i = 0; i < levelCount; i++) {
+    _offsets[i] = offset;
+    offset += GetLevelByteSize(i);
+  }
+  _data.assign(offset, 0);
+}
+
+bool CompressedTexture::SaveToDds(const std::filesystem::path& path) const { return SaveToDds(path, 0); }
+
+bool CompressedTexture::SaveToDds(const std::filesystem::path& path, uint64_t key) const {
+  if (!IsValid()) {
+    return false;
+  }
+  uint32_t dxgi = 0;
+  for (const auto& info : BLOCK_FORMAT_INFOS) {
+    if (info.Format == _format && info.IsSrgb == _isSrgb) {
+      dxgi = info.Dxgi;
+      break;
+    }
+  }
+  DdsHeader header{};
+  header.Size = sizeof(DdsHeader);
+  header.Flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;  //CAPS|HEIGHT|WIDTH|PIXELFORMAT|MIPMAPCOUNT|LINEARSIZE
+  header.Height = uint32_t(_height);
+  header.Width = uint32_t(_width);
+  header.PitchOrLinearSize = uint32_t(GetLevelByteSize(0));
+  header.MipMapCount = uint32_t(_levelCount);
+  if (key != 0) {
+    header.Reserved1[0] = DDS_HIKARI_TAG;
+    header.Reserved1[1] = uint32_t(key);
+    header.Reserved1[2] = uint32_t(key >> 32);
+  }
+  header.PixelFormat.Size = sizeof(DdsPixelFormat);
+  header.PixelFormat.Flags = 0x4;  //DDPF_FOURCC
+  header.PixelFormat.FourCC = MakeFourCC('D', 'X', '1', '0');
+  header.Caps[0] = 0x1000 | (_levelCount > 1 ? 0x400008 : 0);  //TEXTURE，有mipmap时加上COMPLEX|MIPMAP
+  DdsHeaderDx10 dx10{};
+  dx10.DxgiFormat = dxgi;
+  dx10.ResourceDimension = 3;  //D3D10_RESOURCE_DIMENSION_TEXTURE2D
+  dx10.ArraySize = 1;
+
+  std::error_code ec;
+  if (path.has_parent_path()) {
+    std::filesystem::create_directories(path.parent_path(), ec);
+  }
+  //先写临时文件再重命名，避免其他进程读到写了一半的文件
+  auto tempPath = path;
+  tempPath += ".tmp";
+  {
+    std::ofstream stream(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+      return false;
+    }
+    stream.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(&dx10), sizeof(dx10));
+    stream.write(reinterpret_cast<const char*>(_data.data()), _data.size());
+    if (!stream.good()) {
+      return false;
+    }
+  }
+  std::filesystem::rename(tempPath, path, ec);
+  if (ec) {
+    std::filesystem::remove(tempPath, ec);
+    return false;
+  }
+  return true;
+}
+
+bool CompressedTexture::LoadDds(const std::filesystem::path& path, uint64_t* key) {
+  MappedFile file;
+  if (!file.Open(path) || file.GetSize() < sizeof(uint32_t) + sizeof(DdsHeader)) {
+    return false;
+  }
+  const uint8_t* base = file.GetData();
+  uint32_t magic;
+  DdsHeader header;
+  std::memcpy(&magic, base, sizeof(magic));
+  std::memcpy(&header, base + sizeof(magic), sizeof(header));
+  if (magic != DDS_MAGIC || header.Size != sizeof(DdsHeader) || header.Width == 0 || header.Height == 0 ||
+      header.Width > 65536 || header.Height > 65536 || (header.Caps[1] & 0x200) != 0) {  //不支持cubemap
+    return false;
+  }
+  size_t offset = sizeof(magic) + sizeof(header);
+  BlockFormat format;
+  bool isSrgb = false;
+  const uint32_t fourCC = header.PixelFormat.FourCC;
+  if ((header.PixelFormat.Flags & 0x4) == 0) {
+    return false;
+  }
+  if (fourCC == MakeFourCC('D', 'X', '1', '0')) {
+    if (file.GetSize() < offset + sizeof(DdsHeaderDx10)) {
+      return false;
+    }
+    DdsHeaderDx10 dx10;
+    std::memcpy(&dx10, base + offset, sizeof(dx10));
+    offset += sizeof(dx10);
+    if (dx10.ResourceDimension != 3 || dx10.ArraySize > 1 || (dx10.MiscFlag & 0x4) != 0) {
+      return false;
+    }
+    auto info = std::find_if(std::begin(BLOCK_FORMAT_INFOS), std::end(BLOCK_FORMAT_INFOS),
+                             [&](const BlockFormatInfo& i) { return i.Dxgi == dx10.DxgiFormat; });
+    if (info == std::end(BLOCK_FORMAT_INFOS)) {
+      return false;
+    }
+    format = info->Format;
+    isSrgb = info->IsSrgb;
+  } else if (fourCC == MakeFourCC('D', 'X', 'T', '1')) {
+    format = BlockFormat::BC1;
+  } else if (fourCC == MakeFourCC('D', 'X', 'T', '4') || fourCC == MakeFourCC('D', 'X', 'T', '5')) {
+    format = BlockFormat::BC3;
+  } else if (fourCC == MakeFourCC('A', 'T', 'I', '1') || fourCC == MakeFourCC('B', 'C', '4', 'U')) {
+    format = BlockFormat::BC4;
+  } else if (fourCC == MakeFourCC('A', 'T', 'I', '2') || fourCC == MakeFourCC('B', 'C', '5', 'U')) {
+    format = BlockFormat::BC5;
+  } else {
+    return false;
+  }
+  int levelCount = (header.Flags & 0x20000) != 0 ? std::max(1, int(header.MipMapCount)) : 1;
+  CompressedTexture texture;
+  texture.Allocate(format, isSrgb, int(header.Width), int(header.Height), std::min(levelCount, 17));
+  if (file.GetSize() < offset + texture._data.size()) {
+    return false;
+  }
+  std::memcpy(texture._data.data(), base + offset, texture._data.size());
+  if (key != nullptr) {
+    *key = header.Reserved1[0] == DDS_HIKARI_TAG ? (uint64_t(header.Reserved1[2]) << 32) | header.Reserved1[1] : 0;
+  }
+  *this = std::move(texture);
+  return true;
+}
+
+bool CompressedTexture::LoadFromDds(const std::filesystem::path& path, CompressedTexture& texture) {
+  return texture.LoadDds(path, nullptr);
+}
+
+bool CompressedTexture::LoadFromKtx2(const std::filesystem::path& path, CompressedTexture& texture) {
+  MappedFile file;
+  if (!file.Open(path) || file.GetSize() < sizeof(Ktx2Header)) {
+    return false;
+  }
+  const uint8_t* base = file.GetData();
+  Ktx2Header header;
+  std::memcpy(&header, base, sizeof(header));
+  if (std::memcmp(header.Identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0 ||
+      header.SupercompressionScheme != 0 || header.PixelDepth > 1 || header.LayerCount > 1 || header.FaceCount != 1 ||
+      header.PixelWidth == 0 || header.PixelHeight == 0 || header.PixelWidth > 65536 || header.PixelHeight > 65536) {
+    return false;
+  }
+  auto info = std::find_if(std::begin(BLOCK_FORMAT_INFOS), std::end(BLOCK_FORMAT_INFOS),
+                           [&](const BlockFormatInfo& i) { return i.Vk == header.VkFormat; });
+  if (info == std::end(BLOCK_FORMAT_INFOS)) {
+    return false;
+  }
+  //levelCount为0表示由使用者生成mipmap，文件里只有第0级
+  int levelCount = std::min(std::max(1, int(header.LevelCount)), 17);
+  if (file.GetSize() < sizeof(header) + levelCount * sizeof(Ktx2LevelIndex)) {
+    return false;
+  }
+  CompressedTexture result;
+  result.Allocate(info->Format, info->IsSrgb, int(header.PixelWidth), int(header.PixelHeight), levelCount);
+  for (int i = 0; i < levelCount; i++) {
+    Ktx2LevelIndex level;
+    std::memcpy(&level, base + sizeof(header) + i * sizeof(Ktx2LevelIndex), sizeof(level));
+    size_t size = result.GetLevelByteSize(i);
+    if (level.ByteLength != size || level.ByteOffset > file.GetSize() || size > file.GetSize() - level.ByteOffset) {
+      return false;
+    }
+    std::memcpy(result._data.data() + result._offsets[i], base + level.ByteOffset, size);
+  }
+  texture = std::move(result);
+  return true;
+}
+
+bool CompressedTexture::LoadFromFile(const std::filesystem::path& path, CompressedTexture& texture) {
+  uint8_t identifier[sizeof(KTX2_IDENTIFIER)] = {};
+  {
+    std::ifstream stream(path, std::ios::in | std::ios::binary);
+    if (!stream.is_open()) {
+      return false;
+    }
+    stream.read(reinterpret_cast<char*>(identifier), sizeof(identifier));
+  }
+  if (std::memcmp(identifier, KTX2_IDENTIFIER, sizeof(identifier)) == 0) {
+    return LoadFromKtx2(path, texture);
+  }
+  return LoadFromDds(path, texture);
+}
+
+CompressedTexture CompressTexture(const void* data,
+                                  int width,
+                                  int height,
+                                  int channel,
+                                  MipDataType type,
+                                  BlockFormat format,
+                                  const BlockCompressOptions& options) {
+  CompressedTexture texture;
+  const bool isHdr = format == BlockFormat::BC6H;
+  if (data == nullptr || width <= 0 || height <= 0 || channel < 1 || channel > 4 ||
+      isHdr != (type == MipDataType::Float32)) {
+    return texture;
+  }
+  const bool isSrgb = options.IsSrgb && (format == BlockFormat::BC1 || format == BlockFormat::BC3);
+  MipGenerateOptions mipOptions = options.Mip;
+  mipOptions.IsSrgb = isSrgb;
+  mipOptions.UseCache = false;  //只缓存最终的压缩结果
+  std::filesystem::path cachePath;
+  uint64_t key = 0;
+  if (options.UseCache) {
+    BlockCacheKey k{BC_CACHE_VERSION, uint32_t(width), uint32_t(height), uint32_t(channel), uint32_t(type),
+                    uint32_t(format), isSrgb, options.GenerateMips, uint32_t(mipOptions.Filter), mipOptions.IsWrap,
+                    mipOptions.MaxLevelCount, mipOptions.KaiserWidth, mipOptions.KaiserAlpha};
+    key = Hash64(&k, sizeof(k), Hash64(data, size_t(width) * height * channel * SizeOfMipDataType(type)));
+    key = key == 0 ? 1 : key;  //0表示不是缓存文件
+    cachePath = GetCacheDirectory() / "texture" / (ToHexString(key) + ".dds");
+    uint64_t cachedKey = 0;
+    if (texture.LoadDds(cachePath, &cachedKey) && cachedKey == key) {
+      return texture;
+    }
+  }
+  MipChain mips;
+  int levelCount = 1;
+  if (options.GenerateMips) {
+    mips = GenerateMipChain(data, width, height, channel, type, mipOptions);
+    levelCount = mips.GetLevelCount();
+  }
+  texture.Allocate(format, isSrgb, width, height, levelCount);
+  for (int level = 0; level < levelCount; level++) {
+    const void* src = level == 0 ? data : mips.GetLevelData(level);
+    auto dst = const_cast<uint8_t*>(static_cast<const uint8_t*>(texture.GetLevelData(level)));
+    CompressLevel(src, texture.GetWidth(level), texture.GetHeight(level), channel, format, dst);
+  }
+  if (options.UseCache && !texture.SaveToDds(cachePath, key)) {
+    std::cout << "can't write texture cache: " << cachePath << "\n";
+  }
+  return texture;
+}
+
+//-------------------------------------------------------------------------------------------------
+// 全景图转cubemap
+//-------------------------------------------------------------------------------------------------
+constexpr uint32_t CUBE_CACHE_MAGIC = 0x42434B48;  //"HKCB"
+constexpr uint32_t CUBE_CACHE_VERSION = 1;
+
+struct CubeCacheHeader {
+  uint32_t Magic;
+  uint32_t Version;
+  uint64_t Key;
+  uint32_t Size;
+  uint32_t LevelCount;
+  uint64_t FileSize;
+};
+
+/**
+ * @brief 面上的方向 = Major + u * U + v * V，u、v 范围 [-1, 1]，v 沿着行增加。与OpenGL规范中cubemap的选面规则互逆
+ */
+struct CubeFaceAxis {
+  float Major[3];
+  float U[3];
+  float V[3];
+};
+
+static const CubeFaceAxis CUBE_FACE_AXES[6] = {
+    {{1, 0, 0}, {0, 0, -1}, {0, -1, 0}},
+    {{-1, 0, 0}, {0, 0, 1}, {0, -1, 0}},
+    {{0, 1, 0}, {1, 0, 0}, {0, 0, 1}},
+    {{0, -1, 0}, {1, 0, 0}, {0, 0, -1}},
+    {{0, 0, 1}, {1, 0, 0}, {0, -1, 0}},
+    {{0, 0, -1}, {-1, 0, 0}, {0, -1, 0}},
+};
+
+template <HdrStorage Storage>
+static void FetchHdrTexel(const void* data, size_t index, int channel, float* out) {
+  if constexpr (Storage == HdrStorage::Float32) {
+    const float* p = static_cast<const float*>(data) + index * channel;
+    out[0] = p[0];
+    out[1] = p[1];
+    out[2] = p[2];
+  } else if constexpr (Storage == HdrStorage::Half) {
+    const uint16_t* p = static_cast<const uint16_t*>(data) + index * 3;
+    out[0] = HalfToFloat(p[0]);
+    out[1] = HalfToFloat(p[1]);
+    out[2] = HalfToFloat(p[2]);
+  } else {
+    Vector3f c = Rgb9e5ToFloat(static_cast<const uint32_t*>(data)[index]);
+    out[0] = c.X();
+    out[1] = c.Y();
+    out[2] = c.Z();
+  }
+}
+
+/**
+ * @brief 转换 [begin, end) 范围内的行，行号为 face * faceSize + y
+ */
+template <HdrStorage Storage>
+static void ConvertEquirectRows(const void* data, int width, int height, int channel, int faceSize,
+                                size_t begin, size_t end, float* output) {
+  constexpr float INV_TWO_PI = float(0.5 / PI_VALUE);
+  constexpr float INV_PI = float(1.0 / PI_VALUE);
+  const float step = 2.0f / faceSize;
+  for (size_t row = begin; row < end; row++) {
+    const CubeFaceAxis& axis = CUBE_FACE_AXES[row / faceSize];
+    const float v = (float(row % faceSize) + 0.5f) * step - 1.0f;
+    float base[3];
+    for (int k = 0; k < 3; k++) {
+      base[k] = axis.Major[k] + v * axis.V[k];
+    }
+    float* dst = output + row * faceSize * 3;
+    for (int x = 0; x < faceSize; x++) {
+      const float u = (float(x) + 0.5f) * step - 1.0f;
+      const float dx = base[0] + u * axis.U[0];
+      const float dy = base[1] + u * axis.U[1];
+      const float dz = base[2] + u * axis.U[2];
+      const float invLength = 1.0f / std::sqrt(dx * dx + dy * dy + dz * dz);
+      const float su = std::atan2(dz, dx) * INV_TWO_PI + 0.5f;
+      const float sv = std::asin(std::clamp(dy * invLength, -1.0f, 1.0f)) * INV_PI + 0.5f;
+      //纹素中心在 +0.5 处
+      const float fx = su * width - 0.5f;
+      const float fy = sv * height - 0.5f;
+      const float flx = std::floor(fx), fly = std::floor(fy);
+      const float tx = fx - flx, ty = fy - fly;
+      int x0 = int(flx) % width;
+      x0 = x0 < 0 ? x0 + width : x0;
+      const int x1 = x0 + 1 == width ? 0 : x0 + 1;
+      const int y0 = std::clamp(int(fly), 0, height - 1);
+      const int y1 = std::clamp(int(fly) + 1, 0, height - 1);
+      float c00[3], c10[3], c01[3], c11[3];
+      FetchHdrTexel<Storage>(data, size_t(y0) * width + x0, channel, c00);
+      FetchHdrTexel<Storage>(data, size_t(y0) * width + x1, channel, c10);
+      FetchHdrTexel<Storage>(data, size_t(y1) * width + x0, channel, c01);
+      FetchHdrTexel<Storage>(data, size_t(y1) * width + x1, channel, c11);
+      const float w00 = (1 - tx) * (1 - ty), w10 = tx * (1 - ty), w01 = (1 - tx) * ty, w11 = tx * ty;
+      for (int k = 0; k < 3; k++) {
+        dst[x * 3 + k] = c00[k] * w00 + c10[k] * w10 + c01[k] * w01 + c11[k] * w11;
+      }
+    }
+  }
+}
+
+bool CubeMapImage::IsValid() const { return _size > 0; }
+
+int CubeMapImage::GetSize() const { return _size; }
+
+int CubeMapImage::GetChannel() const { return 3; }
+
+const float* CubeMapImage::GetFaceData(int face) const {
+  if (!IsValid() || face < 0 || face >= 6) {
+    return nullptr;
+  }
+  return _data.data() + size_t(face) * _size * _size * 3;
+}
+
+size_t CubeMapImage::GetFaceByteSize() const { return size_t(_size) * _size * 3 * sizeof(float); }
+
+size_t CubeMapImage::GetByteSize() const { return _data.size() * sizeof(float); }
+
+void CubeMapImage::Allocate(int size) {
+  _size = size;
+  _data.resize(size_t(size) * size * 3 * 6);
+}
+
+void BakedCubeMap::Allocate(int size, int levelCount) {
+  _size = size;
+  _levelCount = levelCount;
+  _offsets.assign(size_t(levelCount), 0);
+  size_t offset = 0;
+  for (int i = 0; i < levelCount; i++) {
+    _offsets[i] = offset;
+    offset += GetFaceByteSize(i) / sizeof(uint16_t) * 6;
+  }
+  _data.assign(offset, 0);
+}
+
+bool BakedCubeMap::IsValid() const { return _levelCount > 0; }
+
+int BakedCubeMap::GetSize(int level) const { return std::max(1, _size >> level); }
+
+int BakedCubeMap::GetLevelCount() const { return _levelCount; }
+
+void* BakedCubeMap::GetFaceData(int level, int face) {
+  return _data.data() + _offsets[level] + GetFaceByteSize(level) / sizeof(uint16_t) * face;
+}
+
+const void* BakedCubeMap::GetFaceData(int level, int face) const {
+  return _data.data() + _offsets[level] + GetFaceByteSize(level) / sizeof(uint16_t) * face;
+}
+
+size_t BakedCubeMap::GetFaceByteSize(int level) const {
+  return size_t(GetSize(level)) * GetSize(level) * 3 * sizeof(uint16_t);
+}
+
+size_t BakedCubeMap::GetByteSize() const { return _data.size() * sizeof(uint16_t); }
+
+bool BakedCubeMap::SaveToFile(const std::filesystem::path& path, uint64_t key) const {
+  CubeCacheHeader header{};
+  header.Magic = CUBE_CACHE_MAGIC;
+  header.Version = CUBE_CACHE_VERSION;
+  header.Key = key;
+  header.Size = uint32_t(_size);
+  header.LevelCount = uint32_t(_levelCount);
+  header.FileSize = sizeof(header) + GetByteSize();
+  std::error_code ec;
+  std::filesystem::create_directories(path.parent_path(), ec);
+  auto tempPath = path;
+  tempPath += ".tmp";
+  {
+    std::ofstream stream(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+      return false;
+    }
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(_data.data()), GetByteSize());
+    if (!stream.good()) {
+      return false;
+    }
+  }
+  std::filesystem::rename(tempPath, path, ec);
+  if (ec) {
+    std::filesystem::remove(tempPath, ec);
+    return false;
+  }
+  return true;
+}
+
+bool BakedCubeMap::LoadFromFile(const std::filesystem::path& path, uint64_t key) {
+  MappedFile file;
+  if (!file.Open(path) || file.GetSize() < sizeof(CubeCacheHeader)) {
+    return false;
+  }
+  CubeCacheHeader header;
+  std::memcpy(&header, file.GetData(), sizeof(header));
+  if (header.Magic != CUBE_CACHE_MAGIC ||
+      header.Version != CUBE_CACHE_VERSION ||
+      header.Key != key ||
+      header.FileSize != file.GetSize() ||
+      header.Size == 0 || header.LevelCount == 0 || header.LevelCount > 32) {
+    return false;
+  }
+  Allocate(int(header.Size), int(header.LevelCount));
+  if (sizeof(header) + GetByteSize() != header.FileSize) {
+    *this = BakedCubeMap();
+    return false;
+  }
+  std::memcpy(_data.data(), file.GetData() + sizeof(header), GetByteSize());
+  return true;
+}
+
+CubeMapImage ConvertEquirectToCubeMap(const void* data, int width, int height, int channel, HdrStorage storage, int faceSize) {
+  CubeMapImage cube;
+  bool isChannelValid = storage == HdrStorage::Float32 ? (channel == 3 || channel == 4) : channel == 3;
+  if (data == nullptr || width <= 0 || height <= 0 || faceSize <= 0 || !isChannelValid) {
+    return cube;
+  }
+  cube.Allocate(faceSize);
+  float* output = cube._data.data();
+  const size_t rowCount = size_t(faceSize) * 6;
+  const size_t grain = std::max(size_t(1), size_t(4096) / size_t(faceSize));
+  ParallelFor(0, rowCount, grain, [&](size_t begin, size_t end) {
+    switch (storage) {
+      case HdrStorage::Half:
+        ConvertEquirectRows<HdrStorage::Half>(data, width, height, channel, faceSize, begin, end, output);
+        break;
+      case HdrStorage::RGB9E5:
+        ConvertEquirectRows<HdrStorage::RGB9E5>(data, width, height, channel, faceSize, begin, end, output);
+        break;
+      default:
+        ConvertEquirectRows<HdrStorage::Float32>(data, width, height, channel, faceSize, begin, end, output);
+        break;
+    }
+  });
+  return cube;
+}
+
+CubeMapImage ConvertEquirectToCubeMap(const ImmutableHdrTexture& hdr, int faceSize) {
+  if (!hdr.IsValid()) {
+    return CubeMapImage();
+  }
+  return ConvertEquirectToCubeMap(hdr.GetRawData(), hdr.GetWidth(), hdr.GetHeight(), hdr.GetChannel(), hdr.GetStorage(), faceSize);
+}
+
+//-------------------------------------------------------------------------------------------------
+// 球谐辐照度
+//-------------------------------------------------------------------------------------------------
+/**
+ * @brief 实数球谐基函数，去掉了常数，顺序为 1, y, z, x, xy, yz, 3z^2-1, xz, x^2-y^2
+ */
+static void ShPolynomials(float x, float y, float z, float* out) {
+  out[0] = 1.0f;
+  out[1] = y;
+  out[2] = z;
+  out[3] = x;
+  out[4] = x * y;
+  out[5] = y * z;
+  out[6] = 3.0f * z * z - 1.0f;
+  out[7] = x * z;
+  out[8] = x * x - y * y;
+}
+
+IrradianceSH9 ProjectIrradianceSH9(const float* const faces[6], int size, int channel) {
+  IrradianceSH9 sh;
+  if (size <= 0 || channel < 3) {
+    return sh;
+  }
+  for (int i = 0; i < 6; i++) {
+    if (faces[i] == nullptr) {
+      return sh;
+    }
+  }
+  //每行的部分和单独保存，最后按顺序相加，结果与线程数无关
+  const size_t rowCount = size_t(size) * 6;
+  std::vector<double> rowSums(rowCount * 28);
+  const float step = 2.0f / size;
+  const size_t grain = std::max(size_t(1), size_t(4096) / size_t(size));
+  ParallelFor(0, rowCount, grain, [&](size_t begin, size_t end) {
+    for (size_t row = begin; row < end; row++) {
+      const CubeFaceAxis& axis = CUBE_FACE_AXES[row / size];
+      const int y = int(row % size);
+      const float v = (float(y) + 0.5f) * step - 1.0f;
+      const float* src = faces[row / size] + size_t(y) * size * channel;
+      float sum[27] = {};
+      float weightSum = 0;
+      for (int x = 0; x < size; x++) {
+        const float u = (float(x) + 0.5f) * step - 1.0f;
+        float d[3];
+        for (int k = 0; k < 3; k++) {
+          d[k] = axis.Major[k] + u * axis.U[k] + v * axis.V[k];
+        }
+        //纹素的立体角近似为 面积 / (1 + u^2 + v^2)^(3/2)
+        const float lengthSq = 1.0f + u * u + v * v;
+        const float invLength = 1.0f / std::sqrt(lengthSq);
+        const float weight = invLength / lengthSq;
+        float basis[9];
+        ShPolynomials(d[0] * invLength, d[1] * invLength, d[2] * invLength, basis);
+        const float* c = src + size_t(x) * channel;
+        for (int i = 0; i < 9; i++) {
+          const float w = basis[i] * weight;
+          sum[i * 3 + 0] += c[0] * w;
+          sum[i * 3 + 1] += c[1] * w;
+          sum[i * 3 + 2] += c[2] * w;
+        }
+        weightSum += weight;
+      }
+      double* dst = &rowSums[row * 28];
+      for (int i = 0; i < 27; i++) {
+        dst[i] = sum[i];
+      }
+      dst[27] = weightSum;
+    }
+  });
+  double total[28] = {};
+  for (size_t row = 0; row < rowCount; row++) {
+    for (int i = 0; i < 28; i++) {
+      total[i] += rowSums[row * 28 + i];
+    }
+  }
+  //立体角的和归一化到4PI，抵消近似的误差
+  const double solidAngle = 4.0 * PI_VALUE / total[27];
+  //基函数常数的平方，乘余弦卷积的系数 PI, 2PI/3, PI/4，再除以PI
+  const double y0 = 0.282094791773878, y1 = 0.488602511902920, y2 = 1.092548430592079;
+  const double y20 = 0.315391565252520, y22 = 0.546274215296040;
+  const double scale[9] = {y0 * y0,
+                           y1 * y1 * 2.0 / 3.0, y1 * y1 * 2.0 / 3.0, y1 * y1 * 2.0 / 3.0,
+                           y2 * y2 / 4.0, y2 * y2 / 4.0, y20 * y20 / 4.0, y2 * y2 / 4.0, y22 * y22 / 4.0};
+  for (int i = 0; i < 9; i++) {
+    for (int k = 0; k < 3; k++) {
+      sh.Coefficients[i][k] = float(total[i * 3 + k] * solidAngle * scale[i]);
+    }
+  }
+  return sh;
+}
+
+IrradianceSH9 ProjectIrradianceSH9(const CubeMapImage& cube) {
+  if (!cube.IsValid()) {
+    return IrradianceSH9();
+  }
+  const float* faces[6];
+  for (int i = 0; i < 6; i++) {
+    faces[i] = cube.GetFaceData(i);
+  }
+  return ProjectIrradianceSH9(faces, cube.GetSize(), cube.GetChannel());
+}
+
+Vector3f EvaluateIrradianceSH9(const IrradianceSH9& sh, const Vector3f& n) {
+  float basis[9];
+  ShPolynomials(n.X(), n.Y(), n.Z(), basis);
+  Vector3f result{};
+  for (int i = 0; i < 9; i++) {
+    for (int k = 0; k < 3; k++) {
+      result[k] += sh.Coefficients[i][k] * basis[i];
+    }
+  }
+  for (int k = 0; k < 3; k++) {
+    result[k] = std::max(result[k], 0.0f);
+  }
+  return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+// BRDF查询表
+//-------------------------------------------------------------------------------------------------
+constexpr uint32_t BRDF_LUT_CACHE_MAGIC = 0x4C424B48;  //"HKBL"
+constexpr uint32_t BRDF_LUT_CACHE_VERSION = 1;
+
+struct BrdfLutCacheHeader {
+  uint32_t Magic;
+  uint32_t Version;
+  uint64_t Key;
+  uint32_t Type;
+  uint32_t Width;
+  uint32_t Height;
+  uint32_t Reserved;
+  uint64_t FileSize;
+};
+
+struct BrdfLutCacheKey {
+  uint32_t Type;
+  uint32_t Width;
+  uint32_t Height;
+  uint32_t SampleCount;
+  uint32_t DiffuseSampleCount;
+};
+
+/**
+ * @brief 与 BRDF.glsl 的 Hammersley 相同
+ */
+static void Hammersley(uint32_t i, uint32_t n, float* xi) {
+  uint32_t bits = i;
+  bits = (bits << 16u) | (bits >> 16u);
+  bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+  bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+  bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+  bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+  xi[0] = float(i) / float(n);
+  xi[1] = float(bits) * 2.3283064365386963e-10f;
+}
+
+/**
+ * @brief 与 BRDF.glsl 的 ImportanceSampleGGX 相同，法线固定为 (0, 0, 1)，
+ * 这时切线是 (0, -1, 0)，副切线是 (1, 0, 0)
+ */
+static void ImportanceSampleGGX(const float* xi, float roughness, float* h) {
+  const float a = roughness * roughness;
+  const float phi = 2.0f * PI * xi[0];
+  const float cosTheta = std::sqrt((1.0f - xi[1]) / (1.0f + (a * a - 1.0f) * xi[1]));
+  const float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+  h[0] = std::sin(phi) * sinTheta;
+  h[1] = -std::cos(phi) * sinTheta;
+  h[2] = cosTheta;
+}
+
+static float SchlickGGX(float NdotV, float k) { return NdotV / (NdotV * (1.0f - k) + k); }
+
+static float Pow5(float x) { return (x * x) * (x * x) * x; }
+
+/**
+ * @brief BrdfLut.frag 的 IntegrateBRDF，V 在 xz 平面上，只需要半程向量的 x 和 z
+ */
+static void IntegrateSplitSum(float NdotV, float roughness, const std::vector<float>& halfVectors, float* out) {
+  const float vx = std::sqrt(1.0f - NdotV * NdotV);
+  const float vz = NdotV;
+  const float k = roughness * roughness / 2.0f;
+  const float gv = SchlickGGX(NdotV, k);
+  const size_t count = halfVectors.size() / 3;
+  double a = 0, b = 0;
+  for (size_t i = 0; i < count; i++) {
+    const float* h = &halfVectors[i * 3];
+    const float VdotH = vx * h[0] + vz * h[2];
+    const float NdotL = std::max(2.0f * VdotH * h[2] - vz, 0.0f);
+    if (NdotL > 0.0f) {
+      const float NdotH = std::max(h[2], 0.0f);
+      const float clampVdotH = std::max(VdotH, 0.0f);
+      const float gVis = gv * SchlickGGX(NdotL, k) * clampVdotH / (NdotH * NdotV);
+      const float fc = Pow5(1.0f - clampVdotH);
+      a += (1.0f - fc) * gVis;
+      b += fc * gVis;
+    }
+  }
+  out[0] = float(a / double(count));
+  out[1] = float(b / double(count));
+}
+
+static float SpecularGMultiScattering(float NoL, float NoV, float a) {
+  float a2 = a * a;
+  a2 = a2 * a2;
+  const float ggxL = NoV * std::sqrt((-NoL * a2 + NoL) * NoL + a2);
+  const float ggxV = NoL * std::sqrt((-NoV * a2 + NoV) * NoV + a2);
+  return (2.0f * NoL) / (ggxL + ggxV);
+}
+
+static float FSchlick(float f0, float f90, float u) { return f0 + (f90 - f0) * Pow5(1.0f - u); }
+
+/**
+ * @brief BrdfLutMultiScattering.frag 的 IntegrateBRDF，cosineSamples 与粗糙度无关，整张表共用
+ */
+static void IntegrateMultiScattering(float NoV, float roughness, const std::vector<float>& halfVectors,
+                                     const std::vector<float>& cosineSamples, float* out) {
+  const float vx = std::sqrt(1.0f - NoV * NoV);
+  const float vz = NoV;
+  const size_t count = halfVectors.size() / 3;
+  double rx = 0, ry = 0;
+  for (size_t i = 0; i < count; i++) {
+    const float* h = &halfVectors[i * 3];
+    const float rawVoH = vx * h[0] + vz * h[2];
+    const float NoL = std::clamp(2.0f * rawVoH * h[2] - vz, 0.0f, 1.0f);
+    if (NoL > 0.0f) {
+      const float VoH = std::clamp(rawVoH, 0.0f, 1.0f);
+      const float NoH = std::clamp(h[2], 0.0f, 1.0f);
+      const float gv = SpecularGMultiScattering(NoL, NoV, roughness) * VoH / NoH;
+      rx += gv;
+      ry += gv * Pow5(1.0f - VoH);
+    }
+  }
+  const size_t diffCount = cosineSamples.size() / 3;
+  const float energy = 1.0f + (1.0f / 0.662f - 1.0f) * roughness;
+  double rz = 0;
+  for (size_t i = 0; i < diffCount; i++) {
+    const float* h = &cosineSamples[i * 3];
+    const float VoH = vx * h[0] + vz * h[2];
+    float l[3] = {2.0f * VoH * h[0] - vx, 2.0f * VoH * h[1], 2.0f * VoH * h[2] - vz};
+    const float NoL = std::clamp(l[2], 0.0f, 1.0f);
+    const float LoH = std::clamp(l[0] * h[0] + l[1] * h[1] + l[2] * h[2], 0.0f, 1.0f);
+    if (LoH > 0.0f) {
+      const float f90 = 0.5f * roughness + 2.0f * LoH * LoH * roughness;
+      rz += FSchlick(1.0f, f90, NoL) * FSchlick(1.0f, f90, NoV) * energy;
+    }
+  }
+  out[0] = float(rx / double(count));
+  out[1] = float(ry / double(count));
+  out[2] = diffCount > 0 ? float(rz / double(diffCount)) : 0.0f;
+}
+
+bool BrdfLut::IsValid() const { return !_data.empty(); }
+
+BrdfLutType BrdfLut::GetType() const { return _type; }
+
+int BrdfLut::GetWidth() const { return _width; }
+
+int BrdfLut::GetHeight() const { return _height; }
+
+int BrdfLut::GetChannel() const { return _type == BrdfLutType::SplitSum ? 2 : 3; }
+
+const float* BrdfLut::GetData() const { return _data.data(); }
+
+size_t BrdfLut::GetByteSize() const { return _data.size() * sizeof(float); }
+
+void BrdfLut::Allocate(BrdfLutType type, int width, int height) {
+  _type = type;
+  _width = width;
+  _height = height;
+  _data.assign(size_t(width) * height * GetChannel(), 0.0f);
+}
+
+bool BrdfLut::SaveToCache(const std::filesystem::path& cachePath, uint64_t key) const {
+  BrdfLutCacheHeader header{};
+  header.Magic = BRDF_LUT_CACHE_MAGIC;
+  header.Version = BRDF_LUT_CACHE_VERSION;
+  header.Key = key;
+  header.Type = uint32_t(_type);
+  header.Width = uint32_t(_width);
+  header.Height = uint32_t(_height);
+  header.FileSize = sizeof(header) + GetByteSize();
+  std::error_code ec;
+  std::filesystem::create_directories(cachePath.parent_path(), ec);
+  auto tempPath = cachePath;
+  tempPath += ".tmp";
+  {
+    std::ofstream stream(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+      return false;
+    }
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(_data.data()), GetByteSize());
+    if (!stream.good()) {
+      return false;
+    }
+  }
+  std::filesystem::rename(tempPath, cachePath, ec);
+  if (ec) {
+    std::filesystem::remove(tempPath, ec);
+    return false;
+  }
+  return true;
+}
+
+bool BrdfLut::LoadFromCache(const std::filesystem::path& cachePath, uint64_t key) {
+  MappedFile file;
+  if (!file.Open(cachePath) || file.GetSize() < sizeof(BrdfLutCacheHeader)) {
+    return false;
+  }
+  BrdfLutCacheHeader header;
+  std::memcpy(&header, file.GetData(), sizeof(header));
+  if (header.Magic != BRDF_LUT_CACHE_MAGIC ||
+      header.Version != BRDF_LUT_CACHE_VERSION ||
+      header.Key != key ||
+      header.FileSize != file.GetSize() ||
+      header.Type > uint32_t(BrdfLutType::MultiScattering)) {
+    return false;
+  }
+  Allocate(BrdfLutType(header.Type), int(header.Width), int(header.Height));
+  if (sizeof(header) + GetByteSize() != header.FileSize) {
+    *this = BrdfLut();
+    return false;
+  }
+  std::memcpy(_data.data(), file.GetData() + sizeof(header), GetByteSize());
+  return true;
+}
+
+BrdfLut BakeBrdfLut(BrdfLutType type, int width, int height, const BrdfLutOptions& options) {
+  BrdfLut lut;
+  if (width <= 0 || height <= 0 || options.SampleCount <= 0) {
+    return lut;
+  }
+  const bool isMulti = type == BrdfLutType::MultiScattering;
+  const int diffCount = isMulti ? std::max(options.DiffuseSampleCount, 0) : 0;
+  std::filesystem::path cachePath;
+  uint64_t key = 0;
+  if (options.UseCache) {
+    BrdfLutCacheKey k{uint32_t(type), uint32_t(width), uint32_t(height), uint32_t(options.SampleCount), uint32_t(diffCount)};
+    key = Hash64(&k, sizeof(k), BRDF_LUT_CACHE_VERSION);
+    cachePath = GetCacheDirectory() / "brdf" / (ToHexString(key) + ".hklut");
+    if (lut.LoadFromCache(cachePath, key)) {
+      return lut;
+    }
+  }
+  lut.Allocate(type, width, height);
+
+  std::vector<float> xis(size_t(options.SampleCount) * 2);
+  for (int i = 0; i < options.SampleCount; i++) {
+    Hammersley(uint32_t(i), uint32_t(options.SampleCount), &xis[size_t(i) * 2]);
+  }
+  std::vector<float> cosineSamples(size_t(diffCount) * 3);
+  for (int i = 0; i < diffCount; i++) {
+    float xi[2];
+    Hammersley(uint32_t(i), uint32_t(diffCount), xi);
+    const float r = std::sqrt(xi[0]);
+    const float theta = 2.0f * PI * xi[1];
+    float* h = &cosineSamples[size_t(i) * 3];
+    h[0] = r * std::cos(theta);
+    h[1] = r * std::sin(theta);
+    h[2] = std::sqrt(std::max(0.0f, 1.0f - xi[0]));
+  }
+  const int channel = lut.GetChannel();
+  float* data = lut._data.data();
+  ParallelFor(0, size_t(height), 1, [&](size_t begin, size_t end) {
+    std::vector<float> halfVectors(size_t(options.SampleCount) * 3);
+    for (size_t y = begin; y < end; y++) {
+      const float roughness = (float(y) + 0.5f) / float(height);
+      for (int i = 0; i < options.SampleCount; i++) {
+        ImportanceSampleGGX(&xis[size_t(i) * 2], roughness, &halfVectors[size_t(i) * 3]);
+      }
+      float* row = data + y * width * channel;
+      for (int x = 0; x < width; x++) {
+        const float NdotV = (float(x) + 0.5f) / float(width);
+        if (isMulti) {
+          IntegrateMultiScattering(NdotV, roughness, halfVectors, cosineSamples, row + size_t(x) * channel);
+        } else {
+          IntegrateSplitSum(NdotV, roughness, halfVectors, row + size_t(x) * channel);
+        }
+      }
+    }
+  });
+  if (options.UseCache && !lut.SaveToCache(cachePath, key)) {
+    std::cout << "can't write brdf lut cache: " << cachePath << "\n";
+  }
+  return lut;
+}
+
+}  // namespace Hikari
@@ -0,0 +1,1143 @@
+#include <hikari/mesh.h>
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cmath>
+#include <array>
+
+#include <hikari/parallel.h>
+
+namespace Hikari {
+/**
+ * @brief 顶点到三角形的邻接表（CSR）
+ */
+struct TriangleAdjacency {
+  std::vector<uint32_t> Offsets;
+  std::vector<uint32_t> Triangles;
+
+  TriangleAdjacency(ArrayView<uint32_t> indices, size_t vertexCount) {
+    Offsets.assign(vertexCount + 1, 0);
+    for (auto v : indices) {
+      Offsets[v + 1]++;
+    }
+    for (size_t i = 0; i < vertexCount; i++) {
+      Offsets[i + 1] += Offsets[i];
+    }
+    Triangles.resize(indices.size());
+    std::vector<uint32_t> cursor(Offsets.begin(), Offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++) {
+      Triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+  }
+};
+
+VertexCacheStats AnalyzeVertexCache(ArrayView<uint32_t> indices, size_t vertexCount, size_t cacheSize) {
+  std::vector<size_t> cacheTime(vertexCount, 0);
+  size_t time = cacheSize + 1;
+  size_t misses = 0;
+  for (auto v : indices) {
+    if (time - cacheTime[v] > cacheSize) {
+      cacheTime[v] = time++;
+      misses++;
+    }
+  }
+  VertexCacheStats stats{};
+  size_t triangleCount = indices.size() / 3;
+  stats.Acmr = triangleCount == 0 ? 0.0f : float(misses) / float(triangleCount);
+  stats.Atvr = vertexCount == 0 ? 0.0f : float(misses) / float(vertexCount);
+  return stats;
+}
+
+std::vector<uint32_t> OptimizeVertexCache(ArrayView<uint32_t> indices, size_t vertexCount, size_t cacheSize) {
+  const size_t triangleCount = indices.size() / 3;
+  std::vector<uint32_t> result;
+  result.reserve(triangleCount * 3);
+  if (triangleCount == 0) {
+    return result;
+  }
+  TriangleAdjacency adj(indices, vertexCount);
+  std::vector<uint32_t> live(vertexCount);
+  for (size_t v = 0; v < vertexCount; v++) {
+    live[v] = adj.Offsets[v + 1] - adj.Offsets[v];
+  }
+  std::vector<size_t> cacheTime(vertexCount, 0);
+  std::vector<bool> isEmitted(triangleCount, false);
+  std::vector<uint32_t> deadEnd;
+  std::vector<uint32_t> candidates;
+  deadEnd.reserve(indices.size());
+  size_t time = cacheSize + 1;
+  size_t cursor = 0;
+  int64_t fan = 0;
+  //没有可扇出的候选时，先回溯死路栈，再顺序扫描
+  auto skipDeadEnd = [&]() -> int64_t {
+    while (!deadEnd.empty()) {
+      uint32_t d = deadEnd.back();
+      deadEnd.pop_back();
+      if (live[d] > 0) {
+        return d;
+      }
+    }
+    while (cursor < vertexCount) {
+      if (live[cursor] > 0) {
+        return static_cast<int64_t>(cursor);
+      }
+      cursor++;
+    }
+    return -1;
+  };
+  while (fan >= 0) {
+    candidates.clear();
+    for (uint32_t i = adj.Offsets[fan]; i < adj.Offsets[fan + 1]; i++) {
+      uint32_t t = adj.Triangles[i];
+      if (isEmitted[t]) {
+        continue;
+      }
+      for (size_t k = 0; k < 3; k++) {
+        uint32_t v = indices[t * 3 + k];
+        result.emplace_back(v);
+        deadEnd.emplace_back(v);
+        candidates.emplace_back(v);
+        live[v]--;
+        if (time - cacheTime[v] > cacheSize) {
+          cacheTime[v] = time++;
+        }
+      }
+      isEmitted[t] = true;
+    }
+    //选择仍在缓存中、且扇出后不会被挤出缓存的最老顶点
+    int64_t next = -1;
+    int64_t best = -1;
+    for (auto v : candidates) {
+      if (live[v] == 0) {
+        continue;
+      }
+      int64_t priority = 0;
+      if (time - cacheTime[v] + 2 * live[v] <= cacheSize) {
+        priority = static_cast<int64_t>(time - cacheTime[v]);
+      }
+      if (priority > best) {
+        best = priority;
+        next = v;
+      }
+    }
+    fan = next >= 0 ? next : skipDeadEnd();
+  }
+  return result;
+}
+
+std::vector<uint32_t> OptimizeOverdraw(ArrayView<uint32_t> indices, ArrayView<Vector3f> positions, size_t cacheSize) {
+  const size_t triangleCount = indices.size() / 3;
+  if (triangleCount == 0) {
+    return std::vector<uint32_t>(indices.begin(), indices.end());
+  }
+  //三个顶点都未命中缓存的三角形是缓存的硬边界，从这里切分不会增加未命中
+  std::vector<size_t> clusterStart;
+  std::vector<size_t> cacheTime(positions.size(), 0);
+  size_t time = cacheSize + 1;
+  for (size_t t = 0; t < triangleCount; t++) {
+    int misses = 0;
+    for (size_t k = 0; k < 3; k++) {
+      uint32_t v = indices[t * 3 + k];
+      if (time - cacheTime[v] > cacheSize) {
+        cacheTime[v] = time++;
+        misses++;
+      }
+    }
+    if (t == 0 || misses == 3) {
+      clusterStart.emplace_back(t);
+    }
+  }
+  clusterStart.emplace_back(triangleCount);
+  const size_t clusterCount = clusterStart.size() - 1;
+
+  //按面积加权的簇中心和法线
+  std::vector<Vector3f> centroids(clusterCount);
+  std::vector<Vector3f> normals(clusterCount);
+  Vector3f meshCentroid{};
+  float meshArea = 0;
+  for (size_t c = 0; c < clusterCount; c++) {
+    Vector3f center{};
+    Vector3f normal{};
+    float area = 0;
+    for (size_t t = clusterStart[c]; t < clusterStart[c + 1]; t++) {
+      const auto& a = positions[indices[t * 3 + 0]];
+      const auto& b = positions[indices[t * 3 + 1]];
+      const auto& d = positions[indices[t * 3 + 2]];
+      auto n = Cross(b - a, d - a);
+      float triArea = Length(n);
+      center += (a + b + d) * Vector3f(triArea / 3.0f);
+      normal += n;
+      area += triArea;
+    }
+    meshCentroid += center;
+    meshArea += area;
+    centroids[c] = area > 0 ? center / Vector3f(area) : positions[indices[clusterStart[c] * 3]];
+    normals[c] = normal;
+  }
+  if (meshArea > 0) {
+    meshCentroid /= Vector3f(meshArea);
+  }
+  std::vector<float> sortKey(clusterCount);
+  for (size_t c = 0; c < clusterCount; c++) {
+    float len = Length(normals[c]);
+    sortKey[c] = len > 0 ? Dot(centroids[c] - meshCentroid, normals[c]) / len : 0.0f;
+  }
+  std::vector<size_t> order(clusterCount);
+  std::iota(order.begin(), order.end(), size_t(0));
+  std::stable_sort(order.begin(), order.end(), [&](size_t l, size_t r) { return sortKey[l] > sortKey[r]; });
+
+  std::vector<uint32_t> result;
+  result.reserve(indices.size());
+  for (auto c : order) {
+    result.insert(result.end(), indices.begin() + clusterStart[c] * 3, indices.begin() + clusterStart[c + 1] * 3);
+  }
+  return result;
+}
+
+std::vector<uint32_t> OptimizeVertexFetchRemap(ArrayView<uint32_t> indices, size_t vertexCount) {
+  std::vector<uint32_t> remap(vertexCount, std::numeric_limits<uint32_t>::max());
+  uint32_t next = 0;
+  for (auto v : indices) {
+    if (remap[v] == std::numeric_limits<uint32_t>::max()) {
+      remap[v] = next++;
+    }
+  }
+  return remap;
+}
+
+template <typename T>
+static std::vector<T> RemapVertices(ArrayView<T> data, const std::vector<uint32_t>& remap, size_t newCount) {
+  if (data.empty()) {
+    return {};
+  }
+  std::vector<T> result(newCount);
+  for (size_t i = 0; i < remap.size(); i++) {
+    if (remap[i] != std::numeric_limits<uint32_t>::max()) {
+      result[remap[i]] = data[i];
+    }
+  }
+  return result;
+}
+
+ImmutableModel OptimizeModel(const ImmutableModel& model, MeshOptimizeStats* stats) {
+  const size_t vertexCount = model.GetVertexCount();
+  std::vector<uint32_t> indices(model.GetIndices().begin(), model.GetIndices().end());
+  if (stats != nullptr) {
+    stats->Before = AnalyzeVertexCache(indices, vertexCount);
+  }
+  indices = OptimizeVertexCache(indices, vertexCount);
+  indices = OptimizeOverdraw(indices, model.GetPosition());
+  auto remap = OptimizeVertexFetchRemap(indices, vertexCount);
+  size_t newCount = 0;
+  for (auto r : remap) {
+    newCount += r != std::numeric_limits<uint32_t>::max();
+  }
+  for (auto& index : indices) {
+    index = remap[index];
+  }
+  if (stats != nullptr) {
+    stats->After = AnalyzeVertexCache(indices, newCount);
+  }
+  return ImmutableModel(model.GetName(),
+                        RemapVertices(model.GetPosition(), remap, newCount),
+                        RemapVertices(model.GetNormals(), remap, newCount),
+                        RemapVertices(model.GetTexCoords(), remap, newCount),
+                        RemapVertices(model.GetTangents(), remap, newCount),
+                        std::move(indices));
+}
+
+/**
+ * @brief 平面距离平方的二次型，只存对称矩阵的上三角
+ */
+struct Quadric {
+  double A00, A11, A22, A01, A02, A12;
+  double B0, B1, B2;
+  double C;
+  double Weight;
+
+  void AddPlane(const Vector3f& n, float d, double w) {
+    double a = n.X(), b = n.Y(), c = n.Z();
+    A00 += w * a * a;
+    A11 += w * b * b;
+    A22 += w * c * c;
+    A01 += w * a * b;
+    A02 += w * a * c;
+    A12 += w * b * c;
+    B0 += w * a * d;
+    B1 += w * b * d;
+    B2 += w * c * d;
+    C += w * d * d;
+    Weight += w;
+  }
+
+  void Add(const Quadric& o) {
+    A00 += o.A00;
+    A11 += o.A11;
+    A22 += o.A22;
+    A01 += o.A01;
+    A02 += o.A02;
+    A12 += o.A12;
+    B0 += o.B0;
+    B1 += o.B1;
+    B2 += o.B2;
+    C += o.C;
+    Weight += o.Weight;
+  }
+
+  double Eval(const Vector3f& p) const {
+    double x = p.X(), y = p.Y(), z = p.Z();
+    double r = A00 * x * x + A11 * y * y + A22 * z * z +
+               2 * (A01 * x * y + A02 * x * z + A12 * y * z) +
+               2 * (B0 * x + B1 * y + B2 * z) + C;
+    return std::max(r, 0.0);
+  }
+};
+
+/**
+ * @brief 把位置在量化网格上相同的顶点映射到同一个代表顶点，容差相对包围盒尺寸，
+ * 可以吸收三角函数生成的接缝两侧的微小误差
+ */
+static std::vector<uint32_t> WeldPositions(ArrayView<Vector3f> positions) {
+  Vector3f min(std::numeric_limits<float>::max());
+  Vector3f max(std::numeric_limits<float>::lowest());
+  for (const auto& p : positions) {
+    for (size_t k = 0; k < 3; k++) {
+      min[k] = std::min(min[k], p[k]);
+      max[k] = std::max(max[k], p[k]);
+    }
+  }
+  float extent = std::max(max[0] - min[0], std::max(max[1] - min[1], max[2] - min[2]));
+  float scale = extent > 0 ? float(1 << 20) / extent : 1.0f;
+  std::vector<std::array<int32_t, 3>> keys(positions.size());
+  for (size_t i = 0; i < positions.size(); i++) {
+    for (size_t k = 0; k < 3; k++) {
+      keys[i][k] = int32_t(std::lround((positions[i][k] - min[k]) * scale));
+    }
+  }
+  std::vector<uint32_t> order(positions.size());
+  std::iota(order.begin(), order.end(), 0u);
+  std::sort(order.begin(), order.end(), [&](uint32_t l, uint32_t r) {
+    return keys[l] != keys[r] ? keys[l] < keys[r] : l < r;
+  });
+  std::vector<uint32_t> weld(positions.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    uint32_t v = order[i];
+    weld[v] = i > 0 && keys[v] == keys[order[i - 1]] ? weld[order[i - 1]] : v;
+  }
+  return weld;
+}
+
+/**
+ * @brief 检查把位置u折叠到位置v是否会产生非流形或翻转的三角形
+ * @param tri 按位置表示的三角形
+ */
+static bool CanCollapse(uint32_t u, uint32_t v,
+                        const std::vector<uint32_t>& tri,
+                        const TriangleAdjacency& adj,
+                        ArrayView<Vector3f> positions,
+                        std::vector<uint32_t>& ringU,
+                        std::vector<uint32_t>& ringV) {
+  //连接条件：内部边两端只能有两个公共邻居
+  auto gatherRing = [&](uint32_t p, std::vector<uint32_t>& ring) {
+    ring.clear();
+    for (uint32_t i = adj.Offsets[p]; i < adj.Offsets[p + 1]; i++) {
+      uint32_t t = adj.Triangles[i];
+      for (size_t k = 0; k < 3; k++) {
+        if (tri[t * 3 + k] != p) {
+          ring.emplace_back(tri[t * 3 + k]);
+        }
+      }
+    }
+    std::sort(ring.begin(), ring.end());
+    ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+  };
+  gatherRing(u, ringU);
+  gatherRing(v, ringV);
+  size_t common = 0;
+  for (size_t i = 0, j = 0; i < ringU.size() && j < ringV.size();) {
+    if (ringU[i] < ringV[j]) {
+      i++;
+    } else if (ringU[i] > ringV[j]) {
+      j++;
+    } else {
+      common++;
+      i++;
+      j++;
+    }
+  }
+  if (common != 2) {
+    return false;
+  }
+  for (uint32_t i = adj.Offsets[u]; i < adj.Offsets[u + 1]; i++) {
+    uint32_t t = adj.Triangles[i];
+    uint32_t a = tri[t * 3 + 0], b = tri[t * 3 + 1], c = tri[t * 3 + 2];
+    if (a == v || b == v || c == v) {
+      continue;
+    }
+    const auto& pa = positions[a];
+    const auto& pb = positions[b];
+    const auto& pc = positions[c];
+    auto before = Cross(pb - pa, pc - pa);
+    const auto& qa = a == u ? positions[v] : pa;
+    const auto& qb = b == u ? positions[v] : pb;
+    const auto& qc = c == u ? positions[v] : pc;
+    auto after = Cross(qb - qa, qc - qa);
+    if (Dot(before, after) <= 0.25f * Length(before) * Length(after)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<uint32_t> SimplifyMesh(ArrayView<uint32_t> indices,
+                                   ArrayView<Vector3f> positions,
+                                   size_t targetIndexCount,
+                                   float targetError,
+                                   float* resultError) {
+  const size_t vertexCount = positions.size();
+  auto weld = WeldPositions(positions);
+  //去掉按位置看退化的三角形，例如球极点处的三角形
+  std::vector<uint32_t> result;
+  result.reserve(indices.size());
+  for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+    uint32_t a = weld[indices[t]], b = weld[indices[t + 1]], c = weld[indices[t + 2]];
+    if (a != b && b != c && a != c) {
+      result.insert(result.end(), indices.begin() + t, indices.begin() + t + 3);
+    }
+  }
+  //同一位置上有多个属性不同的顶点就是接缝，接缝和开放边界上的位置不能被移除
+  std::vector<uint8_t> isLocked(vertexCount, 0);
+  {
+    std::vector<uint8_t> isSeen(vertexCount, 0);
+    std::vector<uint32_t> wedgeCount(vertexCount, 0);
+    for (auto v : result) {
+      if (!isSeen[v]) {
+        isSeen[v] = 1;
+        if (++wedgeCount[weld[v]] > 1) {
+          isLocked[weld[v]] = 1;
+        }
+      }
+    }
+    std::vector<uint64_t> edges;
+    edges.reserve(result.size());
+    for (size_t t = 0; t < result.size(); t += 3) {
+      for (size_t k = 0; k < 3; k++) {
+        uint64_t a = weld[result[t + k]];
+        uint64_t b = weld[result[t + (k + 1) % 3]];
+        edges.emplace_back(a << 32 | b);
+      }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size(); i++) {
+      uint64_t e = edges[i];
+      uint64_t reverse = (e << 32) | (e >> 32);
+      bool isRepeat = (i > 0 && edges[i - 1] == e) || (i + 1 < edges.size() && edges[i + 1] == e);
+      if (isRepeat || !std::binary_search(edges.begin(), edges.end(), reverse)) {
+        isLocked[e >> 32] = 1;
+        isLocked[e & 0xFFFFFFFF] = 1;
+      }
+    }
+  }
+  //每个位置累积相邻三角形平面的二次型，按面积加权
+  std::vector<Quadric> quadrics(vertexCount, Quadric{});
+  for (size_t t = 0; t < result.size(); t += 3) {
+    const auto& p0 = positions[result[t]];
+    const auto& p1 = positions[result[t + 1]];
+    const auto& p2 = positions[result[t + 2]];
+    auto n = Cross(p1 - p0, p2 - p0);
+    float len = Length(n);
+    if (len == 0) {
+      continue;
+    }
+    n /= Vector3f(len);
+    float d = -Dot(n, p0);
+    for (size_t k = 0; k < 3; k++) {
+      quadrics[weld[result[t + k]]].AddPlane(n, d, len * 0.5);
+    }
+  }
+
+  struct Candidate {
+    double Cost;
+    uint32_t From;
+    uint32_t To;
+  };
+  const double maxCost = double(targetError) * double(targetError);
+  double worstCost = 0;
+  std::vector<Candidate> candidates;
+  std::vector<uint32_t> tri;
+  std::vector<uint32_t> collapse(vertexCount);
+  std::vector<uint8_t> isDirty(vertexCount);
+  std::vector<uint32_t> ringU, ringV;
+  //每轮按代价从小到大折叠互不相邻的边，然后重建三角形
+  while (result.size() > targetIndexCount) {
+    tri.resize(result.size());
+    for (size_t i = 0; i < result.size(); i++) {
+      tri[i] = weld[result[i]];
+    }
+    TriangleAdjacency adj(tri, vertexCount);
+    candidates.clear();
+    for (size_t t = 0; t < result.size(); t += 3) {
+      for (size_t k = 0; k < 3; k++) {
+        uint32_t from = result[t + k];
+        uint32_t to = result[t + (k + 1) % 3];
+        uint32_t u = weld[from], v = weld[to];
+        if (isLocked[u]) {
+          continue;
+        }
+        Quadric q = quadrics[u];
+        q.Add(quadrics[v]);
+        double cost = q.Weight > 0 ? q.Eval(positions[v]) / q.Weight : 0.0;
+        candidates.emplace_back(Candidate{cost, from, to});
+      }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& l, const Candidate& r) {
+      if (l.Cost != r.Cost) return l.Cost < r.Cost;
+      if (l.From != r.From) return l.From < r.From;
+      return l.To < r.To;
+    });
+    std::iota(collapse.begin(), collapse.end(), 0u);
+    std::fill(isDirty.begin(), isDirty.end(), uint8_t(0));
+    const size_t removeTarget = (result.size() - targetIndexCount + 2) / 3;
+    size_t removed = 0;
+    size_t collapseCount = 0;
+    for (const auto& c : candidates) {
+      if (removed >= removeTarget || c.Cost > maxCost) {
+        break;
+      }
+      uint32_t u = weld[c.From], v = weld[c.To];
+      if (isDirty[u] || isDirty[v] || !CanCollapse(u, v, tri, adj, positions, ringU, ringV)) {
+        continue;
+      }
+      //未锁定的位置只有一个顶点，它的三角形全部改用v的这个顶点，属性仍然来自已有顶点
+      collapse[c.From] = c.To;
+      quadrics[v].Add(quadrics[u]);
+      for (uint32_t i = adj.Offsets[u]; i < adj.Offsets[u + 1]; i++) {
+        uint32_t t = adj.Triangles[i];
+        bool hasV = false;
+        for (size_t k = 0; k < 3; k++) {
+          isDirty[tri[t * 3 + k]] = 1;
+          hasV |= tri[t * 3 + k] == v;
+        }
+        removed += hasV;
+      }
+      worstCost = std::max(worstCost, c.Cost);
+      collapseCount++;
+    }
+    if (collapseCount == 0) {
+      break;
+    }
+    size_t write = 0;
+    for (size_t t = 0; t < result.size(); t += 3) {
+      uint32_t a = collapse[result[t]], b = collapse[result[t + 1]], c = collapse[result[t + 2]];
+      if (weld[a] != weld[b] && weld[b] != weld[c] && weld[a] != weld[c]) {
+        result[write++] = a;
+        result[write++] = b;
+        result[write++] = c;
+      }
+    }
+    result.resize(write);
+  }
+  if (resultError != nullptr) {
+    *resultError = float(std::sqrt(worstCost));
+  }
+  return result;
+}
+
+std::vector<MeshLod> BuildLodChain(const ImmutableModel& model,
+                                   std::vector<uint32_t>& indices,
+                                   size_t maxLevel,
+                                   float ratio) {
+  std::vector<uint32_t> level(model.GetIndices().begin(), model.GetIndices().end());
+  indices = level;
+  std::vector<MeshLod> lods;
+  lods.emplace_back(MeshLod{0, level.size(), 0.0f});
+  float error = 0;
+  //误差超过包围球半径四分之一的级别已经看不出原来的形状，不再继续
+  const float maxError = Length(model.GetBoundsMax() - model.GetBoundsMin()) * 0.125f;
+  while (lods.size() < maxLevel) {
+    size_t target = size_t(float(level.size() / 3) * ratio) * 3;
+    float levelError = 0;
+    auto next = SimplifyMesh(level, model.GetPosition(), target, std::numeric_limits<float>::max(), &levelError);
+    //简化不动了就停止，避免生成几乎一样的级别
+    if (next.empty() || next.size() * 10 > level.size() * 9) {
+      break;
+    }
+    //每一级从上一级简化而来，误差累加是保守的上界
+    error += levelError;
+    if (error > maxError) {
+      break;
+    }
+    next = OptimizeVertexCache(next, model.GetVertexCount());
+    lods.emplace_back(MeshLod{indices.size(), next.size(), error});
+    indices.insert(indices.end(), next.begin(), next.end());
+    level = std::move(next);
+  }
+  return lods;
+}
+
+Frustum Frustum::FromMatrix(const Matrix4f& viewProj) {
+  //矩阵按行向量存储，着色器里的 u_MatrixVP 是它的转置，第r行是 At(0..3, r)
+  auto row = [&](size_t r) {
+    return Vector4f{viewProj.At(0, r), viewProj.At(1, r), viewProj.At(2, r), viewProj.At(3, r)};
+  };
+  Frustum f{};
+  auto r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+  f.Planes[0] = r3 + r0;
+  f.Planes[1] = r3 - r0;
+  f.Planes[2] = r3 + r1;
+  f.Planes[3] = r3 - r1;
+  f.Planes[4] = r3 + r2;
+  f.Planes[5] = r3 - r2;
+  for (auto& p : f.Planes) {
+    float len = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+    if (len > 0) {
+      p /= Vector4f(len);
+    }
+  }
+  return f;
+}
+
+MeshletBounds ComputeMeshletBounds(ArrayView<uint32_t> vertices, ArrayView<uint8_t> triangles, ArrayView<Vector3f> positions) {
+  MeshletBounds bounds{};
+  if (vertices.empty()) {
+    return bounds;
+  }
+  //Ritter包围球：先取跨度最大的轴上的两个极值点，再把外面的点逐个包进来
+  size_t minIndex[3] = {0, 0, 0};
+  size_t maxIndex[3] = {0, 0, 0};
+  for (size_t i = 0; i < vertices.size(); i++) {
+    const auto& p = positions[vertices[i]];
+    for (size_t k = 0; k < 3; k++) {
+      if (p[k] < positions[vertices[minIndex[k]]][k]) minIndex[k] = i;
+      if (p[k] > positions[vertices[maxIndex[k]]][k]) maxIndex[k] = i;
+    }
+  }
+  size_t axis = 0;
+  float span = -1;
+  for (size_t k = 0; k < 3; k++) {
+    float d = Length(positions[vertices[maxIndex[k]]] - positions[vertices[minIndex[k]]]);
+    if (d > span) {
+      span = d;
+      axis = k;
+    }
+  }
+  Vector3f center = (positions[vertices[minIndex[axis]]] + positions[vertices[maxIndex[axis]]]) * Vector3f(0.5f);
+  float radius = span * 0.5f;
+  for (auto v : vertices) {
+    const auto& p = positions[v];
+    float d = Length(p - center);
+    if (d > radius) {
+      float newRadius = (radius + d) * 0.5f;
+      center += (p - center) * Vector3f((newRadius - radius) / d);
+      radius = newRadius;
+    }
+  }
+  bounds.Center = center;
+  bounds.Radius = radius;
+  //法线锥：轴是平均法线，半角由与轴夹角最大的法线决定
+  std::vector<Vector3f> normals;
+  normals.reserve(triangles.size() / 3);
+  Vector3f sum{};
+  for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+    const auto& a = positions[vertices[triangles[t]]];
+    const auto& b = positions[vertices[triangles[t + 1]]];
+    const auto& c = positions[vertices[triangles[t + 2]]];
+    auto n = Cross(b - a, c - a);
+    float len = Length(n);
+    if (len == 0) {
+      continue;
+    }
+    n /= Vector3f(len);
+    normals.emplace_back(n);
+    sum += n;
+  }
+  float sumLen = Length(sum);
+  float minDot = -1;
+  if (sumLen > 0) {
+    bounds.ConeAxis = sum / Vector3f(sumLen);
+    minDot = 1;
+    for (const auto& n : normals) {
+      minDot = std::min(minDot, Dot(n, bounds.ConeAxis));
+    }
+  }
+  //锥太宽时背面剔除几乎没有收益，直接禁用
+  bounds.ConeCutoff = minDot <= 0.1f ? 1.0f : std::sqrt(1 - minDot * minDot);
+  return bounds;
+}
+
+MeshletData BuildMeshlets(ArrayView<uint32_t> indices,
+                          ArrayView<Vector3f> positions,
+                          size_t maxVertices,
+                          size_t maxTriangles) {
+  //局部编号是8位，0xFF留作“不在簇内”
+  maxVertices = std::clamp<size_t>(maxVertices, 3, 255);
+  maxTriangles = std::clamp<size_t>(maxTriangles, 1, 65535);
+  const size_t vertexCount = positions.size();
+  const size_t triangleCount = indices.size() / 3;
+  MeshletData data;
+  data.Vertices.reserve(triangleCount);
+  data.Triangles.reserve(triangleCount * 3);
+  TriangleAdjacency adj(indices, vertexCount);
+  std::vector<uint32_t> live(vertexCount);
+  for (size_t v = 0; v < vertexCount; v++) {
+    live[v] = adj.Offsets[v + 1] - adj.Offsets[v];
+  }
+  std::vector<uint8_t> isEmitted(triangleCount, 0);
+  std::vector<uint8_t> localIndex(vertexCount, 0xFF);
+  //边界候选：与当前簇相邻且未输出的三角形，用簇编号标记避免重复加入
+  std::vector<uint32_t> frontier;
+  std::vector<uint32_t> frontierStamp(triangleCount, std::numeric_limits<uint32_t>::max());
+  uint32_t meshletId = 0;
+  Meshlet current{};
+  Vector3f centerSum{};
+  auto newVertexCount = [&](size_t t) {
+    return uint32_t(localIndex[indices[t * 3 + 0]] == 0xFF) +
+           uint32_t(localIndex[indices[t * 3 + 1]] == 0xFF) +
+           uint32_t(localIndex[indices[t * 3 + 2]] == 0xFF);
+  };
+  auto flush = [&]() {
+    if (current.TriangleCount == 0) {
+      return;
+    }
+    for (uint32_t i = 0; i < current.VertexCount; i++) {
+      localIndex[data.Vertices[current.VertexOffset + i]] = 0xFF;
+    }
+    data.Meshlets.emplace_back(current);
+    current = Meshlet{};
+    current.VertexOffset = static_cast<uint32_t>(data.Vertices.size());
+    current.TriangleOffset = static_cast<uint32_t>(data.Triangles.size());
+    centerSum = Vector3f{};
+    frontier.clear();
+    meshletId++;
+  };
+  auto emit = [&](size_t t) {
+    for (size_t k = 0; k < 3; k++) {
+      uint32_t v = indices[t * 3 + k];
+      if (localIndex[v] == 0xFF) {
+        localIndex[v] = static_cast<uint8_t>(current.VertexCount++);
+        data.Vertices.emplace_back(v);
+        centerSum += positions[v];
+      }
+      data.Triangles.emplace_back(localIndex[v]);
+      live[v]--;
+    }
+    current.TriangleCount++;
+    isEmitted[t] = 1;
+    for (size_t k = 0; k < 3; k++) {
+      uint32_t v = indices[t * 3 + k];
+      for (uint32_t i = adj.Offsets[v]; i < adj.Offsets[v + 1]; i++) {
+        uint32_t n = adj.Triangles[i];
+        if (!isEmitted[n] && frontierStamp[n] != meshletId) {
+          frontierStamp[n] = meshletId;
+          frontier.emplace_back(n);
+        }
+      }
+    }
+  };
+  //先挑新增顶点最少的候选，再挑离簇中心最近的，簇会向四周均匀生长而不是长成条带
+  auto findNext = [&]() -> int64_t {
+    int64_t best = -1;
+    uint32_t bestExtra = 4;
+    float bestDistance = std::numeric_limits<float>::max();
+    Vector3f center = centerSum / Vector3f(float(std::max<uint32_t>(current.VertexCount, 1)));
+    for (size_t i = 0; i < frontier.size();) {
+      uint32_t t = frontier[i];
+      if (isEmitted[t]) {
+        frontier[i] = frontier.back();
+        frontier.pop_back();
+        continue;
+      }
+      i++;
+      uint32_t extra = newVertexCount(t);
+      if (current.VertexCount + extra > maxVertices || extra > bestExtra) {
+        continue;
+      }
+      auto centroid = (positions[indices[t * 3]] + positions[indices[t * 3 + 1]] + positions[indices[t * 3 + 2]]) * Vector3f(1.0f / 3.0f);
+      auto offset = centroid - center;
+      float distance = Dot(offset, offset);
+      if (extra < bestExtra || distance < bestDistance) {
+        best = t;
+        bestExtra = extra;
+        bestDistance = distance;
+      }
+    }
+    return best;
+  };
+  //新簇的种子取上一个簇边界上剩余邻接最少的三角形，先收拢角落，减少零碎的小簇
+  auto findSeed = [&]() -> int64_t {
+    int64_t best = -1;
+    uint32_t bestLive = std::numeric_limits<uint32_t>::max();
+    for (auto t : frontier) {
+      if (isEmitted[t]) {
+        continue;
+      }
+      uint32_t l = live[indices[t * 3]] + live[indices[t * 3 + 1]] + live[indices[t * 3 + 2]];
+      if (l < bestLive) {
+        bestLive = l;
+        best = t;
+      }
+    }
+    return best;
+  };
+  size_t cursor = 0;
+  for (size_t emitted = 0; emitted < triangleCount; emitted++) {
+    int64_t next = current.TriangleCount < maxTriangles ? findNext() : -1;
+    if (next < 0 && (!frontier.empty() || current.TriangleCount >= maxTriangles)) {
+      //放不下了，新簇从边界处继续生长
+      next = findSeed();
+      flush();
+    }
+    if (next < 0) {
+      while (isEmitted[cursor]) {
+        cursor++;
+      }
+      next = static_cast<int64_t>(cursor);
+      if (current.VertexCount + newVertexCount(next) > maxVertices) {
+        flush();
+      }
+    }
+    emit(static_cast<size_t>(next));
+  }
+  flush();
+  data.Bounds.reserve(data.Meshlets.size());
+  for (const auto& m : data.Meshlets) {
+    data.Bounds.emplace_back(ComputeMeshletBounds(
+        ArrayView<uint32_t>(data.Vertices.data() + m.VertexOffset, m.VertexCount),
+        ArrayView<uint8_t>(data.Triangles.data() + m.TriangleOffset, size_t(m.TriangleCount) * 3),
+        positions));
+  }
+  return data;
+}
+
+MeshletData BuildMeshlets(const ImmutableModel& model) {
+  std::vector<uint32_t> indices(model.GetIndices().begin(), model.GetIndices().end());
+  indices = OptimizeVertexCache(indices, model.GetVertexCount());
+  return BuildMeshlets(indices, model.GetPosition());
+}
+
+size_t CullMeshlets(const MeshletData& data, const Frustum& frustum, const Vector3f& cameraPos, std::vector<uint32_t>& visible) {
+  const size_t count = data.Bounds.size();
+  visible.resize(count);
+  const float cx = cameraPos.X(), cy = cameraPos.Y(), cz = cameraPos.Z();
+  size_t write = 0;
+  //无分支写入，编译器可以把平面测试展开
+  for (size_t i = 0; i < count; i++) {
+    const auto& b = data.Bounds[i];
+    float dx = b.Center.X() - cx, dy = b.Center.Y() - cy, dz = b.Center.Z() - cz;
+    float dist = std::sqrt(dx * dx + dy * dy + dz * dz);
+    float along = dx * b.ConeAxis.X() + dy * b.ConeAxis.Y() + dz * b.ConeAxis.Z();
+    bool isCulled = along >= b.ConeCutoff * dist + b.Radius;
+    for (const auto& p : frustum.Planes) {
+      float d = p[0] * b.Center.X() + p[1] * b.Center.Y() + p[2] * b.Center.Z() + p[3];
+      isCulled |= d < -b.Radius;
+    }
+    visible[write] = static_cast<uint32_t>(i);
+    write += !isCulled;
+  }
+  visible.resize(write);
+  return write;
+}
+
+/**
+ * @brief acos的多项式近似（Abramowitz & Stegun 4.4.45），误差小于7e-5弧度，只用于角度权重
+ */
+static inline float FastAcos(float x) {
+  float a = std::min(std::abs(x), 1.0f);
+  float r = std::sqrt(1.0f - a) * (1.5707288f + a * (-0.2121144f + a * (0.0742610f - 0.0187293f * a)));
+  return x < 0 ? PI - r : r;
+}
+
+/**
+ * @brief 计算切线时一个三角形需要的量，三个角共用
+ */
+struct TangentTriangle {
+  float Os[3];        //单位化并乘手性后的切线方向
+  float Edges[3][3];  //边k从角k指向角k+1
+  float Lengths[3];   //边k长度的平方
+  float Sign;         //纹理坐标的手性，退化的三角形为0，不参与
+};
+
+static inline void LoadTangentTriangle(const uint32_t v[3],
+                                       ArrayView<Vector3f> positions,
+                                       ArrayView<Vector2f> texcoords,
+                                       TangentTriangle& tri) {
+  const Vector3f& p0 = positions[v[0]];
+  const Vector3f& p1 = positions[v[1]];
+  const Vector3f& p2 = positions[v[2]];
+  for (size_t c = 0; c < 3; c++) {
+    tri.Edges[0][c] = p1[c] - p0[c];
+    tri.Edges[1][c] = p2[c] - p1[c];
+    tri.Edges[2][c] = p0[c] - p2[c];
+  }
+  const auto& w0 = texcoords[v[0]];
+  float s1 = texcoords[v[1]].X() - w0.X();
+  float t1 = texcoords[v[1]].Y() - w0.Y();
+  float s2 = texcoords[v[2]].X() - w0.X();
+  float t2 = texcoords[v[2]].Y() - w0.Y();
+  float area = s1 * t2 - s2 * t1;
+  //p2 - p0 就是 -Edges[2]
+  float os[3];
+  for (size_t c = 0; c < 3; c++) {
+    os[c] = tri.Edges[0][c] * t2 + tri.Edges[2][c] * t1;
+  }
+  float osLength = std::sqrt(os[0] * os[0] + os[1] * os[1] + os[2] * os[2]);
+  bool isDegenerate = std::abs(area) <= std::numeric_limits<float>::min() || osLength <= 0;
+  tri.Sign = isDegenerate ? 0.0f : (area > 0 ? 1.0f : -1.0f);
+  float scale = isDegenerate ? 0.0f : tri.Sign / osLength;
+  for (size_t c = 0; c < 3; c++) {
+    tri.Os[c] = os[c] * scale;
+    const float* e = tri.Edges[c];
+    tri.Lengths[c] = e[0] * e[0] + e[1] * e[1] + e[2] * e[2];
+  }
+}
+
+/**
+ * @brief 角k投影到法线切平面上需要的量：切线和两条邻边（Edges[k] 和 -Edges[k+2]）都投影后，
+ * 用点积展开得到长度和夹角，不构造投影后的向量
+ */
+struct TangentCorner {
+  float NormalLength2;
+  float NormalDotA;
+  float NormalDotC;
+  float NormalDotOs;
+  float EdgeDot;  //Edges[k] 和 Edges[k+2] 的点积
+  float LengthA;  //两条邻边长度的平方
+  float LengthC;
+};
+
+static inline TangentCorner ProjectTangentCorner(const TangentTriangle& tri, size_t k, const Vector3f& n) {
+  const float* ea = tri.Edges[k];
+  const float* ec = tri.Edges[(k + 2) % 3];
+  TangentCorner corner;
+  corner.NormalLength2 = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+  corner.NormalDotA = n[0] * ea[0] + n[1] * ea[1] + n[2] * ea[2];
+  corner.NormalDotC = n[0] * ec[0] + n[1] * ec[1] + n[2] * ec[2];
+  corner.NormalDotOs = n[0] * tri.Os[0] + n[1] * tri.Os[1] + n[2] * tri.Os[2];
+  corner.EdgeDot = ea[0] * ec[0] + ea[1] * ec[1] + ea[2] * ec[2];
+  corner.LengthA = tri.Lengths[k];
+  corner.LengthC = tri.Lengths[(k + 2) % 3];
+  return corner;
+}
+
+/**
+ * @brief 角的权重：angle为两条邻边投影后的夹角，weight乘 (Os*|n|^2 - n*dot(n,Os)) 就是投影后单位化的切线再乘夹角。
+ * 各项都乘了|n|^2，夹角的余弦不变，每个角只需要一次除法
+ */
+static inline void WeighTangentCorner(const TangentCorner& c, float& angle, float& weight) {
+  float nn = c.NormalLength2;
+  float aa = std::max(c.LengthA * nn - c.NormalDotA * c.NormalDotA, 0.0f);
+  float cc = std::max(c.LengthC * nn - c.NormalDotC * c.NormalDotC, 0.0f);
+  float ab = c.NormalDotA * c.NormalDotC - c.EdgeDot * nn;
+  float tt = std::max(nn - c.NormalDotOs * c.NormalDotOs, 0.0f) * nn;
+  float edgeLength = std::sqrt(aa * cc);
+  float tangentLength = std::sqrt(tt);
+  float inv = 1.0f / (edgeLength * tangentLength + std::numeric_limits<float>::min());
+  //三角形与法线垂直时切线投影为0，不贡献方向，但夹角仍然计入手性的权重
+  float cosine = tangentLength > 0 ? ab * tangentLength * inv : ab / (edgeLength + std::numeric_limits<float>::min());
+  //极点处有长度为0的边，acos(1)=0，这个角不参与
+  angle = FastAcos(edgeLength > 0 ? cosine : 1.0f);
+  weight = tangentLength > 0 ? angle * edgeLength * inv : 0.0f;
+}
+
+static inline void AddTangentCorner(const TangentTriangle& tri, const Vector3f& n, const TangentCorner& c, Vector4f& sum) {
+  float angle, weight;
+  WeighTangentCorner(c, angle, weight);
+  for (size_t i = 0; i < 3; i++) {
+    sum[i] += (tri.Os[i] * c.NormalLength2 - n[i] * c.NormalDotOs) * weight;
+  }
+  sum[3] += angle;
+}
+
+template <typename Index>
+static std::vector<Vector4f> GenerateTangentsImpl(ArrayView<Index> indices,
+                                                  ArrayView<Vector3f> positions,
+                                                  ArrayView<Vector3f> normals,
+                                                  ArrayView<Vector2f> texcoords,
+                                                  TangentSplit* split) {
+  const size_t vertexCount = positions.size();
+  const size_t cornerCount = indices.size();
+  const size_t triangleCount = cornerCount / 3;
+  constexpr size_t grain = 4096;
+  auto loadIndices = [&](size_t t, uint32_t v[3]) {
+    for (size_t k = 0; k < 3; k++) {
+      v[k] = indices[t * 3 + k];
+    }
+  };
+  //两种手性分开累加：sums[2v]是正手性的三角形，sums[2v+1]是负手性的。两条路径都按角的顺序累加，结果一致
+  std::vector<Vector4f> sums(vertexCount * 2, Vector4f(0.0f));
+  if (ThreadPool::GetGlobal().GetThreadCount() <= 1 || triangleCount <= grain) {
+    //只有一个线程时逐三角形直接累加，不需要邻接表，每个三角形只算一次
+    for (size_t t = 0; t < triangleCount; t++) {
+      uint32_t v[3];
+      loadIndices(t, v);
+      TangentTriangle tri;
+      LoadTangentTriangle(v, positions, texcoords, tri);
+      if (tri.Sign == 0) {
+        continue;
+      }
+      size_t side = tri.Sign < 0;
+      for (size_t k = 0; k < 3; k++) {
+        const auto& n = normals[v[k]];
+        AddTangentCorner(tri, n, ProjectTangentCorner(tri, k, n), sums[v[k] * 2 + side]);
+      }
+    }
+  } else {
+    //顶点到角的邻接表（CSR），每个顶点只写自己的累加值，不需要原子操作
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < cornerCount; i++) {
+      offsets[indices[i] + 1]++;
+    }
+    for (size_t i = 0; i < vertexCount; i++) {
+      offsets[i + 1] += offsets[i];
+    }
+    std::vector<uint32_t> vertexCorners(cornerCount);
+    {
+      std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+      for (size_t i = 0; i < cornerCount; i++) {
+        vertexCorners[cursor[indices[i]]++] = static_cast<uint32_t>(i);
+      }
+    }
+    ParallelFor(0, vertexCount, grain, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        for (uint32_t c = offsets[i]; c < offsets[i + 1]; c++) {
+          uint32_t v[3];
+          loadIndices(vertexCorners[c] / 3, v);
+          TangentTriangle tri;
+          LoadTangentTriangle(v, positions, texcoords, tri);
+          if (tri.Sign == 0) {
+            continue;
+          }
+          size_t k = vertexCorners[c] % 3;
+          AddTangentCorner(tri, normals[i], ProjectTangentCorner(tri, k, normals[i]), sums[i * 2 + (tri.Sign < 0)]);
+        }
+      }
+    });
+  }
+
+  //保留权重大的一侧，两侧都有三角形时另一侧拆成新顶点
+  auto keptSide = [&](size_t v) -> size_t { return sums[v * 2 + 1].W() > sums[v * 2].W(); };
+  std::vector<uint32_t> sources;
+  if (split != nullptr) {
+    for (size_t v = 0; v < vertexCount; v++) {
+      if (sums[v * 2].W() > 0 && sums[v * 2 + 1].W() > 0) {
+        sources.push_back(static_cast<uint32_t>(v));
+      }
+    }
+  }
+  const size_t totalCount = vertexCount + sources.size();
+  std::vector<Vector4f> result(totalCount);
+  ParallelFor(0, totalCount, grain, [&](size_t begin, size_t end) {
+    //结构数组形式的正交化没有分支，编译器可以向量化
+    constexpr size_t batch = 256;
+    float tx[batch], ty[batch], tz[batch], tw[batch];
+    float nx[batch], ny[batch], nz[batch];
+    for (size_t base = begin; base < end; base += batch) {
+      const size_t count = std::min(batch, end - base);
+      for (size_t i = 0; i < count; i++) {
+        size_t vertex = base + i;
+        size_t side = 0;
+        if (vertex < vertexCount) {
+          side = keptSide(vertex);
+        } else {
+          vertex = sources[vertex - vertexCount];
+          side = 1 - keptSide(vertex);
+        }
+        const auto& sum = sums[vertex * 2 + side];
+        const auto& n = normals[vertex];
+        tx[i] = sum.X();
+        ty[i] = sum.Y();
+        tz[i] = sum.Z();
+        tw[i] = side != 0 ? -1.0f : 1.0f;
+        nx[i] = n.X();
+        ny[i] = n.Y();
+        nz[i] = n.Z();
+      }
+      for (size_t i = 0; i < count; i++) {
+        float nn = nx[i] * nx[i] + ny[i] * ny[i] + nz[i] * nz[i];
+        float invN = nn > 0 ? 1.0f / std::sqrt(nn) : 0.0f;
+        float ux = nx[i] * invN;
+        float uy = ny[i] * invN;
+        float uz = nz[i] * invN;
+        float d = tx[i] * ux + ty[i] * uy + tz[i] * uz;
+        float x = tx[i] - ux * d;
+        float y = ty[i] - uy * d;
+        float z = tz[i] - uz * d;
+        float ll = x * x + y * y + z * z;
+        float inv = ll > 0 ? 1.0f / std::sqrt(ll) : 0.0f;
+        tx[i] = x * inv;
+        ty[i] = y * inv;
+        tz[i] = z * inv;
+      }
+      for (size_t i = 0; i < count; i++) {
+        Vector3f t{tx[i], ty[i], tz[i]};
+        if (t.X() == 0 && t.Y() == 0 && t.Z() == 0) {
+          //没有有效的贡献时取任意一个与法线垂直的方向
+          const auto& n = Vector3f{nx[i], ny[i], nz[i]};
+          auto axis = std::abs(n.X()) < 0.9f ? Vector3f{1, 0, 0} : Vector3f{0, 1, 0};
+          auto r = axis - n * Vector3f(Dot(n, axis) / std::max(Dot(n, n), std::numeric_limits<float>::min()));
+          t = Length(r) > 0 ? Normalize(r) : axis;
+        }
+        result[base + i] = Vector4f{t.X(), t.Y(), t.Z(), tw[i]};
+      }
+    }
+  });
+
+  if (split != nullptr) {
+    split->Remap.clear();
+    if (!sources.empty()) {
+      //手性属于被拆出一侧的角改指向新顶点
+      std::vector<uint32_t> splitTo(vertexCount, 0);
+      for (size_t i = 0; i < sources.size(); i++) {
+        splitTo[sources[i]] = static_cast<uint32_t>(vertexCount + i);
+      }
+      for (size_t t = 0; t < triangleCount; t++) {
+        uint32_t v[3];
+        loadIndices(t, v);
+        if (splitTo[v[0]] == 0 && splitTo[v[1]] == 0 && splitTo[v[2]] == 0) {
+          continue;
+        }
+        TangentTriangle tri;
+        LoadTangentTriangle(v, positions, texcoords, tri);
+        if (tri.Sign == 0) {
+          continue;
+        }
+        size_t side = tri.Sign < 0;
+        for (size_t k = 0; k < 3; k++) {
+          if (splitTo[v[k]] != 0 && side != keptSide(v[k])) {
+            split->Remap.emplace_back(static_cast<uint32_t>(t * 3 + k), splitTo[v[k]]);
+          }
+        }
+      }
+    }
+    split->Sources = std::move(sources);
+  }
+  return result;
+}
+
+size_t GetTangentScratchBytes(size_t vertexCount, size_t indexCount) {
+  //两侧手性的累加值、CSR的偏移和角序号、填表用的游标、拆分时的顶点映射
+  return vertexCount * 2 * sizeof(Vector4f) + indexCount * sizeof(uint32_t) + (3 * vertexCount + 1) * sizeof(uint32_t);
+}
+
+std::vector<Vector4f> GenerateTangents(IndexArrayView indices,
+                                       ArrayView<Vector3f> positions,
+                                       ArrayView<Vector3f> normals,
+                                       ArrayView<Vector2f> texcoords,
+                                       TangentSplit* split) {
+  if (split != nullptr) {
+    split->Sources.clear();
+    split->Remap.clear();
+  }
+  const size_t vertexCount = positions.size();
+  if (normals.size() != vertexCount || texcoords.size() != vertexCount || indices.size() % 3 != 0) {
+    return {};
+  }
+  //按索引宽度分开实例化，内层循环不用判断格式
+  if (indices.GetFormat() == IndexFormat::UInt16) {
+    return GenerateTangentsImpl(indices.AsUInt16(), positions, normals, texcoords, split);
+  }
+  return GenerateTangentsImpl(indices.AsUInt32(), positions, normals, texcoords, split);
+}
+
+}  // namespace Hikari
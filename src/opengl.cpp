@@ -35,6 +35,16 @@ void FeatureOpenGL::Init() {
   if (CanUseSsbo()) {
     HIKARI_CHECK_GL(glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &_ssboAlign));
   }
+  _programBinaryFormats.clear();
+  if (_major >= 4 && _minor >= 1) {
+    int formatCount = 0;
+    HIKARI_CHECK_GL(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount));
+    if (formatCount > 0) {
+      std::vector<GLint> formats(formatCount);
+      HIKARI_CHECK_GL(glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data()));
+      _programBinaryFormats.assign(formats.begin(), formats.end());
+    }
+  }
   _isInit = true;
 }
 
@@ -96,6 +106,22 @@ bool FeatureOpenGL::CanUseTextureStorage() const {
   return (_major >= 4 && _minor >= 2);  //||IsExtensionSupported("GL_ARB_texture_storage");
 }
 
+bool FeatureOpenGL::CanUseS3tc() const { return IsExtensionSupported("GL_EXT_texture_compression_s3tc"); }
+
+bool FeatureOpenGL::CanUseBptc() const {
+  return (_major >= 4 && _minor >= 2) || IsExtensionSupported("GL_ARB_texture_compression_bptc");
+}
+
+bool FeatureOpenGL::CanUseProgramBinary() const { return !_programBinaryFormats.empty(); }
+
+bool FeatureOpenGL::CanUseParallelShaderCompile() const {
+  return IsExtensionSupported("GL_KHR_parallel_shader_compile") || IsExtensionSupported("GL_ARB_parallel_shader_compile");
+}
+
+bool FeatureOpenGL::IsProgramBinaryFormatSupported(GLenum format) const {
+  return std::find(_programBinaryFormats.begin(), _programBinaryFormats.end(), format) != _programBinaryFormats.end();
+}
+
 FeatureOpenGL& FeatureOpenGL::Get() noexcept {
   static FeatureOpenGL _feature;
   return _feature;
@@ -123,6 +149,19 @@ GLenum MapIndexDataType(IndexDataType type) {
   }
 }
 
+size_t SizeOfIndexDataType(IndexDataType type) {
+  switch (type) {
+    case IndexDataType::UnsignedByte:
+      return sizeof(GLubyte);
+    case IndexDataType::UnsignedShort:
+      return sizeof(GLushort);
+    case IndexDataType::UnsignedInt:
+      return sizeof(GLuint);
+    default:
+      throw OpenGLException("unknown IndexDataType");
+  }
+}
+
 GLenum MapComparison(DepthComparison comp) {
   switch (comp) {
     case Hikari::DepthComparison::Never:
@@ -408,23 +447,42 @@ bool ShaderOpenGL::CompileFromSource(GLenum type, const std::string& source, GLu
   auto sourceLen = static_cast<GLint>(source.length());
   HIKARI_CHECK_GL(glShaderSource(id, 1, &sourcePtr, &sourceLen));
   HIKARI_CHECK_GL(glCompileShader(id));
-  GLint status;
-  HIKARI_CHECK_GL(glGetShaderiv(id, GL_COMPILE_STATUS, &status));
-  bool isSuccess = status == GL_TRUE;
+  bool isSuccess = CheckCompileStatus(id);
   if (isSuccess) {
     result = id;
   } else {
-    int errorLen;
-    HIKARI_CHECK_GL(glGetShaderiv(id, GL_INFO_LOG_LENGTH, &errorLen));
-    auto errorInfo = std::make_unique<char[]>(errorLen);
-    HIKARI_CHECK_GL(glGetShaderInfoLog(id, errorLen, nullptr, errorInfo.get()));
-    std::cerr << "Shader Compile Error:\n"
-              << errorInfo;
     HIKARI_CHECK_GL(glDeleteShader(id));
   }
   return isSuccess;
 }
 
+ShaderOpenGL ShaderOpenGL::SubmitCompile(ShaderType type, const std::string& source) {
+  ShaderOpenGL shader;
+  shader._type = type;
+  shader._handle = HIKARI_CHECK_GL(glCreateShader(MapType(type)));
+  auto sourcePtr = source.c_str();
+  auto sourceLen = static_cast<GLint>(source.length());
+  HIKARI_CHECK_GL(glShaderSource(shader._handle, 1, &sourcePtr, &sourceLen));
+  HIKARI_CHECK_GL(glCompileShader(shader._handle));
+  return shader;
+}
+
+bool ShaderOpenGL::CheckCompileStatus(GLuint shader) {
+  GLint status;
+  HIKARI_CHECK_GL(glGetShaderiv(shader, GL_COMPILE_STATUS, &status));
+  if (status == GL_TRUE) {
+    return true;
+  }
+  int errorLen;
+  HIKARI_CHECK_GL(glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &errorLen));
+  auto errorInfo = std::make_unique<char[]>(std::max(errorLen, 1));
+  errorInfo[0] = '\0';
+  HIKARI_CHECK_GL(glGetShaderInfoLog(shader, errorLen, nullptr, errorInfo.get()));
+  std::cerr << "Shader Compile Error:\n"
+            << errorInfo.get();
+  return false;
+}
+
 ShaderAttributeLayout::ShaderAttributeLayout() noexcept = default;
 
 ShaderAttributeLayout::ShaderAttributeLayout(const std::string& name,
@@ -796,16 +854,42 @@ bool ProgramOpenGL::Link(const ShaderOpenGL& vs,
                          const ShaderOpenGL& fs,
                          const ShaderAttributeLayouts& desc,
                          ProgramOpenGL& result) {
+  return FinishLink(SubmitLink(vs, fs), vs, fs, desc, result);
+}
+
+GLuint ProgramOpenGL::SubmitLink(const ShaderOpenGL& vs, const ShaderOpenGL& fs) {
   auto id = HIKARI_CHECK_GL(glCreateProgram());
   HIKARI_CHECK_GL(glAttachShader(id, vs.GetHandle()));
   HIKARI_CHECK_GL(glAttachShader(id, fs.GetHandle()));
+  if (FeatureOpenGL::Get().CanUseProgramBinary()) {
+    HIKARI_CHECK_GL(glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+  }
   HIKARI_CHECK_GL(glLinkProgram(id));
+  return id;
+}
+
+bool ProgramOpenGL::IsLinkCompleted(GLuint prog) {
+  if (!FeatureOpenGL::Get().CanUseParallelShaderCompile()) {
+    return true;
+  }
+  GLint isCompleted = GL_TRUE;
+  HIKARI_CHECK_GL(glGetProgramiv(prog, GL_COMPLETION_STATUS_KHR, &isCompleted));
+  return isCompleted == GL_TRUE;
+}
+
+bool ProgramOpenGL::FinishLink(GLuint prog,
+                               const ShaderOpenGL& vs,
+                               const ShaderOpenGL& fs,
+                               const ShaderAttributeLayouts& desc,
+                               ProgramOpenGL& result) {
+  auto id = prog;
   GLint status;
   HIKARI_CHECK_GL(glGetProgramiv(id, GL_LINK_STATUS, &status));
   if (status == GL_TRUE) {
     result._handle = id;
+    ProgramReflection reflection;
     auto activeAttrib = ReflectActiveAttrib(result.GetHandle());
-    result._attribs.reserve(activeAttrib.size());
+    reflection.Attributes.reserve(activeAttrib.size());
     for (const auto& aInfo : activeAttrib) {
       auto ad = std::find_if(desc.begin(),
                              desc.end(),
@@ -822,36 +906,88 @@ bool ProgramOpenGL::Link(const ShaderOpenGL& vs,
       attrib.Length = aInfo.Length;
       attrib.Location = aInfo.Location;
       attrib.Semantic = semantic;
-      result._attribs.emplace_back(attrib);
+      reflection.Attributes.emplace_back(attrib);
     }
-    result._nameToAttrib.reserve(activeAttrib.size());
-    result._semanticToAttrib.reserve(activeAttrib.size());
-    for (size_t i = 0; i < result._attribs.size(); i++) {
-      const auto& attrib = result._attribs[i];
-      auto [it0, isNameInsert] = result._nameToAttrib.emplace(attrib.Name, i);
-      auto [it1, isSemInsert] = result._semanticToAttrib.emplace(attrib.Semantic, i);
-      assert(isNameInsert);
-      assert(isSemInsert);
-    }
-    result._uniforms = ReflectActiveUniform(result.GetHandle());
-    result._nameToUni.reserve(result._uniforms.size());
-    for (size_t i = 0; i < result._uniforms.size(); i++) {
-      auto [_, isNameInsert] = result._nameToUni.emplace(result._uniforms[i].Name, i);
-      assert(isNameInsert);
-    }
-    result._blocks = ReflectActiveBlock(result.GetHandle());
+    reflection.Uniforms = ReflectActiveUniform(result.GetHandle());
+    reflection.Blocks = ReflectActiveBlock(result.GetHandle());
+    result.SetReflection(std::move(reflection));
     return true;
   } else {
     int errorLen;
     HIKARI_CHECK_GL(glGetProgramiv(id, GL_INFO_LOG_LENGTH, &errorLen));
-    auto errorInfo = std::make_unique<char[]>(errorLen);
+    auto errorInfo = std::make_unique<char[]>(std::max(errorLen, 1));
+    errorInfo[0] = '\0';
     HIKARI_CHECK_GL(glGetProgramInfoLog(id, errorLen, nullptr, errorInfo.get()));
-    std::cerr << "ProgramOpenGL::Link():" << errorInfo << '\n';
+    std::cerr << "ProgramOpenGL::Link():" << errorInfo.get() << '\n';
+    //编译是延迟检查的，链接失败时再输出两个阶段的编译日志
+    ShaderOpenGL::CheckCompileStatus(vs.GetHandle());
+    ShaderOpenGL::CheckCompileStatus(fs.GetHandle());
     HIKARI_CHECK_GL(glDeleteProgram(id));
     return false;
   }
 }
 
+bool ProgramOpenGL::LoadBinary(GLenum format,
+                               const void* binary,
+                               size_t size,
+                               ProgramReflection&& reflection,
+                               ProgramOpenGL& result) {
+  if (!FeatureOpenGL::Get().IsProgramBinaryFormatSupported(format)) {
+    return false;
+  }
+  auto id = HIKARI_CHECK_GL(glCreateProgram());
+  //驱动不接受这份二进制时只是链接状态失败
+  HIKARI_CHECK_GL(glProgramBinary(id, format, binary, GLsizei(size)));
+  GLint status = GL_FALSE;
+  HIKARI_CHECK_GL(glGetProgramiv(id, GL_LINK_STATUS, &status));
+  if (status != GL_TRUE) {
+    HIKARI_CHECK_GL(glDeleteProgram(id));
+    return false;
+  }
+  result._handle = id;
+  result.SetReflection(std::move(reflection));
+  return true;
+}
+
+bool ProgramOpenGL::GetBinary(GLenum& format, std::vector<uint8_t>& binary) const {
+  if (_handle == 0 || !FeatureOpenGL::Get().CanUseProgramBinary()) {
+    return false;
+  }
+  GLint length = 0;
+  HIKARI_CHECK_GL(glGetProgramiv(_handle, GL_PROGRAM_BINARY_LENGTH, &length));
+  if (length <= 0) {
+    return false;
+  }
+  binary.resize(length);
+  GLsizei written = 0;
+  HIKARI_CHECK_GL(glGetProgramBinary(_handle, length, &written, &format, binary.data()));
+  binary.resize(written);
+  return written > 0;
+}
+
+void ProgramOpenGL::SetReflection(ProgramReflection&& reflection) {
+  _attribs = std::move(reflection.Attributes);
+  _uniforms = std::move(reflection.Uniforms);
+  _blocks = std::move(reflection.Blocks);
+  _nameToAttrib.clear();
+  _semanticToAttrib.clear();
+  _nameToUni.clear();
+  _nameToAttrib.reserve(_attribs.size());
+  _semanticToAttrib.reserve(_attribs.size());
+  for (size_t i = 0; i < _attribs.size(); i++) {
+    const auto& attrib = _attribs[i];
+    auto [it0, isNameInsert] = _nameToAttrib.emplace(attrib.Name, i);
+    auto [it1, isSemInsert] = _semanticToAttrib.emplace(attrib.Semantic, i);
+    assert(isNameInsert);
+    assert(isSemInsert);
+  }
+  _nameToUni.reserve(_uniforms.size());
+  for (size_t i = 0; i < _uniforms.size(); i++) {
+    auto [_, isNameInsert] = _nameToUni.emplace(_uniforms[i].Name, i);
+    assert(isNameInsert);
+  }
+}
+
 std::vector<ShaderAttribute> ProgramOpenGL::ReflectActiveAttrib(GLuint prog) {
   auto id = prog;
   GLint attribCount;
@@ -1098,6 +1234,7 @@ VertexArrayOpenGL::VertexArrayOpenGL(const std::vector<ShaderAttribute>& attribs
       HIKARI_CHECK_GL(glVertexArrayAttribFormat(_handle, attrib.Location, size, type, GL_FALSE, 0));
       HIKARI_CHECK_GL(glVertexArrayAttribBinding(_handle, attrib.Location, attrib.Location));
       HIKARI_CHECK_GL(glEnableVertexArrayAttrib(_handle, attrib.Location));
+      _attribFormat.emplace(attrib.Location, VertexAttributeFormat{(GLuint)attrib.Location, attrib.Type, GL_FALSE, 0});
     }
   } else {
     HIKARI_CHECK_GL(glGenVertexArrays(1, &_handle));
@@ -1108,6 +1245,7 @@ VertexArrayOpenGL::VertexArrayOpenGL(const std::vector<ShaderAttribute>& attribs
         HIKARI_CHECK_GL(glVertexAttribFormat(attrib.Location, size, type, GL_FALSE, 0));
         HIKARI_CHECK_GL(glVertexAttribBinding(attrib.Location, attrib.Location));
         HIKARI_CHECK_GL(glEnableVertexAttribArray(attrib.Location));
+        _attribFormat.emplace(attrib.Location, VertexAttributeFormat{(GLuint)attrib.Location, attrib.Type, GL_FALSE, 0});
       }
     } else {
       for (const auto& attrib : attribs) {
@@ -1174,11 +1312,11 @@ void VertexArrayOpenGL::SetVertexBuffer(const VertexBufferBinding& binding) cons
       HIKARI_CHECK_GL(glBindVertexBuffer(binding.BindingPoint, binding.Handle, binding.Offset, binding.Stride));
     } else {  //opengl version<=4.2
       const auto& format = _attribFormat.at(binding.BindingPoint);
-      auto [size, type] = MapType(format.Type);
+      auto [size, type, isNormalised] = MapFormat(format.Type, format.Format);
       HIKARI_CHECK_GL(glBindBuffer(GL_ARRAY_BUFFER, binding.Handle));
       HIKARI_CHECK_GL(glVertexAttribPointer(format.AttribIndex,
                                             size, type,
-                                            format.IsNormalised,
+                                            isNormalised,
                                             binding.Stride,  //两组数据之间间隔
                                             //buffer内偏移量+绑定点相对偏移量
                                             (void*)(binding.Offset + format.RelativeOffset)));
@@ -1195,6 +1333,43 @@ void VertexArrayOpenGL::SetIndexBuffer(GLuint iboHandle) const {
   }
 }
 
+void VertexArrayOpenGL::SetAttribFormat(GLuint attribIndex, ParamType type, VertexFormat format) const {
+  auto iter = _attribFormat.find(attribIndex);
+  if (iter != _attribFormat.end() && iter->second.Format == format) {
+    return;
+  }
+  auto [size, glType, isNormalised] = MapFormat(type, format);
+  _attribFormat[attribIndex] = VertexAttributeFormat{attribIndex, type, isNormalised, 0, format};
+  const auto& feature = FeatureOpenGL::Get();
+  if (feature.CanUseDirectStateAccess()) {
+    HIKARI_CHECK_GL(glVertexArrayAttribFormat(_handle, attribIndex, size, glType, isNormalised, 0));
+  } else if (feature.CanUseVertexAttribBinding()) {
+    HIKARI_CHECK_GL(glVertexAttribFormat(attribIndex, size, glType, isNormalised, 0));
+  }
+  //opengl版本<=4.2时格式在SetVertexBuffer中随glVertexAttribPointer一起设置
+}
+
+std::tuple<GLint, GLenum, GLboolean> VertexArrayOpenGL::MapFormat(ParamType type, VertexFormat format) {
+  switch (format) {
+    case VertexFormat::Default: {
+      auto [size, glType] = MapType(type);
+      return std::make_tuple(size, glType, (GLboolean)GL_FALSE);
+    }
+    case VertexFormat::Half2:
+      return std::make_tuple(2, (GLenum)GL_HALF_FLOAT, (GLboolean)GL_FALSE);
+    case VertexFormat::UNorm16x2:
+      return std::make_tuple(2, (GLenum)GL_UNSIGNED_SHORT, (GLboolean)GL_TRUE);
+    case VertexFormat::UNorm16x4:
+      return std::make_tuple(4, (GLenum)GL_UNSIGNED_SHORT, (GLboolean)GL_TRUE);
+    case VertexFormat::SNorm16x2:
+      return std::make_tuple(2, (GLenum)GL_SHORT, (GLboolean)GL_TRUE);
+    case VertexFormat::SNorm16x4:
+      return std::make_tuple(4, (GLenum)GL_SHORT, (GLboolean)GL_TRUE);
+    default:
+      throw OpenGLException("unknown VertexFormat");
+  }
+}
+
 std::pair<GLint, GLenum> VertexArrayOpenGL::MapType(ParamType type) {
   switch (type) {
     case ParamType::Int32:
@@ -1326,6 +1501,16 @@ int TextureOpenGL::GetWidth() const { return _width; }
 
 int TextureOpenGL::GetHeight() const { return _height; }
 
+void TextureOpenGL::ReadImage(int level, int face, ImageDataFormat format, ImageDataType type, void* output) const {
+  auto target = MapTextureType(_type);
+  auto imageTarget = _type == TextureType::CubeMap ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+  HIKARI_CHECK_GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+  HIKARI_CHECK_GL(glBindTexture(target, _handle));
+  HIKARI_CHECK_GL(glGetTexImage(imageTarget, level, (GLenum)MapPixelFormat(format), MapTextureDataType(type), output));
+  HIKARI_CHECK_GL(glBindTexture(target, 0));
+  HIKARI_CHECK_GL(glPixelStorei(GL_PACK_ALIGNMENT, 4));
+}
+
 GLuint TextureOpenGL::MapFilterMode(FilterMode mode) {
   switch (mode) {
     case FilterMode::Point:
@@ -1362,6 +1547,8 @@ GLint TextureOpenGL::MapPixelFormat(ImageDataFormat format) {
       return GL_DEPTH_COMPONENT;
     case ImageDataFormat::RG:
       return GL_RG;
+    case ImageDataFormat::R:
+      return GL_RED;
     default:
       throw OpenGLException("unknown ImageDataFormat");
   }
@@ -1373,6 +1560,10 @@ GLenum TextureOpenGL::MapTextureDataType(ImageDataType format) {
       return GL_UNSIGNED_BYTE;
     case ImageDataType::Float32:
       return GL_FLOAT;
+    case ImageDataType::Float16:
+      return GL_HALF_FLOAT;
+    case ImageDataType::UInt5999Rev:
+      return GL_UNSIGNED_INT_5_9_9_9_REV;
     default:
       throw OpenGLException("unknown ImageDataType");
   }
@@ -1393,16 +1584,49 @@ GLsizei TextureOpenGL::CalcMipmapLevels(int mipmapLevel, int maxSize, bool isUse
   return levels;
 }
 
+bool TextureOpenGL::IsCompressedFormat(PixelFormat format) {
+  switch (format) {
+    case PixelFormat::BC1:
+    case PixelFormat::BC1Srgb:
+    case PixelFormat::BC3:
+    case PixelFormat::BC3Srgb:
+    case PixelFormat::BC4:
+    case PixelFormat::BC5:
+    case PixelFormat::BC6H:
+      return true;
+    default:
+      return false;
+  }
+}
+
+GLsizei TextureOpenGL::CalcCompressedImageSize(PixelFormat format, int width, int height) {
+  if (!IsCompressedFormat(format)) {
+    return 0;
+  }
+  bool isHalfBlock = format == PixelFormat::BC1 || format == PixelFormat::BC1Srgb || format == PixelFormat::BC4;
+  return ((width + 3) / 4) * ((height + 3) / 4) * (isHalfBlock ? 8 : 16);
+}
+
 void TextureOpenGL::CreateTexture2d(const Texture2dDescriptorOpenGL& desc, TextureOpenGL& texture) {
   auto min = MapFilterMode(desc.MinFilter);
   auto mag = MapFilterMode(desc.MagFilter);
   auto wrap = MapWrapMode(desc.Wrap);
   auto texFormat = static_cast<GLenum>(desc.TextureFormat);
-  auto dataFormat = (GLenum)MapPixelFormat(desc.DataFormat);
-  auto dataType = MapTextureDataType(desc.DataType);
+  const bool isCompressed = IsCompressedFormat(desc.TextureFormat);
+  auto dataFormat = isCompressed ? GL_NONE : (GLenum)MapPixelFormat(desc.DataFormat);
+  auto dataType = isCompressed ? GL_NONE : MapTextureDataType(desc.DataType);
   auto width = desc.Width;
   auto height = desc.Height;
   auto levels = CalcMipmapLevels(desc.MipMapLevel, std::max(width, height), desc.MinFilter == FilterMode::Trilinear);
+  //预计算的mipmap覆盖了所有级别时不需要驱动再生成
+  auto mipCount = desc.DataPtr == nullptr ? 0 : std::min((GLsizei)desc.MipDataPtr.size(), levels - 1);
+  if (isCompressed && desc.DataPtr != nullptr) {
+    levels = mipCount + 1;
+  }
+  bool isGenerateMipmap = mipCount < levels - 1;
+  auto levelData = [&](GLsizei level) { return level == 0 ? desc.DataPtr : desc.MipDataPtr[level - 1]; };
+  //小的mip级别一行不一定是4字节对齐
+  HIKARI_CHECK_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
   const auto& feature = FeatureOpenGL::Get();
   if (feature.CanUseDirectStateAccess()) {
     GLuint name;
@@ -1412,10 +1636,18 @@ void TextureOpenGL::CreateTexture2d(const Texture2dDescriptorOpenGL& desc, Textu
     HIKARI_CHECK_GL(glTextureParameteri(name, GL_TEXTURE_WRAP_S, wrap));
     HIKARI_CHECK_GL(glTextureParameteri(name, GL_TEXTURE_WRAP_T, wrap));
     HIKARI_CHECK_GL(glTextureStorage2D(name, levels, texFormat, width, height));
-    if (desc.DataPtr != nullptr) {
-      HIKARI_CHECK_GL(glTextureSubImage2D(name, 0, 0, 0, width, height, dataFormat, dataType, desc.DataPtr));
+    for (GLsizei i = desc.DataPtr == nullptr ? 1 : 0; i <= mipCount; i++) {
+      auto w = std::max(1, width >> i), h = std::max(1, height >> i);
+      if (isCompressed) {
+        HIKARI_CHECK_GL(glCompressedTextureSubImage2D(name, i, 0, 0, w, h, texFormat,
+                                                      CalcCompressedImageSize(desc.TextureFormat, w, h), levelData(i)));
+      } else {
+        HIKARI_CHECK_GL(glTextureSubImage2D(name, i, 0, 0, w, h, dataFormat, dataType, levelData(i)));
+      }
+    }
+    if (isGenerateMipmap && !isCompressed) {
+      HIKARI_CHECK_GL(glGenerateTextureMipmap(name));
     }
-    HIKARI_CHECK_GL(glGenerateTextureMipmap(name));
     texture._handle = name;
   } else {
     HIKARI_CHECK_GL(glGenTextures(1, &texture._handle));
@@ -1426,21 +1658,36 @@ void TextureOpenGL::CreateTexture2d(const Texture2dDescriptorOpenGL& desc, Textu
     HIKARI_CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap));
     if (feature.CanUseTextureStorage()) {
       HIKARI_CHECK_GL(glTexStorage2D(GL_TEXTURE_2D, levels, texFormat, width, height));
-      if (desc.DataPtr != nullptr) {
-        HIKARI_CHECK_GL(glTextureSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, dataFormat, dataType, desc.DataPtr));
+      for (GLsizei i = desc.DataPtr == nullptr ? 1 : 0; i <= mipCount; i++) {
+        auto w = std::max(1, width >> i), h = std::max(1, height >> i);
+        if (isCompressed) {
+          HIKARI_CHECK_GL(glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, w, h, texFormat,
+                                                    CalcCompressedImageSize(desc.TextureFormat, w, h), levelData(i)));
+        } else {
+          HIKARI_CHECK_GL(glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, w, h, dataFormat, dataType, levelData(i)));
+        }
       }
     } else {
       HIKARI_CHECK_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1));
-      HIKARI_CHECK_GL(glTexImage2D(GL_TEXTURE_2D,
-                                   0,
-                                   texFormat,
-                                   width, height,
-                                   0,
-                                   dataFormat, dataType, static_cast<const GLvoid*>(desc.DataPtr)));
+      for (GLsizei i = 0; i <= mipCount; i++) {
+        auto w = std::max(1, width >> i), h = std::max(1, height >> i);
+        if (isCompressed) {
+          //没有数据时不能分配压缩纹理，只有 TexStorage 可以
+          if (levelData(i) != nullptr) {
+            HIKARI_CHECK_GL(glCompressedTexImage2D(GL_TEXTURE_2D, i, texFormat, w, h, 0,
+                                                   CalcCompressedImageSize(desc.TextureFormat, w, h), levelData(i)));
+          }
+        } else {
+          HIKARI_CHECK_GL(glTexImage2D(GL_TEXTURE_2D, i, texFormat, w, h, 0, dataFormat, dataType, levelData(i)));
+        }
+      }
+    }
+    if (isGenerateMipmap && !isCompressed) {
+      HIKARI_CHECK_GL(glGenerateMipmap(GL_TEXTURE_2D));
     }
-    HIKARI_CHECK_GL(glGenerateMipmap(GL_TEXTURE_2D));
     HIKARI_CHECK_GL(glBindTexture(GL_TEXTURE_2D, 0));
   }
+  HIKARI_CHECK_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
   texture._type = TextureType::Image2d;
   texture._pixelFormat = desc.TextureFormat;
 }
@@ -1453,6 +1700,9 @@ void TextureOpenGL::CreateCubeMap(const TextureCubeMapDescriptorOpenGL& desc, Te
   auto levels = CalcMipmapLevels(desc.MipMapLevel,
                                  std::max(desc.Width, desc.Height),
                                  desc.MinFilter == FilterMode::Trilinear);
+  auto mipCount = std::min((GLsizei)desc.MipDataPtr.size(), levels - 1);
+  bool isGenerateMipmap = mipCount < levels - 1;
+  HIKARI_CHECK_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
   if (feature.CanUseDirectStateAccess()) {
     GLuint name;
     auto texFormat = static_cast<GLenum>(desc.TextureFormat);
@@ -1475,8 +1725,15 @@ void TextureOpenGL::CreateCubeMap(const TextureCubeMapDescriptorOpenGL& desc, Te
                                           desc.Width, desc.Height,
                                           1,  //一次性上传多少个cubmap纹理,这里一个一个传
                                           dataFormat, dataType, desc.DataPtr[i]));
+      for (GLsizei level = 1; level <= mipCount; level++) {
+        auto size = std::max(1, desc.Width >> level);
+        HIKARI_CHECK_GL(glTextureSubImage3D(name, level, 0, 0, i, size, size, 1,
+                                            dataFormat, dataType, desc.MipDataPtr[level - 1][i]));
+      }
+    }
+    if (isGenerateMipmap) {
+      HIKARI_CHECK_GL(glGenerateTextureMipmap(name));
     }
-    HIKARI_CHECK_GL(glGenerateTextureMipmap(name));
     texture._handle = name;
   } else {
     HIKARI_CHECK_GL(glGenTextures(1, &texture._handle));
@@ -1499,6 +1756,11 @@ void TextureOpenGL::CreateCubeMap(const TextureCubeMapDescriptorOpenGL& desc, Te
                                         0, 0,
                                         desc.Width, desc.Height,
                                         dataFormat, dataType, desc.DataPtr[i]));
+        for (GLsizei level = 1; level <= mipCount; level++) {
+          auto size = std::max(1, desc.Width >> level);
+          HIKARI_CHECK_GL(glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, 0, 0, size, size,
+                                          dataFormat, dataType, desc.MipDataPtr[level - 1][i]));
+        }
       }
     } else {
       //max level从0开始
@@ -1512,11 +1774,19 @@ void TextureOpenGL::CreateCubeMap(const TextureCubeMapDescriptorOpenGL& desc, Te
                                      desc.Width, desc.Height,
                                      0,  //*永远* 是0
                                      dataFormat, dataType, static_cast<const GLvoid*>(desc.DataPtr[i])));
+        for (GLsizei level = 1; level <= mipCount; level++) {
+          auto size = std::max(1, desc.Width >> level);
+          HIKARI_CHECK_GL(glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, texFormat, size, size, 0,
+                                       dataFormat, dataType, desc.MipDataPtr[level - 1][i]));
+        }
       }
     }
-    HIKARI_CHECK_GL(glGenerateMipmap(GL_TEXTURE_CUBE_MAP));
+    if (isGenerateMipmap) {
+      HIKARI_CHECK_GL(glGenerateMipmap(GL_TEXTURE_CUBE_MAP));
+    }
     HIKARI_CHECK_GL(glBindTexture(GL_TEXTURE_CUBE_MAP, 0));
   }
+  HIKARI_CHECK_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
   texture._type = TextureType::CubeMap;
 }
 
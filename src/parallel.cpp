@@ -0,0 +1,115 @@
+#include <hikari/parallel.h>
+
+#include <atomic>
+#include <algorithm>
+#include <exception>
+
+namespace Hikari {
+ThreadPool::ThreadPool(size_t threadCount) {
+  if (threadCount == 0) {
+    threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+  _workers.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; i++) {
+    _workers.emplace_back([this]() { WorkerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _isStop = true;
+  }
+  _cv.notify_all();
+  for (auto& worker : _workers) {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::GetThreadCount() const { return _workers.size(); }
+
+ThreadPool& ThreadPool::GetGlobal() {
+  static ThreadPool pool;
+  return pool;
+}
+
+void ThreadPool::Enqueue(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _tasks.emplace(std::move(task));
+  }
+  _cv.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _cv.wait(lock, [this]() { return _isStop || !_tasks.empty(); });
+      if (_isStop && _tasks.empty()) {
+        return;
+      }
+      task = std::move(_tasks.front());
+      _tasks.pop();
+    }
+    task();
+  }
+}
+
+void ParallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& func) {
+  if (begin >= end) {
+    return;
+  }
+  grain = std::max<size_t>(grain, 1);
+  size_t chunkCount = (end - begin + grain - 1) / grain;
+  auto& pool = ThreadPool::GetGlobal();
+  if (chunkCount == 1 || pool.GetThreadCount() <= 1) {
+    func(begin, end);
+    return;
+  }
+  //调用线程和辅助任务从同一个计数器领取块，调用线程不会因线程池繁忙而死锁
+  struct State {
+    std::atomic<size_t> Next{0};
+    std::atomic<size_t> Done{0};
+    std::mutex Mutex;
+    std::condition_variable Cv;
+    std::exception_ptr Error;
+  };
+  auto state = std::make_shared<State>();
+  auto run = [state, begin, end, grain, chunkCount, &func]() {
+    while (true) {
+      size_t chunk = state->Next.fetch_add(1);
+      if (chunk >= chunkCount) {
+        return;
+      }
+      size_t b = begin + chunk * grain;
+      size_t e = std::min(end, b + grain);
+      try {
+        func(b, e);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(state->Mutex);
+        if (!state->Error) {
+          state->Error = std::current_exception();
+        }
+      }
+      if (state->Done.fetch_add(1) + 1 == chunkCount) {
+        std::lock_guard<std::mutex> lock(state->Mutex);
+        state->Cv.notify_all();
+      }
+    }
+  };
+  size_t helperCount = std::min(pool.GetThreadCount(), chunkCount - 1);
+  for (size_t i = 0; i < helperCount; i++) {
+    //辅助任务可能在调用返回后才被调度，此时领不到块直接退出，不会访问func
+    pool.Submit(run);
+  }
+  run();
+  std::unique_lock<std::mutex> lock(state->Mutex);
+  state->Cv.wait(lock, [&]() { return state->Done.load() == chunkCount; });
+  if (state->Error) {
+    std::rethrow_exception(state->Error);
+  }
+}
+
+}  // namespace Hikari
@@ -0,0 +1,181 @@
+#include <hikari/quantize.h>
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace Hikari {
+uint16_t FloatToHalf(float value) {
+  uint32_t f;
+  std::memcpy(&f, &value, sizeof(f));
+  uint32_t sign = (f >> 16) & 0x8000;
+  uint32_t abs = f & 0x7FFFFFFF;
+  if (abs >= 0x7F800000) {
+    //NaN保留为安静NaN
+    return static_cast<uint16_t>(sign | 0x7C00 | (abs > 0x7F800000 ? 0x200 : 0));
+  }
+  if (abs >= 0x477FF000) {
+    return static_cast<uint16_t>(sign | 0x7C00);
+  }
+  if (abs < 0x38800000) {
+    //非规格化数：加上隐含的1后右移，舍入到最近偶数
+    if (abs < 0x33000000) {
+      return static_cast<uint16_t>(sign);
+    }
+    uint32_t mantissa = (abs & 0x007FFFFF) | 0x00800000;
+    uint32_t shift = 113 - (abs >> 23) + 13;
+    uint32_t half = mantissa >> shift;
+    uint32_t rest = mantissa & ((1u << shift) - 1);
+    uint32_t mid = 1u << (shift - 1);
+    if (rest > mid || (rest == mid && (half & 1))) {
+      half++;
+    }
+    return static_cast<uint16_t>(sign | half);
+  }
+  uint32_t half = ((abs - 0x38000000) >> 13);
+  uint32_t rest = abs & 0x1FFF;
+  if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+    half++;
+  }
+  return static_cast<uint16_t>(sign | half);
+}
+
+float HalfToFloat(uint16_t value) {
+  uint32_t sign = uint32_t(value & 0x8000) << 16;
+  uint32_t exponent = (value >> 10) & 0x1F;
+  uint32_t mantissa = value & 0x3FF;
+  uint32_t f;
+  if (exponent == 0) {
+    if (mantissa == 0) {
+      f = sign;
+    } else {
+      //非规格化数转成float的规格化数
+      exponent = 113;
+      while ((mantissa & 0x400) == 0) {
+        mantissa <<= 1;
+        exponent--;
+      }
+      mantissa &= 0x3FF;
+      f = sign | (exponent << 23) | (mantissa << 13);
+    }
+  } else if (exponent == 0x1F) {
+    f = sign | 0x7F800000 | (mantissa << 13);
+  } else {
+    f = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+  float result;
+  std::memcpy(&result, &f, sizeof(result));
+  return result;
+}
+
+int16_t FloatToSnorm16(float value) {
+  value = std::clamp(value, -1.0f, 1.0f);
+  return static_cast<int16_t>(std::lround(value * 32767.0f));
+}
+
+uint16_t FloatToUnorm16(float value) {
+  value = std::clamp(value, 0.0f, 1.0f);
+  return static_cast<uint16_t>(std::lround(value * 65535.0f));
+}
+
+uint32_t FloatToRgb9e5(const Vector3f& rgb) {
+  constexpr int mantissaBits = 9;
+  constexpr int bias = 15;
+  constexpr float maxValue = float((1 << mantissaBits) - 1) / (1 << mantissaBits) * float(1 << (31 - bias));
+  float c[3];
+  for (size_t i = 0; i < 3; i++) {
+    c[i] = rgb[i] > 0 ? std::min(rgb[i], maxValue) : 0.0f;  //NaN也变为0
+  }
+  float maxRgb = std::max({c[0], c[1], c[2]});
+  if (maxRgb <= 0) {
+    return 0;
+  }
+  int exp;
+  std::frexp(maxRgb, &exp);  //floor(log2(maxRgb)) = exp - 1
+  int sharedExp = std::max(-bias - 1, exp - 1) + 1 + bias;
+  float denom = std::ldexp(1.0f, sharedExp - bias - mantissaBits);
+  if (std::floor(maxRgb / denom + 0.5f) == float(1 << mantissaBits)) {
+    denom *= 2;
+    sharedExp++;
+  }
+  uint32_t result = uint32_t(sharedExp) << 27;
+  for (size_t i = 0; i < 3; i++) {
+    result |= uint32_t(std::floor(c[i] / denom + 0.5f)) << (i * 9);
+  }
+  return result;
+}
+
+Vector3f Rgb9e5ToFloat(uint32_t value) {
+  float scale = std::ldexp(1.0f, int(value >> 27) - 15 - 9);
+  return Vector3f{float(value & 0x1FF) * scale,
+                  float((value >> 9) & 0x1FF) * scale,
+                  float((value >> 18) & 0x1FF) * scale};
+}
+
+uint32_t RgbeToRgb9e5(const uint8_t* rgbe) {
+  if (rgbe[3] == 0) {
+    return 0;
+  }
+  //RGBE 为 m * 2^(e - 136)，RGB9E5 为 m9 * 2^(E - 24)，取 m9 = 2m 得 E = e - 113
+  int exp = int(rgbe[3]) - 113;
+  if (exp > 31) {
+    //超出范围时按分量截断，很少见，直接走浮点路径
+    float scale = std::ldexp(1.0f, int(rgbe[3]) - 136);
+    return FloatToRgb9e5(Vector3f{rgbe[0] * scale, rgbe[1] * scale, rgbe[2] * scale});
+  }
+  //指数低于RGB9E5的下限时尾数右移，与 FloatToRgb9e5 一样四舍五入
+  uint32_t shift = exp < 0 ? uint32_t(-exp) : 0;
+  if (shift > 10) {
+    return 0;
+  }
+  uint32_t round = shift > 0 ? 1u << (shift - 1) : 0;
+  uint32_t result = uint32_t(std::max(exp, 0)) << 27;
+  for (size_t i = 0; i < 3; i++) {
+    result |= (((uint32_t(rgbe[i]) << 1) + round) >> shift) << (i * 9);
+  }
+  return result;
+}
+
+static inline float SignNotZero(float v) { return v >= 0 ? 1.0f : -1.0f; }
+
+Vector2f EncodeOctahedral(const Vector3f& n) {
+  float sum = std::abs(n.X()) + std::abs(n.Y()) + std::abs(n.Z());
+  if (sum == 0) {
+    return Vector2f{0, 0};
+  }
+  float x = n.X() / sum;
+  float y = n.Y() / sum;
+  if (n.Z() < 0) {
+    //下半球折叠到外侧的四个三角形
+    float fx = (1 - std::abs(y)) * SignNotZero(x);
+    float fy = (1 - std::abs(x)) * SignNotZero(y);
+    x = fx;
+    y = fy;
+  }
+  return Vector2f{x, y};
+}
+
+Vector3f DecodeOctahedral(const Vector2f& e) {
+  float x = e.X();
+  float y = e.Y();
+  float z = 1 - std::abs(x) - std::abs(y);
+  if (z < 0) {
+    float fx = (1 - std::abs(y)) * SignNotZero(x);
+    float fy = (1 - std::abs(x)) * SignNotZero(y);
+    x = fx;
+    y = fy;
+  }
+  return Normalize(Vector3f{x, y, z});
+}
+
+PositionQuantization PositionQuantization::FromBounds(const Vector3f& min, const Vector3f& max) {
+  PositionQuantization q;
+  q.Offset = min;
+  for (size_t i = 0; i < 3; i++) {
+    float extent = max[i] - min[i];
+    q.Scale[i] = extent > 0 ? extent : 1.0f;
+  }
+  return q;
+}
+
+}  // namespace Hikari
@@ -6,12 +6,15 @@
 #include <fstream>
 #include <cstring>
 #include <sstream>
+#include <cstdlib>
+#include <thread>
 
 #include <SPIRV/GlslangToSpv.h>
 #include <spirv_cross.hpp>
 #include <spirv_glsl.hpp>
 
 #include <hikari/asset.h>
+#include <hikari/parallel.h>
 
 namespace Hikari {
 //从glslang里cv来的（
@@ -134,33 +137,34 @@ static const Matrix4f __cmcView[6] = {
     LookAt(Vector3f{0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, -1.0f, 0.0f}),
     LookAt(Vector3f{0.0f}, {0.0f, 0.0f, -1.0f}, {0.0f, -1.0f, 0.0f})};
 
-ShaderIncluder::ShaderIncluder() noexcept = default;
+ShaderIncluder::ShaderIncluder() : _cache(std::make_shared<ShaderIncludeCache>()) {}
 
 ShaderIncluder ::~ShaderIncluder() = default;
 
 glslang::TShader::Includer::IncludeResult* ShaderIncluder::includeSystem(const char* headerName,
                                                                          const char* includerName,
                                                                          size_t inclusionDepth) {
-  for (const auto& sysPath : _systemPaths) {
-    auto findPath = sysPath / headerName;
-    if (!std::filesystem::exists(findPath)) {
-      continue;
-    }
-    try {
-      auto str = ReadText(findPath);
-      auto result = new char[str.length()];
-      std::copy(str.begin(), str.end(), result);
-      return new IncludeResult(headerName, result, str.length(), result);
-    } catch (std::exception& e) {
-      return new IncludeResult(std::string(), e.what(), strlen(e.what()), nullptr);
-    }
-  }
-  return nullptr;
+  auto findPath = Resolve(headerName, true);
+  return findPath.empty() ? nullptr : MakeResult(headerName, findPath, true);
 }
 
 glslang::TShader::Includer::IncludeResult* ShaderIncluder::includeLocal(const char* headerName,
                                                                         const char* includerName,
                                                                         size_t inclusionDepth) {
+  auto findPath = Resolve(headerName, false);
+  return findPath.empty() ? nullptr : MakeResult(headerName, findPath, false);
+}
+
+std::filesystem::path ShaderIncluder::Resolve(const std::string& headerName, bool isSystem) {
+  if (isSystem) {
+    for (const auto& sysPath : _systemPaths) {
+      auto findPath = sysPath / headerName;
+      if (std::filesystem::exists(findPath)) {
+        return findPath;
+      }
+    }
+    return std::filesystem::path();
+  }
   if (_workPath.empty()) {
     std::error_code errCode;
     _workPath = std::filesystem::current_path(errCode);
@@ -169,14 +173,21 @@ glslang::TShader::Includer::IncludeResult* ShaderIncluder::includeLocal(const ch
     }
   }
   auto findPath = _workPath / headerName;
-  if (!std::filesystem::exists(findPath)) {
-    return nullptr;
-  }
+  return std::filesystem::exists(findPath) ? findPath : std::filesystem::path();
+}
+
+glslang::TShader::Includer::IncludeResult* ShaderIncluder::MakeResult(const char* headerName,
+                                                                      const std::filesystem::path& p,
+                                                                      bool isSystem) {
   try {
-    auto str = ReadText(findPath);
-    auto result = new char[str.length()];
-    std::copy(str.begin(), str.end(), result);
-    return new IncludeResult(headerName, result, str.length(), result);
+    auto file = GetFile(p);
+    if (file == nullptr) {
+      return nullptr;
+    }
+    _record.emplace_back(ShaderDependency{p.string(), file->Hash, headerName, isSystem});
+    //userData持有文件，文件在预处理期间被重新读取也不会释放正在使用的文本
+    auto holder = new std::shared_ptr<const ShaderIncludeFile>(file);
+    return new IncludeResult(headerName, file->Text.data(), file->Text.size(), holder);
   } catch (std::exception& e) {
     return new IncludeResult(std::string(), e.what(), strlen(e.what()), nullptr);
   }
@@ -185,7 +196,7 @@ glslang::TShader::Includer::IncludeResult* ShaderIncluder::includeLocal(const ch
 void ShaderIncluder::releaseInclude(IncludeResult* result) {
   if (result != nullptr) {
     if (result->userData != nullptr) {
-      delete[] static_cast<char*>(result->userData);
+      delete static_cast<std::shared_ptr<const ShaderIncludeFile>*>(result->userData);
     }
     delete result;
   }
@@ -198,6 +209,55 @@ void ShaderIncluder::AddSystemPath(const std::filesystem::path& sysPath) {
   }
 }
 
+ShaderIncluder ShaderIncluder::Fork() const {
+  ShaderIncluder fork;
+  fork._systemPaths = _systemPaths;
+  fork._workPath = _workPath;
+  fork._cache = _cache;
+  return fork;
+}
+
+uint64_t ShaderIncluder::HashSearchPaths(uint64_t seed) const {
+  auto hashPath = [](const std::filesystem::path& p, uint64_t h) {
+    auto str = p.string();
+    uint64_t size = str.size();
+    return Hash64(str.data(), str.size(), Hash64(&size, sizeof(size), h));
+  };
+  for (const auto& sysPath : _systemPaths) {
+    seed = hashPath(sysPath, seed);
+  }
+  std::error_code ec;
+  return hashPath(_workPath.empty() ? std::filesystem::current_path(ec) : _workPath, seed);
+}
+
+std::shared_ptr<const ShaderIncludeFile> ShaderIncluder::GetFile(const std::filesystem::path& p) {
+  std::error_code ec;
+  auto writeTime = std::filesystem::last_write_time(p, ec);
+  if (ec) {
+    return nullptr;
+  }
+  auto key = p.string();
+  {
+    std::lock_guard<std::mutex> lock(_cache->Mutex);
+    auto iter = _cache->Files.find(key);
+    if (iter != _cache->Files.end() && iter->second->WriteTime == writeTime) {
+      return iter->second;
+    }
+  }
+  //读文件时不持有锁，两个线程同时读到同一个文件也只是多读一次
+  auto file = std::make_shared<ShaderIncludeFile>();
+  file->Text = ReadText(p);
+  file->Hash = Hash64(file->Text.data(), file->Text.size());
+  file->WriteTime = writeTime;
+  std::lock_guard<std::mutex> lock(_cache->Mutex);
+  _cache->Files[key] = file;
+  return file;
+}
+
+void ShaderIncluder::BeginRecord() { _record.clear(); }
+
+const std::vector<ShaderDependency>& ShaderIncluder::GetRecord() const { return _record; }
+
 std::string ShaderIncluder::ReadText(const std::filesystem::path& p) {
   std::ifstream stream(p, std::ios_base::in | std::ios::binary);
   auto size = std::filesystem::file_size(p);
@@ -212,8 +272,10 @@ RenderContextOpenGL::RenderContextOpenGL(RenderContextOpenGL&& other) noexcept {
   _objects = std::move(other._objects);
   _vaos = std::move(other._vaos);
   _globalBlocks = std::move(other._globalBlocks);
+  _freeBlocks = std::move(other._freeBlocks);
   _blockQueryMap = std::move(other._blockQueryMap);
   _globalUniforms = std::move(other._globalUniforms);
+  _globalValues = std::move(other._globalValues);
   _isValid = other._isValid;
   other._isValid = false;
 }
@@ -222,8 +284,10 @@ RenderContextOpenGL& RenderContextOpenGL::operator=(RenderContextOpenGL&& other)
   _objects = std::move(other._objects);
   _vaos = std::move(other._vaos);
   _globalBlocks = std::move(other._globalBlocks);
+  _freeBlocks = std::move(other._freeBlocks);
   _blockQueryMap = std::move(other._blockQueryMap);
   _globalUniforms = std::move(other._globalUniforms);
+  _globalValues = std::move(other._globalValues);
   _isValid = other._isValid;
   other._isValid = false;
   return *this;
@@ -231,8 +295,10 @@ RenderContextOpenGL& RenderContextOpenGL::operator=(RenderContextOpenGL&& other)
 
 void RenderContextOpenGL::Destroy() {
   _globalBlocks.clear();
+  _freeBlocks.clear();
   _blockQueryMap.clear();
   _globalUniforms.clear();
+  _globalValues.clear();
   for (auto& [_, vao] : _vaos) {
     vao.Destroy();
   }
@@ -270,25 +336,335 @@ std::shared_ptr<BufferOpenGL> RenderContextOpenGL::CreateUniformBuffer(const voi
   return CreateBuffer(data, size, BufferType::UniformBuffer, usage, access);
 }
 
+constexpr uint32_t PROGRAM_CACHE_MAGIC = 0x42504B48;  //"HKPB"
+constexpr uint32_t PROGRAM_CACHE_VERSION = 1;
+
+/**
+ * @brief 后面依次是 ReflectionSize 字节的反射信息和 BinarySize 字节的程序二进制
+ */
+struct ProgramCacheHeader {
+  uint32_t Magic;
+  uint32_t Version;
+  uint64_t Key;
+  uint32_t BinaryFormat;
+  uint32_t Reserved;
+  uint64_t ReflectionSize;
+  uint64_t BinarySize;
+  uint64_t FileSize;
+};
+
+/**
+ * @brief 预处理后的源码、驱动和硬件、顶点属性的语义都相同时才能复用程序二进制
+ */
+static uint64_t MakeProgramCacheKey(const std::string& vs, const std::string& fs, const ShaderAttributeLayouts& desc) {
+  const auto& feature = FeatureOpenGL::Get();
+  uint64_t key = Hash64(feature.GetDriverInfo().data(), feature.GetDriverInfo().size(), PROGRAM_CACHE_VERSION);
+  key = Hash64(feature.GetHardwareInfo().data(), feature.GetHardwareInfo().size(), key);
+  for (const auto& layout : desc) {
+    int32_t semantic[2] = {int32_t(layout.Semantic.Type), int32_t(layout.Semantic.Index)};
+    key = Hash64(layout.Name.data(), layout.Name.size(), key);
+    key = Hash64(semantic, sizeof(semantic), key);
+  }
+  key = Hash64(vs.data(), vs.size(), key);
+  return Hash64(fs.data(), fs.size(), key);
+}
+
+template <class T>
+static void WriteValue(std::string& out, const T& value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static void WriteString(std::string& out, const std::string& str) {
+  WriteValue(out, uint32_t(str.size()));
+  out.append(str);
+}
+
+/**
+ * @brief 按顺序读取反射信息，越界时返回false
+ */
+struct ReflectionReader {
+  const uint8_t* Data;
+  size_t Size;
+  size_t Offset;
+
+  template <class T>
+  bool Read(T& value) {
+    if (Offset + sizeof(T) > Size) {
+      return false;
+    }
+    std::memcpy(&value, Data + Offset, sizeof(T));
+    Offset += sizeof(T);
+    return true;
+  }
+  bool Read(std::string& str) {
+    uint32_t size;
+    if (!Read(size) || Offset + size > Size) {
+      return false;
+    }
+    str.assign(reinterpret_cast<const char*>(Data + Offset), size);
+    Offset += size;
+    return true;
+  }
+};
+
+static std::string WriteReflection(const ProgramOpenGL& program) {
+  std::string out;
+  WriteValue(out, uint32_t(program.GetAttributes().size()));
+  for (const auto& attrib : program.GetAttributes()) {
+    WriteString(out, attrib.Name);
+    int32_t values[5] = {int32_t(attrib.Type), attrib.Length, attrib.Location, int32_t(attrib.Semantic.Type), attrib.Semantic.Index};
+    WriteValue(out, values);
+  }
+  WriteValue(out, uint32_t(program.GetUniforms().size()));
+  for (const auto& uniform : program.GetUniforms()) {
+    WriteString(out, uniform.Name);
+    int32_t values[3] = {int32_t(uniform.Type), uniform.Length, uniform.Location};
+    WriteValue(out, values);
+  }
+  WriteValue(out, uint32_t(program.GetBlocks().size()));
+  for (const auto& block : program.GetBlocks()) {
+    WriteString(out, block.Name);
+    int32_t values[3] = {block.Index, block.DataSize, int32_t(block.Members.size())};
+    WriteValue(out, values);
+    for (const auto& member : block.Members) {
+      WriteString(out, member.Name);
+      int32_t memberValues[5] = {member.Location, int32_t(member.Type), member.Length, member.Offset, member.Align};
+      WriteValue(out, memberValues);
+    }
+  }
+  return out;
+}
+
+static bool ReadReflection(const uint8_t* data, size_t size, ProgramReflection& reflection) {
+  ReflectionReader reader{data, size, 0};
+  uint32_t count;
+  if (!reader.Read(count)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    ShaderAttribute attrib;
+    int32_t values[5];
+    if (!reader.Read(attrib.Name) || !reader.Read(values)) {
+      return false;
+    }
+    attrib.Type = ParamType(values[0]);
+    attrib.Length = values[1];
+    attrib.Location = values[2];
+    attrib.Semantic = AttributeSemantic(SemanticType(values[3]), values[4]);
+    reflection.Attributes.emplace_back(std::move(attrib));
+  }
+  if (!reader.Read(count)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    ShaderUniform uniform;
+    int32_t values[3];
+    if (!reader.Read(uniform.Name) || !reader.Read(values)) {
+      return false;
+    }
+    uniform.Type = ParamType(values[0]);
+    uniform.Length = values[1];
+    uniform.Location = values[2];
+    reflection.Uniforms.emplace_back(std::move(uniform));
+  }
+  if (!reader.Read(count)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    ShaderUniformBlock block;
+    int32_t values[3];
+    if (!reader.Read(block.Name) || !reader.Read(values) || values[2] < 0) {
+      return false;
+    }
+    block.Index = values[0];
+    block.DataSize = values[1];
+    for (int32_t j = 0; j < values[2]; j++) {
+      ShaderUniformBlock::Member member;
+      int32_t memberValues[5];
+      if (!reader.Read(member.Name) || !reader.Read(memberValues)) {
+        return false;
+      }
+      member.Location = memberValues[0];
+      member.Type = ParamType(memberValues[1]);
+      member.Length = memberValues[2];
+      member.Offset = memberValues[3];
+      member.Align = memberValues[4];
+      block.Members.emplace_back(std::move(member));
+    }
+    reflection.Blocks.emplace_back(std::move(block));
+  }
+  return reader.Offset == size;
+}
+
+/**
+ * @brief 文件损坏、驱动更新后不再接受二进制时返回空，调用者重新编译
+ */
+static std::shared_ptr<ProgramOpenGL> LoadProgramCache(const std::filesystem::path& cachePath, uint64_t key) {
+  MappedFile file;
+  if (!file.Open(cachePath) || file.GetSize() < sizeof(ProgramCacheHeader)) {
+    return nullptr;
+  }
+  ProgramCacheHeader header;
+  std::memcpy(&header, file.GetData(), sizeof(header));
+  if (header.Magic != PROGRAM_CACHE_MAGIC ||
+      header.Version != PROGRAM_CACHE_VERSION ||
+      header.Key != key ||
+      header.FileSize != file.GetSize() ||
+      sizeof(header) + header.ReflectionSize + header.BinarySize != header.FileSize) {
+    return nullptr;
+  }
+  ProgramReflection reflection;
+  const uint8_t* data = file.GetData() + sizeof(header);
+  if (!ReadReflection(data, size_t(header.ReflectionSize), reflection)) {
+    return nullptr;
+  }
+  auto program = std::make_shared<ProgramOpenGL>();
+  if (!ProgramOpenGL::LoadBinary(header.BinaryFormat, data + header.ReflectionSize, size_t(header.BinarySize),
+                                 std::move(reflection), *program)) {
+    return nullptr;
+  }
+  return program;
+}
+
+static bool SaveProgramCache(const std::filesystem::path& cachePath, uint64_t key, const ProgramOpenGL& program) {
+  GLenum format;
+  std::vector<uint8_t> binary;
+  if (!program.GetBinary(format, binary)) {
+    return false;
+  }
+  auto reflection = WriteReflection(program);
+  ProgramCacheHeader header{};
+  header.Magic = PROGRAM_CACHE_MAGIC;
+  header.Version = PROGRAM_CACHE_VERSION;
+  header.Key = key;
+  header.BinaryFormat = format;
+  header.ReflectionSize = reflection.size();
+  header.BinarySize = binary.size();
+  header.FileSize = sizeof(header) + reflection.size() + binary.size();
+  std::error_code ec;
+  std::filesystem::create_directories(cachePath.parent_path(), ec);
+  auto tempPath = cachePath;
+  tempPath += ".tmp";
+  {
+    std::ofstream stream(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+      return false;
+    }
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reflection.data(), reflection.size());
+    stream.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+    if (!stream.good()) {
+      return false;
+    }
+  }
+  std::filesystem::rename(tempPath, cachePath, ec);
+  if (ec) {
+    std::filesystem::remove(tempPath, ec);
+    return false;
+  }
+  return true;
+}
+
+ShaderProgramTask::ShaderProgramTask() noexcept = default;
+
+ShaderProgramTask::ShaderProgramTask(std::shared_ptr<ProgramOpenGL> program) noexcept
+    : _program(std::move(program)), _isDone(true) {}
+
+ShaderProgramTask::~ShaderProgramTask() noexcept {
+  if (_handle != 0) {
+    HIKARI_CHECK_GL(glDeleteProgram(_handle));
+  }
+}
+
+bool ShaderProgramTask::IsDone() const { return _isDone; }
+
+bool ShaderProgramTask::IsFailed() const { return _isDone && _program == nullptr; }
+
+const std::shared_ptr<ProgramOpenGL>& ShaderProgramTask::GetProgram() const { return _program; }
+
 std::shared_ptr<ProgramOpenGL> RenderContextOpenGL::CreateShaderProgram(
     const std::string& vs,
     const std::string& fs,
     const ShaderAttributeLayouts& desc) {
+  return WaitShaderProgram(*SubmitShaderProgram(vs, fs, desc));
+}
+
+std::shared_ptr<ShaderProgramTask> RenderContextOpenGL::SubmitShaderProgram(
+    const std::string& vs,
+    const std::string& fs,
+    const ShaderAttributeLayouts& desc) {
   CheckInit();
-  ShaderOpenGL vShader(ShaderType::Vertex, vs);
-  if (!vShader.IsValid()) {
-    throw RenderContextException("Compile vertex shader failed");
-  }
-  ShaderOpenGL fShader(ShaderType::Fragment, fs);
-  if (!vShader.IsValid()) {
-    throw RenderContextException("Compile fragment shader failed");
-  }
-  auto program = std::make_shared<ProgramOpenGL>(vShader, fShader, desc);
-  vShader.Destroy();
-  fShader.Destroy();
-  if (!program->IsValid()) {
+  auto task = std::make_shared<ShaderProgramTask>();
+  task->_layouts = desc;
+  if (FeatureOpenGL::Get().CanUseProgramBinary()) {
+    task->_cacheKey = MakeProgramCacheKey(vs, fs, desc);
+    task->_cachePath = GetCacheDirectory() / "program" / (ToHexString(task->_cacheKey) + ".hkprog");
+    std::shared_ptr<ProgramOpenGL> program;
+    try {
+      program = LoadProgramCache(task->_cachePath, task->_cacheKey);
+    } catch (std::exception& e) {
+      std::cout << "can't read program cache: " << e.what() << "\n";
+    }
+    if (program != nullptr) {
+      try {
+        AddProgram(program);
+      } catch (RenderContextException& e) {
+        std::cerr << "can't add program: " << e.what() << std::endl;
+        program->Destroy();
+        program = nullptr;
+      }
+      return std::make_shared<ShaderProgramTask>(program);
+    }
+  }
+  task->_vs = ShaderOpenGL::SubmitCompile(ShaderType::Vertex, vs);
+  task->_fs = ShaderOpenGL::SubmitCompile(ShaderType::Fragment, fs);
+  task->_handle = ProgramOpenGL::SubmitLink(task->_vs, task->_fs);
+  return task;
+}
+
+bool RenderContextOpenGL::PollShaderProgram(ShaderProgramTask& task) {
+  if (!task._isDone && ProgramOpenGL::IsLinkCompleted(task._handle)) {
+    FinishShaderProgram(task);
+  }
+  return task._isDone;
+}
+
+std::shared_ptr<ProgramOpenGL> RenderContextOpenGL::WaitShaderProgram(ShaderProgramTask& task) {
+  if (!task._isDone) {
+    FinishShaderProgram(task);
+  }
+  if (task.IsFailed()) {
     throw RenderContextException("Link shader failed");
   }
+  return task._program;
+}
+
+void RenderContextOpenGL::FinishShaderProgram(ShaderProgramTask& task) {
+  auto program = std::make_shared<ProgramOpenGL>();
+  //无论成败，程序的所有权都已经交出去了
+  bool isSuccess = ProgramOpenGL::FinishLink(task._handle, task._vs, task._fs, task._layouts, *program);
+  task._handle = 0;
+  task._vs.Destroy();
+  task._fs.Destroy();
+  task._isDone = true;
+  if (!isSuccess) {
+    return;
+  }
+  if (!task._cachePath.empty() && !SaveProgramCache(task._cachePath, task._cacheKey, *program)) {
+    std::cout << "can't write program cache: " << task._cachePath << "\n";
+  }
+  try {
+    AddProgram(program);
+  } catch (RenderContextException& e) {
+    //uniform block的binding point用完时这个程序不可用，按链接失败处理
+    std::cerr << "can't add program: " << e.what() << std::endl;
+    program->Destroy();
+    return;
+  }
+  task._program = program;
+}
+
+void RenderContextOpenGL::AddProgram(const std::shared_ptr<ProgramOpenGL>& program) {
   AddUniformBlocks(*program);
   AddObjectToSet(program);
   VertexArrayOpenGL vao(program->GetAttributes());
@@ -296,8 +672,6 @@ std::shared_ptr<ProgramOpenGL> RenderContextOpenGL::CreateShaderProgram(
   if (!result.second) {
     throw RenderContextException("can't create VAO for program");
   }
-  //assert(isInsert);
-  return program;
 }
 
 std::shared_ptr<ProgramOpenGL> RenderContextOpenGL::LoadShaderProgram(
@@ -306,32 +680,90 @@ std::shared_ptr<ProgramOpenGL> RenderContextOpenGL::LoadShaderProgram(
     const std::filesystem::path& libPath,
     const ShaderAttributeLayouts& desc,
     const std::vector<std::string>& macros) {
-  std::filesystem::path resVsPath;
-  if (std::filesystem::exists(vsPath)) {
-    resVsPath = vsPath;
-  } else {
-    resVsPath = libPath / vsPath;
+  return LoadShaderPrograms({ShaderProgramRequest{vsPath, fsPath, libPath, desc, macros}})[0];
+}
+
+static std::filesystem::path ResolveShaderPath(const std::filesystem::path& path, const std::filesystem::path& libPath) {
+  return std::filesystem::exists(path) ? path : libPath / path;
+}
+
+/**
+ * @brief 批量加载时的一个待预处理阶段，多个程序共用同一个文件和宏时只处理一次
+ */
+struct ShaderStageTask {
+  ShaderType Type;
+  std::filesystem::path Path;
+  const std::vector<std::string>* Macros;
+  std::string Result;
+  bool IsSuccess;
+};
+
+std::vector<std::shared_ptr<ProgramOpenGL>> RenderContextOpenGL::LoadShaderPrograms(
+    const std::vector<ShaderProgramRequest>& requests) {
+  std::vector<ShaderStageTask> tasks;
+  std::unordered_map<std::string, size_t> taskIndex;
+  std::vector<std::pair<size_t, size_t>> programStages;
+  programStages.reserve(requests.size());
+  auto addTask = [&](ShaderType type, const std::filesystem::path& path, const std::vector<std::string>& macros) {
+    std::string id = std::to_string(int(type)) + "|" + path.string();
+    for (const auto& macro : macros) {
+      id += "|" + macro;
+    }
+    auto [iter, isNew] = taskIndex.emplace(id, tasks.size());
+    if (isNew) {
+      tasks.emplace_back(ShaderStageTask{type, path, &macros, std::string(), false});
+    }
+    return iter->second;
+  };
+  for (const auto& request : requests) {
+    size_t vs = addTask(ShaderType::Vertex, ResolveShaderPath(request.VsPath, request.LibPath), request.Macros);
+    size_t fs = addTask(ShaderType::Fragment, ResolveShaderPath(request.FsPath, request.LibPath), request.Macros);
+    programStages.emplace_back(vs, fs);
   }
-  std::filesystem::path resFsPath;
-  if (std::filesystem::exists(fsPath)) {
-    resFsPath = fsPath;
-  } else {
-    resFsPath = libPath / fsPath;
+  //读文件、glslang预处理和缓存读写都不碰GL，分给线程池
+  ParallelFor(0, tasks.size(), 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      auto& task = tasks[i];
+      ImmutableText text(task.Path.string(), task.Path);
+      task.IsSuccess = PreprocessShader(task.Type, text.GetText(), task.Result, *task.Macros);
+    }
+  });
+  for (const auto& task : tasks) {
+    if (!task.IsSuccess) {
+      std::cerr << "preprocess " << task.Path << " error" << std::endl;
+      throw RenderContextException(task.Type == ShaderType::Vertex
+                                       ? "can't preprocess vertex shader"
+                                       : "can't preprocess fragment shader");
+    }
   }
-  ImmutableText vs("vs", resVsPath);
-  ImmutableText fs("fs", resFsPath);
-  auto& ctx = *this;
-  std::string resVs;
-  if (!ctx.PreprocessShader(ShaderType::Vertex, vs.GetText(), resVs, macros)) {
+  //先全部提交再等待，驱动支持时可以并行编译
+  std::vector<std::shared_ptr<ShaderProgramTask>> submitted;
+  submitted.reserve(requests.size());
+  for (size_t i = 0; i < requests.size(); i++) {
+    const auto& [vs, fs] = programStages[i];
+    submitted.emplace_back(SubmitShaderProgram(tasks[vs].Result, tasks[fs].Result, requests[i].Layouts));
+  }
+  std::vector<std::shared_ptr<ProgramOpenGL>> programs;
+  programs.reserve(requests.size());
+  for (const auto& task : submitted) {
+    programs.emplace_back(WaitShaderProgram(*task));
+  }
+  return programs;
+}
+
+void RenderContextOpenGL::PreprocessShaderProgram(const ShaderProgramRequest& request, std::string& vs, std::string& fs) {
+  auto vsPath = ResolveShaderPath(request.VsPath, request.LibPath);
+  auto fsPath = ResolveShaderPath(request.FsPath, request.LibPath);
+  ImmutableText vsText(vsPath.string(), vsPath);
+  if (!PreprocessShader(ShaderType::Vertex, vsText.GetText(), vs, request.Macros)) {
     std::cerr << "preprocess " << vsPath << " error" << std::endl;
     throw RenderContextException("can't preprocess vertex shader");
   }
-  std::string resFs;
-  if (!ctx.PreprocessShader(ShaderType::Fragment, fs.GetText(), resFs, macros)) {
+  ImmutableText fsText(fsPath.string(), fsPath);
+  if (!PreprocessShader(ShaderType::Fragment, fsText.GetText(), fs, request.Macros)) {
     std::cerr << "preprocess " << fsPath << " error" << std::endl;
     throw RenderContextException("can't preprocess fragment shader");
   }
-  return ctx.CreateShaderProgram(resVs, resFs, desc);
 }
 
 std::shared_ptr<TextureOpenGL> RenderContextOpenGL::CreateTexture2D(const Texture2dDescriptorOpenGL& desc) {
@@ -345,12 +777,22 @@ std::shared_ptr<TextureOpenGL> RenderContextOpenGL::LoadBitmap2D(
     std::filesystem::path p,
     WrapMode wrap,
     FilterMode filter,
-    PixelFormat format) {
+    PixelFormat format,
+    const MipGenerateOptions& mipOptions) {
   ImmutableBitmap env("hdr", p, true);
+  return LoadBitmap2D(env, wrap, filter, format, mipOptions);
+}
+
+std::shared_ptr<TextureOpenGL> RenderContextOpenGL::LoadBitmap2D(
+    const ImmutableBitmap& env,
+    WrapMode wrap,
+    FilterMode filter,
+    PixelFormat format,
+    const MipGenerateOptions& mipOptions) {
   Texture2dDescriptorOpenGL desc;
   desc.Wrap = wrap;
   desc.MinFilter = filter;
-  desc.MagFilter = filter;
+  desc.MagFilter = filter == FilterMode::Trilinear ? FilterMode::Bilinear : filter;  //放大时不使用mipmap
   desc.MipMapLevel = 0;
   desc.TextureFormat = format;
   desc.Width = env.GetWidth();
@@ -358,9 +800,181 @@ std::shared_ptr<TextureOpenGL> RenderContextOpenGL::LoadBitmap2D(
   desc.DataFormat = env.GetChannel() == 3 ? ImageDataFormat::RGB : ImageDataFormat::RGBA;
   desc.DataType = ImageDataType::Byte;
   desc.DataPtr = env.GetData();
+  if (TextureOpenGL::IsCompressedFormat(format)) {
+    BlockFormat block;
+    switch (format) {
+      case PixelFormat::BC1:
+      case PixelFormat::BC1Srgb:
+        block = BlockFormat::BC1;
+        break;
+      case PixelFormat::BC3:
+      case PixelFormat::BC3Srgb:
+        block = BlockFormat::BC3;
+        break;
+      case PixelFormat::BC4:
+        block = BlockFormat::BC4;
+        break;
+      case PixelFormat::BC5:
+        block = BlockFormat::BC5;
+        break;
+      default:
+        throw RenderContextException("bitmap can't be compressed to BC6H");
+    }
+    BlockCompressOptions options;
+    options.IsSrgb = format == PixelFormat::BC1Srgb || format == PixelFormat::BC3Srgb;
+    options.GenerateMips = filter == FilterMode::Trilinear;
+    options.Mip = mipOptions;
+    options.UseCache = mipOptions.UseCache;
+    auto compressed = CompressTexture(env.GetData(), env.GetWidth(), env.GetHeight(), env.GetChannel(), MipDataType::UInt8, block, options);
+    return LoadCompressedTexture2D(compressed, wrap, filter);
+  }
+  MipChain mips;
+  if (filter == FilterMode::Trilinear) {
+    mips = GenerateMipChain(env.GetData(), env.GetWidth(), env.GetHeight(), env.GetChannel(), MipDataType::UInt8, GetBitmapMipOptions(format, mipOptions));
+    desc.MipDataPtr = mips.GetLevelPointers();
+  }
   return CreateTexture2D(desc);
 }
 
+MipGenerateOptions RenderContextOpenGL::GetBitmapMipOptions(PixelFormat format, const MipGenerateOptions& mipOptions) {
+  MipGenerateOptions options = mipOptions;
+  options.IsSrgb = format == PixelFormat::SRGB8A8;
+  return options;
+}
+
+std::shared_ptr<TextureOpenGL> RenderContextOpenGL::LoadCompressedTexture2D(const CompressedTexture& texture,
+                                                                            WrapMode wrap,
+                                                                            FilterMode filter) {
+  if (!texture.IsValid()) {
+    throw RenderContextException("invalid compressed texture");
+  }
+  const auto& feature = FeatureOpenGL::Get();
+  Texture2dDescriptorOpenGL desc;
+  desc.Wrap = wrap;
+  desc.MinFilter = filter;
+  desc.MagFilter = filter == FilterMode::Trilinear ? FilterMode::Bilinear : filter;
+  desc.MipMapLevel = 0;
+  desc.Width = texture.GetWidth(0);
+  desc.Height = texture.GetHeight(0);
+  desc.DataFormat = ImageDataFormat::RGBA;
+  desc.DataType = ImageDataType::Byte;
+  bool isSupported = true;
+  switch (texture.GetFormat()) {
+    case BlockFormat::BC1:
+      desc.TextureFormat = texture.IsSrgb() ? PixelFormat::BC1Srgb : PixelFormat::BC1;
+      isSupported = feature.CanUseS3tc();
+      break;
+    case BlockFormat::BC3:
+      desc.TextureFormat = texture.IsSrgb() ? PixelFormat::BC3Srgb : PixelFormat::BC3;
+      isSupported = feature.CanUseS3tc();
+      break;
+    case BlockFormat::BC4:
+      desc.TextureFormat = PixelFormat::BC4;  //RGTC是3.0的核心功能
+      break;
+    case BlockFormat::BC5:
+      desc.TextureFormat = PixelFormat::BC5;
+      break;
+    case BlockFormat::BC6H:
+      desc.TextureFormat = PixelFormat::BC6H;
+      isSupported = feature.CanUseBptc();
+      break;
+  }
+  const int levelCount = filter == FilterMode::Trilinear ? texture.GetLevelCount() : 1;
+  if (isSupported) {
+    desc.DataPtr = texture.GetLevelData(0);
+    for (int i = 1; i < levelCount; i++) {
+      desc.MipDataPtr.emplace_back(texture.GetLevelData(i));
+    }
+    return CreateTexture2D(desc);
+  }
+  //回退：逐级解压
+  switch (texture.GetFormat()) {
+    case BlockFormat::BC4:
+      desc.TextureFormat = PixelFormat::R8;
+      desc.DataFormat = ImageDataFormat::R;
+      break;
+    case BlockFormat::BC5:
+      desc.TextureFormat = PixelFormat::RG8;
+      desc.DataFormat = ImageDataFormat::RG;
+      break;
+    case BlockFormat::BC6H:
+      desc.TextureFormat = PixelFormat::RGB16F;
+      desc.DataFormat = ImageDataFormat::RGB;
+      desc.DataType = ImageDataType::Float32;
+      break;
+    default:
+      desc.TextureFormat = texture.IsSrgb() ? PixelFormat::SRGB8A8 : PixelFormat::RGBA8;
+      break;
+  }
+  const size_t pixelSize = texture.GetFormat() == BlockFormat::BC6H ? sizeof(float) * 3
+                           : texture.GetFormat() == BlockFormat::BC5 ? 2
+                           : texture.GetFormat() == BlockFormat::BC4 ? 1
+                                                                     : 4;
+  std::vector<std::vector<uint8_t>> levels(levelCount);
+  for (int i = 0; i < levelCount; i++) {
+    levels[i].resize(size_t(texture.GetWidth(i)) * texture.GetHeight(i) * pixelSize);
+    if (!DecompressBlocks(texture.GetLevelData(i), texture.GetFormat(), texture.GetWidth(i), texture.GetHeight(i), levels[i].data())) {
+      throw RenderContextException("unsupported BC6H block mode");
+    }
+    if (i > 0) {
+      desc.MipDataPtr.emplace_back(levels[i].data());
+    }
+  }
+  desc.DataPtr = levels[0].data();
+  return CreateTexture2D(desc);
+}
+
+std::shared_ptr<TextureOpenGL> RenderContextOpenGL::LoadCompressedTexture2D(const std::filesystem::path& path,
+                                                                            WrapMode wrap,
+                                                                            FilterMode filter) {
+  CompressedTexture texture;
+  if (!CompressedTexture::LoadFromFile(path, texture)) {
+    throw RenderContextException("can't load compressed texture " + path.string());
+  }
+  return LoadCompressedTexture2D(texture, wrap, filter);
+}
+
+void SetHdrTextureData(const ImmutableHdrTexture& hdr, Texture2dDescriptorOpenGL& desc) {
+  desc.Width = hdr.GetWidth();
+  desc.Height = hdr.GetHeight();
+  desc.DataPtr = hdr.GetRawData();
+  switch (hdr.GetStorage()) {
+    case HdrStorage::Half:
+      desc.TextureFormat = PixelFormat::RGB16F;
+      desc.DataFormat = ImageDataFormat::RGB;
+      desc.DataType = ImageDataType::Float16;
+      break;
+    case HdrStorage::RGB9E5:
+      desc.TextureFormat = PixelFormat::RGB9E5;
+      desc.DataFormat = ImageDataFormat::RGB;
+      desc.DataType = ImageDataType::UInt5999Rev;
+      break;
+    default:
+      desc.TextureFormat = PixelFormat::RGB32F;
+      desc.DataFormat = hdr.GetChannel() == 3 ? ImageDataFormat::RGB : ImageDataFormat::RGBA;
+      desc.DataType = ImageDataType::Float32;
+      break;
+  }
+}
+
+void SetCubeMapData(const CubeMapImage& cube, TextureCubeMapDescriptorOpenGL& desc) {
+  desc.Width = cube.GetSize();
+  desc.Height = cube.GetSize();
+  for (int i = 0; i < 6; i++) {
+    desc.DataFormat[i] = ImageDataFormat::RGB;
+    desc.DataType[i] = ImageDataType::Float32;
+    desc.DataPtr[i] = cube.GetFaceData(i);
+  }
+}
+
+void SetBrdfLutData(const BrdfLut& lut, Texture2dDescriptorOpenGL& desc) {
+  desc.Width = lut.GetWidth();
+  desc.Height = lut.GetHeight();
+  desc.DataFormat = lut.GetChannel() == 2 ? ImageDataFormat::RG : ImageDataFormat::RGB;
+  desc.DataType = ImageDataType::Float32;
+  desc.DataPtr = lut.GetData();
+}
+
 std::shared_ptr<TextureOpenGL> RenderContextOpenGL::CreateCubeMap(const TextureCubeMapDescriptorOpenGL& desc) {
   CheckInit();
   auto texture = std::make_shared<TextureOpenGL>(desc);
@@ -478,6 +1092,26 @@ std::shared_ptr<BufferOpenGL> RenderContextOpenGL::CreateVbo(const std::vector<V
   return CreateVertexBuffer(data, size);
 }
 
+std::shared_ptr<BufferOpenGL> RenderContextOpenGL::CreateIbo(IndexArrayView indices) {
+  return CreateIndexBuffer(indices.data(), indices.GetByteSize());
+}
+
+std::shared_ptr<BufferOpenGL> RenderContextOpenGL::CreateVbo(const std::vector<VertexPNTC>& pnt) {
+  return CreateVertexBuffer(pnt.data(), pnt.size() * SizePNTC());
+}
+
+std::shared_ptr<BufferOpenGL> RenderContextOpenGL::CreateVbo(const std::vector<VertexPNTQ>& pnt) {
+  return CreateVertexBuffer(pnt.data(), pnt.size() * SizePNTQ());
+}
+
+std::shared_ptr<BufferOpenGL> RenderContextOpenGL::CreateVbo(const std::vector<VertexPTNTC>& ptnt) {
+  return CreateVertexBuffer(ptnt.data(), ptnt.size() * SizePTNTC());
+}
+
+std::shared_ptr<BufferOpenGL> RenderContextOpenGL::CreateVbo(const std::vector<VertexPTNTQ>& ptnt) {
+  return CreateVertexBuffer(ptnt.data(), ptnt.size() * SizePTNTQ());
+}
+
 std::shared_ptr<TextureOpenGL> RenderContextOpenGL::ConvertSphericalToCubemap(
     const Texture2dDescriptorOpenGL& tex2d,
     const TextureCubeMapDescriptorOpenGL& _cubeConfig,
@@ -650,6 +1284,153 @@ std::shared_ptr<TextureOpenGL> RenderContextOpenGL::PrefilterEnvMap(
   return cube;
 }
 
+constexpr uint32_t ENVIRONMENT_CACHE_VERSION = 2;
+
+/**
+ * @brief 参与环境贴图缓存哈希的参数，全部是4字节的字段，没有填充。上一步结果的键作为种子
+ */
+struct EnvironmentCacheKey {
+  uint32_t Kind;
+  uint32_t Size;
+  uint32_t LevelCount;
+  uint32_t Version;
+};
+
+struct EnvironmentSourceKey {
+  uint32_t Width;
+  uint32_t Height;
+  uint32_t Channel;
+  uint32_t Storage;
+};
+
+/**
+ * @brief 烘焙shader改动后缓存自动失效。哈希的是两个阶段预处理后的源码，
+ * include的库文件和宏都展开在里面，改动任何一个都会失效。预处理结果有缓存，命中时只检查依赖文件
+ */
+static uint64_t HashBakeProgram(RenderContextOpenGL& ctx, const std::filesystem::path& shaderLib, const std::string& name, uint64_t seed) {
+  ShaderProgramRequest request{shaderLib / (name + ".vert"), shaderLib / (name + ".frag"), shaderLib, {}, {}};
+  std::string vs, fs;
+  ctx.PreprocessShaderProgram(request, vs, fs);
+  return Hash64(fs.data(), fs.size(), Hash64(vs.data(), vs.size(), seed));
+}
+
+static uint64_t MakeEnvironmentKey(uint32_t kind, int size, int levelCount, uint64_t programHash, uint64_t seed) {
+  EnvironmentCacheKey k{kind, uint32_t(size), uint32_t(levelCount), ENVIRONMENT_CACHE_VERSION};
+  return Hash64(&k, sizeof(k), Hash64(&programHash, sizeof(programHash), seed));
+}
+
+static TextureCubeMapDescriptorOpenGL MakeEnvironmentDesc(int size, FilterMode minFilter) {
+  TextureCubeMapDescriptorOpenGL desc;
+  desc.Wrap = WrapMode::Clamp;
+  desc.MinFilter = minFilter;
+  desc.MagFilter = FilterMode::Bilinear;
+  desc.MipMapLevel = 0;
+  desc.TextureFormat = PixelFormat::RGBA16F;
+  desc.Width = size;
+  desc.Height = size;
+  for (int i = 0; i < 6; i++) {
+    desc.DataFormat[i] = ImageDataFormat::RGB;
+    desc.DataType[i] = ImageDataType::Float16;
+    desc.DataPtr[i] = nullptr;
+  }
+  return desc;
+}
+
+static void SetBakedCubeMapData(const BakedCubeMap& baked, TextureCubeMapDescriptorOpenGL& desc) {
+  for (int i = 0; i < 6; i++) {
+    desc.DataPtr[i] = baked.GetFaceData(0, i);
+  }
+  desc.MipDataPtr.resize(size_t(baked.GetLevelCount() - 1));
+  for (int level = 1; level < baked.GetLevelCount(); level++) {
+    for (int i = 0; i < 6; i++) {
+      desc.MipDataPtr[level - 1][i] = baked.GetFaceData(level, i);
+    }
+  }
+}
+
+static void SaveEnvironmentCache(const TextureOpenGL& texture, int levelCount, const std::filesystem::path& path, uint64_t key) {
+  BakedCubeMap baked;
+  baked.Allocate(texture.GetWidth(), levelCount);
+  for (int level = 0; level < levelCount; level++) {
+    for (int i = 0; i < 6; i++) {
+      texture.ReadImage(level, i, ImageDataFormat::RGB, ImageDataType::Float16, baked.GetFaceData(level, i));
+    }
+  }
+  if (!baked.SaveToFile(path, key)) {
+    std::cout << "can't write environment cache: " << path << "\n";
+  }
+}
+
+EnvironmentMaps RenderContextOpenGL::BakeEnvironmentMaps(const ImmutableHdrTexture& hdr,
+                                                         const EnvironmentBakeOptions& options,
+                                                         const std::filesystem::path& shaderLib) {
+  CheckInit();
+  if (!hdr.IsValid() || options.SkyboxSize <= 0) {
+    throw RenderContextException("invalid environment bake input");
+  }
+  const int prefilterLevels = TextureOpenGL::CalcMipmapLevels(0, std::max(options.PrefilterSize, 1), true);
+  //只有使用缓存时才哈希全景图和预处理烘焙shader，不生成的贴图不计算键
+  uint64_t skyKey = 0, irrKey = 0, filterKey = 0;
+  if (options.UseCache) {
+    EnvironmentSourceKey source{uint32_t(hdr.GetWidth()), uint32_t(hdr.GetHeight()), uint32_t(hdr.GetChannel()), uint32_t(hdr.GetStorage())};
+    const uint64_t sourceKey = Hash64(hdr.GetRawData(), hdr.GetByteSize(), Hash64(&source, sizeof(source)));
+    skyKey = MakeEnvironmentKey(0, options.SkyboxSize, 1, HashBakeProgram(*this, shaderLib, "SphericalToCubeMap", 0), sourceKey);
+    if (options.IrradianceSize > 0) {
+      irrKey = MakeEnvironmentKey(1, options.IrradianceSize, 1, HashBakeProgram(*this, shaderLib, "IrradianceConvolution", 0), skyKey);
+    }
+    if (options.PrefilterSize > 0) {
+      filterKey = MakeEnvironmentKey(2, options.PrefilterSize, prefilterLevels, HashBakeProgram(*this, shaderLib, "PreFilterEnv", 0), skyKey);
+    }
+  }
+  auto cachePath = [](uint64_t key) { return GetCacheDirectory() / "ibl" / (ToHexString(key) + ".hkcube"); };
+
+  EnvironmentMaps maps;
+  //命中的贴图直接上传，没有命中的由上一步的结果烘焙，读回后写入缓存
+  BakedCubeMap baked;
+  auto skyDesc = MakeEnvironmentDesc(options.SkyboxSize, FilterMode::Bilinear);
+  if (options.UseCache && baked.LoadFromFile(cachePath(skyKey), skyKey) && baked.GetSize(0) == options.SkyboxSize) {
+    SetBakedCubeMapData(baked, skyDesc);
+    maps.Skybox = CreateCubeMap(skyDesc);
+  } else {
+    Texture2dDescriptorOpenGL hdrDesc;
+    hdrDesc.Wrap = WrapMode::Clamp;
+    hdrDesc.MinFilter = FilterMode::Bilinear;
+    hdrDesc.MagFilter = FilterMode::Bilinear;
+    hdrDesc.MipMapLevel = 0;
+    SetHdrTextureData(hdr, hdrDesc);
+    maps.Skybox = ConvertSphericalToCubemap(hdrDesc, skyDesc, shaderLib);
+    if (options.UseCache) {
+      SaveEnvironmentCache(*maps.Skybox, 1, cachePath(skyKey), skyKey);
+    }
+  }
+  if (options.IrradianceSize > 0) {
+    auto desc = MakeEnvironmentDesc(options.IrradianceSize, FilterMode::Bilinear);
+    if (options.UseCache && baked.LoadFromFile(cachePath(irrKey), irrKey) && baked.GetSize(0) == options.IrradianceSize) {
+      SetBakedCubeMapData(baked, desc);
+      maps.Irradiance = CreateCubeMap(desc);
+    } else {
+      maps.Irradiance = GenIrradianceConvolutionCubemap(maps.Skybox, desc, shaderLib);
+      if (options.UseCache) {
+        SaveEnvironmentCache(*maps.Irradiance, 1, cachePath(irrKey), irrKey);
+      }
+    }
+  }
+  if (options.PrefilterSize > 0) {
+    auto desc = MakeEnvironmentDesc(options.PrefilterSize, FilterMode::Trilinear);
+    if (options.UseCache && baked.LoadFromFile(cachePath(filterKey), filterKey) &&
+        baked.GetSize(0) == options.PrefilterSize && baked.GetLevelCount() == prefilterLevels) {
+      SetBakedCubeMapData(baked, desc);
+      maps.Prefiltered = CreateCubeMap(desc);
+    } else {
+      maps.Prefiltered = PrefilterEnvMap(maps.Skybox, desc, shaderLib);
+      if (options.UseCache) {
+        SaveEnvironmentCache(*maps.Prefiltered, prefilterLevels, cachePath(filterKey), filterKey);
+      }
+    }
+  }
+  return maps;
+}
+
 std::shared_ptr<TextureOpenGL> RenderContextOpenGL::PrecomputeBrdfLut(
     const Texture2dDescriptorOpenGL& desc,
     const std::filesystem::path& shaderLib) {
@@ -732,36 +1513,112 @@ std::shared_ptr<TextureOpenGL> RenderContextOpenGL::PrecomputerBrdfMultiScatteri
 
 void RenderContextOpenGL::AddUniformBlocks(const ProgramOpenGL& prog) {
   CheckInit();
-  for (const auto& block : prog.GetBlocks()) {
-    auto iter = _blockQueryMap.find(block.Name);
-    GLuint bindingPoint;
-    if (iter == _blockQueryMap.end()) {
-      GlobalUniformBlock binding;
-      binding.Block = block;
-      binding.BindingPoint = std::distance(_globalBlocks.begin(), _globalBlocks.end());
-      binding.Data.resize(block.DataSize, 0);
-      binding.Ubo = CreateUniformBuffer(nullptr, block.DataSize, BufferUsage::Dynamic);
-      _globalBlocks.emplace_back(binding);
-      bindingPoint = GLuint(binding.BindingPoint);
-      HIKARI_CHECK_GL(glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, binding.Ubo->GetHandle()));
-      _blockQueryMap.emplace(block.Name, binding.BindingPoint);
-      for (const auto& member : block.Members) {
-        auto result = _globalUniforms.emplace(member.Name, GlobalUniform{member, binding.BindingPoint});
-        if (!result.second) {
-          throw RenderContextException("uniform block member has same name");
-        }
+  const size_t maxCount = size_t(std::max(FeatureOpenGL::Get().GetMaxUniformBlockBindings(), 0));
+  std::vector<std::pair<size_t, bool>> handles;
+  try {
+    for (const auto& block : prog.GetBlocks()) {
+      handles.emplace_back(RegisterGlobalBlock(block, maxCount));
+    }
+  } catch (...) {
+    //binding point不够时不留下这个程序的引用
+    for (const auto& [handle, _] : handles) {
+      ReleaseGlobalBlock(handle);
+    }
+    throw;
+  }
+  for (size_t i = 0; i < handles.size(); i++) {
+    auto [handle, isNew] = handles[i];
+    auto& binding = _globalBlocks[handle];
+    if (isNew) {
+      //复用的编号上可能还留着旧布局的buffer，大小不一定合适
+      if (binding.Ubo != nullptr) {
+        DestroyObject(binding.Ubo);
       }
-    } else {
-      const auto& global = _globalBlocks[iter->second];
-      if (global.Block != block) {
-        throw RenderContextException("Uniform block has same name but different layout");
+      binding.Ubo = CreateUniformBuffer(nullptr, binding.Block.DataSize, BufferUsage::Dynamic);
+      HIKARI_CHECK_GL(glBindBufferBase(GL_UNIFORM_BUFFER, GLuint(binding.BindingPoint), binding.Ubo->GetHandle()));
+    }
+    HIKARI_CHECK_GL(glUniformBlockBinding(prog.GetHandle(), prog.GetBlocks()[i].Index, GLuint(binding.BindingPoint)));
+  }
+}
+
+std::pair<size_t, bool> RenderContextOpenGL::RegisterGlobalBlock(const ShaderUniformBlock& block, size_t maxCount) {
+  //同一个块在不同变体里数组长度可能不同，每种布局单独占一个binding point
+  auto [begin, end] = _blockQueryMap.equal_range(block.Name);
+  auto iter = std::find_if(begin, end, [&](const auto& p) { return _globalBlocks[p.second].Block == block; });
+  if (iter != end) {
+    _globalBlocks[iter->second].RefCount++;
+    return std::make_pair(iter->second, false);
+  }
+  for (const auto& member : block.Members) {
+    auto [memberBegin, memberEnd] = _globalUniforms.equal_range(member.Name);
+    for (auto other = memberBegin; other != memberEnd; ++other) {
+      if (_globalBlocks[other->second.BlockHandle].Block.Name != block.Name) {
+        throw RenderContextException("uniform block member has same name");
       }
-      bindingPoint = GLuint(global.BindingPoint);
     }
-    HIKARI_CHECK_GL(glUniformBlockBinding(prog.GetHandle(), block.Index, bindingPoint));
   }
+  size_t handle;
+  if (!_freeBlocks.empty()) {
+    handle = _freeBlocks.back();
+    _freeBlocks.pop_back();
+  } else if (_globalBlocks.size() < maxCount) {
+    handle = _globalBlocks.size();
+    _globalBlocks.emplace_back();
+  } else {
+    throw RenderContextException("too many uniform block layouts, max binding point count is " + std::to_string(maxCount));
+  }
+  auto& binding = _globalBlocks[handle];
+  binding.Block = block;
+  binding.BindingPoint = handle;
+  binding.Data.assign(block.DataSize, 0);
+  binding.RefCount = 1;
+  binding.IsDirty = true;
+  _blockQueryMap.emplace(block.Name, handle);
+  for (const auto& member : block.Members) {
+    auto uniform = _globalUniforms.emplace(member.Name, GlobalUniform{member, handle});
+    //新布局用已经写入过的数据初始化，程序加载前设置的全局数据不会丢
+    auto value = _globalValues.find(member.Name);
+    if (value != _globalValues.end()) {
+      const auto& v = value->second;
+      SetGlobalUniformData(uniform->second, v.DataSize, std::min(v.Length, member.Length), v.Align, v.Data.data());
+    }
+  }
+  return std::make_pair(handle, true);
+}
+
+bool RenderContextOpenGL::ReleaseGlobalBlock(size_t handle) {
+  auto& binding = _globalBlocks.at(handle);
+  if (binding.RefCount <= 0) {
+    throw RenderContextException("uniform block layout is not referenced");
+  }
+  if (--binding.RefCount > 0) {
+    return false;
+  }
+  auto [begin, end] = _blockQueryMap.equal_range(binding.Block.Name);
+  for (auto iter = begin; iter != end; ++iter) {
+    if (iter->second == handle) {
+      _blockQueryMap.erase(iter);
+      break;
+    }
+  }
+  for (const auto& member : binding.Block.Members) {
+    auto [memberBegin, memberEnd] = _globalUniforms.equal_range(member.Name);
+    for (auto iter = memberBegin; iter != memberEnd; ++iter) {
+      if (iter->second.BlockHandle == handle) {
+        _globalUniforms.erase(iter);
+        break;
+      }
+    }
+  }
+  //buffer留到编号被复用时再销毁
+  binding.Block = ShaderUniformBlock{};
+  binding.Data.clear();
+  _freeBlocks.emplace_back(handle);
+  return true;
 }
 
+const GlobalUniformBlock& RenderContextOpenGL::GetGlobalBlock(size_t handle) const { return _globalBlocks.at(handle); }
+
 void RenderContextOpenGL::DestroyObject(const std::shared_ptr<ObjectOpenGL>& ptr) {
   ptr->Destroy();
   auto count = _objects.erase(ptr);
@@ -772,6 +1629,16 @@ void RenderContextOpenGL::DestroyObject(const std::shared_ptr<ObjectOpenGL>& ptr
 
 void RenderContextOpenGL::DestroyObject(const std::shared_ptr<ProgramOpenGL>& ptr) {
   auto count = _vaos.erase(ptr);
+  if (count != 0) {
+    //只有 AddProgram 登记过的程序引用了uniform block布局
+    for (const auto& block : ptr->GetBlocks()) {
+      auto [begin, end] = _blockQueryMap.equal_range(block.Name);
+      auto iter = std::find_if(begin, end, [&](const auto& p) { return _globalBlocks[p.second].Block == block; });
+      if (iter != end) {
+        ReleaseGlobalBlock(iter->second);
+      }
+    }
+  }
   auto cast = std::static_pointer_cast<ObjectOpenGL, ProgramOpenGL>(ptr);
   DestroyObject(cast);
   if (count == 0) {
@@ -803,14 +1670,169 @@ static void __OutputStrLog(const char* str) {
   }
 }
 
+/**
+ * @brief glslang的进程级状态只初始化一次，进程退出时释放。之后每个线程都可以直接使用 TShader
+ */
+static void InitGlslangProcess() {
+  static std::once_flag flag;
+  std::call_once(flag, []() {
+    glslang::InitializeProcess();
+    std::atexit([]() { glslang::FinalizeProcess(); });
+  });
+}
+
+constexpr uint32_t PREPROCESS_CACHE_MAGIC = 0x50504B48;  //"HKPP"
+constexpr uint32_t PREPROCESS_CACHE_VERSION = 2;
+
+struct PreprocessCacheHeader {
+  uint32_t Magic;
+  uint32_t Version;
+  uint64_t Key;
+  uint32_t DependencyCount;
+  uint32_t Reserved;
+  uint64_t OutputSize;
+  uint64_t FileSize;
+};
+
+/**
+ * @brief 后面跟着 PathSize 字节的路径和 NameSize 字节的include名字
+ */
+struct PreprocessCacheDependency {
+  uint64_t Hash;
+  uint32_t PathSize;
+  uint32_t NameSize;
+  uint32_t IsSystem;
+  uint32_t Reserved;
+};
+
+/**
+ * @brief 记录的所有include名字仍然解析到同一个文件、并且文件哈希一致时才命中。
+ * 查找路径前面新增了同名文件时解析结果会变，缓存失效
+ */
+static bool LoadPreprocessCache(const std::filesystem::path& cachePath, uint64_t key, ShaderIncluder& includer, std::string& res) {
+  MappedFile file;
+  if (!file.Open(cachePath) || file.GetSize() < sizeof(PreprocessCacheHeader)) {
+    return false;
+  }
+  PreprocessCacheHeader header;
+  std::memcpy(&header, file.GetData(), sizeof(header));
+  if (header.Magic != PREPROCESS_CACHE_MAGIC ||
+      header.Version != PREPROCESS_CACHE_VERSION ||
+      header.Key != key ||
+      header.FileSize != file.GetSize()) {
+    return false;
+  }
+  size_t offset = sizeof(header);
+  for (uint32_t i = 0; i < header.DependencyCount; i++) {
+    PreprocessCacheDependency dep;
+    if (offset + sizeof(dep) > file.GetSize()) {
+      return false;
+    }
+    std::memcpy(&dep, file.GetData() + offset, sizeof(dep));
+    offset += sizeof(dep);
+    if (offset + dep.PathSize + dep.NameSize > file.GetSize()) {
+      return false;
+    }
+    std::string depPath(reinterpret_cast<const char*>(file.GetData() + offset), dep.PathSize);
+    offset += dep.PathSize;
+    std::string depName(reinterpret_cast<const char*>(file.GetData() + offset), dep.NameSize);
+    offset += dep.NameSize;
+    if (includer.Resolve(depName, dep.IsSystem != 0).string() != depPath) {
+      return false;
+    }
+    auto include = includer.GetFile(depPath);
+    if (include == nullptr || include->Hash != dep.Hash) {
+      return false;
+    }
+  }
+  if (offset + header.OutputSize != file.GetSize()) {
+    return false;
+  }
+  res.assign(reinterpret_cast<const char*>(file.GetData() + offset), size_t(header.OutputSize));
+  return true;
+}
+
+static bool SavePreprocessCache(const std::filesystem::path& cachePath,
+                                uint64_t key,
+                                const std::vector<ShaderDependency>& record,
+                                const std::string& res) {
+  //preprocess和parse都会处理include，同一个文件只保存一次
+  std::vector<const ShaderDependency*> deps;
+  for (const auto& dep : record) {
+    auto iter = std::find_if(deps.begin(), deps.end(), [&](const ShaderDependency* d) { return d->Path == dep.Path; });
+    if (iter == deps.end()) {
+      deps.emplace_back(&dep);
+    }
+  }
+  PreprocessCacheHeader header{};
+  header.Magic = PREPROCESS_CACHE_MAGIC;
+  header.Version = PREPROCESS_CACHE_VERSION;
+  header.Key = key;
+  header.DependencyCount = uint32_t(deps.size());
+  header.OutputSize = res.size();
+  header.FileSize = sizeof(header) + res.size();
+  for (const auto* dep : deps) {
+    header.FileSize += sizeof(PreprocessCacheDependency) + dep->Path.size() + dep->Name.size();
+  }
+  std::error_code ec;
+  std::filesystem::create_directories(cachePath.parent_path(), ec);
+  auto tempPath = cachePath;
+  //可能有多个线程同时写同一个条目，临时文件按线程区分
+  tempPath += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+  {
+    std::ofstream stream(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+      return false;
+    }
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto* dep : deps) {
+      PreprocessCacheDependency d{dep->Hash, uint32_t(dep->Path.size()), uint32_t(dep->Name.size()), uint32_t(dep->IsSystem), 0};
+      stream.write(reinterpret_cast<const char*>(&d), sizeof(d));
+      stream.write(dep->Path.data(), dep->Path.size());
+      stream.write(dep->Name.data(), dep->Name.size());
+    }
+    stream.write(res.data(), res.size());
+    if (!stream.good()) {
+      return false;
+    }
+  }
+  std::filesystem::rename(tempPath, cachePath, ec);
+  if (ec) {
+    std::filesystem::remove(tempPath, ec);
+    return false;
+  }
+  return true;
+}
+
 bool RenderContextOpenGL::PreprocessShader(
     ShaderType type,
     const std::string& source,
     std::string& res,
     const std::vector<std::string>& args) {
   //CheckInit();
+  std::vector<std::string> macros(args);
+  macros.emplace_back("#extension GL_GOOGLE_include_directive : enable");  //启用#include
+  std::string preamble;
+  for (const auto& macro : macros) {
+    preamble += (macro + "\n");
+  }
+  uint32_t stage = uint32_t(type);
+  //查找路径也参与哈希，换了库目录或者前面的目录里新增同名文件时不会命中旧的结果
+  uint64_t key = Hash64(source.data(), source.size(),
+                        Hash64(preamble.data(), preamble.size(),
+                               _includer.HashSearchPaths(Hash64(&stage, sizeof(stage), PREPROCESS_CACHE_VERSION))));
+  auto cachePath = GetCacheDirectory() / "shader" / (ToHexString(key) + ".hkpp");
+  //每次调用用独立的includer记录依赖，多个线程同时预处理时互不影响
+  ShaderIncluder includer = _includer.Fork();
+  try {
+    if (LoadPreprocessCache(cachePath, key, includer, res)) {
+      return true;
+    }
+  } catch (std::exception& e) {
+    std::cout << "can't read preprocess cache: " << e.what() << "\n";
+  }
   EShLanguage lang = MapShaderTypToGlslang(type);
-  glslang::InitializeProcess();
+  InitGlslangProcess();
   auto shader = std::make_unique<glslang::TShader>(lang);
   shader->setEnvInput(glslang::EShSourceGlsl, EShLanguage::EShLangVertex, glslang::EShClient::EShClientOpenGL, 100);
   shader->setEnvClient(glslang::EShClient::EShClientOpenGL, glslang::EshTargetClientVersion::EShTargetOpenGL_450);
@@ -819,17 +1841,11 @@ bool RenderContextOpenGL::PreprocessShader(
   shader->setAutoMapLocations(true);
   auto src = source.c_str();
   shader->setStrings(&src, 1);
-  std::vector<std::string> macros(args);
-  macros.emplace_back("#extension GL_GOOGLE_include_directive : enable");  //启用#include
-  std::string preamble;
-  for (const auto& macro : macros) {
-    preamble += (macro + "\n");
-  }
   shader->setPreamble(preamble.c_str());
   std::string result;
-  bool proc = shader->preprocess(&__BuiltInRes, 110, ECoreProfile, false, false, EShMsgDefault, &result, _includer);
+  bool proc = shader->preprocess(&__BuiltInRes, 110, ECoreProfile, false, false, EShMsgDefault, &result, includer);
   if (proc) {
-    proc = shader->parse(&__BuiltInRes, 110, false, EShMsgDefault, _includer);
+    proc = shader->parse(&__BuiltInRes, 110, false, EShMsgDefault, includer);
     if (!proc) {
       std::cout << "--------------parse info---------------" << std::endl;
       __OutputStrLog(shader->getInfoLog());
@@ -866,15 +1882,17 @@ bool RenderContextOpenGL::PreprocessShader(
         res.append("\n");
       }
     }
+    if (!SavePreprocessCache(cachePath, key, includer.GetRecord(), res)) {
+      std::cout << "can't write preprocess cache: " << cachePath << "\n";
+    }
   }
-  glslang::InitializeProcess();
   return proc;
 }
 
 bool RenderContextOpenGL::ProcessShader(ShaderType type, const std::string& source, std::string& res) {
   CheckInit();
   EShLanguage lang = MapShaderTypToGlslang(type);
-  glslang::InitializeProcess();
+  InitGlslangProcess();
   auto shader = std::make_unique<glslang::TShader>(lang);
   //最后一个参数version不知道啥玩意，看StandAlone.cpp只要是opengl和vulkan就填100
   shader->setEnvInput(glslang::EShSourceGlsl, EShLanguage::EShLangVertex, glslang::EShClient::EShClientOpenGL, 100);
@@ -885,11 +1903,11 @@ bool RenderContextOpenGL::ProcessShader(ShaderType type, const std::string& sour
   auto src = source.c_str();
   shader->setStrings(&src, 1);
   shader->setPreamble("\n#extension GL_GOOGLE_include_directive : enable\n");
+  ShaderIncluder includer = _includer.Fork();
   //defaultVersion，桌面填110，ES填100（没看出有啥区别
-  bool parseResult = shader->parse(&__BuiltInRes, 110, false, EShMsgDefault, _includer);
+  bool parseResult = shader->parse(&__BuiltInRes, 110, false, EShMsgDefault, includer);
   if (!parseResult) {
     res = std::string(shader->getInfoLog());
-    glslang::FinalizeProcess();
     return false;
   }
   auto program = std::make_unique<glslang::TProgram>();
@@ -897,7 +1915,6 @@ bool RenderContextOpenGL::ProcessShader(ShaderType type, const std::string& sour
   bool linkResult = program->link(EShMsgDefault);
   if (!linkResult) {
     res = std::string(program->getInfoLog());
-    glslang::FinalizeProcess();
     return false;
   }
   glslang::SpvOptions spvOpt;
@@ -909,7 +1926,6 @@ bool RenderContextOpenGL::ProcessShader(ShaderType type, const std::string& sour
   glslang::GlslangToSpv(*program->getIntermediate(lang), spirv, &logger, &spvOpt);
   if (spirv.empty()) {
     res = logger.getAllMessages();
-    glslang::FinalizeProcess();
     return false;
   }
   auto compiler = std::make_unique<spirv_cross::CompilerGLSL>(spirv);
@@ -923,7 +1939,6 @@ bool RenderContextOpenGL::ProcessShader(ShaderType type, const std::string& sour
   compiler->set_common_options(cmpOpts);
   auto result = compiler->compile();
   res = result;
-  glslang::FinalizeProcess();
   return true;
 }
 
@@ -976,9 +1991,14 @@ void RenderContextOpenGL::DrawElements(PrimitiveMode mode, int count, IndexDataT
   HIKARI_CHECK_GL(glDrawElements(MapPrimitiveMode(mode), count, MapIndexDataType(type), (void*)first));
 }
 
-void RenderContextOpenGL::SubmitGlobalUnifroms() const {
-  for (const auto& block : _globalBlocks) {
+void RenderContextOpenGL::SubmitGlobalUnifroms() {
+  for (auto& block : _globalBlocks) {
+    //已经注销、只在CPU端登记过或者数据没变的块都不需要上传
+    if (block.RefCount <= 0 || block.Ubo == nullptr || !block.IsDirty) {
+      continue;
+    }
     block.Ubo->UpdateData(0, block.Block.DataSize, block.Data.data());
+    block.IsDirty = false;
   }
 }
 
@@ -987,12 +2007,7 @@ void RenderContextOpenGL::SetGlobalUniformData(const std::string& name,
                                                int length,
                                                int align,
                                                const void* data) {
-  auto iter = _globalUniforms.find(name);
-  if (iter == _globalUniforms.end()) {
-    return;
-  }
-  const auto& uniform = iter->second;
-  SetGlobalUniformData(uniform, dataSize, length, align, data);
+  SetGlobalUniform(name, dataSize, length, align, data);
 }
 
 void RenderContextOpenGL::SetGlobalUniformData(const GlobalUniform& uniform,
@@ -1016,7 +2031,11 @@ void RenderContextOpenGL::SetGlobalUniformData(const GlobalUniform& uniform,
   auto& block = _globalBlocks[uniform.BlockHandle];
   auto head = reinterpret_cast<const std::uint8_t*>(data);
   auto target = block.Data.begin() + uniform.Info.Offset;
-  std::copy(head, head + allSize, target);
+  //每帧都会重新写入全局数据，内容不变时不标记，不用重新上传
+  if (!std::equal(head, head + allSize, target)) {
+    std::copy(head, head + allSize, target);
+    block.IsDirty = true;
+  }
 }
 
 void RenderContextOpenGL::SetGlobalUniform(const std::string& name,
@@ -1024,12 +2043,21 @@ void RenderContextOpenGL::SetGlobalUniform(const std::string& name,
                                            int length,
                                            int align,
                                            const void* data) {
-  auto iter = _globalUniforms.find(name);
-  if (iter == _globalUniforms.end()) {
-    return;
+  if (length < 0) {
+    throw RenderContextException("out of range");
+  }
+  auto head = reinterpret_cast<const uint8_t*>(data);
+  auto& value = _globalValues[name];
+  value.DataSize = dataSize;
+  value.Length = length;
+  value.Align = align;
+  value.Data.assign(head, head + (length > 1 ? size_t(align) * size_t(length) : dataSize * size_t(length)));
+  //当前变体的数组可能比数据短（更长的变体还没编译好），总是截断到布局的长度
+  auto [begin, end] = _globalUniforms.equal_range(name);
+  for (auto iter = begin; iter != end; ++iter) {
+    const auto& uniform = iter->second;
+    SetGlobalUniformData(uniform, dataSize, std::min(length, uniform.Info.Length), align, data);
   }
-  const auto& uniform = iter->second;
-  SetGlobalUniformData(uniform, dataSize, length, align, data);
   //auto& block = _globalBlocks[uniform.BlockHandle];
   //block.Ubo->UpdateData(uniform.Info.Offset, int(dataSize * length), data);
 }
@@ -1052,6 +2080,16 @@ void RenderContextOpenGL::SetGlobalMat4Array(const std::string& name, const void
 void RenderContextOpenGL::SetGlobalVec3Array(const std::string& name, const void* value, int length) { SetGlobalUniform(name, sizeof(Vector3f), length, 16, value); }
 void RenderContextOpenGL::SetGlobalTex2dArray(const std::string& name, const void* tex2d, int length) { SetGlobalUniform(name, sizeof(GLuint), length, 4, tex2d); }
 void RenderContextOpenGL::SetGlobalCubeMapArray(const std::string& name, const void* cubemap, int length) { SetGlobalUniform(name, sizeof(GLuint), length, 4, cubemap); }
+void RenderContextOpenGL::SetGlobalIrradianceSH9(const IrradianceSH9& sh) {
+  struct alignas(16) Vec3Align16 {
+    Vector3f Data;
+  };
+  Vec3Align16 data[9];
+  for (size_t i = 0; i < 9; i++) {
+    data[i].Data = sh.Coefficients[i];
+  }
+  SetGlobalVec3Array(UNIFORM_IRRADIANCE_SH, data, 9);
+}
 
 void RenderContextOpenGL::CheckInit() const {
 #if !defined(NDEBUG)
@@ -1068,9 +2106,9 @@ void RenderContextOpenGL::AddObjectToSet(const std::shared_ptr<ObjectOpenGL>& ob
   }
 }
 
-std::vector<VertexPNT> GenVboDataPNT(const std::vector<Vector3f>& pos,
-                                     const std::vector<Vector3f>& normal,
-                                     const std::vector<Vector2f>& tex) {
+std::vector<VertexPNT> GenVboDataPNT(ArrayView<Vector3f> pos,
+                                     ArrayView<Vector3f> normal,
+                                     ArrayView<Vector2f> tex) {
   std::vector<VertexPNT> pnt(pos.size(), VertexPNT{});
   for (size_t i = 0; i < pos.size(); i++) {
     auto p = pos[i];
@@ -1081,10 +2119,10 @@ std::vector<VertexPNT> GenVboDataPNT(const std::vector<Vector3f>& pos,
   return pnt;
 }
 
-std::vector<VertexPNT> GenVboDataPNT(const std::vector<Vector3f>& pos,
-                                     const std::vector<Vector3f>& normal,
-                                     const std::vector<Vector2f>& tex,
-                                     const std::vector<size_t>& idx) {
+std::vector<VertexPNT> GenVboDataPNT(ArrayView<Vector3f> pos,
+                                     ArrayView<Vector3f> normal,
+                                     ArrayView<Vector2f> tex,
+                                     IndexArrayView idx) {
   std::vector<VertexPNT> pnt(idx.size(), VertexPNT{});
   for (size_t i = 0; i < idx.size(); i++) {
     auto p = pos[idx[i]];
@@ -1095,10 +2133,110 @@ std::vector<VertexPNT> GenVboDataPNT(const std::vector<Vector3f>& pos,
   return pnt;
 }
 
-std::vector<VertexPTNT> GenVboDataPTNT(const std::vector<Vector3f>& pos,
-                                       const std::vector<Vector4f>& tan,
-                                       const std::vector<Vector3f>& normal,
-                                       const std::vector<Vector2f>& tex) {
+TexCoordEncoding ChooseTexCoordEncoding(ArrayView<Vector2f> tex) {
+  for (const auto& t : tex) {
+    if (!(t.X() >= 0 && t.X() <= 1 && t.Y() >= 0 && t.Y() <= 1)) {
+      return TexCoordEncoding::Half;
+    }
+  }
+  return TexCoordEncoding::UNorm16;
+}
+
+static void EncodeNormal(ArrayView<Vector3f> normal, size_t i, int16_t* out) {
+  auto e = EncodeOctahedral(normal.size() > 0 ? normal[i] : Vector3f(0.0f));
+  out[0] = FloatToSnorm16(e.X());
+  out[1] = FloatToSnorm16(e.Y());
+}
+
+static void EncodeTangent(ArrayView<Vector4f> tan, size_t i, int16_t* out) {
+  auto t = tan.size() > 0 ? tan[i] : Vector4f(0.0f);
+  auto e = EncodeOctahedral(Vector3f{t.X(), t.Y(), t.Z()});
+  out[0] = FloatToSnorm16(e.X());
+  out[1] = FloatToSnorm16(e.Y());
+  out[2] = t.W() < 0 ? -32767 : 32767;
+  out[3] = 0;
+}
+
+static void EncodeTexCoord(ArrayView<Vector2f> tex, size_t i, TexCoordEncoding encoding, uint16_t* out) {
+  auto t = tex.size() > 0 ? tex[i] : Vector2f(0.0f);
+  if (encoding == TexCoordEncoding::Half) {
+    out[0] = FloatToHalf(t.X());
+    out[1] = FloatToHalf(t.Y());
+  } else {
+    out[0] = FloatToUnorm16(t.X());
+    out[1] = FloatToUnorm16(t.Y());
+  }
+}
+
+static void EncodePosition(const Vector3f& p, const PositionQuantization& quant, uint16_t* out) {
+  for (size_t k = 0; k < 3; k++) {
+    out[k] = FloatToUnorm16((p[k] - quant.Offset[k]) / quant.Scale[k]);
+  }
+  out[3] = 0;
+}
+
+std::vector<VertexPNTC> GenVboDataPNTC(ArrayView<Vector3f> pos,
+                                       ArrayView<Vector3f> normal,
+                                       ArrayView<Vector2f> tex,
+                                       TexCoordEncoding encoding) {
+  std::vector<VertexPNTC> pnt(pos.size(), VertexPNTC{});
+  for (size_t i = 0; i < pos.size(); i++) {
+    pnt[i].Position = pos[i];
+    EncodeNormal(normal, i, pnt[i].Normal);
+    EncodeTexCoord(tex, i, encoding, pnt[i].TexCoord);
+  }
+  return pnt;
+}
+
+std::vector<VertexPNTQ> GenVboDataPNTQ(ArrayView<Vector3f> pos,
+                                       ArrayView<Vector3f> normal,
+                                       ArrayView<Vector2f> tex,
+                                       const PositionQuantization& quant,
+                                       TexCoordEncoding encoding) {
+  std::vector<VertexPNTQ> pnt(pos.size(), VertexPNTQ{});
+  for (size_t i = 0; i < pos.size(); i++) {
+    EncodePosition(pos[i], quant, pnt[i].Position);
+    EncodeNormal(normal, i, pnt[i].Normal);
+    EncodeTexCoord(tex, i, encoding, pnt[i].TexCoord);
+  }
+  return pnt;
+}
+
+std::vector<VertexPTNTC> GenVboDataPTNTC(ArrayView<Vector3f> pos,
+                                         ArrayView<Vector4f> tan,
+                                         ArrayView<Vector3f> normal,
+                                         ArrayView<Vector2f> tex,
+                                         TexCoordEncoding encoding) {
+  std::vector<VertexPTNTC> ptnt(pos.size(), VertexPTNTC{});
+  for (size_t i = 0; i < pos.size(); i++) {
+    ptnt[i].Position = pos[i];
+    EncodeTangent(tan, i, ptnt[i].Tangent);
+    EncodeNormal(normal, i, ptnt[i].Normal);
+    EncodeTexCoord(tex, i, encoding, ptnt[i].TexCoord);
+  }
+  return ptnt;
+}
+
+std::vector<VertexPTNTQ> GenVboDataPTNTQ(ArrayView<Vector3f> pos,
+                                         ArrayView<Vector4f> tan,
+                                         ArrayView<Vector3f> normal,
+                                         ArrayView<Vector2f> tex,
+                                         const PositionQuantization& quant,
+                                         TexCoordEncoding encoding) {
+  std::vector<VertexPTNTQ> ptnt(pos.size(), VertexPTNTQ{});
+  for (size_t i = 0; i < pos.size(); i++) {
+    EncodePosition(pos[i], quant, ptnt[i].Position);
+    EncodeTangent(tan, i, ptnt[i].Tangent);
+    EncodeNormal(normal, i, ptnt[i].Normal);
+    EncodeTexCoord(tex, i, encoding, ptnt[i].TexCoord);
+  }
+  return ptnt;
+}
+
+std::vector<VertexPTNT> GenVboDataPTNT(ArrayView<Vector3f> pos,
+                                       ArrayView<Vector4f> tan,
+                                       ArrayView<Vector3f> normal,
+                                       ArrayView<Vector2f> tex) {
   std::vector<VertexPTNT> pnt(pos.size(), VertexPTNT{});
   for (size_t i = 0; i < pos.size(); i++) {
     auto p = pos[i];
@@ -1110,11 +2248,11 @@ std::vector<VertexPTNT> GenVboDataPTNT(const std::vector<Vector3f>& pos,
   return pnt;
 }
 
-std::vector<VertexPTNT> GenVboDataPTNT(const std::vector<Vector3f>& pos,
-                                       const std::vector<Vector4f>& tan,
-                                       const std::vector<Vector3f>& normal,
-                                       const std::vector<Vector2f>& tex,
-                                       const std::vector<size_t>& idx) {
+std::vector<VertexPTNT> GenVboDataPTNT(ArrayView<Vector3f> pos,
+                                       ArrayView<Vector4f> tan,
+                                       ArrayView<Vector3f> normal,
+                                       ArrayView<Vector2f> tex,
+                                       IndexArrayView idx) {
   std::vector<VertexPTNT> pnt(idx.size(), VertexPTNT{});
   for (size_t i = 0; i < idx.size(); i++) {
     auto p = pos[idx[i]];
@@ -0,0 +1,180 @@
+#include <hikari/shader_variant.h>
+
+#include <iostream>
+#include <chrono>
+
+#include <hikari/parallel.h>
+
+namespace Hikari {
+ShaderVariantBackend ShaderVariantBackend::Default() {
+  ShaderVariantBackend backend;
+  backend.Preprocess = [](RenderContextOpenGL& ctx, const ShaderProgramRequest& request, std::string& vs, std::string& fs) {
+    ctx.PreprocessShaderProgram(request, vs, fs);
+  };
+  backend.Submit = [](RenderContextOpenGL& ctx, const std::string& vs, const std::string& fs, const ShaderAttributeLayouts& layouts) {
+    return ctx.SubmitShaderProgram(vs, fs, layouts);
+  };
+  backend.Poll = [](RenderContextOpenGL& ctx, ShaderProgramTask& task) { return ctx.PollShaderProgram(task); };
+  backend.Wait = [](RenderContextOpenGL& ctx, ShaderProgramTask& task) { ctx.WaitShaderProgram(task); };
+  return backend;
+}
+
+ShaderPermutation::ShaderPermutation(const ShaderProgramRequest& base,
+                                     const std::vector<ShaderKeywordAxis>& axes,
+                                     ShaderVariantBackend backend)
+    : _base(base), _axes(axes), _backend(std::move(backend)) {}
+
+ShaderPermutation::~ShaderPermutation() noexcept {
+  //后台任务引用着上下文，析构前等它们结束
+  for (auto& [_, variant] : _variants) {
+    if (variant.Pending.valid()) {
+      variant.Pending.wait();
+    }
+  }
+}
+
+const ShaderProgramRequest& ShaderPermutation::GetRequest() const { return _base; }
+
+const std::vector<ShaderKeywordAxis>& ShaderPermutation::GetAxes() const { return _axes; }
+
+std::vector<std::string> ShaderPermutation::SelectValues(const std::unordered_map<std::string, std::string>& keywords) const {
+  std::vector<std::string> values;
+  values.reserve(_axes.size());
+  for (const auto& axis : _axes) {
+    auto iter = keywords.find(axis.Name);
+    values.emplace_back(iter == keywords.end() ? axis.DefaultValue : iter->second);
+  }
+  return values;
+}
+
+void ShaderPermutation::Prepare(RenderContextOpenGL& ctx, const std::vector<std::string>& values) {
+  GetVariant(ctx, values);
+}
+
+void ShaderPermutation::Submit(RenderContextOpenGL& ctx, const std::vector<std::string>& values) {
+  auto& variant = GetVariant(ctx, values);
+  if (variant.Pending.valid()) {
+    SubmitVariant(ctx, variant);
+  }
+}
+
+std::shared_ptr<ProgramOpenGL> ShaderPermutation::Get(RenderContextOpenGL& ctx, const std::vector<std::string>& values) {
+  auto& variant = GetVariant(ctx, values);
+  if (_fallback == nullptr) {
+    WaitVariant(ctx, variant);
+  }
+  if (variant.Stats.IsReady) {
+    _fallback = variant.Program;
+  }
+  if (_fallback == nullptr) {
+    throw RenderContextException("can't compile shader variant " + MakeKey(values));
+  }
+  return _fallback;
+}
+
+void ShaderPermutation::Update(RenderContextOpenGL& ctx, int maxCount) {
+  int count = 0;
+  for (auto& [_, variant] : _variants) {
+    if (count < maxCount && variant.Pending.valid() &&
+        variant.Pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+      SubmitVariant(ctx, variant);
+      count++;
+    }
+    if (variant.Task != nullptr && _backend.Poll(ctx, *variant.Task)) {
+      CompleteVariant(variant);
+    }
+  }
+}
+
+bool ShaderPermutation::IsCompiling() const {
+  for (const auto& [_, variant] : _variants) {
+    if (variant.Pending.valid() || variant.Task != nullptr) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<ShaderVariantStats> ShaderPermutation::GetStats() const {
+  std::vector<ShaderVariantStats> stats;
+  stats.reserve(_variants.size());
+  for (const auto& [_, variant] : _variants) {
+    stats.emplace_back(variant.Stats);
+  }
+  return stats;
+}
+
+std::string ShaderPermutation::MakeKey(const std::vector<std::string>& values) const {
+  std::string key;
+  for (size_t i = 0; i < values.size(); i++) {
+    key += (i == 0 ? "" : " ") + (i < _axes.size() ? _axes[i].Name : std::string()) + "=" + values[i];
+  }
+  return key;
+}
+
+ShaderPermutation::Variant& ShaderPermutation::GetVariant(RenderContextOpenGL& ctx, const std::vector<std::string>& values) {
+  if (values.size() != _axes.size()) {
+    throw RenderContextException("keyword count mismatch");
+  }
+  auto [iter, isNew] = _variants.try_emplace(MakeKey(values));
+  auto& variant = iter->second;
+  if (!isNew) {
+    return variant;
+  }
+  variant.Stats.Values = values;
+  ShaderProgramRequest request = _base;
+  for (size_t i = 0; i < _axes.size(); i++) {
+    request.Macros.emplace_back("#define " + _axes[i].Name + " " + values[i]);
+  }
+  auto context = &ctx;
+  variant.Pending = ThreadPool::GetGlobal().Submit([context, preprocess = _backend.Preprocess, request = std::move(request)]() {
+    auto start = std::chrono::high_resolution_clock::now();
+    Preprocessed result;
+    preprocess(*context, request, result.Vs, result.Fs);
+    result.Time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return result;
+  });
+  return variant;
+}
+
+void ShaderPermutation::SubmitVariant(RenderContextOpenGL& ctx, Variant& variant) {
+  try {
+    auto preprocessed = variant.Pending.get();
+    variant.Stats.PreprocessTime = preprocessed.Time;
+    variant.SubmitTime = std::chrono::high_resolution_clock::now();
+    variant.Task = _backend.Submit(ctx, preprocessed.Vs, preprocessed.Fs, _base.Layouts);
+  } catch (std::exception& e) {
+    //失败的变体不再重试，继续使用回退变体
+    variant.Stats.IsFailed = true;
+    std::cerr << "preprocess shader variant " << _base.FsPath << " [" << MakeKey(variant.Stats.Values) << "] failed: "
+              << e.what() << std::endl;
+  }
+}
+
+void ShaderPermutation::CompleteVariant(Variant& variant) {
+  variant.Stats.CompileTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - variant.SubmitTime).count();
+  if (variant.Task->GetProgram() == nullptr) {
+    variant.Stats.IsFailed = true;
+    std::cerr << "compile shader variant " << _base.FsPath << " [" << MakeKey(variant.Stats.Values) << "] failed" << std::endl;
+  } else {
+    variant.Program = variant.Task->GetProgram();
+    variant.Stats.IsReady = true;
+  }
+  variant.Task = nullptr;
+}
+
+void ShaderPermutation::WaitVariant(RenderContextOpenGL& ctx, Variant& variant) {
+  if (variant.Pending.valid()) {
+    SubmitVariant(ctx, variant);
+  }
+  if (variant.Task != nullptr) {
+    try {
+      _backend.Wait(ctx, *variant.Task);
+    } catch (std::exception&) {
+      //失败由 CompleteVariant 记录
+    }
+    CompleteVariant(variant);
+  }
+}
+
+}  // namespace Hikari
@@ -0,0 +1,146 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+
+#include <hikari/asset_manager.h>
+
+using namespace std;
+using namespace Hikari;
+
+static void WriteObj(const filesystem::path& path, int quadCount) {
+  ofstream obj(path);
+  for (int i = 0; i < quadCount; i++) {
+    obj << "v " << i << " 0 0\nv " << i + 1 << " 0 0\nv " << i + 1 << " 1 0\nv " << i << " 1 0\n";
+  }
+  obj << "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n";
+  obj << "vn 0 0 1\n";
+  for (int i = 0; i < quadCount; i++) {
+    int b = i * 4;
+    obj << "f " << b + 1 << "/1/1 " << b + 2 << "/2/1 " << b + 3 << "/3/1\n";
+    obj << "f " << b + 1 << "/1/1 " << b + 3 << "/3/1 " << b + 4 << "/4/1\n";
+  }
+}
+
+int main(int argc, char** argv) {
+  auto root = filesystem::temp_directory_path() / "hikari_test_asset_manager";
+  filesystem::remove_all(root);
+  filesystem::create_directories(root / "sub");
+  SetCacheDirectory(root / "cache");
+  ModelImportOptions noCache;
+  noCache.UseCache = false;
+  constexpr int modelCount = 8;
+  for (int i = 0; i < modelCount; i++) {
+    WriteObj(root / (to_string(i) + ".obj"), i + 1);
+  }
+
+  AssetManager manager(4);
+  AssetHandle<ImmutableModel> handles[modelCount];
+  for (int i = 0; i < modelCount; i++) {
+    handles[i] = manager.RequestModel(to_string(i), root / (to_string(i) + ".obj"), noCache);
+  }
+  //同一个文件的不同写法只加载一次，句柄指向同一个实例
+  auto same = manager.RequestModel("other name", root / "sub" / ".." / "3.obj", noCache);
+  if (manager.GetRequestCount() != modelCount) { return -1; }
+  if (same.Get() != handles[3].Get()) { return -1; }
+  if (same.Get()->GetName() != "3") { return -1; }
+  manager.WaitAll();
+  size_t sizes[modelCount];
+  size_t total = 0;
+  for (int i = 0; i < modelCount; i++) {
+    if (!handles[i].IsReady()) { return -1; }
+    auto model = handles[i].Get();
+    if (!model->IsValid() || model->GetTriangleCount() != size_t(2 * (i + 1))) { return -1; }
+    sizes[i] = model->GetByteSize();
+    total += sizes[i];
+  }
+  auto stats = manager.GetMemoryStats();
+  if (stats.Usage != total || stats.Peak != total || stats.ResidentCount != modelCount) { return -1; }
+
+  //按最近最少使用淘汰，固定的资源保留。上面按0到7的顺序访问过，0最久未使用
+  handles[7].Pin();
+  manager.SetMemoryBudget(sizes[6] + sizes[7]);
+  stats = manager.GetMemoryStats();
+  if (stats.Usage != sizes[6] + sizes[7] || stats.ResidentCount != 2 || stats.EvictCount != 6) { return -1; }
+  if (handles[0].IsReady() || !handles[6].IsReady() || !handles[7].IsReady()) { return -1; }
+  //淘汰后再次访问透明地重新加载，新加载的资源挤掉没有固定的6
+  auto reloaded = handles[0].Get();
+  if (!reloaded->IsValid() || reloaded->GetTriangleCount() != 2) { return -1; }
+  stats = manager.GetMemoryStats();
+  if (stats.ReloadCount != 1 || stats.Usage != sizes[0] + sizes[7]) { return -1; }
+  if (handles[6].IsReady() || !handles[7].IsReady()) { return -1; }
+  //外部还持有的资源淘汰了也省不下内存，不会被淘汰
+  handles[7].Unpin();
+  manager.SetMemoryBudget(1);
+  stats = manager.GetMemoryStats();
+  if (stats.ResidentCount != 1 || stats.Usage != sizes[0] || !handles[0].IsReady()) { return -1; }
+  reloaded = nullptr;
+  manager.SetMemoryBudget(1);
+  if (manager.GetMemoryStats().Usage != 0 || manager.GetMemoryStats().Peak != total) { return -1; }
+  manager.SetMemoryBudget(0);
+
+  //加载失败时在 Get 上抛出异常
+  auto missing = manager.RequestModel("missing", root / "missing.obj", noCache);
+  auto missingBitmap = manager.RequestBitmap("missing", root / "missing.png", true);
+  bool isThrown = false;
+  try {
+    missing.Get();
+  } catch (const AssetLoadException&) {
+    isThrown = true;
+  }
+  if (!isThrown) { return -1; }
+  isThrown = false;
+  try {
+    missingBitmap.Get();
+  } catch (const AssetLoadException&) {
+    isThrown = true;
+  }
+  if (!isThrown) { return -1; }
+
+  //清空后句柄仍然可用，外部持有的实例不受影响，下次访问得到新的实例
+  auto old = handles[0].Get();
+  auto evictBeforeClear = manager.GetMemoryStats().EvictCount;
+  manager.Clear();
+  if (handles[0].IsReady() || old->GetTriangleCount() != 2) { return -1; }
+  if (manager.GetMemoryStats().EvictCount != evictBeforeClear || manager.GetMemoryStats().ResidentCount != 0) { return -1; }
+  if (handles[0].Get() == old || handles[0].Get()->GetTriangleCount() != 2) { return -1; }
+
+  //导入选项不同时是另一个资源；内存上限不同决定能否导入成功，也是另一个资源
+  {
+    auto requestCount = manager.GetRequestCount();
+    ModelImportOptions streaming = noCache;
+    streaming.Importer = ModelImporter::Streaming;
+    auto other = manager.RequestModel("3", root / "3.obj", streaming);
+    if (manager.GetRequestCount() != requestCount + 1 || other.Get() == handles[3].Get()) { return -1; }
+    if (other.Get()->GetTriangleCount() != handles[3].Get()->GetTriangleCount()) { return -1; }
+    streaming.MemoryLimit = 1;
+    auto limited = manager.RequestModel("3", root / "3.obj", streaming);
+    if (manager.GetRequestCount() != requestCount + 2) { return -1; }
+    isThrown = false;
+    try {
+      limited.Get();
+    } catch (const AssetLoadException&) {
+      isThrown = true;
+    }
+    if (!isThrown) { return -1; }
+  }
+
+  //预算连一个资源都放不下时，加载完还没取走的资源也不会被挤掉，不会重复解码
+  {
+    AssetManager tight(2);
+    tight.SetMemoryBudget(1);
+    auto a = tight.RequestModel("a", root / "5.obj", noCache);
+    auto b = tight.RequestModel("b", root / "6.obj", noCache);
+    tight.WaitAll();
+    if (!a.IsReady() || !b.IsReady()) { return -1; }
+    if (!a.Get()->IsValid() || !b.Get()->IsValid()) { return -1; }
+    if (tight.GetMemoryStats().ReloadCount != 0 || tight.GetMemoryStats().EvictCount != 0) { return -1; }
+    //取走以后恢复正常淘汰
+    tight.SetMemoryBudget(1);
+    if (tight.GetMemoryStats().ResidentCount != 0 || tight.GetMemoryStats().EvictCount != 2) { return -1; }
+  }
+
+  filesystem::remove_all(root);
+  cout << "passed test" << endl;
+  return 0;
+}
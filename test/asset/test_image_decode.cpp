@@ -0,0 +1,197 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <array>
+#include <cmath>
+
+#include <hikari/asset.h>
+#include <hikari/quantize.h>
+
+using namespace std;
+using namespace Hikari;
+
+static uint8_t Pixel(int x, int y, int c, int face) { return uint8_t((x * 7 + y * 31 + c * 3 + face * 50) & 0xff); }
+
+//二进制PPM，stb_image默认支持
+static void WritePpm(const filesystem::path& path, int width, int height, int face) {
+  ofstream ppm(path, ios::binary);
+  ppm << "P6\n" << width << " " << height << "\n255\n";
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      for (int c = 0; c < 3; c++) {
+        ppm.put(char(Pixel(x, y, c, face)));
+      }
+    }
+  }
+}
+
+static void Rgbe(int x, int y, uint8_t* rgbe) {
+  rgbe[0] = uint8_t(128 + (x * 5 + y) % 128);
+  rgbe[1] = uint8_t((x / 3) * 40 % 256);  //连续相同的值，会被编码为游程
+  rgbe[2] = uint8_t(x * 11 + y * 3);
+  rgbe[3] = uint8_t(120 + (x + y) % 16);
+}
+
+//Radiance HDR，宽度不小于8时每个分量按游程或字面量交替编码
+static void WriteHdr(const filesystem::path& path, int width, int height) {
+  ofstream hdr(path, ios::binary);
+  hdr << "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " << height << " +X " << width << "\n";
+  vector<uint8_t> line(size_t(width) * 4);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      Rgbe(x, y, &line[size_t(x) * 4]);
+    }
+    if (width < 8) {
+      hdr.write((const char*)line.data(), line.size());
+      continue;
+    }
+    hdr.put(2).put(2).put(char(width >> 8)).put(char(width & 0xff));
+    for (int k = 0; k < 4; k++) {
+      int x = 0;
+      while (x < width) {
+        int run = 1;
+        while (x + run < width && run < 127 && line[size_t(x + run) * 4 + k] == line[size_t(x) * 4 + k]) {
+          run++;
+        }
+        if (run > 1) {
+          hdr.put(char(128 + run)).put(char(line[size_t(x) * 4 + k]));
+        } else {
+          hdr.put(1).put(char(line[size_t(x) * 4 + k]));
+        }
+        x += run;
+      }
+    }
+  }
+}
+
+static bool CheckHdr(const ImmutableHdrTexture& hdr, int width, int height, bool isFlipY) {
+  if (!hdr.IsValid() || hdr.GetWidth() != width || hdr.GetHeight() != height || hdr.GetData() != nullptr) {
+    return false;
+  }
+  for (int y = 0; y < height; y++) {
+    int srcY = isFlipY ? height - 1 - y : y;
+    for (int x = 0; x < width; x++) {
+      uint8_t rgbe[4];
+      Rgbe(x, srcY, rgbe);
+      size_t i = size_t(y) * width + x;
+      if (hdr.GetStorage() == HdrStorage::RGB9E5) {
+        if (static_cast<const uint32_t*>(hdr.GetRawData())[i] != RgbeToRgb9e5(rgbe)) {
+          return false;
+        }
+        continue;
+      }
+      auto half = static_cast<const uint16_t*>(hdr.GetRawData()) + i * 3;
+      for (int c = 0; c < 3; c++) {
+        if (half[c] != FloatToHalf(rgbe[c] * std::ldexp(1.0f, rgbe[3] - 136))) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+static bool CheckBitmap(const ImmutableBitmap& bitmap, int width, int height, int face, bool isFlipY) {
+  if (!bitmap.IsValid() || bitmap.GetWidth() != width || bitmap.GetHeight() != height || bitmap.GetChannel() != 3) {
+    return false;
+  }
+  for (int y = 0; y < height; y++) {
+    int srcY = isFlipY ? height - 1 - y : y;
+    for (int x = 0; x < width; x++) {
+      for (int c = 0; c < 3; c++) {
+        if (bitmap.GetData()[(y * width + x) * 3 + c] != Pixel(x, srcY, c, face)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  //行宽不是块大小的整数倍，行数为奇数，覆盖块交换、尾部交换和中间行
+  {
+    const size_t rowBytes = 64 * 3 + 5;
+    const size_t rowCount = 7;
+    vector<uint8_t> image(rowBytes * rowCount);
+    for (size_t i = 0; i < image.size(); i++) {
+      image[i] = uint8_t(i * 13);
+    }
+    auto flipped = image;
+    FlipImageRows(flipped.data(), rowBytes, rowCount);
+    for (size_t y = 0; y < rowCount; y++) {
+      for (size_t x = 0; x < rowBytes; x++) {
+        if (flipped[y * rowBytes + x] != image[(rowCount - 1 - y) * rowBytes + x]) { return -1; }
+      }
+    }
+    FlipImageRows(flipped.data(), rowBytes, rowCount);
+    if (flipped != image) { return -1; }
+  }
+
+  auto root = filesystem::temp_directory_path() / "hikari_test_image_decode";
+  filesystem::remove_all(root);
+  filesystem::create_directories(root);
+  const int width = 37;
+  const int height = 9;
+  array<string, 6> faces{"right.ppm", "left.ppm", "top.ppm", "bottom.ppm", "front.ppm", "back.ppm"};
+  for (int i = 0; i < 6; i++) {
+    WritePpm(root / faces[i], width, height, i);
+  }
+
+  ImmutableBitmap single;
+  if (!ImmutableBitmap::LoadFromDisk("right", root / faces[0], false, single)) { return -1; }
+  if (!CheckBitmap(single, width, height, 0, false)) { return -1; }
+  if (!ImmutableBitmap::LoadFromDisk("right", root / faces[0], true, single)) { return -1; }
+  if (!CheckBitmap(single, width, height, 0, true)) { return -1; }
+
+  //翻转与否交替进行，并行解码时互不影响
+  for (int isFlipY = 0; isFlipY < 2; isFlipY++) {
+    array<ImmutableBitmap, 6> cube;
+    if (!ImmutableBitmap::LoadCubeFaces(root, faces, isFlipY, cube)) { return -1; }
+    for (int i = 0; i < 6; i++) {
+      if (!CheckBitmap(cube[i], width, height, i, isFlipY)) { return -1; }
+      if (cube[i].GetName() != faces[i]) { return -1; }
+    }
+  }
+  vector<string> names{"a", "b", "missing"};
+  vector<filesystem::path> paths{root / faces[0], root / faces[1], root / "missing.ppm"};
+  vector<ImmutableBitmap> batch;
+  if (ImmutableBitmap::LoadFromDiskParallel(names, paths, true, batch)) { return -1; }
+  if (batch.size() != 3 || !CheckBitmap(batch[1], width, height, 1, true) || batch[2].IsValid()) { return -1; }
+
+  //8位图片按浮点读取时stb会做gamma转换，只比较翻转前后的行
+  ImmutableHdrTexture hdr("hdr", root / faces[2], false);
+  ImmutableHdrTexture hdrFlip("hdr", root / faces[2], true);
+  if (hdrFlip.GetWidth() != width || hdrFlip.GetHeight() != height || hdrFlip.GetChannel() != 3) { return -1; }
+  for (int y = 0; y < height; y++) {
+    for (int i = 0; i < width * 3; i++) {
+      if (hdrFlip.GetData()[y * width * 3 + i] != hdr.GetData()[(height - 1 - y) * width * 3 + i]) { return -1; }
+    }
+  }
+
+  //紧凑格式逐行解码Radiance文件，覆盖未压缩（宽度小于8）和游程编码两种扫描线
+  WriteHdr(root / "flat.hdr", 5, 4);
+  WriteHdr(root / "rle.hdr", 300, 7);
+  for (int isFlipY = 0; isFlipY < 2; isFlipY++) {
+    for (auto storage : {HdrStorage::Half, HdrStorage::RGB9E5}) {
+      ImmutableHdrTexture flat("flat", root / "flat.hdr", isFlipY, storage);
+      ImmutableHdrTexture rle("rle", root / "rle.hdr", isFlipY, storage);
+      if (flat.GetStorage() != storage || !CheckHdr(flat, 5, 4, isFlipY) || !CheckHdr(rle, 300, 7, isFlipY)) { return -1; }
+      size_t pixelBytes = storage == HdrStorage::Half ? 6 : 4;
+      if (rle.GetByteSize() != 300 * 7 * pixelBytes) { return -1; }
+    }
+  }
+  //不是Radiance文件时先按float解码再转换
+  ImmutableHdrTexture converted("hdr", root / faces[2], true, HdrStorage::RGB9E5);
+  if (converted.GetStorage() != HdrStorage::RGB9E5 || converted.GetData() != nullptr) { return -1; }
+  for (int i = 0; i < width * height; i++) {
+    const float* p = hdrFlip.GetData() + i * 3;
+    if (static_cast<const uint32_t*>(converted.GetRawData())[i] != FloatToRgb9e5(Vector3f{p[0], p[1], p[2]})) { return -1; }
+  }
+
+  filesystem::remove_all(root);
+  cout << "passed test" << endl;
+  return 0;
+}
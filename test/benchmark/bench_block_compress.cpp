@@ -0,0 +1,54 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include <hikari/image.h>
+
+using namespace std;
+using namespace Hikari;
+
+int main(int argc, char** argv) {
+  int size = argc > 1 ? stoi(argv[1]) : 1024;
+  int repeat = argc > 2 ? stoi(argv[2]) : 3;
+  vector<uint8_t> image(size_t(size) * size * 4);
+  vector<float> hdr(size_t(size) * size * 3);
+  for (size_t i = 0; i < image.size(); i++) {
+    image[i] = uint8_t((i * 2654435761u) >> 24);
+  }
+  for (size_t i = 0; i < hdr.size(); i++) {
+    hdr[i] = float((i * 2654435761u) >> 16) / 4096.0f;
+  }
+  auto root = filesystem::temp_directory_path() / "hikari_bench_block_compress";
+  filesystem::remove_all(root);
+  SetCacheDirectory(root);
+  cout << "image: " << size << "x" << size << "\n";
+  auto measure = [&](const char* name, BlockFormat format, const BlockCompressOptions& options) {
+    bool isHdr = format == BlockFormat::BC6H;
+    double best = 1e30;
+    for (int i = 0; i < repeat; i++) {
+      auto start = chrono::high_resolution_clock::now();
+      auto texture = isHdr ? CompressTexture(hdr.data(), size, size, 3, MipDataType::Float32, format, options)
+                           : CompressTexture(image.data(), size, size, 4, MipDataType::UInt8, format, options);
+      auto end = chrono::high_resolution_clock::now();
+      best = std::min(best, chrono::duration<double, milli>(end - start).count());
+    }
+    cout << name << best << " ms\n";
+  };
+  BlockCompressOptions options;
+  options.UseCache = false;
+  options.GenerateMips = false;
+  measure("bc1: ", BlockFormat::BC1, options);
+  measure("bc3: ", BlockFormat::BC3, options);
+  measure("bc4: ", BlockFormat::BC4, options);
+  measure("bc5: ", BlockFormat::BC5, options);
+  measure("bc6h: ", BlockFormat::BC6H, options);
+  options.GenerateMips = true;
+  measure("bc1 with mips: ", BlockFormat::BC1, options);
+  //第一次写入缓存，之后都是命中
+  options.UseCache = true;
+  measure("bc1 with mips cached: ", BlockFormat::BC1, options);
+  filesystem::remove_all(root);
+  return 0;
+}
@@ -0,0 +1,36 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <filesystem>
+
+#include <hikari/image.h>
+
+using namespace std;
+using namespace Hikari;
+
+int main(int argc, char** argv) {
+  int maxSize = argc > 1 ? stoi(argv[1]) : 256;
+  int sampleCount = argc > 2 ? stoi(argv[2]) : 2048;
+  auto root = filesystem::temp_directory_path() / "hikari_bench_brdf_lut";
+  filesystem::remove_all(root);
+  SetCacheDirectory(root);
+  cout << "samples: " << sampleCount << "\n";
+  auto measure = [&](const char* name, BrdfLutType type, int size, bool useCache) {
+    BrdfLutOptions options;
+    options.SampleCount = sampleCount;
+    options.UseCache = useCache;
+    auto start = chrono::high_resolution_clock::now();
+    auto lut = BakeBrdfLut(type, size, size, options);
+    auto end = chrono::high_resolution_clock::now();
+    cout << name << size << "x" << size << ": " << chrono::duration<double, milli>(end - start).count() << " ms\n";
+  };
+  for (int size = 32; size <= maxSize; size *= 2) {
+    measure("split sum ", BrdfLutType::SplitSum, size, false);
+    measure("multi scattering ", BrdfLutType::MultiScattering, size, false);
+  }
+  //第一次写入缓存，第二次命中
+  measure("multi scattering bake and save ", BrdfLutType::MultiScattering, maxSize, true);
+  measure("multi scattering cached ", BrdfLutType::MultiScattering, maxSize, true);
+  filesystem::remove_all(root);
+  return 0;
+}
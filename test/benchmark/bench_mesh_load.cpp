@@ -0,0 +1,96 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <functional>
+#include <string>
+
+#include <hikari/asset.h>
+#include <hikari/parallel.h>
+
+using namespace std;
+using namespace Hikari;
+
+//生成 n*n 个顶点的网格
+static void WriteGridObj(const filesystem::path& path, int n) {
+  ofstream obj(path);
+  for (int y = 0; y < n; y++) {
+    for (int x = 0; x < n; x++) {
+      obj << "v " << x << " " << y << " " << ((x * 7 + y * 13) % 5) * 0.1f << "\n";
+      obj << "vt " << (float)x / (n - 1) << " " << (float)y / (n - 1) << "\n";
+    }
+  }
+  obj << "vn 0 0 1\n";
+  for (int y = 0; y + 1 < n; y++) {
+    for (int x = 0; x + 1 < n; x++) {
+      int a = y * n + x + 1;
+      int b = a + 1;
+      int c = a + n;
+      int d = c + 1;
+      obj << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 " << d << "/" << d << "/1\n";
+      obj << "f " << a << "/" << a << "/1 " << d << "/" << d << "/1 " << c << "/" << c << "/1\n";
+    }
+  }
+}
+
+static double Measure(const function<void()>& func, int count) {
+  auto start = chrono::high_resolution_clock::now();
+  for (int i = 0; i < count; i++) {
+    func();
+  }
+  auto end = chrono::high_resolution_clock::now();
+  return chrono::duration<double, milli>(end - start).count() / count;
+}
+
+int main(int argc, char** argv) {
+  int n = argc > 1 ? stoi(argv[1]) : 512;
+  int count = argc > 2 ? stoi(argv[2]) : 5;
+  auto root = filesystem::temp_directory_path() / "hikari_bench_mesh_load";
+  filesystem::remove_all(root);
+  filesystem::create_directories(root);
+  SetCacheDirectory(root / "cache");
+  auto objPath = root / "grid.obj";
+  WriteGridObj(objPath, n);
+  cout << "obj: " << filesystem::file_size(objPath) / 1024 << " KiB, " << 2 * (n - 1) * (n - 1) << " triangles\n";
+
+  ModelImportOptions noCache;
+  noCache.UseCache = false;
+  noCache.Importer = ModelImporter::TinyObj;
+  ModelImportOptions parallel;
+  parallel.UseCache = false;
+  parallel.Importer = ModelImporter::Parallel;
+  auto loadObj = [&]() {
+    ImmutableModel model;
+    ImmutableModel::LoadFromFile("grid", objPath, model, noCache);
+  };
+  auto loadParallel = [&]() {
+    ImmutableModel model;
+    ImmutableModel::LoadFromFile("grid", objPath, model, parallel);
+  };
+  ModelImportStats stats;
+  ModelImportOptions streaming;
+  streaming.UseCache = false;
+  streaming.Importer = ModelImporter::Streaming;
+  streaming.Stats = &stats;
+  auto loadStreaming = [&]() {
+    ImmutableModel model;
+    ImmutableModel::LoadFromFile("grid", objPath, model, streaming);
+  };
+  auto loadCached = [&]() {
+    ImmutableModel model;
+    ImmutableModel::LoadFromFile("grid", objPath, model);
+  };
+  auto parse = Measure(loadObj, count);
+  auto parseParallel = Measure(loadParallel, count);
+  auto parseStreaming = Measure(loadStreaming, count);
+  auto write = Measure(loadCached, 1);
+  auto mapped = Measure(loadCached, count);
+  cout << "threads:              " << ThreadPool::GetGlobal().GetThreadCount() << "\n";
+  cout << "parse obj (tinyobj):  " << parse << " ms\n";
+  cout << "parse obj (parallel): " << parseParallel << " ms\n";
+  cout << "parse obj (stream):   " << parseStreaming << " ms, peak " << stats.PeakMemoryBytes / 1024 << " KiB\n";
+  cout << "parse obj + write:    " << write << " ms\n";
+  cout << "map cache (and hash): " << mapped << " ms\n";
+  filesystem::remove_all(root);
+  return 0;
+}
@@ -0,0 +1,53 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <hikari/mesh.h>
+
+using namespace std;
+using namespace Hikari;
+
+int main(int argc, char** argv) {
+  int slices = argc > 1 ? stoi(argv[1]) : 1024;
+  auto sphere = ImmutableModel::CreateSphere("sphere", 1.0f, slices);
+  cout << "triangles: " << sphere.GetTriangleCount() << "\n";
+
+  auto buildStart = chrono::high_resolution_clock::now();
+  auto data = BuildMeshlets(sphere);
+  auto buildEnd = chrono::high_resolution_clock::now();
+  size_t vertexRefs = data.Vertices.size();
+  cout << "meshlets:         " << data.Meshlets.size() << "\n";
+  cout << "avg vertices:     " << double(vertexRefs) / data.Meshlets.size() << "\n";
+  cout << "avg triangles:    " << double(sphere.GetTriangleCount()) / data.Meshlets.size() << "\n";
+  cout << "build:            " << chrono::duration<double, milli>(buildEnd - buildStart).count() << " ms\n";
+  size_t clusterBytes = data.Meshlets.size() * (sizeof(Meshlet) + sizeof(MeshletBounds)) +
+                        data.Vertices.size() * sizeof(uint32_t) + data.Triangles.size();
+  cout << "cluster data:     " << clusterBytes / 1024 << " KB (flat uint32 indices "
+       << sphere.GetIndexCount() * sizeof(uint32_t) / 1024 << " KB)\n";
+
+  //相机绕球一圈，每帧剔除一次
+  const int frames = 256;
+  auto proj = Perspective<float>(Radian(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+  vector<uint32_t> visible;
+  size_t visibleTriangles = 0;
+  size_t visibleMeshlets = 0;
+  auto cullStart = chrono::high_resolution_clock::now();
+  for (int i = 0; i < frames; i++) {
+    float angle = 2.0f * PI * float(i) / float(frames);
+    Vector3f eye{2.0f * std::sin(angle), 0.5f, 2.0f * std::cos(angle)};
+    Vector3f target{0.3f * std::sin(angle * 3), 0, 0};
+    auto frustum = Frustum::FromMatrix(LookAt(eye, target, Vector3f{0, 1, 0}) * proj);
+    visibleMeshlets += CullMeshlets(data, frustum, eye, visible);
+    for (auto m : visible) {
+      visibleTriangles += data.Meshlets[m].TriangleCount;
+    }
+  }
+  auto cullEnd = chrono::high_resolution_clock::now();
+  auto cullMs = chrono::duration<double, milli>(cullEnd - cullStart).count() / frames;
+  cout << "cull per frame:   " << cullMs << " ms (" << data.Meshlets.size() / cullMs / 1000.0 << " M meshlets/s)\n";
+  cout << "visible meshlets: " << double(visibleMeshlets) / frames / data.Meshlets.size() * 100 << " %\n";
+  cout << "triangles culled: " << 100.0 - double(visibleTriangles) / frames / sphere.GetTriangleCount() * 100 << " %\n";
+  return 0;
+}
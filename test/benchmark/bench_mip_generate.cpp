@@ -0,0 +1,45 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include <hikari/image.h>
+
+using namespace std;
+using namespace Hikari;
+
+int main(int argc, char** argv) {
+  int size = argc > 1 ? stoi(argv[1]) : 2048;
+  int repeat = argc > 2 ? stoi(argv[2]) : 3;
+  vector<uint8_t> image(size_t(size) * size * 4);
+  for (size_t i = 0; i < image.size(); i++) {
+    image[i] = uint8_t((i * 2654435761u) >> 24);
+  }
+  auto root = filesystem::temp_directory_path() / "hikari_bench_mip_generate";
+  filesystem::remove_all(root);
+  SetCacheDirectory(root);
+  cout << "image: " << size << "x" << size << " RGBA8\n";
+  auto measure = [&](const char* name, const MipGenerateOptions& options) {
+    double best = 1e30;
+    for (int i = 0; i < repeat; i++) {
+      auto start = chrono::high_resolution_clock::now();
+      auto chain = GenerateMipChain(image.data(), size, size, 4, MipDataType::UInt8, options);
+      auto end = chrono::high_resolution_clock::now();
+      best = std::min(best, chrono::duration<double, milli>(end - start).count());
+    }
+    cout << name << best << " ms\n";
+  };
+  MipGenerateOptions options;
+  options.UseCache = false;
+  measure("box: ", options);
+  options.IsSrgb = true;
+  measure("box srgb: ", options);
+  options.Filter = MipFilter::Kaiser;
+  measure("kaiser srgb: ", options);
+  //第一次写入缓存，之后都是命中
+  options.UseCache = true;
+  measure("kaiser srgb cached: ", options);
+  filesystem::remove_all(root);
+  return 0;
+}
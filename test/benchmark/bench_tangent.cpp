@@ -0,0 +1,68 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <hikari/mesh.h>
+
+using namespace std;
+using namespace Hikari;
+
+//原来导入时使用的串行实现，逐三角形累加到共享数组
+static vector<Vector4f> SerialTangents(const ImmutableModel& m) {
+  auto idx = m.GetIndices();
+  auto pos = m.GetPosition();
+  auto nor = m.GetNormals();
+  auto tex = m.GetTexCoords();
+  vector<Vector3f> tangent(m.GetVertexCount(), Vector3f{});
+  vector<Vector3f> biTan(m.GetVertexCount(), Vector3f{});
+  vector<Vector4f> result(m.GetVertexCount());
+  for (size_t i = 0; i < idx.size(); i += 3) {
+    auto i0 = idx[i], i1 = idx[i + 1], i2 = idx[i + 2];
+    auto e1 = pos[i1] - pos[i0];
+    auto e2 = pos[i2] - pos[i0];
+    auto x1 = tex[i1].X() - tex[i0].X();
+    auto x2 = tex[i2].X() - tex[i0].X();
+    auto y1 = tex[i1].Y() - tex[i0].Y();
+    auto y2 = tex[i2].Y() - tex[i0].Y();
+    float r = 1.0f / (x1 * y2 - x2 * y1);
+    auto t = (e1 * Vector3f(y2) - e2 * Vector3f(y1)) * Vector3f(r);
+    auto b = (e2 * Vector3f(x1) - e1 * Vector3f(x2)) * Vector3f(r);
+    tangent[i0] += t;
+    tangent[i1] += t;
+    tangent[i2] += t;
+    biTan[i0] += b;
+    biTan[i1] += b;
+    biTan[i2] += b;
+  }
+  for (size_t i = 0; i < result.size(); i++) {
+    auto xyz = Normalize(Reject(tangent[i], nor[i]));
+    auto w = (Dot(Cross(tangent[i], biTan[i]), nor[i]) > 0.0f) ? 1.0f : -1.0f;
+    result[i] = {xyz.X(), xyz.Y(), xyz.Z(), w};
+  }
+  return result;
+}
+
+int main(int argc, char** argv) {
+  int slices = argc > 1 ? stoi(argv[1]) : 1024;
+  int repeat = argc > 2 ? stoi(argv[2]) : 5;
+  auto sphere = ImmutableModel::CreateSphere("sphere", 1.0f, slices);
+  cout << "vertices: " << sphere.GetVertexCount() << ", triangles: " << sphere.GetTriangleCount() << "\n";
+  auto measure = [&](const char* name, auto&& func) {
+    double best = 1e30;
+    for (int i = 0; i < repeat; i++) {
+      auto start = chrono::high_resolution_clock::now();
+      auto result = func();
+      auto end = chrono::high_resolution_clock::now();
+      best = std::min(best, chrono::duration<double, milli>(end - start).count());
+    }
+    cout << name << best << " ms\n";
+    return best;
+  };
+  double serial = measure("serial:   ", [&]() { return SerialTangents(sphere); });
+  double parallel = measure("parallel: ", [&]() {
+    return GenerateTangents(sphere.GetIndices(), sphere.GetPosition(), sphere.GetNormals(), sphere.GetTexCoords());
+  });
+  cout << "speedup:  " << serial / parallel << "x\n";
+  return 0;
+}
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <map>
+#include <cmath>
+#include <string>
+
+#include <tiny_obj_loader.h>
+
+#include <hikari/asset.h>
+
+using namespace std;
+using namespace Hikari;
+
+//生成约 triangleCount 个三角形的网格，位置/纹理坐标/法线分别编号，保证去重有意义
+static void WriteGridObj(const filesystem::path& path, size_t triangleCount) {
+  int n = static_cast<int>(std::sqrt(triangleCount / 2.0)) + 1;
+  ofstream obj(path);
+  for (int y = 0; y < n; y++) {
+    for (int x = 0; x < n; x++) {
+      obj << "v " << x << " " << y << " 0\n";
+      obj << "vt " << (float)x / (n - 1) << " " << (float)y / (n - 1) << "\n";
+    }
+  }
+  obj << "vn 0 0 1\n";
+  for (int y = 0; y + 1 < n; y++) {
+    for (int x = 0; x + 1 < n; x++) {
+      int a = y * n + x + 1;
+      int b = a + 1;
+      int c = a + n;
+      int d = c + 1;
+      obj << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 " << d << "/" << d << "/1\n";
+      obj << "f " << a << "/" << a << "/1 " << d << "/" << d << "/1 " << c << "/" << c << "/1\n";
+    }
+  }
+}
+
+struct MapKey {
+  int p;
+  int n;
+  int t;
+  bool operator<(const MapKey& v) const {
+    if (p != v.p) return p < v.p;
+    if (n != v.n) return n < v.n;
+    return t < v.t;
+  }
+};
+
+int main(int argc, char** argv) {
+  size_t triangleCount = argc > 1 ? stoull(argv[1]) : 5000000;
+  auto root = filesystem::temp_directory_path() / "hikari_bench_vertex_dedup";
+  filesystem::create_directories(root);
+  auto objPath = root / "grid.obj";
+  WriteGridObj(objPath, triangleCount);
+
+  tinyobj::ObjReader reader;
+  if (!reader.ParseFromFile(objPath.string())) {
+    cout << "parse failed\n";
+    return -1;
+  }
+  const auto& shapes = reader.GetShapes();
+  size_t indexCount = 0;
+  for (const auto& shape : shapes) {
+    indexCount += shape.mesh.indices.size();
+  }
+  cout << "triangles: " << indexCount / 3 << "\n";
+
+  //旧实现：std::map
+  vector<size_t> mapIndices;
+  mapIndices.reserve(indexCount);
+  auto mapStart = chrono::high_resolution_clock::now();
+  {
+    map<MapKey, size_t> uni;
+    size_t count = 0;
+    for (const auto& shape : shapes) {
+      for (const auto& i : shape.mesh.indices) {
+        auto [iter, isIn] = uni.try_emplace({i.vertex_index, i.normal_index, i.texcoord_index}, count);
+        if (isIn) {
+          count++;
+        }
+        mapIndices.emplace_back(iter->second);
+      }
+    }
+  }
+  auto mapEnd = chrono::high_resolution_clock::now();
+
+  //新实现：开放寻址哈希表
+  vector<size_t> hashIndices;
+  hashIndices.reserve(indexCount);
+  auto hashStart = chrono::high_resolution_clock::now();
+  {
+    VertexDedupTable uni(indexCount);
+    uint32_t count = 0;
+    for (const auto& shape : shapes) {
+      for (const auto& i : shape.mesh.indices) {
+        auto [index, isIn] = uni.Insert(i.vertex_index, i.normal_index, i.texcoord_index, count);
+        if (isIn) {
+          count++;
+        }
+        hashIndices.emplace_back(index);
+      }
+    }
+  }
+  auto hashEnd = chrono::high_resolution_clock::now();
+
+  auto mapMs = chrono::duration<double, milli>(mapEnd - mapStart).count();
+  auto hashMs = chrono::duration<double, milli>(hashEnd - hashStart).count();
+  cout << "std::map dedup:   " << mapMs << " ms\n";
+  cout << "flat hash dedup:  " << hashMs << " ms\n";
+  cout << "speedup:          " << mapMs / hashMs << "x\n";
+  cout << "identical output: " << (mapIndices == hashIndices ? "yes" : "no") << "\n";
+  filesystem::remove_all(root);
+  return mapIndices == hashIndices ? 0 : -1;
+}
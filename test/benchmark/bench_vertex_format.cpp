@@ -0,0 +1,76 @@
+#include <iostream>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <hikari/asset.h>
+#include <hikari/render_context.h>
+
+using namespace std;
+using namespace Hikari;
+
+static Vector3f DecodeSnorm(const int16_t* e) {
+  return DecodeOctahedral(Vector2f{std::max(e[0] / 32767.0f, -1.0f), std::max(e[1] / 32767.0f, -1.0f)});
+}
+
+static float DecodeTex(uint16_t v, TexCoordEncoding encoding) {
+  return encoding == TexCoordEncoding::Half ? HalfToFloat(v) : v / 65535.0f;
+}
+
+static float AngleDegree(const Vector3f& a, const Vector3f& b) {
+  return std::atan2(Length(Cross(a, b)), Dot(a, b)) * 180.0f / PI;
+}
+
+static void Report(const ImmutableModel& model) {
+  auto pos = model.GetPosition();
+  auto nor = model.GetNormals();
+  auto tex = model.GetTexCoords();
+  auto tan = model.GetTangents();
+  auto encoding = ChooseTexCoordEncoding(tex);
+  auto quant = PositionQuantization::FromBounds(model.GetBoundsMin(), model.GetBoundsMax());
+  auto pntq = GenVboDataPNTQ(pos, nor, tex, quant, encoding);
+  auto ptntq = GenVboDataPTNTQ(pos, tan, nor, tex, quant, encoding);
+  float posError = 0, norError = 0, tanError = 0, texError = 0;
+  for (size_t i = 0; i < pos.size(); i++) {
+    const auto& v = pntq[i];
+    for (size_t k = 0; k < 3; k++) {
+      float p = quant.Offset[k] + quant.Scale[k] * (v.Position[k] / 65535.0f);
+      posError = std::max(posError, std::abs(p - pos[i][k]));
+    }
+    if (nor.size() > 0) {
+      norError = std::max(norError, AngleDegree(DecodeSnorm(v.Normal), Normalize(nor[i])));
+    }
+    if (tan.size() > 0) {
+      Vector3f t{tan[i].X(), tan[i].Y(), tan[i].Z()};
+      tanError = std::max(tanError, AngleDegree(DecodeSnorm(ptntq[i].Tangent), Normalize(t)));
+    }
+    if (tex.size() > 0) {
+      texError = std::max(texError, std::abs(DecodeTex(v.TexCoord[0], encoding) - tex[i].X()));
+      texError = std::max(texError, std::abs(DecodeTex(v.TexCoord[1], encoding) - tex[i].Y()));
+    }
+  }
+  size_t n = pos.size();
+  auto kb = [](size_t bytes) { return double(bytes) / 1024.0; };
+  cout << model.GetName() << ": " << n << " vertices, texcoord "
+       << (encoding == TexCoordEncoding::Half ? "half" : "unorm16") << "\n";
+  cout << "  PNT   " << kb(n * SizePNT()) << " KB, PNTC  " << kb(n * SizePNTC()) << " KB, PNTQ  " << kb(n * SizePNTQ()) << " KB\n";
+  cout << "  PTNT  " << kb(n * SizePTNT()) << " KB, PTNTC " << kb(n * SizePTNTC()) << " KB, PTNTQ " << kb(n * SizePTNTQ()) << " KB\n";
+  float extent = Length(model.GetBoundsMax() - model.GetBoundsMin());
+  cout << "  max error: position " << posError << " (" << posError / extent * 100 << " % of diagonal), normal "
+       << norError << " deg, tangent " << tanError << " deg, texcoord " << texError << "\n";
+}
+
+int main(int argc, char** argv) {
+  Report(ImmutableModel::CreateSphere("sphere", 1.0f, 256));
+  Report(ImmutableModel::CreateCube("cube", 1.0f));
+  Report(ImmutableModel::CreateQuad("quad", 1.0f));
+  for (int i = 1; i < argc; i++) {
+    ImmutableModel model;
+    if (!ImmutableModel::LoadFromFile(argv[i], argv[i], model)) {
+      cout << "cannot load " << argv[i] << "\n";
+      continue;
+    }
+    Report(model);
+  }
+  return 0;
+}
@@ -0,0 +1,188 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+#include <hikari/image.h>
+
+using namespace std;
+using namespace Hikari;
+
+static size_t CountFiles(const filesystem::path& dir, const string& ext) {
+  size_t count = 0;
+  for (const auto& entry : filesystem::directory_iterator(dir)) {
+    count += entry.path().extension() == ext;
+  }
+  return count;
+}
+
+static bool SameTexture(const CompressedTexture& a, const CompressedTexture& b) {
+  if (a.GetFormat() != b.GetFormat() || a.IsSrgb() != b.IsSrgb() || a.GetLevelCount() != b.GetLevelCount() ||
+      a.GetWidth(0) != b.GetWidth(0) || a.GetHeight(0) != b.GetHeight(0) || a.GetByteSize() != b.GetByteSize()) {
+    return false;
+  }
+  for (int i = 0; i < a.GetLevelCount(); i++) {
+    if (memcmp(a.GetLevelData(i), b.GetLevelData(i), a.GetLevelByteSize(i)) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//平滑的渐变，每个4x4块内颜色接近一条直线
+static vector<uint8_t> MakeGradient(int width, int height, int channel) {
+  vector<uint8_t> image(size_t(width) * height * channel);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      for (int c = 0; c < channel; c++) {
+        image[(size_t(y) * width + x) * channel + c] = uint8_t((x * (c + 2) + y * (3 - c % 3)) & 0xff);
+      }
+    }
+  }
+  return image;
+}
+
+int main(int argc, char** argv) {
+  auto root = filesystem::temp_directory_path() / "hikari_test_block_compress";
+  filesystem::remove_all(root);
+  SetCacheDirectory(root);
+  BlockCompressOptions noCache;
+  noCache.UseCache = false;
+  noCache.GenerateMips = false;
+
+  if (CalcBlockCompressedSize(BlockFormat::BC1, 13, 7) != 4 * 2 * 8) { return -1; }
+  if (CalcBlockCompressedSize(BlockFormat::BC5, 1, 1) != 16) { return -1; }
+
+  //纯色块可以精确还原（565可表示的颜色）
+  {
+    uint8_t image[4 * 4 * 4];
+    for (int i = 0; i < 16; i++) {
+      image[i * 4 + 0] = 255;
+      image[i * 4 + 1] = 0;
+      image[i * 4 + 2] = 132;
+      image[i * 4 + 3] = 77;
+    }
+    for (auto format : {BlockFormat::BC1, BlockFormat::BC3}) {
+      auto texture = CompressTexture(image, 4, 4, 4, MipDataType::UInt8, format, noCache);
+      if (!texture.IsValid() || texture.GetLevelCount() != 1) { return -1; }
+      uint8_t decoded[16 * 4];
+      if (!DecompressBlocks(texture.GetLevelData(0), format, 4, 4, decoded)) { return -1; }
+      for (int i = 0; i < 16; i++) {
+        if (decoded[i * 4] != 255 || decoded[i * 4 + 1] != 0 || decoded[i * 4 + 2] != 132) { return -1; }
+        if (decoded[i * 4 + 3] != (format == BlockFormat::BC3 ? 77 : 255)) { return -1; }
+      }
+    }
+  }
+
+  //8位格式的误差，尺寸不是4的倍数
+  {
+    const int width = 45, height = 23;
+    auto rgba = MakeGradient(width, height, 4);
+    struct Case {
+      BlockFormat Format;
+      int Channel;  //解码后的通道数
+      float MaxRmse;
+    } cases[] = {{BlockFormat::BC1, 4, 3.0f}, {BlockFormat::BC3, 4, 3.0f}, {BlockFormat::BC4, 1, 1.0f}, {BlockFormat::BC5, 2, 1.0f}};
+    for (const auto& c : cases) {
+      auto texture = CompressTexture(rgba.data(), width, height, 4, MipDataType::UInt8, c.Format, noCache);
+      if (texture.GetLevelByteSize(0) != CalcBlockCompressedSize(c.Format, width, height)) { return -1; }
+      vector<uint8_t> decoded(size_t(width) * height * c.Channel);
+      if (!DecompressBlocks(texture.GetLevelData(0), c.Format, width, height, decoded.data())) { return -1; }
+      double error = 0;
+      int compared = c.Format == BlockFormat::BC1 ? 3 : c.Channel;  //BC1没有alpha
+      for (int i = 0; i < width * height; i++) {
+        for (int k = 0; k < compared; k++) {
+          double d = double(decoded[size_t(i) * c.Channel + k]) - rgba[size_t(i) * 4 + k];
+          error += d * d;
+        }
+      }
+      double rmse = std::sqrt(error / (double(width) * height * compared));
+      cout << "format " << int(c.Format) << " rmse " << rmse << "\n";
+      if (rmse > c.MaxRmse) { return -1; }
+    }
+  }
+
+  //BC6H：半精度范围内的相对误差，负数变为0
+  {
+    const int width = 16, height = 12;
+    vector<float> hdr(size_t(width) * height * 3);
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        float base = std::exp2(float(x + y) * 0.25f - 2.0f);
+        float* p = &hdr[(size_t(y) * width + x) * 3];
+        p[0] = base;
+        p[1] = base * 0.5f;
+        p[2] = base * 0.25f;
+      }
+    }
+    hdr[0] = -1.0f;
+    auto texture = CompressTexture(hdr.data(), width, height, 3, MipDataType::Float32, BlockFormat::BC6H, noCache);
+    vector<float> decoded(hdr.size());
+    if (!DecompressBlocks(texture.GetLevelData(0), BlockFormat::BC6H, width, height, decoded.data())) { return -1; }
+    double error = 0;
+    for (size_t i = 3; i < hdr.size(); i++) {
+      error += std::abs(decoded[i] - hdr[i]) / hdr[i];
+    }
+    error /= double(hdr.size() - 3);
+    cout << "bc6h mean relative error " << error << "\n";
+    if (error > 0.03 || decoded[0] < 0) { return -1; }
+    //8位数据不能压缩为BC6H，浮点数据不能压缩为BC1
+    if (CompressTexture(hdr.data(), width, height, 3, MipDataType::Float32, BlockFormat::BC1, noCache).IsValid()) { return -1; }
+  }
+
+  //mipmap、DDS往返和KTX2读取
+  {
+    const int width = 37, height = 20;
+    auto rgb = MakeGradient(width, height, 3);
+    BlockCompressOptions options = noCache;
+    options.GenerateMips = true;
+    options.IsSrgb = true;
+    auto texture = CompressTexture(rgb.data(), width, height, 3, MipDataType::UInt8, BlockFormat::BC1, options);
+    if (texture.GetLevelCount() != 6 || !texture.IsSrgb() || texture.GetWidth(5) != 1 || texture.GetHeight(4) != 1) { return -1; }
+    filesystem::create_directories(root);
+    if (!texture.SaveToDds(root / "a.dds")) { return -1; }
+    CompressedTexture dds;
+    if (!CompressedTexture::LoadFromFile(root / "a.dds", dds) || !SameTexture(texture, dds)) { return -1; }
+
+    ofstream ktx(root / "a.ktx2", ios::binary);
+    const uint8_t identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+    ktx.write((const char*)identifier, 12);
+    uint32_t header[17] = {132, 1, uint32_t(width), uint32_t(height), 0, 0, 1, uint32_t(texture.GetLevelCount()), 0};
+    ktx.write((const char*)header, sizeof(header));
+    //级别索引后面按从小到大的顺序存放数据
+    uint64_t offset = 80 + 24 * texture.GetLevelCount();
+    vector<uint64_t> index;
+    for (int i = texture.GetLevelCount() - 1; i >= 0; i--) {
+      offset += i == texture.GetLevelCount() - 1 ? 0 : texture.GetLevelByteSize(i + 1);
+      index.insert(index.begin(), {offset, texture.GetLevelByteSize(i), texture.GetLevelByteSize(i)});
+    }
+    ktx.write((const char*)index.data(), index.size() * sizeof(uint64_t));
+    for (int i = texture.GetLevelCount() - 1; i >= 0; i--) {
+      ktx.write((const char*)texture.GetLevelData(i), texture.GetLevelByteSize(i));
+    }
+    ktx.close();
+    CompressedTexture ktx2;
+    if (!CompressedTexture::LoadFromFile(root / "a.ktx2", ktx2) || !SameTexture(texture, ktx2)) { return -1; }
+    CompressedTexture missing;
+    if (CompressedTexture::LoadFromFile(root / "missing.dds", missing) || missing.IsValid()) { return -1; }
+  }
+
+  //磁盘缓存：第二次直接读取，参数不同时不会命中
+  {
+    const int size = 32;
+    auto rg = MakeGradient(size, size, 2);
+    BlockCompressOptions options;
+    auto first = CompressTexture(rg.data(), size, size, 2, MipDataType::UInt8, BlockFormat::BC5, options);
+    if (CountFiles(root / "texture", ".dds") != 1) { return -1; }
+    auto cached = CompressTexture(rg.data(), size, size, 2, MipDataType::UInt8, BlockFormat::BC5, options);
+    if (!SameTexture(first, cached) || cached.GetLevelCount() != 6) { return -1; }
+    CompressTexture(rg.data(), size, size, 2, MipDataType::UInt8, BlockFormat::BC4, options);
+    if (CountFiles(root / "texture", ".dds") != 2) { return -1; }
+  }
+
+  filesystem::remove_all(root);
+  cout << "passed test" << endl;
+  return 0;
+}
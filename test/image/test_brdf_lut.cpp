@@ -0,0 +1,129 @@
+#include <iostream>
+#include <filesystem>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <hikari/image.h>
+#include <hikari/mathematics.h>
+
+using namespace std;
+using namespace Hikari;
+
+//在L的球坐标上做中点积分，与重要性采样无关，作为参考值
+struct Reference {
+  double A;
+  double B;
+  double MultiSpecular;
+};
+
+static Reference Integrate(double NdotV, double roughness) {
+  const double alpha = roughness * roughness;
+  const double a2 = alpha * alpha;
+  const double k = alpha / 2.0;
+  const double vx = std::sqrt(1.0 - NdotV * NdotV), vz = NdotV;
+  const int thetaCount = 256, phiCount = 512;
+  const double dTheta = PI_VALUE / 2.0 / thetaCount, dPhi = 2.0 * PI_VALUE / phiCount;
+  Reference ref{};
+  for (int i = 0; i < thetaCount; i++) {
+    const double theta = (i + 0.5) * dTheta;
+    for (int j = 0; j < phiCount; j++) {
+      const double phi = (j + 0.5) * dPhi;
+      const double l[3] = {std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)};
+      double h[3] = {l[0] + vx, l[1], l[2] + vz};
+      const double len = std::sqrt(h[0] * h[0] + h[1] * h[1] + h[2] * h[2]);
+      const double NoH = h[2] / len, VoH = (vx * h[0] + vz * h[2]) / len, NoL = l[2];
+      const double t = NoH * NoH * (a2 - 1.0) + 1.0;
+      const double d = a2 / (PI_VALUE * t * t);
+      const double dOmega = std::sin(theta) * dTheta * dPhi;
+      const double g = (NdotV / (NdotV * (1 - k) + k)) * (NoL / (NoL * (1 - k) + k));
+      const double fc = std::pow(1.0 - VoH, 5.0);
+      const double spec = d * g / (4.0 * NdotV) * dOmega;
+      ref.A += (1.0 - fc) * spec;
+      ref.B += fc * spec;
+      const double vis = 0.5 / (NdotV * std::sqrt(NoL * NoL * (1 - a2) + a2) + NoL * std::sqrt(NdotV * NdotV * (1 - a2) + a2));
+      ref.MultiSpecular += d * vis * NoL * dOmega;
+    }
+  }
+  return ref;
+}
+
+static size_t CountCacheFiles(const filesystem::path& dir) {
+  size_t count = 0;
+  for (const auto& entry : filesystem::directory_iterator(dir)) {
+    count += entry.path().extension() == ".hklut";
+  }
+  return count;
+}
+
+int main(int argc, char** argv) {
+  auto root = filesystem::temp_directory_path() / "hikari_test_brdf_lut";
+  filesystem::remove_all(root);
+  SetCacheDirectory(root);
+  BrdfLutOptions noCache;
+  noCache.UseCache = false;
+
+  //与独立的数值积分比较
+  {
+    BrdfLutOptions options = noCache;
+    options.SampleCount = 4096;
+    const int size = 8;
+    auto split = BakeBrdfLut(BrdfLutType::SplitSum, size, size, options);
+    auto multi = BakeBrdfLut(BrdfLutType::MultiScattering, size, size, options);
+    if (split.GetChannel() != 2 || multi.GetChannel() != 3) { return -1; }
+    if (split.GetByteSize() != size * size * 2 * sizeof(float)) { return -1; }
+    int texels[][2] = {{3, 4}, {6, 2}, {1, 6}, {7, 7}};
+    float maxError = 0;
+    for (auto& t : texels) {
+      auto ref = Integrate((t[0] + 0.5) / size, (t[1] + 0.5) / size);
+      const float* s = split.GetData() + (t[1] * size + t[0]) * 2;
+      const float* m = multi.GetData() + (t[1] * size + t[0]) * 3;
+      maxError = std::max({maxError, std::abs(s[0] - float(ref.A)), std::abs(s[1] - float(ref.B)),
+                           std::abs(m[0] - float(ref.MultiSpecular))});
+    }
+    cout << "brdf lut max error " << maxError << "\n";
+    if (maxError > 0.02f) { return -1; }
+  }
+
+  //所有值非负，A+B不超过1；接近光滑时正视方向的A+B接近1
+  {
+    const int size = 32;
+    BrdfLutOptions options = noCache;
+    options.SampleCount = 512;
+    auto split = BakeBrdfLut(BrdfLutType::SplitSum, size, size, options);
+    for (int i = 0; i < size * size; i++) {
+      const float a = split.GetData()[i * 2], b = split.GetData()[i * 2 + 1];
+      if (!(a >= 0 && b >= 0 && a + b <= 1.01f)) { return -1; }
+    }
+    for (int x = size / 2; x < size; x++) {
+      if (std::abs(split.GetData()[x * 2] + split.GetData()[x * 2 + 1] - 1.0f) > 0.02f) { return -1; }
+    }
+    auto multi = BakeBrdfLut(BrdfLutType::MultiScattering, size, size, options);
+    for (int i = 0; i < size * size; i++) {
+      const float* m = multi.GetData() + i * 3;
+      if (!(m[0] >= 0 && m[1] >= 0 && m[1] <= m[0] && m[2] > 0 && m[2] < 2.0f)) { return -1; }
+    }
+  }
+
+  //磁盘缓存：第二次从缓存读取，内容一致，参数不同时不会命中
+  {
+    BrdfLutOptions options;
+    options.SampleCount = 256;
+    auto first = BakeBrdfLut(BrdfLutType::MultiScattering, 16, 8, options);
+    if (CountCacheFiles(root / "brdf") != 1) { return -1; }
+    auto cached = BakeBrdfLut(BrdfLutType::MultiScattering, 16, 8, options);
+    if (cached.GetType() != BrdfLutType::MultiScattering || cached.GetWidth() != 16 || cached.GetHeight() != 8) { return -1; }
+    if (cached.GetByteSize() != first.GetByteSize() || memcmp(cached.GetData(), first.GetData(), first.GetByteSize()) != 0) { return -1; }
+    BakeBrdfLut(BrdfLutType::SplitSum, 16, 8, options);
+    options.DiffuseSampleCount = 64;
+    BakeBrdfLut(BrdfLutType::MultiScattering, 16, 8, options);
+    if (CountCacheFiles(root / "brdf") != 3) { return -1; }
+  }
+
+  if (BakeBrdfLut(BrdfLutType::SplitSum, 0, 4).IsValid()) { return -1; }
+
+  filesystem::remove_all(root);
+  cout << "passed test" << endl;
+  return 0;
+}
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <filesystem>
+#include <vector>
+#include <cstring>
+#include <cmath>
+
+#include <hikari/image.h>
+#include <hikari/quantize.h>
+
+using namespace std;
+using namespace Hikari;
+
+//全景图的每个纹素保存自己中心的方向，加上2保证是正数
+static void Direction(float u, float v, float* dir) {
+  float phi = (u - 0.5f) * 2.0f * PI;
+  float theta = (v - 0.5f) * PI;
+  dir[0] = std::cos(theta) * std::cos(phi);
+  dir[1] = std::sin(theta);
+  dir[2] = std::cos(theta) * std::sin(phi);
+}
+
+//OpenGL规范的选面规则：按主轴选面，再算面内的 s、t
+static void Lookup(const float* d, int& face, float& s, float& t) {
+  float ax = std::abs(d[0]), ay = std::abs(d[1]), az = std::abs(d[2]);
+  float sc, tc, ma;
+  if (ax >= ay && ax >= az) {
+    face = d[0] > 0 ? 0 : 1;
+    sc = d[0] > 0 ? -d[2] : d[2];
+    tc = -d[1];
+    ma = ax;
+  } else if (ay >= az) {
+    face = d[1] > 0 ? 2 : 3;
+    sc = d[0];
+    tc = d[1] > 0 ? d[2] : -d[2];
+    ma = ay;
+  } else {
+    face = d[2] > 0 ? 4 : 5;
+    sc = d[2] > 0 ? d[0] : -d[0];
+    tc = -d[1];
+    ma = az;
+  }
+  s = (sc / ma + 1) * 0.5f;
+  t = (tc / ma + 1) * 0.5f;
+}
+
+int main(int argc, char** argv) {
+  const int width = 256, height = 128, faceSize = 32;
+  vector<float> equirect(size_t(width) * height * 3);
+  vector<uint32_t> packed(size_t(width) * height);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      float* p = &equirect[(size_t(y) * width + x) * 3];
+      Direction((x + 0.5f) / width, (y + 0.5f) / height, p);
+      for (int k = 0; k < 3; k++) {
+        p[k] += 2.0f;
+      }
+      packed[size_t(y) * width + x] = FloatToRgb9e5(Vector3f{p[0], p[1], p[2]});
+    }
+  }
+
+  //无效输入
+  if (ConvertEquirectToCubeMap(equirect.data(), width, height, 2, HdrStorage::Float32, faceSize).IsValid()) { return -1; }
+  if (ConvertEquirectToCubeMap(nullptr, width, height, 3, HdrStorage::Float32, faceSize).IsValid()) { return -1; }
+
+  for (auto storage : {HdrStorage::Float32, HdrStorage::RGB9E5}) {
+    const void* data = storage == HdrStorage::Float32 ? (const void*)equirect.data() : (const void*)packed.data();
+    auto cube = ConvertEquirectToCubeMap(data, width, height, 3, storage, faceSize);
+    if (!cube.IsValid() || cube.GetSize() != faceSize || cube.GetByteSize() != cube.GetFaceByteSize() * 6) { return -1; }
+    //按采样规则从方向找到纹素，结果应该接近这个方向
+    float maxError = 0;
+    for (int i = 0; i < 2000; i++) {
+      float dir[3];
+      Direction(std::fmod(i * 0.618034f, 1.0f), (i + 0.5f) / 2000.0f * 0.98f + 0.01f, dir);
+      int face;
+      float s, t;
+      Lookup(dir, face, s, t);
+      int x = std::min(int(s * faceSize), faceSize - 1);
+      int y = std::min(int(t * faceSize), faceSize - 1);
+      const float* p = cube.GetFaceData(face) + (size_t(y) * faceSize + x) * 3;
+      float texel[3];
+      float error = 0;
+      for (int k = 0; k < 3; k++) {
+        texel[k] = p[k] - 2.0f;
+        error += texel[k] * texel[k];
+      }
+      float dot = 0;
+      for (int k = 0; k < 3; k++) {
+        dot += texel[k] / std::sqrt(error) * dir[k];
+      }
+      maxError = std::max(maxError, std::acos(std::min(1.0f, dot)));
+    }
+    cout << "max angle error " << maxError * 180.0f / PI << " degree\n";
+    //纹素中心与查询方向最多相差半个纹素的对角线，面中心约2.5度，再加上双线性插值和RGB9E5的误差
+    if (maxError * 180.0f / PI > 3.0f) { return -1; }
+  }
+
+  //常数全景图得到常数cubemap
+  {
+    vector<float> constant(size_t(16) * 8 * 4, 1.5f);
+    auto cube = ConvertEquirectToCubeMap(constant.data(), 16, 8, 4, HdrStorage::Float32, 5);
+    for (int face = 0; face < 6; face++) {
+      for (int i = 0; i < 5 * 5 * 3; i++) {
+        if (std::abs(cube.GetFaceData(face)[i] - 1.5f) > 1e-5f) { return -1; }
+      }
+    }
+  }
+
+  //烘焙结果的缓存文件：mip的尺寸、往返一致，键不同时拒绝读取
+  {
+    BakedCubeMap baked;
+    baked.Allocate(8, 4);
+    if (baked.GetSize(3) != 1 || baked.GetFaceByteSize(1) != 4 * 4 * 3 * sizeof(uint16_t)) { return -1; }
+    if (baked.GetByteSize() != (64 + 16 + 4 + 1) * 6 * 3 * sizeof(uint16_t)) { return -1; }
+    for (int level = 0; level < 4; level++) {
+      for (int face = 0; face < 6; face++) {
+        auto data = static_cast<uint16_t*>(baked.GetFaceData(level, face));
+        for (size_t i = 0; i < baked.GetFaceByteSize(level) / sizeof(uint16_t); i++) {
+          data[i] = FloatToHalf(float(level * 100 + face * 10) + float(i) * 0.25f);
+        }
+      }
+    }
+    auto path = filesystem::temp_directory_path() / "hikari_test_baked_cube.hkcube";
+    if (!baked.SaveToFile(path, 42)) { return -1; }
+    BakedCubeMap loaded;
+    if (loaded.LoadFromFile(path, 43) || loaded.IsValid()) { return -1; }
+    if (!loaded.LoadFromFile(path, 42) || loaded.GetLevelCount() != 4 || loaded.GetSize(0) != 8) { return -1; }
+    if (memcmp(loaded.GetFaceData(0, 0), baked.GetFaceData(0, 0), baked.GetByteSize()) != 0) { return -1; }
+    filesystem::remove(path);
+  }
+
+  cout << "passed test" << endl;
+  return 0;
+}
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include <hikari/image.h>
+
+using namespace std;
+using namespace Hikari;
+
+//天空渐变加一个比较集中的太阳
+static Vector3f Environment(const Vector3f& d) {
+  Vector3f sun = Normalize(Vector3f{0.3f, 0.8f, -0.5f});
+  float lobe = std::pow(std::max(0.0f, Dot(d, sun)), 8.0f) * 5.0f;
+  return Vector3f{0.5f + 0.5f * d.Y() + lobe, 0.4f + 0.3f * d.Y() + lobe, 0.6f + 0.1f * d.X() + lobe * 0.8f};
+}
+
+//与 IrradianceConvolution.frag 相同的半球积分，直接对环境函数采样
+static Vector3f Convolution(const Vector3f& n) {
+  const float sampleStep = 0.02f;
+  Vector3f up{0.0f, 1.0f, 0.0f};
+  Vector3f right = Normalize(Cross(up, n));
+  up = Cross(n, right);
+  Vector3f irradiance{};
+  float sampleCount = 0;
+  for (float phi = 0; phi < 2 * PI; phi += sampleStep) {
+    for (float theta = 0; theta < 0.5f * PI; theta += sampleStep) {
+      Vector3f t{std::cos(phi) * std::sin(theta), std::sin(phi) * std::sin(theta), std::cos(theta)};
+      Vector3f w = right * Vector3f(t.X()) + up * Vector3f(t.Y()) + n * Vector3f(t.Z());
+      irradiance = irradiance + Environment(w) * Vector3f(std::cos(theta) * std::sin(theta));
+      sampleCount++;
+    }
+  }
+  return irradiance * Vector3f(PI / sampleCount);
+}
+
+int main(int argc, char** argv) {
+  //常数环境光的辐照度（除以PI后）等于常数
+  {
+    const int size = 8;
+    vector<float> face(size_t(size) * size * 3, 2.0f);
+    const float* faces[6] = {face.data(), face.data(), face.data(), face.data(), face.data(), face.data()};
+    auto sh = ProjectIrradianceSH9(faces, size, 3);
+    for (int i = 0; i < 3; i++) {
+      if (std::abs(sh.Coefficients[0][i] - 2.0f) > 1e-4f) { return -1; }
+    }
+    for (int i = 1; i < 9; i++) {
+      for (int k = 0; k < 3; k++) {
+        if (std::abs(sh.Coefficients[i][k]) > 1e-4f) { return -1; }
+      }
+    }
+    auto e = EvaluateIrradianceSH9(sh, Normalize(Vector3f{1, -2, 3}));
+    if (std::abs(e.X() - 2.0f) > 1e-4f) { return -1; }
+    const float* missing[6] = {face.data(), nullptr, face.data(), face.data(), face.data(), face.data()};
+    if (ProjectIrradianceSH9(missing, size, 3).Coefficients[0].X() != 0) { return -1; }
+  }
+
+  //与卷积的结果比较
+  {
+    const int width = 512, height = 256;
+    vector<float> equirect(size_t(width) * height * 3);
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        float phi = ((x + 0.5f) / width - 0.5f) * 2 * PI;
+        float theta = ((y + 0.5f) / height - 0.5f) * PI;
+        Vector3f d{std::cos(theta) * std::cos(phi), std::sin(theta), std::cos(theta) * std::sin(phi)};
+        Vector3f c = Environment(d);
+        for (int k = 0; k < 3; k++) {
+          equirect[(size_t(y) * width + x) * 3 + k] = c[k];
+        }
+      }
+    }
+    auto cube = ConvertEquirectToCubeMap(equirect.data(), width, height, 3, HdrStorage::Float32, 64);
+    auto sh = ProjectIrradianceSH9(cube);
+    float maxError = 0, meanError = 0;
+    const int count = 64;
+    for (int i = 0; i < count; i++) {
+      //球面上的斐波那契点
+      float z = 1.0f - (i + 0.5f) * 2.0f / count;
+      float r = std::sqrt(1.0f - z * z);
+      float phi = i * 2.399963f;
+      Vector3f n{r * std::cos(phi), r * std::sin(phi), z};
+      Vector3f expected = Convolution(n);
+      Vector3f actual = EvaluateIrradianceSH9(sh, n);
+      for (int k = 0; k < 3; k++) {
+        float error = std::abs(actual[k] - expected[k]) / expected[k];
+        maxError = std::max(maxError, error);
+        meanError += error / (count * 3);
+      }
+    }
+    cout << "sh9 vs convolution: mean relative error " << meanError << ", max " << maxError << "\n";
+    //三阶球谐截断了集中光源的高频部分，背光处辐照度很小，相对误差最大
+    if (meanError > 0.03f || maxError > 0.15f) { return -1; }
+  }
+
+  cout << "passed test" << endl;
+  return 0;
+}
@@ -0,0 +1,124 @@
+#include <iostream>
+#include <filesystem>
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+#include <hikari/image.h>
+
+using namespace std;
+using namespace Hikari;
+
+static bool CheckConstant(const MipChain& chain, float value) {
+  for (int level = 1; level < chain.GetLevelCount(); level++) {
+    auto data = static_cast<const float*>(chain.GetLevelData(level));
+    size_t count = chain.GetLevelByteSize(level) / sizeof(float);
+    for (size_t i = 0; i < count; i++) {
+      if (std::abs(data[i] - value) > 1e-5f) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  auto root = filesystem::temp_directory_path() / "hikari_test_mip_generate";
+  filesystem::remove_all(root);
+  SetCacheDirectory(root);
+  MipGenerateOptions noCache;
+  noCache.UseCache = false;
+
+  //级数和尺寸与OpenGL一致
+  {
+    vector<float> image(size_t(37) * 5, 1.0f);
+    auto chain = GenerateMipChain(image.data(), 37, 5, 1, MipDataType::Float32, noCache);
+    if (chain.GetLevelCount() != 6) { return -1; }
+    int expected[][2] = {{37, 5}, {18, 2}, {9, 1}, {4, 1}, {2, 1}, {1, 1}};
+    for (int i = 0; i < 6; i++) {
+      if (chain.GetWidth(i) != expected[i][0] || chain.GetHeight(i) != expected[i][1]) { return -1; }
+    }
+    if (chain.GetLevelData(0) != nullptr || chain.GetLevelPointers().size() != 5) { return -1; }
+    //权重归一化，常数图像的每一级仍是常数
+    if (!CheckConstant(chain, 1.0f)) { return -1; }
+    MipGenerateOptions kaiser = noCache;
+    kaiser.Filter = MipFilter::Kaiser;
+    if (!CheckConstant(GenerateMipChain(image.data(), 37, 5, 1, MipDataType::Float32, kaiser), 1.0f)) { return -1; }
+    kaiser.IsWrap = true;
+    kaiser.MaxLevelCount = 3;
+    auto limited = GenerateMipChain(image.data(), 37, 5, 1, MipDataType::Float32, kaiser);
+    if (limited.GetLevelCount() != 3 || !CheckConstant(limited, 1.0f)) { return -1; }
+    //通道数不是1到4时走通用路径
+    vector<float> wide(size_t(9) * 6 * 5, 1.0f);
+    if (!CheckConstant(GenerateMipChain(wide.data(), 9, 6, 5, MipDataType::Float32, noCache), 1.0f)) { return -1; }
+  }
+
+  //偶数尺寸的盒式滤波就是2x2平均；奇数尺寸按覆盖面积加权
+  {
+    float image[] = {0, 1, 2, 3,
+                     4, 5, 6, 7};
+    auto chain = GenerateMipChain(image, 4, 2, 1, MipDataType::Float32, noCache);
+    auto level1 = static_cast<const float*>(chain.GetLevelData(1));
+    if (level1[0] != 2.5f || level1[1] != 4.5f) { return -1; }
+    if (*static_cast<const float*>(chain.GetLevelData(2)) != 3.5f) { return -1; }
+    float odd[] = {0, 3, 6, 9, 12};
+    auto oddChain = GenerateMipChain(odd, 5, 1, 1, MipDataType::Float32, noCache);
+    //5变为2，目标像素分别覆盖源像素 [0, 2.5) 和 [2.5, 5)
+    auto oddLevel1 = static_cast<const float*>(oddChain.GetLevelData(1));
+    if (std::abs(oddLevel1[0] - 2.4f) > 1e-5f || std::abs(oddLevel1[1] - 9.6f) > 1e-5f) { return -1; }
+  }
+
+  //8位数据：线性平均和sRGB平均，alpha保持线性
+  {
+    uint8_t image[] = {0, 0, 0, 0, 255, 255, 255, 255};
+    auto linear = GenerateMipChain(image, 2, 1, 4, MipDataType::UInt8, noCache);
+    auto l = static_cast<const uint8_t*>(linear.GetLevelData(1));
+    if (l[0] != 128 || l[3] != 128) { return -1; }
+    MipGenerateOptions srgb = noCache;
+    srgb.IsSrgb = true;
+    auto gamma = GenerateMipChain(image, 2, 1, 4, MipDataType::UInt8, srgb);
+    auto g = static_cast<const uint8_t*>(gamma.GetLevelData(1));
+    //线性0.5编码为sRGB是188
+    if (g[0] != 188 || g[1] != 188 || g[2] != 188 || g[3] != 128) { return -1; }
+    //所有8位值往返不变
+    for (int v = 0; v < 256; v++) {
+      uint8_t flat[] = {uint8_t(v), uint8_t(v), uint8_t(v), uint8_t(v)};
+      auto chain = GenerateMipChain(flat, 2, 2, 1, MipDataType::UInt8, srgb);
+      if (*static_cast<const uint8_t*>(chain.GetLevelData(1)) != v) { return -1; }
+    }
+  }
+
+  //磁盘缓存：第二次从缓存读取，内容一致，参数不同时不会命中
+  {
+    const int size = 64;
+    vector<uint8_t> image(size_t(size) * size * 3);
+    for (size_t i = 0; i < image.size(); i++) {
+      image[i] = uint8_t(i * 7 + i / 13);
+    }
+    MipGenerateOptions options;
+    options.Filter = MipFilter::Kaiser;
+    options.IsSrgb = true;
+    auto first = GenerateMipChain(image.data(), size, size, 3, MipDataType::UInt8, options);
+    size_t fileCount = 0;
+    for (const auto& entry : filesystem::directory_iterator(root / "mip")) {
+      fileCount += entry.path().extension() == ".hkmip";
+    }
+    if (fileCount != 1) { return -1; }
+    auto cached = GenerateMipChain(image.data(), size, size, 3, MipDataType::UInt8, options);
+    if (cached.GetLevelCount() != first.GetLevelCount() || cached.GetByteSize() != first.GetByteSize()) { return -1; }
+    for (int i = 1; i < first.GetLevelCount(); i++) {
+      if (memcmp(cached.GetLevelData(i), first.GetLevelData(i), first.GetLevelByteSize(i)) != 0) { return -1; }
+    }
+    options.IsSrgb = false;
+    GenerateMipChain(image.data(), size, size, 3, MipDataType::UInt8, options);
+    fileCount = 0;
+    for (const auto& entry : filesystem::directory_iterator(root / "mip")) {
+      fileCount += entry.path().extension() == ".hkmip";
+    }
+    if (fileCount != 2) { return -1; }
+  }
+
+  filesystem::remove_all(root);
+  cout << "passed test" << endl;
+  return 0;
+}
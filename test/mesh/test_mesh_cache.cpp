@@ -0,0 +1,91 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+
+#include <hikari/asset.h>
+
+using namespace std;
+using namespace Hikari;
+
+static void WriteObj(const filesystem::path& path, float offset) {
+  ofstream obj(path);
+  obj << "v 0 0 0\nv 1 0 0\nv 1 1 " << offset << "\nv 0 1 0\n";
+  obj << "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n";
+  obj << "vn 0 0 1\n";
+  obj << "f 1/1/1 2/2/1 3/3/1\nf 1/1/1 3/3/1 4/4/1\n";
+}
+
+template <typename View>
+static bool AreEquals(const View& a, const View& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); i++) {
+    if (!(a[i] == b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool AreEquals(const ImmutableModel& a, const ImmutableModel& b) {
+  return AreEquals(a.GetPosition(), b.GetPosition()) &&
+         AreEquals(a.GetNormals(), b.GetNormals()) &&
+         AreEquals(a.GetTexCoords(), b.GetTexCoords()) &&
+         AreEquals(a.GetTangents(), b.GetTangents()) &&
+         AreEquals(a.GetIndices(), b.GetIndices()) &&
+         a.GetIndexFormat() == b.GetIndexFormat() &&
+         a.GetBoundsMin() == b.GetBoundsMin() &&
+         a.GetBoundsMax() == b.GetBoundsMax();
+}
+
+int main(int argc, char** argv) {
+  auto root = filesystem::temp_directory_path() / "hikari_test_mesh_cache";
+  filesystem::remove_all(root);
+  filesystem::create_directories(root);
+  SetCacheDirectory(root / "cache");
+  auto objPath = root / "quad.obj";
+  WriteObj(objPath, 0);
+
+  ImmutableModel ref;
+  ModelImportOptions noCache;
+  noCache.UseCache = false;
+  if (!ImmutableModel::LoadFromFile("ref", objPath, ref, noCache)) { return -1; }
+  if (ref.GetVertexCount() != 4 || ref.GetIndexCount() != 6) { return -1; }
+  if (ref.GetIndexFormat() != IndexFormat::UInt16 || ref.GetIndices().GetByteSize() != 12) { return -1; }
+  //顶点超过65536时使用32位索引
+  auto big = ImmutableModel::CreateSphere("big", 1.0f, 512);
+  if (big.GetVertexCount() <= 0x10000 || big.GetIndexFormat() != IndexFormat::UInt32) { return -1; }
+
+  uint64_t hash;
+  if (!HashFileContent(objPath, hash)) { return -1; }
+  auto cachePath = ImmutableModel::GetCachePath(hash);
+  {
+    //第一次加载写入缓存
+    ImmutableModel first;
+    if (!ImmutableModel::LoadFromFile("first", objPath, first)) { return -1; }
+    if (!filesystem::exists(cachePath)) { return -1; }
+    if (!AreEquals(ref, first)) { return -1; }
+  }
+  {
+    //第二次加载直接映射缓存
+    ImmutableModel mapped;
+    if (!ImmutableModel::LoadFromCache("mapped", cachePath, hash, mapped)) { return -1; }
+    if (!AreEquals(ref, mapped)) { return -1; }
+    ImmutableModel moved(std::move(mapped));
+    if (!AreEquals(ref, moved) || mapped.IsValid()) { return -1; }
+    //哈希不一致时拒绝
+    ImmutableModel stale;
+    if (ImmutableModel::LoadFromCache("stale", cachePath, hash + 1, stale)) { return -1; }
+  }
+  {
+    //源文件改变后重新解析
+    WriteObj(objPath, 0.5f);
+    ImmutableModel changed;
+    if (!ImmutableModel::LoadFromFile("changed", objPath, changed)) { return -1; }
+    if (changed.GetBoundsMax().Z() != 0.5f) { return -1; }
+  }
+  filesystem::remove_all(root);
+  cout << "passed test" << endl;
+  return 0;
+}
@@ -0,0 +1,76 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include <hikari/mesh.h>
+
+using namespace std;
+using namespace Hikari;
+
+int main(int argc, char** argv) {
+  //平面网格内部可以无误差地简化，边界保持不动
+  const int n = 16;
+  vector<Vector3f> grid;
+  vector<uint32_t> gridIndices;
+  for (int y = 0; y <= n; y++) {
+    for (int x = 0; x <= n; x++) {
+      grid.emplace_back(Vector3f{float(x), float(y), 0.0f});
+    }
+  }
+  for (int y = 0; y < n; y++) {
+    for (int x = 0; x < n; x++) {
+      uint32_t a = y * (n + 1) + x, b = a + 1, c = a + n + 1, d = c + 1;
+      gridIndices.insert(gridIndices.end(), {a, b, d, a, d, c});
+    }
+  }
+  float gridError = -1;
+  auto flat = SimplifyMesh(gridIndices, grid, 0, 1e-4f, &gridError);
+  cout << "grid " << gridIndices.size() / 3 << " -> " << flat.size() / 3 << " triangles, error " << gridError << "\n";
+  if (flat.size() * 4 > gridIndices.size() || gridError > 1e-4f) { return -1; }
+  for (size_t t = 0; t < flat.size(); t += 3) {
+    auto nor = Cross(grid[flat[t + 1]] - grid[flat[t]], grid[flat[t + 2]] - grid[flat[t]]);
+    if (nor.Z() <= 0) { return -1; }
+  }
+  for (int i = 0; i <= n; i++) {
+    uint32_t border[] = {uint32_t(i), uint32_t(n * (n + 1) + i), uint32_t(i * (n + 1)), uint32_t(i * (n + 1) + n)};
+    for (auto v : border) {
+      if (find(flat.begin(), flat.end(), v) == flat.end()) { return -1; }
+    }
+  }
+
+  const int slices = 32;
+  auto sphere = ImmutableModel::CreateSphere("sphere", 0.5f, slices);
+  vector<uint32_t> indices;
+  auto lods = BuildLodChain(sphere, indices);
+  for (const auto& lod : lods) {
+    cout << "lod " << lod.IndexCount / 3 << " triangles, error " << lod.Error << "\n";
+  }
+  if (lods.size() < 3) { return -1; }
+  if (lods[0].IndexCount != sphere.GetIndexCount()) { return -1; }
+  if (lods.back().IndexCount * 3 > lods[0].IndexCount) { return -1; }
+  if (lods[1].Error > 0.05f) { return -1; }
+  for (size_t l = 1; l < lods.size(); l++) {
+    if (lods[l].IndexCount >= lods[l - 1].IndexCount || lods[l].Error < lods[l - 1].Error) { return -1; }
+    if (lods[l].IndexStart != lods[l - 1].IndexStart + lods[l - 1].IndexCount) { return -1; }
+    auto begin = indices.begin() + lods[l].IndexStart;
+    auto end = begin + lods[l].IndexCount;
+    //球上不能出现翻转的三角形，接缝上的狭长三角形可能与视线平行
+    for (auto it = begin; it != end; it += 3) {
+      const auto& a = sphere.GetPosition()[*it];
+      const auto& b = sphere.GetPosition()[*(it + 1)];
+      const auto& c = sphere.GetPosition()[*(it + 2)];
+      auto nor = Cross(b - a, c - a);
+      auto dir = a + b + c;
+      if (Dot(nor, dir) < -1e-4f * Length(nor) * Length(dir)) { return -1; }
+    }
+    //纹理接缝两侧的顶点都要保留
+    for (int i = 1; i < slices / 2; i++) {
+      uint32_t left = i * (slices + 1);
+      uint32_t right = left + slices;
+      if (find(begin, end, left) == end || find(begin, end, right) == end) { return -1; }
+    }
+  }
+  if (indices.size() != lods.back().IndexStart + lods.back().IndexCount) { return -1; }
+  cout << "passed test" << endl;
+  return 0;
+}
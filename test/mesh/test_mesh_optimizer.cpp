@@ -0,0 +1,57 @@
+#include <iostream>
+#include <vector>
+#include <array>
+#include <algorithm>
+
+#include <hikari/mesh.h>
+
+using namespace std;
+using namespace Hikari;
+
+//每个三角形的三个顶点位置，旋转到字典序最小的顶点开头，保持绕序
+static vector<array<float, 9>> CollectTriangles(const ImmutableModel& model) {
+  vector<array<float, 9>> result;
+  for (size_t t = 0; t < model.GetTriangleCount(); t++) {
+    array<Vector3f, 3> p;
+    for (size_t k = 0; k < 3; k++) {
+      p[k] = model.GetPosition()[model.GetIndices()[t * 3 + k]];
+    }
+    auto less = [](const Vector3f& a, const Vector3f& b) {
+      return lexicographical_compare(a.GetAddress(), a.GetAddress() + 3, b.GetAddress(), b.GetAddress() + 3);
+    };
+    size_t first = min_element(p.begin(), p.end(), less) - p.begin();
+    array<float, 9> tri;
+    for (size_t k = 0; k < 3; k++) {
+      const auto& v = p[(first + k) % 3];
+      tri[k * 3 + 0] = v.X();
+      tri[k * 3 + 1] = v.Y();
+      tri[k * 3 + 2] = v.Z();
+    }
+    result.emplace_back(tri);
+  }
+  sort(result.begin(), result.end());
+  return result;
+}
+
+int main(int argc, char** argv) {
+  auto sphere = ImmutableModel::CreateSphere("sphere", 1.0f, 64);
+  MeshOptimizeStats stats;
+  auto optimized = OptimizeModel(sphere, &stats);
+  cout << "ACMR " << stats.Before.Acmr << " -> " << stats.After.Acmr << "\n";
+  cout << "ATVR " << stats.Before.Atvr << " -> " << stats.After.Atvr << "\n";
+  if (stats.After.Acmr > stats.Before.Acmr) { return -1; }
+  if (stats.After.Acmr > 0.8f) { return -1; }
+  if (optimized.GetIndexCount() != sphere.GetIndexCount()) { return -1; }
+  if (optimized.GetVertexCount() != sphere.GetVertexCount() || !optimized.HasTangent()) { return -1; }
+  //三角形集合和绕序不变
+  if (CollectTriangles(sphere) != CollectTriangles(optimized)) { return -1; }
+  //顶点按首次引用的顺序排列
+  uint32_t next = 0;
+  for (size_t i = 0; i < optimized.GetIndexCount(); i++) {
+    auto v = optimized.GetIndices()[i];
+    if (v > next) { return -1; }
+    if (v == next) { next++; }
+  }
+  cout << "passed test" << endl;
+  return 0;
+}
@@ -0,0 +1,93 @@
+#include <iostream>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cmath>
+
+#include <hikari/mesh.h>
+
+using namespace std;
+using namespace Hikari;
+
+static array<uint32_t, 3> Canonical(uint32_t a, uint32_t b, uint32_t c) {
+  if (b < a && b < c) return {b, c, a};
+  if (c < a && c < b) return {c, a, b};
+  return {a, b, c};
+}
+
+static float PlaneDistance(const Vector4f& p, const Vector3f& v) {
+  return p[0] * v.X() + p[1] * v.Y() + p[2] * v.Z() + p[3];
+}
+
+int main(int argc, char** argv) {
+  auto sphere = ImmutableModel::CreateSphere("sphere", 1.0f, 64);
+  auto pos = sphere.GetPosition();
+  auto data = BuildMeshlets(sphere);
+  cout << "meshlets " << data.Meshlets.size() << " for " << sphere.GetTriangleCount() << " triangles\n";
+  if (data.Meshlets.size() != data.Bounds.size()) { return -1; }
+  if (data.Meshlets.size() * 40 > sphere.GetTriangleCount()) { return -1; }
+  //每个三角形恰好出现一次，绕序不变
+  vector<array<uint32_t, 3>> expect, actual;
+  for (size_t t = 0; t < sphere.GetTriangleCount(); t++) {
+    auto idx = sphere.GetIndices();
+    expect.emplace_back(Canonical(uint32_t(idx[t * 3]), uint32_t(idx[t * 3 + 1]), uint32_t(idx[t * 3 + 2])));
+  }
+  for (size_t m = 0; m < data.Meshlets.size(); m++) {
+    const auto& meshlet = data.Meshlets[m];
+    const auto& bounds = data.Bounds[m];
+    if (meshlet.VertexCount > MESHLET_MAX_VERTICES || meshlet.TriangleCount > MESHLET_MAX_TRIANGLES) { return -1; }
+    const uint32_t* verts = data.Vertices.data() + meshlet.VertexOffset;
+    const uint8_t* tris = data.Triangles.data() + meshlet.TriangleOffset;
+    for (size_t i = 0; i < meshlet.VertexCount; i++) {
+      if (Length(pos[verts[i]] - bounds.Center) > bounds.Radius * 1.0001f + 1e-6f) { return -1; }
+    }
+    float minSin = std::sqrt(std::max(0.0f, 1 - bounds.ConeCutoff * bounds.ConeCutoff));
+    for (size_t t = 0; t < meshlet.TriangleCount; t++) {
+      if (tris[t * 3] >= meshlet.VertexCount || tris[t * 3 + 1] >= meshlet.VertexCount || tris[t * 3 + 2] >= meshlet.VertexCount) { return -1; }
+      uint32_t a = verts[tris[t * 3]], b = verts[tris[t * 3 + 1]], c = verts[tris[t * 3 + 2]];
+      actual.emplace_back(Canonical(a, b, c));
+      auto n = Cross(pos[b] - pos[a], pos[c] - pos[a]);
+      float len = Length(n);
+      if (bounds.ConeCutoff < 1 && len > 0 && Dot(n, bounds.ConeAxis) / len < minSin - 1e-4f) { return -1; }
+    }
+  }
+  sort(expect.begin(), expect.end());
+  sort(actual.begin(), actual.end());
+  if (expect != actual) { return -1; }
+
+  //被剔除的簇里不能有朝向相机且在视锥内的三角形
+  Vector3f eye{0, 0, 3};
+  auto view = LookAt(eye, Vector3f{0, 0, 0}, Vector3f{0, 1, 0});
+  auto proj = Perspective<float>(Radian(45.0f), 1.0f, 0.1f, 100.0f);
+  auto frustum = Frustum::FromMatrix(view * proj);
+  vector<uint32_t> visible;
+  size_t visibleCount = CullMeshlets(data, frustum, eye, visible);
+  cout << "visible " << visibleCount << " / " << data.Meshlets.size() << "\n";
+  if (visibleCount == 0 || visibleCount * 10 > data.Meshlets.size() * 7) { return -1; }
+  vector<uint8_t> isVisible(data.Meshlets.size(), 0);
+  for (auto m : visible) {
+    isVisible[m] = 1;
+  }
+  for (size_t m = 0; m < data.Meshlets.size(); m++) {
+    if (isVisible[m]) {
+      continue;
+    }
+    const auto& meshlet = data.Meshlets[m];
+    for (size_t t = 0; t < meshlet.TriangleCount; t++) {
+      const auto& a = pos[data.Vertices[meshlet.VertexOffset + data.Triangles[meshlet.TriangleOffset + t * 3]]];
+      const auto& b = pos[data.Vertices[meshlet.VertexOffset + data.Triangles[meshlet.TriangleOffset + t * 3 + 1]]];
+      const auto& c = pos[data.Vertices[meshlet.VertexOffset + data.Triangles[meshlet.TriangleOffset + t * 3 + 2]]];
+      bool isFront = Dot(Cross(b - a, c - a), eye - a) > 1e-6f;
+      bool isOutside = false;
+      for (const auto& p : frustum.Planes) {
+        isOutside |= PlaneDistance(p, a) < 0 && PlaneDistance(p, b) < 0 && PlaneDistance(p, c) < 0;
+      }
+      if (isFront && !isOutside) { return -1; }
+    }
+  }
+  //背对球时全部在视锥外
+  auto away = LookAt(eye, Vector3f{0, 0, 6}, Vector3f{0, 1, 0});
+  if (CullMeshlets(data, Frustum::FromMatrix(away * proj), eye, visible) != 0) { return -1; }
+  cout << "passed test" << endl;
+  return 0;
+}
@@ -0,0 +1,186 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+
+#include <hikari/asset.h>
+
+using namespace std;
+using namespace Hikari;
+
+template <typename View>
+static bool AreEquals(const View& a, const View& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); i++) {
+    if (!(a[i] == b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  auto root = filesystem::temp_directory_path() / "hikari_test_obj_parser";
+  filesystem::create_directories(root);
+  ModelImportOptions tinyObj;
+  tinyObj.UseCache = false;
+  tinyObj.Importer = ModelImporter::TinyObj;
+  ModelImportOptions parallel;
+  parallel.UseCache = false;
+  parallel.Importer = ModelImporter::Parallel;
+  {
+    //与tinyobj结果一致：负数索引、注释、科学计数法、CRLF
+    auto path = root / "tri.obj";
+    ofstream obj(path, ios::binary);
+    obj << "# comment\r\nmtllib a.mtl\r\no tri\r\n";
+    obj << "v 0 0 0\r\nv 1.5 0 0\r\nv\t1.5 2.5e-1 -0.125\r\nv -1E+1 1 .5\r\n";
+    obj << "vt 0 0\r\nvt 1 0\r\nvt 1 1\r\nvt 0 1\r\n";
+    obj << "vn 0 0 1\r\nvn 0 1 0\r\n";
+    obj << "usemtl m\r\ns off\r\n";
+    obj << "f 1/1/1 2/2/1 3/3/1\r\nf -4/-4/-2 -2/-2/-1 -1/-1/-1\r\n";
+    obj << "g other\r\nf 2/2/1 3/3/1 4/4/2 # tail\r\n";
+    obj.close();
+    ImmutableModel a, b;
+    if (!ImmutableModel::LoadFromFile("a", path, a, tinyObj)) { return -1; }
+    if (!ImmutableModel::LoadFromFile("b", path, b, parallel)) { return -1; }
+    if (!AreEquals(a.GetPosition(), b.GetPosition()) ||
+        !AreEquals(a.GetNormals(), b.GetNormals()) ||
+        !AreEquals(a.GetTexCoords(), b.GetTexCoords()) ||
+        !AreEquals(a.GetIndices(), b.GetIndices())) {
+      return -1;
+    }
+    if (b.GetPosition()[2] != Vector3f(1.5f, 0.25f, -0.125f)) { return -1; }
+    ModelImportOptions streaming;
+    streaming.UseCache = false;
+    streaming.Importer = ModelImporter::Streaming;
+    ImmutableModel c;
+    if (!ImmutableModel::LoadFromFile("c", path, c, streaming)) { return -1; }
+    if (!AreEquals(a.GetPosition(), c.GetPosition()) ||
+        !AreEquals(a.GetNormals(), c.GetNormals()) ||
+        !AreEquals(a.GetTexCoords(), c.GetTexCoords()) ||
+        !AreEquals(a.GetTangents(), c.GetTangents()) ||
+        !AreEquals(a.GetIndices(), c.GetIndices())) {
+      return -1;
+    }
+    if (b.GetBoundsMin().X() != -10.0f) { return -1; }
+  }
+  {
+    //多边形扇形三角化，缺失的分量
+    auto path = root / "poly.obj";
+    ofstream obj(path, ios::binary);
+    obj << "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv -1 0.5 0\n";
+    obj << "f 1 2 3 4 5\n";
+    obj.close();
+    ImmutableModel m;
+    if (!ImmutableModel::LoadFromFile("m", path, m, parallel)) { return -1; }
+    if (m.GetTriangleCount() != 3 || m.HasNormal() || m.HasTexCoord()) { return -1; }
+    const size_t expect[] = {0, 1, 2, 0, 2, 3, 0, 3, 4};
+    for (size_t i = 0; i < 9; i++) {
+      if (m.GetIndices()[i] != expect[i]) { return -1; }
+    }
+  }
+  {
+    //超过一个块时跨块的相对索引
+    auto path = root / "big.obj";
+    ofstream obj(path, ios::binary);
+    const int n = 40000;
+    for (int i = 0; i < n; i++) {
+      obj << "v " << i << " " << i * 0.5f << " 0\n";
+      obj << "v " << i << " " << i * 0.5f << " 1\n";
+      obj << "v " << i << " " << i * 0.5f << " 2\n";
+      obj << "f -3 -2 -1\n";
+    }
+    obj.close();
+    ImmutableModel a, b;
+    if (!ImmutableModel::LoadFromFile("a", path, a, tinyObj)) { return -1; }
+    if (!ImmutableModel::LoadFromFile("b", path, b, parallel)) { return -1; }
+    if (b.GetTriangleCount() != n ||
+        !AreEquals(a.GetPosition(), b.GetPosition()) ||
+        !AreEquals(a.GetIndices(), b.GetIndices())) {
+      return -1;
+    }
+    //流式导入，窗口远小于文件
+    ModelImportStats stats;
+    ModelImportOptions streaming;
+    streaming.UseCache = false;
+    streaming.Importer = ModelImporter::Streaming;
+    streaming.StreamWindowSize = 4096;
+    streaming.Stats = &stats;
+    ImmutableModel c;
+    if (!ImmutableModel::LoadFromFile("c", path, c, streaming)) { return -1; }
+    if (!AreEquals(a.GetPosition(), c.GetPosition()) || !AreEquals(a.GetIndices(), c.GetIndices())) { return -1; }
+    cout << "streaming peak: " << stats.PeakMemoryBytes << " bytes\n";
+    if (stats.PeakMemoryBytes == 0) { return -1; }
+    //上限不足时失败
+    streaming.MemoryLimit = stats.PeakMemoryBytes / 2;
+    ImmutableModel d;
+    if (ImmutableModel::LoadFromFile("d", path, d, streaming)) { return -1; }
+  }
+  {
+    //每个面都有接缝的立方体：8个位置、6个法线、4个纹理坐标，但有24个唯一顶点，比任何一种属性都多
+    auto path = root / "seam.obj";
+    ofstream obj(path, ios::binary);
+    const int cubes = 2000;
+    const int face[6][4] = {{1, 2, 3, 4}, {5, 8, 7, 6}, {1, 5, 6, 2}, {2, 6, 7, 3}, {3, 7, 8, 4}, {5, 1, 4, 8}};
+    for (int i = 0; i < cubes; i++) {
+      for (int k = 0; k < 8; k++) {
+        obj << "v " << (k & 1) + i * 2 << " " << ((k >> 1) & 1) << " " << ((k >> 2) & 1) << "\n";
+      }
+      for (int k = 0; k < 6; k++) {
+        obj << "vn " << (k == 0) << " " << (k == 1) << " " << (k == 2) << "\n";
+      }
+      obj << "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n";
+      for (int f = 0; f < 6; f++) {
+        obj << "f";
+        for (int c = 0; c < 4; c++) {
+          obj << " " << face[f][c] - 9 << "/" << c - 4 << "/" << f - 6;
+        }
+        obj << "\n";
+      }
+    }
+    obj.close();
+    ImmutableModel a;
+    if (!ImmutableModel::LoadFromFile("a", path, a, parallel)) { return -1; }
+    ModelImportStats stats;
+    ModelImportOptions streaming;
+    streaming.UseCache = false;
+    streaming.Importer = ModelImporter::Streaming;
+    streaming.StreamWindowSize = 4096;
+    streaming.Stats = &stats;
+    ImmutableModel b;
+    if (!ImmutableModel::LoadFromFile("b", path, b, streaming)) { return -1; }
+    if (b.GetVertexCount() != size_t(cubes) * 24 ||
+        !AreEquals(a.GetPosition(), b.GetPosition()) ||
+        !AreEquals(a.GetNormals(), b.GetNormals()) ||
+        !AreEquals(a.GetTexCoords(), b.GetTexCoords()) ||
+        !AreEquals(a.GetIndices(), b.GetIndices())) {
+      return -1;
+    }
+    //峰值至少包含最终的顶点数组
+    size_t finalBytes = b.GetVertexCount() * (sizeof(Vector3f) * 2 + sizeof(Vector2f) + sizeof(Vector4f));
+    if (stats.PeakMemoryBytes < finalBytes) { return -1; }
+    //上限正好等于峰值时成功，峰值不超过上限；再小一点就在分配前失败
+    streaming.MemoryLimit = stats.PeakMemoryBytes;
+    ModelImportStats limited;
+    streaming.Stats = &limited;
+    ImmutableModel c;
+    if (!ImmutableModel::LoadFromFile("c", path, c, streaming)) { return -1; }
+    if (limited.PeakMemoryBytes > streaming.MemoryLimit) { return -1; }
+    streaming.MemoryLimit = stats.PeakMemoryBytes - 1;
+    ImmutableModel d;
+    if (ImmutableModel::LoadFromFile("d", path, d, streaming)) { return -1; }
+  }
+  {
+    //越界索引
+    auto path = root / "bad.obj";
+    ofstream obj(path, ios::binary);
+    obj << "v 0 0 0\nf 1 2 3\n";
+    obj.close();
+    ImmutableModel m;
+    if (ImmutableModel::LoadFromFile("m", path, m, parallel)) { return -1; }
+  }
+  filesystem::remove_all(root);
+  cout << "passed test" << endl;
+  return 0;
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <cmath>
+#include <vector>
+
+#include <hikari/mesh.h>
+
+using namespace std;
+using namespace Hikari;
+
+static bool IsClose(const Vector4f& a, const Vector4f& b, float cosTolerance) {
+  return a.W() == b.W() && a.X() * b.X() + a.Y() * b.Y() + a.Z() * b.Z() >= cosTolerance;
+}
+
+int main(int argc, char** argv) {
+  auto sphere = ImmutableModel::CreateSphere("sphere", 1.0f, 64);
+  auto cube = ImmutableModel::CreateCube("cube", 1.0f);
+  auto quad = ImmutableModel::CreateQuad("quad", 1.0f);
+  for (const auto* m : {&sphere, &cube, &quad}) {
+    TangentSplit split;
+    auto gen = GenerateTangents(m->GetIndices(), m->GetPosition(), m->GetNormals(), m->GetTexCoords(), &split);
+    //这几个模型的手性都一致，不需要拆分
+    if (gen.size() != m->GetVertexCount() || !split.Sources.empty() || !split.Remap.empty()) { return -1; }
+    size_t analyticMatch = 0;
+    for (size_t i = 0; i < gen.size(); i++) {
+      const auto& t = gen[i];
+      Vector3f xyz{t.X(), t.Y(), t.Z()};
+      if (abs(Length(xyz) - 1) > 1e-4f || abs(Dot(xyz, m->GetNormals()[i])) > 1e-4f) { return -1; }
+      analyticMatch += IsClose(t, m->GetTangents()[i], 0.99f);
+    }
+    //极点处解析切线不确定，其余顶点应当与生成模型时给出的切线一致
+    cout << m->GetName() << ": " << analyticMatch << " / " << gen.size() << " match analytic tangents\n";
+    if (analyticMatch * 10 < gen.size() * 9) { return -1; }
+    //结果与线程调度无关
+    if (GenerateTangents(m->GetIndices(), m->GetPosition(), m->GetNormals(), m->GetTexCoords()) != gen) { return -1; }
+  }
+
+  //不带切线构造时自动生成，纹理坐标镜像时手性为负
+  {
+    vector<Vector3f> pos{{0, 0, 0}, {1, 0, 0}, {0, 1, 0}};
+    vector<Vector3f> nor(3, Vector3f{0, 0, 1});
+    vector<Vector2f> tex{{1, 0}, {0, 0}, {1, 1}};
+    ImmutableModel mirrored("mirrored", std::move(pos), std::move(nor), std::move(tex), vector<uint32_t>{0, 1, 2});
+    if (!mirrored.HasTangent()) { return -1; }
+    for (const auto& t : mirrored.GetTangents()) {
+      if (!IsClose(t, Vector4f{-1, 0, 0, -1}, 0.9999f)) { return -1; }
+    }
+  }
+
+  //共享顶点的两个三角形切线方向不同，按顶点处的角度加权：90度的三角形切线为x，45度的为y，
+  //期望值 normalize(90*(1,0,0) + 45*(0,1,0)) = (2,1,0)/sqrt(5)
+  {
+    vector<Vector3f> pos{{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 1, 0}, {-1, 1, 0}};
+    vector<Vector3f> nor(5, Vector3f{0, 0, 1});
+    //第二个三角形 u=y, v=-x，切线为y，手性仍为正
+    vector<Vector2f> tex{{0, 0}, {1, 0}, {0, 1}, {1, 0}, {1, 1}};
+    ImmutableModel fan("fan", std::move(pos), std::move(nor), std::move(tex), vector<uint32_t>{0, 1, 2, 0, 3, 4});
+    const Vector4f expect[] = {{0.894427f, 0.447214f, 0, 1}, {1, 0, 0, 1}, {1, 0, 0, 1}, {0, 1, 0, 1}, {0, 1, 0, 1}};
+    if (fan.GetVertexCount() != 5) { return -1; }
+    for (size_t i = 0; i < 5; i++) {
+      if (!IsClose(fan.GetTangents()[i], expect[i], 0.99999f)) { return -1; }
+    }
+  }
+
+  //四边形和三角形沿x=1的边镜像纹理坐标：左边 u=x，切线(1,0,0,1)；右边 u=2-x，切线(-1,0,0,-1)。
+  //共享边上的两个顶点按手性拆开，每个角的切线都与所在三角形一致
+  {
+    vector<Vector3f> pos{{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {2, 0.5f, 0}};
+    vector<Vector3f> nor(5, Vector3f{0, 0, 1});
+    vector<Vector2f> tex{{0, 0}, {1, 0}, {1, 1}, {0, 1}, {0, 0.5f}};
+    vector<uint32_t> ind{0, 1, 2, 0, 2, 3, 1, 4, 2};
+    ImmutableModel seam("seam", vector<Vector3f>(pos), vector<Vector3f>(nor), vector<Vector2f>(tex), vector<uint32_t>(ind));
+    if (seam.GetVertexCount() != 7 || seam.GetIndexCount() != ind.size()) { return -1; }
+    for (size_t c = 0; c < ind.size(); c++) {
+      uint32_t v = seam.GetIndices()[c];
+      //拆出的顶点复制原顶点的属性
+      if (seam.GetPosition()[v] != pos[ind[c]] || seam.GetTexCoords()[v] != tex[ind[c]]) { return -1; }
+      auto expect = c < 6 ? Vector4f{1, 0, 0, 1} : Vector4f{-1, 0, 0, -1};
+      if (!IsClose(seam.GetTangents()[v], expect, 0.99999f)) { return -1; }
+    }
+    //不要求拆分时只返回原顶点的切线，共享顶点取角度之和大的左侧（90度对63.4度）
+    auto unsplit = GenerateTangents(IndexArrayView(ind), pos, nor, tex);
+    if (unsplit.size() != 5 || !IsClose(unsplit[1], Vector4f{1, 0, 0, 1}, 0.99999f) ||
+        !IsClose(unsplit[2], Vector4f{1, 0, 0, 1}, 0.99999f) || !IsClose(unsplit[4], Vector4f{-1, 0, 0, -1}, 0.99999f)) {
+      return -1;
+    }
+  }
+  cout << "passed test" << endl;
+  return 0;
+}
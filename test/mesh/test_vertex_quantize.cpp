@@ -0,0 +1,86 @@
+#include <iostream>
+#include <cmath>
+#include <limits>
+
+#include <hikari/quantize.h>
+
+using namespace std;
+using namespace Hikari;
+
+int main(int argc, char** argv) {
+  //半精度：可表示的值往返不变，其余相对误差不超过 2^-11
+  float exact[] = {0.0f, -0.0f, 1.0f, -2.0f, 0.5f, 65504.0f, 6.103515625e-05f, 5.9604644775390625e-08f};
+  for (float v : exact) {
+    if (HalfToFloat(FloatToHalf(v)) != v) { return -1; }
+  }
+  if (FloatToHalf(65536.0f) != 0x7C00 || FloatToHalf(-1e10f) != 0xFC00) { return -1; }
+  if (!std::isnan(HalfToFloat(FloatToHalf(numeric_limits<float>::quiet_NaN())))) { return -1; }
+  if (FloatToHalf(1.0f + 1.0f / 2048.0f) != FloatToHalf(1.0f)) { return -1; }  //舍入到偶数
+  float maxHalfError = 0;
+  for (int i = 0; i < 20000; i++) {
+    float v = (float(i) - 10000.0f) * 0.0137f;
+    if (v == 0) { continue; }
+    maxHalfError = std::max(maxHalfError, std::abs(HalfToFloat(FloatToHalf(v)) - v) / std::abs(v));
+  }
+  cout << "half max relative error " << maxHalfError << "\n";
+  if (maxHalfError > 1.0f / 2048.0f) { return -1; }
+
+  //RGB9E5：最大分量的相对误差不超过 2^-9，负数和NaN变为0，超出范围截断
+  {
+    Vector3f one = Rgb9e5ToFloat(FloatToRgb9e5(Vector3f{1.0f, 0.5f, 0.0f}));
+    if (one.X() != 1.0f || one.Y() != 0.5f || one.Z() != 0.0f) { return -1; }
+    Vector3f clamped = Rgb9e5ToFloat(FloatToRgb9e5(Vector3f{-1.0f, numeric_limits<float>::quiet_NaN(), 1e10f}));
+    if (clamped.X() != 0 || clamped.Y() != 0 || clamped.Z() != 65408.0f) { return -1; }
+    if (FloatToRgb9e5(Vector3f{}) != 0) { return -1; }
+    float maxError = 0;
+    for (int i = 1; i < 20000; i++) {
+      float v = float(i) * float(i) * 0.00013f;
+      Vector3f decoded = Rgb9e5ToFloat(FloatToRgb9e5(Vector3f{v, v * 0.25f, 0.0f}));
+      maxError = std::max(maxError, std::abs(decoded.X() - v) / v);
+    }
+    cout << "rgb9e5 max relative error " << maxError << "\n";
+    if (maxError > 1.0f / 512.0f) { return -1; }
+    //RGBE直接转换与先转float再编码的结果一致
+    for (int e = 100; e < 150; e++) {
+      for (int m = 128; m < 256; m += 17) {
+        uint8_t rgbe[4] = {uint8_t(m), uint8_t(m / 2), uint8_t(m / 5), uint8_t(e)};
+        float scale = std::ldexp(1.0f, e - 136);
+        uint32_t expected = FloatToRgb9e5(Vector3f{rgbe[0] * scale, rgbe[1] * scale, rgbe[2] * scale});
+        if (RgbeToRgb9e5(rgbe) != expected) { return -1; }
+      }
+    }
+  }
+
+  if (FloatToSnorm16(1.0f) != 32767 || FloatToSnorm16(-1.0f) != -32767 || FloatToSnorm16(2.0f) != 32767) { return -1; }
+  if (FloatToUnorm16(1.0f) != 65535 || FloatToUnorm16(0.0f) != 0 || FloatToUnorm16(-1.0f) != 0) { return -1; }
+
+  //八面体编码：SNORM16量化后角度误差很小
+  float maxAngle = 0;
+  const int n = 64;
+  for (int y = 0; y <= n; y++) {
+    for (int x = 0; x < 2 * n; x++) {
+      float theta = PI * float(y) / float(n);
+      float phi = PI * float(x) / float(n);
+      Vector3f dir{std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)};
+      auto e = EncodeOctahedral(dir);
+      Vector2f q{FloatToSnorm16(e.X()) / 32767.0f, FloatToSnorm16(e.Y()) / 32767.0f};
+      auto d = DecodeOctahedral(q);
+      //acos在1附近精度不够，用叉积和点积求角度
+      maxAngle = std::max(maxAngle, std::atan2(Length(Cross(d, dir)), Dot(d, dir)));
+    }
+  }
+  cout << "octahedral max error " << maxAngle * 180.0f / PI << " degree\n";
+  if (maxAngle * 180.0f / PI > 0.01f) { return -1; }
+
+  auto quant = PositionQuantization::FromBounds(Vector3f{-1, 2, 3}, Vector3f{1, 6, 3});
+  Vector3f p{0.25f, 5.0f, 3.0f};
+  float maxPosError = 0;
+  for (size_t k = 0; k < 3; k++) {
+    float u = FloatToUnorm16((p[k] - quant.Offset[k]) / quant.Scale[k]) / 65535.0f;
+    maxPosError = std::max(maxPosError, std::abs(quant.Offset[k] + quant.Scale[k] * u - p[k]));
+  }
+  if (maxPosError > 4.0f / 65535.0f) { return -1; }
+
+  cout << "passed test" << endl;
+  return 0;
+}
@@ -0,0 +1,114 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <hikari/render_context.h>
+#include <hikari/parallel.h>
+
+using namespace std;
+using namespace Hikari;
+
+static const char* SOURCE = R"(#version 330 core
+#include <Common.glsl>
+out vec4 FragColor;
+void main() {
+  FragColor = vec4(Scale());
+})";
+
+static void WriteText(const filesystem::path& path, const string& text) {
+  ofstream stream(path, ios::binary | ios::trunc);
+  stream << text;
+}
+
+static size_t CountCacheFiles(const filesystem::path& dir) {
+  size_t count = 0;
+  for (const auto& entry : filesystem::directory_iterator(dir)) {
+    count += entry.path().extension() == ".hkpp";
+  }
+  return count;
+}
+
+int main(int argc, char** argv) {
+  auto root = filesystem::temp_directory_path() / "hikari_test_preprocess_cache";
+  filesystem::remove_all(root);
+  filesystem::create_directories(root / "lib");
+  SetCacheDirectory(root / "cache");
+  auto include = root / "lib" / "Common.glsl";
+  WriteText(include, "float Scale() { return 2.0; }\n");
+
+  string first;
+  {
+    RenderContextOpenGL ctx;
+    ctx.Init(root / "lib");
+    if (!ctx.PreprocessShader(ShaderType::Fragment, SOURCE, first, {"#define FOO 1"})) { return -1; }
+    if (first.find("return 2.0") == string::npos) { return -1; }
+  }
+  if (CountCacheFiles(root / "cache" / "shader") != 1) { return -1; }
+
+  //改写缓存里的结果，新的上下文读到改写后的内容，说明没有再调用glslang
+  {
+    auto cacheFile = filesystem::directory_iterator(root / "cache" / "shader")->path();
+    ifstream in(cacheFile, ios::binary);
+    string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    auto pos = bytes.rfind("return 2.0");
+    if (pos == string::npos) { return -1; }
+    bytes.replace(pos, 10, "return 9.0");
+    WriteText(cacheFile, bytes);
+    RenderContextOpenGL ctx;
+    ctx.Init(root / "lib");
+    string cached;
+    if (!ctx.PreprocessShader(ShaderType::Fragment, SOURCE, cached, {"#define FOO 1"})) { return -1; }
+    if (cached.find("return 9.0") == string::npos) { return -1; }
+  }
+
+  //include的文件改变后缓存失效，结果覆盖同一个文件；宏不同时是另一个文件
+  {
+    WriteText(include, "float Scale() { return 3.0; }\n");
+    filesystem::last_write_time(include, filesystem::last_write_time(include) + chrono::seconds(2));
+    RenderContextOpenGL ctx;
+    ctx.Init(root / "lib");
+    string changed;
+    if (!ctx.PreprocessShader(ShaderType::Fragment, SOURCE, changed, {"#define FOO 1"})) { return -1; }
+    if (changed.find("return 3.0") == string::npos) { return -1; }
+    if (CountCacheFiles(root / "cache" / "shader") != 1) { return -1; }
+    string other;
+    if (!ctx.PreprocessShader(ShaderType::Fragment, SOURCE, other, {"#define FOO 2"})) { return -1; }
+    if (CountCacheFiles(root / "cache" / "shader") != 2) { return -1; }
+  }
+
+  //换了库目录后，同名include解析到另一个文件，不能命中旧的结果
+  {
+    filesystem::create_directories(root / "lib2");
+    WriteText(root / "lib2" / "Common.glsl", "float Scale() { return 5.0; }\n");
+    RenderContextOpenGL ctx;
+    ctx.Init(root / "lib2");
+    string moved;
+    if (!ctx.PreprocessShader(ShaderType::Fragment, SOURCE, moved, {"#define FOO 1"})) { return -1; }
+    if (moved.find("return 5.0") == string::npos) { return -1; }
+  }
+
+  //同一个上下文在多个线程同时预处理，结果与单线程一致
+  {
+    RenderContextOpenGL ctx;
+    ctx.Init(root / "lib");
+    const size_t count = 16;
+    vector<string> results(count);
+    vector<int> isSuccess(count);
+    ParallelFor(0, count, 1, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        isSuccess[i] = ctx.PreprocessShader(ShaderType::Fragment, SOURCE, results[i], {"#define BAR " + to_string(i % 4)});
+      }
+    });
+    for (size_t i = 0; i < count; i++) {
+      if (!isSuccess[i] || results[i].find("return 3.0") == string::npos) { return -1; }
+      if (results[i] != results[i % 4]) { return -1; }
+    }
+  }
+
+  filesystem::remove_all(root);
+  cout << "passed test" << endl;
+  return 0;
+}
@@ -0,0 +1,46 @@
+#include <iostream>
+#include <cmath>
+
+#include <hikari/application.h>
+
+using namespace std;
+using namespace Hikari;
+
+static float SrgbToLinear(float c) {
+  return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static float LinearToSrgb(float c) {
+  return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+int main(int argc, char** argv) {
+  MipGenerateOptions noCache;
+  noCache.UseCache = false;
+  //2x2的RGBA，每个通道四个不同的值，alpha线性平均
+  const uint8_t image[] = {0, 40, 255, 0,
+                           255, 90, 10, 255,
+                           128, 200, 30, 64,
+                           60, 250, 180, 192};
+  auto srgbOptions = RenderContextOpenGL::GetBitmapMipOptions(PixelFormat::SRGB8A8, noCache);
+  if (!srgbOptions.IsSrgb || srgbOptions.UseCache) { return -1; }
+  auto srgb = GenerateMipChain(image, 2, 2, 4, MipDataType::UInt8, srgbOptions);
+  auto level1 = static_cast<const uint8_t*>(srgb.GetLevelData(1));
+  for (int c = 0; c < 4; c++) {
+    float sum = 0;
+    for (int p = 0; p < 4; p++) {
+      float v = image[p * 4 + c] / 255.0f;
+      sum += c == 3 ? v : SrgbToLinear(v);
+    }
+    float expect = c == 3 ? sum / 4 : LinearToSrgb(sum / 4);
+    if (std::abs(level1[c] - expect * 255.0f) > 1.0f) { return -1; }
+  }
+  //线性格式按编码值平均，结果与sRGB不同
+  auto linearOptions = RenderContextOpenGL::GetBitmapMipOptions(PixelFormat::RGBA8, srgbOptions);
+  if (linearOptions.IsSrgb) { return -1; }
+  auto linear = GenerateMipChain(image, 2, 2, 4, MipDataType::UInt8, linearOptions);
+  auto linearLevel1 = static_cast<const uint8_t*>(linear.GetLevelData(1));
+  if (std::abs(linearLevel1[0] - (0 + 255 + 128 + 60) / 4.0f) > 1.0f || linearLevel1[0] == level1[0]) { return -1; }
+  cout << "passed test" << endl;
+  return 0;
+}
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <cstring>
+#include <memory>
+
+#include <hikari/application.h>
+
+using namespace std;
+using namespace Hikari;
+
+//HikariLight.glsl 按 std140 排布的 uniform block，数组长度由变体的 MAX_DIR_LIGHT/MAX_POI_LIGHT 决定
+static ShaderUniformBlock MakeLightBlock(int dirCount, int pointCount) {
+  ShaderUniformBlock block;
+  block.Name = "HikariLight";
+  block.Index = 0;
+  int offset = 0;
+  auto addArray = [&](const char* name, int length) {
+    block.Members.emplace_back(ShaderUniformBlock::Member{name, -1, ParamType::Float32Vec3, length, offset, 16});
+    offset += 16 * length;
+  };
+  addArray(UNIFORM_LIGHT_DIR_RAD, dirCount);
+  addArray(UNIFORM_LIGHT_DIR_DIR, dirCount);
+  addArray(UNIFORM_LIGHT_POINT_RAD, pointCount);
+  addArray(UNIFORM_LIGHT_POINT_DIR, pointCount);
+  block.Members.emplace_back(ShaderUniformBlock::Member{UNIFORM_LIGHT_DIR_CNT, -1, ParamType::Int32, 1, offset, 0});
+  block.Members.emplace_back(ShaderUniformBlock::Member{UNIFORM_LIGHT_POINT_CNT, -1, ParamType::Int32, 1, offset + 4, 0});
+  block.DataSize = offset + 16;
+  return block;
+}
+
+static float ReadFloat(const GlobalUniformBlock& block, size_t offset) {
+  float value;
+  memcpy(&value, block.Data.data() + offset, sizeof(value));
+  return value;
+}
+
+static int ReadInt(const GlobalUniformBlock& block, size_t offset) {
+  int value;
+  memcpy(&value, block.Data.data() + offset, sizeof(value));
+  return value;
+}
+
+int main(int argc, char** argv) {
+  RenderContextOpenGL ctx;
+  LightCollection lights;
+  //启动时只有一个方向光，变体的数组长度是1
+  lights.AddLight(make_shared<Light>("dir0", LightType::Directional, Vector3f(1.0f), 1.0f, Vector3f(0, -1, 0)));
+  lights.CollectData();
+  lights.SubmitData(ctx);
+  auto [small, isSmallNew] = ctx.RegisterGlobalBlock(MakeLightBlock(1, 1));
+  if (!isSmallNew) { return -1; }
+  if (ReadFloat(ctx.GetGlobalBlock(small), 0) != 1.0f || ReadInt(ctx.GetGlobalBlock(small), 64) != 1) { return -1; }
+
+  //运行时加灯，更长的变体还在编译，只有旧布局。数组截断到旧布局的长度，不能抛异常
+  for (int i = 1; i < 3; i++) {
+    lights.AddLight(make_shared<Light>("dir" + to_string(i), LightType::Directional, Vector3f(float(i + 1)), 1.0f, Vector3f(0, -1, 0)));
+  }
+  lights.CollectData();
+  try {
+    lights.SubmitData(ctx);
+  } catch (const exception& e) {
+    cout << "submit light data failed: " << e.what() << endl;
+    return -1;
+  }
+  const auto& smallBlock = ctx.GetGlobalBlock(small);
+  if (ReadFloat(smallBlock, 0) != 1.0f || ReadInt(smallBlock, 64) != 3) { return -1; }
+
+  //新变体编译好后登记新布局，用保留的数据初始化，所有灯光都在
+  auto [large, isLargeNew] = ctx.RegisterGlobalBlock(MakeLightBlock(4, 1));
+  if (!isLargeNew || large == small) { return -1; }
+  const auto& largeBlock = ctx.GetGlobalBlock(large);
+  for (int i = 0; i < 3; i++) {
+    if (ReadFloat(largeBlock, size_t(16 * i)) != float(i + 1)) { return -1; }
+  }
+  if (ReadInt(largeBlock, 16 * 10) != 3) { return -1; }
+  //相同布局不会重复登记
+  if (ctx.RegisterGlobalBlock(MakeLightBlock(1, 1)) != make_pair(small, false)) { return -1; }
+
+  //没有程序引用的布局被注销，编号留给下一个新布局，新布局同样用保留的数据初始化
+  if (!ctx.ReleaseGlobalBlock(large)) { return -1; }
+  auto [medium, isMediumNew] = ctx.RegisterGlobalBlock(MakeLightBlock(2, 1), 2);
+  if (!isMediumNew || medium != large) { return -1; }
+  const auto& mediumBlock = ctx.GetGlobalBlock(medium);
+  if (mediumBlock.RefCount != 1 || ReadFloat(mediumBlock, 16) != 2.0f || ReadInt(mediumBlock, 16 * 6) != 3) { return -1; }
+  //超出binding point数量时抛出异常
+  try {
+    ctx.RegisterGlobalBlock(MakeLightBlock(3, 1), 2);
+    return -1;
+  } catch (const RenderContextException&) {
+  }
+  //登记了两次的布局要释放两次；注销后继续写入全局数据不受影响
+  if (ctx.ReleaseGlobalBlock(small) || !ctx.ReleaseGlobalBlock(small)) { return -1; }
+  lights.SubmitData(ctx);
+  try {
+    ctx.ReleaseGlobalBlock(small);
+    return -1;
+  } catch (const RenderContextException&) {
+  }
+
+  cout << "passed test" << endl;
+  return 0;
+}
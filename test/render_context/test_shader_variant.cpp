@@ -0,0 +1,116 @@
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <map>
+
+#include <hikari/shader_variant.h>
+
+using namespace std;
+using namespace Hikari;
+
+//不需要GL上下文的编译后端：预处理把宏拼成源码，提交时按宏决定结果
+//MAX_DIR_LIGHT=4 一直在编译，=8 链接失败，=9 预处理失败，其余立即完成
+struct FakeBackend {
+  atomic<int> PreprocessCount{0};
+  mutex Lock;
+  map<string, shared_ptr<ProgramOpenGL>> Programs;
+
+  ShaderVariantBackend Make() {
+    ShaderVariantBackend backend;
+    backend.Preprocess = [this](RenderContextOpenGL&, const ShaderProgramRequest& request, string& vs, string& fs) {
+      PreprocessCount++;
+      vs.clear();
+      for (const auto& macro : request.Macros) {
+        vs += macro + "\n";
+      }
+      if (vs.find("MAX_DIR_LIGHT 9") != string::npos) {
+        throw RenderContextException("bad macro");
+      }
+      fs = vs;
+    };
+    backend.Submit = [this](RenderContextOpenGL&, const string& vs, const string&, const ShaderAttributeLayouts&) {
+      if (vs.find("MAX_DIR_LIGHT 4") != string::npos) {
+        return make_shared<ShaderProgramTask>();
+      }
+      if (vs.find("MAX_DIR_LIGHT 8") != string::npos) {
+        return make_shared<ShaderProgramTask>(nullptr);
+      }
+      auto program = make_shared<ProgramOpenGL>();
+      lock_guard<mutex> guard(Lock);
+      Programs[vs] = program;
+      return make_shared<ShaderProgramTask>(program);
+    };
+    backend.Poll = [](RenderContextOpenGL&, ShaderProgramTask& task) { return task.IsDone(); };
+    backend.Wait = [](RenderContextOpenGL&, ShaderProgramTask&) {};
+    return backend;
+  }
+
+  shared_ptr<ProgramOpenGL> Find(const string& dir, const string& shadow) {
+    lock_guard<mutex> guard(Lock);
+    auto iter = Programs.find("#define MAX_DIR_LIGHT " + dir + "\n#define USE_SHADOW " + shadow + "\n");
+    return iter == Programs.end() ? nullptr : iter->second;
+  }
+};
+
+int main(int argc, char** argv) {
+  RenderContextOpenGL ctx;
+  FakeBackend fake;
+  ShaderProgramRequest request{"a.vert", "a.frag", "", {}, {}};
+  vector<ShaderKeywordAxis> axes{{"MAX_DIR_LIGHT", "1"}, {"USE_SHADOW", "0"}};
+  ShaderPermutation permutation(request, axes, fake.Make());
+
+  //表里没有的维度用默认值，多余的关键字忽略
+  auto values = permutation.SelectValues({{"USE_SHADOW", "1"}, {"OTHER", "x"}});
+  if (values != vector<string>{"1", "1"}) { return -1; }
+  try {
+    permutation.Get(ctx, {"1"});
+    return -1;
+  } catch (const RenderContextException&) {
+  }
+
+  //还没有可用变体时等待第一个变体
+  auto first = permutation.Get(ctx, {"1", "0"});
+  if (first == nullptr || first != fake.Find("1", "0") || fake.PreprocessCount != 1) { return -1; }
+  //相同关键字复用变体，不会重新预处理
+  if (permutation.Get(ctx, {"1", "0"}) != first || fake.PreprocessCount != 1) { return -1; }
+
+  //还在编译的变体返回回退变体
+  permutation.Submit(ctx, {"4", "0"});
+  if (!permutation.IsCompiling() || permutation.Get(ctx, {"4", "0"}) != first) { return -1; }
+
+  //新变体完成后成为回退变体
+  permutation.Submit(ctx, {"2", "1"});
+  permutation.Update(ctx);
+  auto second = permutation.Get(ctx, {"2", "1"});
+  if (second == nullptr || second != fake.Find("2", "1")) { return -1; }
+  if (permutation.Get(ctx, {"4", "0"}) != second) { return -1; }
+
+  //链接失败和预处理失败的变体不重试，继续使用回退变体
+  permutation.Submit(ctx, {"8", "0"});
+  permutation.Submit(ctx, {"9", "0"});
+  permutation.Update(ctx);
+  if (permutation.Get(ctx, {"8", "0"}) != second || permutation.Get(ctx, {"9", "0"}) != second) { return -1; }
+  const int preprocessCount = fake.PreprocessCount;
+  permutation.Update(ctx);
+  if (permutation.Get(ctx, {"9", "0"}) != second || fake.PreprocessCount != preprocessCount) { return -1; }
+  int readyCount = 0, failedCount = 0;
+  auto stats = permutation.GetStats();
+  for (const auto& s : stats) {
+    readyCount += s.IsReady;
+    failedCount += s.IsFailed;
+  }
+  if (stats.size() != 5 || readyCount != 2 || failedCount != 2) { return -1; }
+  //只有编译中的变体时仍然在编译
+  if (!permutation.IsCompiling()) { return -1; }
+
+  //第一个变体就失败时没有回退，抛出异常
+  ShaderPermutation broken(request, axes, fake.Make());
+  try {
+    broken.Get(ctx, {"8", "0"});
+    return -1;
+  } catch (const RenderContextException&) {
+  }
+
+  cout << "passed test" << endl;
+  return 0;
+}